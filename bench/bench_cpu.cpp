@@ -0,0 +1,156 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <threaded_cpu.hpp>
+
+#include "benchmark.hpp"
+#include "machine.hpp"
+
+namespace chip8 {
+namespace bench {
+
+namespace {
+
+/// @brief Instructions run per measure.
+const uint32_t INSTRUCTION_COUNT = 1 << 22;
+
+/// @brief Looping program exercising one opcode class.
+struct OpcodeClass
+{
+    /// @brief Class name.
+    char const * name;
+    /// @brief Program, it loops back to the program start.
+    Memory::Words opcodes;
+};
+
+/// @brief Programs of the opcode classes.
+const OpcodeClass OPCODE_CLASSES[] = {
+    { "immediate", {
+        opcode::encode6XKK(0x0, 0x12),
+        opcode::encode7XKK(0x0, 0x34),
+        opcode::encode6XKK(0x1, 0x56),
+        opcode::encode7XKK(0x1, 0x78),
+        opcode::encode1NNN(0x200) } },
+    { "alu", {
+        opcode::encode8XY4(0x0, 0x1),
+        opcode::encode8XY5(0x2, 0x0),
+        opcode::encode8XY6(0x3, 0x2),
+        opcode::encode8XYE(0x4, 0x3),
+        opcode::encode8XY7(0x5, 0x4),
+        opcode::encode8XY1(0x6, 0x5),
+        opcode::encode8XY2(0x7, 0x6),
+        opcode::encode8XY3(0x1, 0x7),
+        opcode::encode1NNN(0x200) } },
+    { "branch", {
+        opcode::encode3XKK(0x0, 0x01),
+        opcode::encode4XKK(0x0, 0x00),
+        opcode::encode9XY0(0x0, 0x1),
+        opcode::encode2NNN(0x20A),
+        opcode::encode1NNN(0x200),
+        opcode::encode00EE() } },
+    { "memory", {
+        opcode::encodeANNN(0x400),
+        opcode::encodeFX55(0x7),
+        opcode::encodeFX65(0x7),
+        opcode::encodeFX33(0x3),
+        opcode::encodeFX1E(0x3),
+        opcode::encodeFX29(0x2),
+        opcode::encode1NNN(0x200) } },
+    { "draw", {
+        opcode::encodeFX29(0x2),
+        opcode::encodeDXYN(0x0, 0x1, 5),
+        opcode::encode7XKK(0x0, 0x03),
+        opcode::encode7XKK(0x1, 0x01),
+        opcode::encode7XKK(0x2, 0x01),
+        opcode::encode1NNN(0x200) } },
+    { "timers", {
+        opcode::encodeFX15(0x0),
+        opcode::encodeFX07(0x1),
+        opcode::encodeFX18(0x1),
+        opcode::encode1NNN(0x200) } },
+    { "fused", {
+        opcode::encode6XKK(0x0, 0x00),
+        opcode::encode6XKK(0x1, 0x00),
+        opcode::encodeANNN(0x400),
+        opcode::encodeDXYN(0x0, 0x1, 1),
+        opcode::encode7XKK(0x2, 0x01),
+        opcode::encode3XKK(0x2, 0x00),
+        opcode::encode1NNN(0x208),
+        opcode::encodeFX33(0x3),
+        opcode::encodeFX65(0x2),
+        opcode::encode8XY4(0x3, 0x1),
+        opcode::encode8XY5(0x3, 0x0),
+        opcode::encode1NNN(0x200) } },
+    { "random", {
+        opcode::encodeCXKK(0x0, 0xFF),
+        opcode::encodeCXKK(0x1, 0x0F),
+        opcode::encode1NNN(0x200) } }
+};
+
+} // namespace
+
+/// @brief Measure CPU throughput per opcode class, update by update through
+///        the device interfaces and on headless devices, and in threaded runs.
+void benchCpu()
+{
+    for (auto const& opcodeClass : OPCODE_CLASSES)
+    {
+        auto rom = toRom(opcodeClass.opcodes);
+
+        measure(("cpu/update/" + std::string{ opcodeClass.name }).c_str(), [&] {
+            Machine<CpuImpl> machine{ rom };
+
+            for (uint32_t instruction = 0; instruction < INSTRUCTION_COUNT; ++instruction)
+            {
+                machine.cpu().update();
+            }
+
+            doNotOptimize(machine.cpu().getRegContext());
+            return uint64_t{ INSTRUCTION_COUNT };
+        });
+
+        measure(("cpu/headless/" + std::string{ opcodeClass.name }).c_str(), [&] {
+            Machine<HeadlessCpu> machine{ rom };
+
+            for (uint32_t instruction = 0; instruction < INSTRUCTION_COUNT; ++instruction)
+            {
+                machine.cpu().update();
+            }
+
+            doNotOptimize(machine.cpu().getRegContext());
+            return uint64_t{ INSTRUCTION_COUNT };
+        });
+
+        measure(("cpu/threaded/" + std::string{ opcodeClass.name }).c_str(), [&] {
+            Machine<HeadlessThreadedCpu> machine{ rom };
+
+            uint64_t executed = machine.cpu().run(INSTRUCTION_COUNT);
+
+            doNotOptimize(machine.cpu().getRegContext());
+            return executed;
+        });
+    }
+}
+
+}  // bench
+}  // chip8
@@ -0,0 +1,180 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <opcode.hpp>
+#include <opcode_table.hpp>
+#include "benchmark.hpp"
+
+namespace chip8 {
+namespace bench {
+
+namespace {
+
+/// @brief Opcode count per iteration.
+constexpr size_t OPCODE_COUNT = 4096;
+/// @brief Iteration count.
+constexpr size_t ITERATION_COUNT = 4096;
+
+/// @brief Handler state.
+struct Machine
+{
+    uint32_t counters[8];
+};
+
+using Handler = void (*)(Machine &, opcode::Opcode);
+
+template<size_t INDEX>
+void handler(Machine & machine, opcode::Opcode opcode)
+{
+    machine.counters[INDEX & 0x7] += opcode;
+}
+
+using Entry = opcode::DispatchTable<Handler>::Entry;
+
+/// @brief Instruction list shared by both dispatchers.
+constexpr Entry ENTRIES[] = {
+    { opcode::OPCODE_00E0, &handler<0> },
+    { opcode::OPCODE_00EE, &handler<1> },
+    { opcode::OPCODE_1NNN, &handler<2> },
+    { opcode::OPCODE_2NNN, &handler<3> },
+    { opcode::OPCODE_3XKK, &handler<4> },
+    { opcode::OPCODE_4XKK, &handler<5> },
+    { opcode::OPCODE_5XY0, &handler<6> },
+    { opcode::OPCODE_6XKK, &handler<7> },
+    { opcode::OPCODE_7XKK, &handler<8> },
+    { opcode::OPCODE_8XY0, &handler<9> },
+    { opcode::OPCODE_8XY1, &handler<10> },
+    { opcode::OPCODE_8XY2, &handler<11> },
+    { opcode::OPCODE_8XY3, &handler<12> },
+    { opcode::OPCODE_8XY4, &handler<13> },
+    { opcode::OPCODE_8XY5, &handler<14> },
+    { opcode::OPCODE_8XY6, &handler<15> },
+    { opcode::OPCODE_8XY7, &handler<16> },
+    { opcode::OPCODE_8XYE, &handler<17> },
+    { opcode::OPCODE_9XY0, &handler<18> },
+    { opcode::OPCODE_ANNN, &handler<19> },
+    { opcode::OPCODE_BNNN, &handler<20> },
+    { opcode::OPCODE_CXKK, &handler<21> },
+    { opcode::OPCODE_DXYN, &handler<22> },
+    { opcode::OPCODE_EX9E, &handler<23> },
+    { opcode::OPCODE_EXA1, &handler<24> },
+    { opcode::OPCODE_FX07, &handler<25> },
+    { opcode::OPCODE_FX15, &handler<26> },
+    { opcode::OPCODE_FX18, &handler<27> },
+    { opcode::OPCODE_FX1E, &handler<28> },
+    { opcode::OPCODE_FX29, &handler<29> },
+    { opcode::OPCODE_FX33, &handler<30> },
+    { opcode::OPCODE_FX55, &handler<31> },
+    { opcode::OPCODE_FX65, &handler<32> }
+};
+
+constexpr opcode::DispatchTable<Handler> DISPATCH_TABLE(ENTRIES);
+
+/// @brief Generate a reproducible opcode stream of known instructions.
+///
+/// @return Opcode list.
+std::vector<opcode::Opcode> generateOpcodes()
+{
+    std::mt19937 generator{ 0xC8C8 };
+    std::uniform_int_distribution<size_t> entryDistribution{ 0, std::size(ENTRIES) - 1 };
+    std::uniform_int_distribution<uint16_t> operandDistribution{ 0, 0x0FFF };
+
+    std::vector<opcode::Opcode> opcodes;
+
+    while (opcodes.size() < OPCODE_COUNT)
+    {
+        opcode::Opcode instruction = ENTRIES[entryDistribution(generator)].instruction;
+        opcode::Opcode opcode = instruction | (operandDistribution(generator) & ~instruction & 0x0FFF);
+
+        if (opcode::decodeInstruction(opcode) == instruction)
+        {
+            opcodes.push_back(opcode);
+        }
+    }
+
+    return opcodes;
+}
+
+} // namespace
+
+/// @brief Compare the hash map dispatcher with the two-level table.
+void benchDispatch()
+{
+    std::unordered_map<opcode::Opcode, Handler> hashTable;
+
+    for (auto const& entry : ENTRIES)
+    {
+        hashTable.emplace(entry.instruction, entry.func);
+    }
+
+    auto opcodes = generateOpcodes();
+
+    double hashNs = measure("dispatch/unordered_map", [&]() {
+        Machine machine{};
+
+        for (size_t iteration = 0; iteration < ITERATION_COUNT; ++iteration)
+        {
+            for (auto opcode : opcodes)
+            {
+                auto entry = hashTable.find(opcode::decodeInstruction(opcode));
+
+                if (entry != hashTable.end())
+                {
+                    entry->second(machine, opcode);
+                }
+            }
+        }
+
+        doNotOptimize(machine);
+        return uint64_t{ ITERATION_COUNT * OPCODE_COUNT };
+    });
+
+    double tableNs = measure("dispatch/constexpr_table", [&]() {
+        Machine machine{};
+
+        for (size_t iteration = 0; iteration < ITERATION_COUNT; ++iteration)
+        {
+            for (auto opcode : opcodes)
+            {
+                auto func = DISPATCH_TABLE.lookup(opcode);
+
+                if (func != nullptr)
+                {
+                    func(machine, opcode);
+                }
+            }
+        }
+
+        doNotOptimize(machine);
+        return uint64_t{ ITERATION_COUNT * OPCODE_COUNT };
+    });
+
+    std::printf("dispatch speedup: %.2fx\n", hashNs / tableNs);
+}
+
+}  // bench
+}  // chip8
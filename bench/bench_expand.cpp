@@ -0,0 +1,86 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <random>
+#include <vector>
+
+#include <framebuffer.hpp>
+#include <pixel_expand.hpp>
+
+#include "benchmark.hpp"
+
+namespace chip8 {
+namespace bench {
+
+namespace {
+
+/// @brief Frames expanded per measure.
+const uint32_t FRAME_COUNT = 2000;
+
+/// @brief Display scale, as presented in a 1024x512 window.
+const uint32_t SCALE = 16;
+
+using ExpandRowFunc = void (*)(uint64_t, pixel::Palette const&, uint32_t, pixel::Pixel *);
+
+/// @brief Expand a frame row by row with the given kernel.
+uint64_t expandFrames(ExpandRowFunc expandRow, uint64_t const * rows, std::vector<pixel::Pixel> & pixels)
+{
+    size_t rowPixels = Framebuffer::DISPLAY_WIDTH * SCALE;
+
+    for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        for (uint32_t y = 0; y < Framebuffer::DISPLAY_HEIGHT; ++y)
+        {
+            expandRow(rows[y] ^ frame, pixel::DEFAULT_PALETTE, SCALE, &pixels[y * rowPixels]);
+        }
+
+        doNotOptimize(pixels.data());
+    }
+
+    return FRAME_COUNT;
+}
+
+} // namespace
+
+/// @brief Compare pixel expansion kernels on a scaled frame.
+void benchExpand()
+{
+    std::mt19937_64 generator{ 0xC8C8 };
+
+    uint64_t rows[Framebuffer::DISPLAY_HEIGHT];
+
+    for (auto & row : rows)
+    {
+        row = generator();
+    }
+
+    std::vector<pixel::Pixel> pixels(Framebuffer::PIXEL_COUNT * SCALE);
+
+    std::printf("expand kernel: %s, scale %u\n", pixel::kernelName(), SCALE);
+
+    measure("expand/scalar", [&] { return expandFrames(&pixel::expandRowScalar, rows, pixels); });
+    measure("expand/vector", [&] { return expandFrames(&pixel::expandRow, rows, pixels); });
+}
+
+}  // bench
+}  // chip8
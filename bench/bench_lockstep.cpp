@@ -0,0 +1,127 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <memory>
+#include <vector>
+
+#include <lockstep_cpu.hpp>
+
+#include "benchmark.hpp"
+#include "machine.hpp"
+
+namespace chip8 {
+namespace bench {
+
+namespace {
+
+/// @brief Instructions run per measure, over all lanes.
+const uint32_t INSTRUCTION_COUNT = 1 << 22;
+
+/// @brief Looping program run by all lanes.
+struct LaneProgram
+{
+    /// @brief Program name.
+    char const * name;
+    /// @brief Program, it loops back to the program start.
+    Memory::Words opcodes;
+};
+
+/// @brief Programs run in lockstep.
+///
+/// The ALU loop never diverges, the mixed one branches on CXKK so lanes
+/// split and join again on each iteration.
+const LaneProgram LANE_PROGRAMS[] = {
+    { "alu", {
+        opcode::encode8XY4(0x0, 0x1),
+        opcode::encode8XY5(0x2, 0x0),
+        opcode::encode8XY6(0x3, 0x2),
+        opcode::encode8XYE(0x4, 0x3),
+        opcode::encode8XY7(0x5, 0x4),
+        opcode::encode8XY1(0x6, 0x5),
+        opcode::encode8XY2(0x7, 0x6),
+        opcode::encode8XY3(0x1, 0x7),
+        opcode::encode1NNN(0x200) } },
+    { "mixed", {
+        opcode::encodeCXKK(0x0, 0x03),
+        opcode::encode3XKK(0x0, 0x00),
+        opcode::encode7XKK(0x1, 0x01),
+        opcode::encode8XY4(0x2, 0x1),
+        opcode::encodeANNN(0x300),
+        opcode::encodeFX1E(0x2),
+        opcode::encodeFX33(0x2),
+        opcode::encodeFX65(0x1),
+        opcode::encode8XY5(0x3, 0x1),
+        opcode::encode1NNN(0x200) } }
+};
+
+} // namespace
+
+/// @brief Measure the lockstep engine against as many scalar cores, each
+///        lane seeded apart.
+void benchLockstep()
+{
+    const size_t LANE_COUNT = LockstepCpu::LANES;
+    const uint32_t CYCLES = INSTRUCTION_COUNT / LANE_COUNT;
+
+    for (auto const& program : LANE_PROGRAMS)
+    {
+        auto rom = toRom(program.opcodes);
+
+        measure(("lockstep/scalar/" + std::string{ program.name }).c_str(), [&] {
+            std::vector<std::unique_ptr<Machine<HeadlessCpu>>> machines;
+
+            for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+            {
+                machines.push_back(std::make_unique<Machine<HeadlessCpu>>(rom));
+                machines.back()->cpu().seedRandom(static_cast<uint32_t>(lane + 1));
+            }
+
+            uint64_t executed = 0;
+
+            for (auto & machine : machines)
+            {
+                executed += machine->cpu().run(CYCLES);
+                doNotOptimize(machine->cpu().getRegContext());
+            }
+
+            return executed;
+        });
+
+        measure(("lockstep/lanes/" + std::string{ program.name }).c_str(), [&] {
+            LockstepCpu cpu{ rom, LANE_COUNT };
+
+            for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+            {
+                cpu.seedLane(lane, static_cast<uint32_t>(lane + 1));
+            }
+
+            uint64_t executed = uint64_t{ cpu.run(CYCLES) } * LANE_COUNT;
+
+            doNotOptimize(cpu.getRegContext());
+            return executed;
+        });
+    }
+}
+
+}  // bench
+}  // chip8
@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <random>
+#include <vector>
+
+#include <memory.hpp>
+
+#include "benchmark.hpp"
+
+namespace chip8 {
+namespace bench {
+
+namespace {
+
+/// @brief Loads per measure.
+const uint32_t LOAD_COUNT = 1 << 24;
+
+/// @brief Address list size, a power of two.
+const size_t ADDRESS_COUNT = 4096;
+
+} // namespace
+
+/// @brief Measure memory loads and stores at reproducible random addresses.
+void benchMemory()
+{
+    std::mt19937 generator{ 0xC8C8 };
+    std::uniform_int_distribution<uint16_t> addressDistribution{ 0, SYSTEM_MEMORY_SIZE - 2 };
+
+    std::vector<uint16_t> addresses(ADDRESS_COUNT);
+
+    for (auto & address : addresses)
+    {
+        address = addressDistribution(generator);
+    }
+
+    Memory memory{ };
+
+    measure("memory/load16", [&] {
+        uint32_t sum = 0;
+
+        for (uint32_t load = 0; load < LOAD_COUNT; ++load)
+        {
+            sum += memory.load<uint16_t>(addresses[load & (ADDRESS_COUNT - 1)]);
+        }
+
+        doNotOptimize(sum);
+        return uint64_t{ LOAD_COUNT };
+    });
+
+    measure("memory/store8", [&] {
+        for (uint32_t store = 0; store < LOAD_COUNT; ++store)
+        {
+            memory.store(addresses[store & (ADDRESS_COUNT - 1)], static_cast<uint8_t>(store));
+        }
+
+        doNotOptimize(memory.data());
+        return uint64_t{ LOAD_COUNT };
+    });
+}
+
+}  // bench
+}  // chip8
@@ -0,0 +1,113 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+#include <scheduler.hpp>
+#include <threaded_cpu.hpp>
+
+#include "benchmark.hpp"
+#include "machine.hpp"
+
+namespace chip8 {
+namespace bench {
+
+namespace {
+
+/// @brief Emulated cycles run per ROM.
+const uint64_t CYCLE_COUNT = 1000000;
+
+/// @brief Emulated CPU rate, timers run at 60 Hz of it.
+const uint32_t CPU_RATE = 500;
+
+/// @brief Timer rate.
+const uint32_t TIMER_RATE = 60;
+
+/// @brief Measure a ROM run on a CPU engine.
+///
+/// @tparam CPU  CPU engine.
+/// @param  name Measurement name.
+/// @param  rom  ROM to run.
+template<typename CPU>
+void measureRom(std::string const& name, Rom const& rom)
+{
+    measure(name.c_str(), [&] {
+        auto machine = std::make_shared<Machine<CPU>>(rom);
+        auto cpu = std::shared_ptr<Cpu>{ machine, &machine->cpu() };
+
+        Scheduler scheduler{ cpu, CPU_RATE };
+        scheduler.addEvent(TIMER_RATE, [&machine] { machine->cpu().tickTimers(); });
+        scheduler.run(CYCLE_COUNT);
+
+        doNotOptimize(machine->cpu().getRegContext());
+        return scheduler.getCycles();
+    });
+}
+
+} // namespace
+
+/// @brief Run each ROM of a directory for a fixed count of emulated cycles.
+///
+/// No key is ever pressed, so each run is reproducible.  Each ROM runs on
+/// the headless interpreter, then on the headless threaded engine.
+///
+/// @param romDirectory Directory of ROM files.
+void benchRoms(std::string const& romDirectory)
+{
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+
+    for (auto const& entry : std::filesystem::directory_iterator{ romDirectory, error })
+    {
+        if (entry.is_regular_file())
+        {
+            files.push_back(entry.path());
+        }
+    }
+
+    if (error)
+    {
+        std::printf("Cannot list ROM directory `%s'\n", romDirectory.c_str());
+        return;
+    }
+
+    std::sort(files.begin(), files.end());
+
+    for (auto const& file : files)
+    {
+        Rom rom;
+
+        if (!rom.load(file.string()))
+        {
+            continue;
+        }
+
+        measureRom<HeadlessCpu>("rom/" + file.filename().string(), rom);
+        measureRom<HeadlessThreadedCpu>("rom/threaded/" + file.filename().string(), rom);
+    }
+}
+
+}  // bench
+}  // chip8
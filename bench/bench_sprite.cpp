@@ -0,0 +1,97 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <random>
+#include <vector>
+
+#include <framebuffer.hpp>
+
+#include "benchmark.hpp"
+
+namespace chip8 {
+namespace bench {
+
+namespace {
+
+/// @brief Sprites drawn per measure.
+const uint32_t SPRITE_COUNT = 1 << 20;
+
+/// @brief Position list size, a power of two.
+const size_t POSITION_COUNT = 1024;
+
+/// @brief Sprite position and size.
+struct Draw
+{
+    uint8_t x;
+    uint8_t y;
+    uint16_t address;
+    uint8_t length;
+};
+
+} // namespace
+
+/// @brief Measure sprite drawing with collisions.
+///
+/// `GpuImpl::drawSprite` draws to its framebuffer, measured here without a
+/// renderer.  Positions overlap, so most draws erase pixels.
+void benchSprite()
+{
+    std::mt19937 generator{ 0xC8C8 };
+    std::uniform_int_distribution<uint16_t> byteDistribution{ 0, 0xFF };
+
+    std::vector<uint8_t> memory(SYSTEM_MEMORY_SIZE);
+
+    for (auto & byte : memory)
+    {
+        byte = static_cast<uint8_t>(byteDistribution(generator));
+    }
+
+    std::vector<Draw> draws(POSITION_COUNT);
+
+    for (auto & draw : draws)
+    {
+        draw.x = static_cast<uint8_t>(byteDistribution(generator) & 0x3F);
+        draw.y = static_cast<uint8_t>(byteDistribution(generator) & 0x1F);
+        draw.address = static_cast<uint16_t>((byteDistribution(generator) << 4) & 0xFFF);
+        draw.length = static_cast<uint8_t>(1 + (byteDistribution(generator) % 15));
+    }
+
+    measure("gpu/draw_sprite", [&] {
+        Framebuffer framebuffer;
+        uint32_t collisions = 0;
+
+        for (uint32_t sprite = 0; sprite < SPRITE_COUNT; ++sprite)
+        {
+            auto const& draw = draws[sprite & (POSITION_COUNT - 1)];
+
+            collisions += framebuffer.drawSprite(draw.x, draw.y,
+                                                 Sprite{ memory.data(), memory.size(), draw.address, draw.length });
+        }
+
+        doNotOptimize(collisions);
+        return uint64_t{ SPRITE_COUNT };
+    });
+}
+
+}  // bench
+}  // chip8
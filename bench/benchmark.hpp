@@ -0,0 +1,107 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_BENCHMARK_HPP
+#define CHIP8_BENCHMARK_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <core.hpp>
+
+namespace chip8 {
+namespace bench {
+
+/// @brief Measured benchmark.
+struct Result
+{
+    /// @brief Benchmark name.
+    std::string name;
+    /// @brief Operations executed by the measured run.
+    uint64_t operations;
+    /// @brief Nanoseconds per operation.
+    double nsPerOp;
+};
+
+/// @brief Return the results measured so far, in order.
+inline std::vector<Result> & results()
+{
+    static std::vector<Result> measured;
+    return measured;
+}
+
+/// @brief Keep a value alive so the measured work is not optimized out.
+///
+/// @param value Value to keep.
+template<typename TYPE>
+inline void doNotOptimize(TYPE const& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// @brief Measure a benchmark body.
+///
+/// The body is called once to warm up and once measured, and must return the
+/// count of operations it executed.
+///
+/// @param name Benchmark name.
+/// @param body Benchmark body.
+/// @return Nanoseconds per operation.
+template<typename BODY>
+double measure(char const * name, BODY && body)
+{
+    using Clock = std::chrono::steady_clock;
+
+    body();
+
+    auto start = Clock::now();
+    uint64_t operations = body();
+    auto stop = Clock::now();
+
+    double elapsed = std::chrono::duration<double, std::nano>(stop - start).count();
+    double nsPerOp = elapsed / operations;
+
+    std::printf("%-32s %12llu ops %10.3f ns/op %14.0f ops/s\n",
+                name,
+                static_cast<unsigned long long>(operations),
+                nsPerOp,
+                1e9 / nsPerOp);
+
+    results().push_back(Result{ name, operations, nsPerOp });
+
+    return nsPerOp;
+}
+
+void benchDispatch();
+void benchExpand();
+void benchCpu();
+void benchLockstep();
+void benchMemory();
+void benchSprite();
+void benchRoms(std::string const& romDirectory);
+
+}  // bench
+}  // chip8
+
+#endif  // CHIP8_BENCHMARK_HPP
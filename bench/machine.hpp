@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_BENCHMACHINE_HPP
+#define CHIP8_BENCHMACHINE_HPP
+
+#include <cpu.hpp>
+#include <headless.hpp>
+#include <memory.hpp>
+#include <rom.hpp>
+
+namespace chip8 {
+namespace bench {
+
+/// @brief Machine over headless devices, nothing is presented.
+///
+/// @tparam CPU CPU engine, `CpuImpl`, `ThreadedCpu` or their headless cores.
+template<typename CPU>
+class Machine
+{
+    public:
+        /// @brief Construct a machine with a loaded program.
+        ///
+        /// @param rom Program loaded at the program start.
+        Machine(Rom const& rom)
+            : memory_{ }
+            , gpu_{ }
+            , keyboard_{ }
+            , cpu_{ borrow(memory_), borrow(keyboard_), borrow(gpu_) }
+        {
+            loadProgram(memory_, rom);
+            cpu_.seedRandom(0xC8C8);
+        }
+
+        Memory & memory() { return memory_; }
+        CPU & cpu() { return cpu_; }
+
+    private:
+        Memory           memory_;
+        HeadlessGpu      gpu_;
+        HeadlessKeyboard keyboard_;
+        CPU              cpu_;
+};
+
+/// @brief Convert opcodes to a big endian program image.
+///
+/// @param opcodes Program opcodes.
+/// @return ROM.
+inline Rom toRom(Memory::Words const& opcodes)
+{
+    Memory::Bytes bytes;
+
+    for (auto opcode : opcodes)
+    {
+        bytes.push_back(opcode >> 8);
+        bytes.push_back(opcode & 0xFF);
+    }
+
+    return Rom{ std::move(bytes) };
+}
+
+}  // bench
+}  // chip8
+
+#endif  // CHIP8_BENCHMACHINE_HPP
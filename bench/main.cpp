@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <cstdio>
+#include <string>
+
+#include <pixel_expand.hpp>
+
+#include "benchmark.hpp"
+
+#ifndef CHIP8_ROM_DIR
+#define CHIP8_ROM_DIR "roms"
+#endif
+
+namespace {
+
+/// @brief Write the results as JSON.
+///
+/// @param filename File to write.
+/// @return True when written, otherwise false.
+bool writeJson(std::string const& filename)
+{
+    std::FILE * jsonFile = std::fopen(filename.c_str(), "w");
+
+    if (jsonFile == nullptr)
+    {
+        std::printf("Cannot write JSON file `%s'\n", filename.c_str());
+        return false;
+    }
+
+    auto const& results = chip8::bench::results();
+
+    std::fprintf(jsonFile, "{\n  \"expand_kernel\": \"%s\",\n  \"benchmarks\": [\n", chip8::pixel::kernelName());
+
+    for (size_t index = 0; index < results.size(); ++index)
+    {
+        auto const& result = results[index];
+
+        // Names are plain identifiers and file names, nothing to escape
+        std::fprintf(jsonFile,
+                     "    { \"name\": \"%s\", \"operations\": %llu, \"ns_per_op\": %.4f, \"ops_per_s\": %.0f }%s\n",
+                     result.name.c_str(),
+                     static_cast<unsigned long long>(result.operations),
+                     result.nsPerOp,
+                     1e9 / result.nsPerOp,
+                     (index + 1 < results.size()) ? "," : "");
+    }
+
+    std::fputs("  ]\n}\n", jsonFile);
+
+    return std::fclose(jsonFile) == 0;
+}
+
+} // namespace
+
+int main(int argc, char * argv[])
+{
+    std::string jsonFile;
+    std::string romDirectory{ CHIP8_ROM_DIR };
+
+    for (int index = 1; index < argc; ++index)
+    {
+        std::string argument{ argv[index] };
+
+        if (argument.compare(0, 7, "--json=") == 0)
+        {
+            jsonFile = argument.substr(7);
+        }
+        else if (argument.compare(0, 7, "--roms=") == 0)
+        {
+            romDirectory = argument.substr(7);
+        }
+        else
+        {
+            std::printf("Unknown option `%s'\n", argument.c_str());
+            return 1;
+        }
+    }
+
+    chip8::bench::benchDispatch();
+    chip8::bench::benchExpand();
+    chip8::bench::benchCpu();
+    chip8::bench::benchLockstep();
+    chip8::bench::benchMemory();
+    chip8::bench::benchSprite();
+    chip8::bench::benchRoms(romDirectory);
+
+    if (!jsonFile.empty() && !writeJson(jsonFile))
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,541 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+
+#include <fontset.hpp>
+#include <headless.hpp>
+#include <scheduler.hpp>
+#include <threaded_cpu.hpp>
+
+#include "harness.hpp"
+
+namespace chip8 {
+namespace conformance {
+
+namespace {
+
+/// @brief FNV-1a offset basis.
+const uint64_t FNV_OFFSET = 0xCBF29CE484222325ULL;
+
+/// @brief FNV-1a prime.
+const uint64_t FNV_PRIME = 0x100000001B3ULL;
+
+/// @brief Hash bytes into a FNV-1a hash.
+///
+/// @param hash Hash so far.
+/// @param data Bytes to hash.
+/// @param size Count of bytes.
+/// @return Updated hash.
+uint64_t hashBytes(uint64_t hash, void const * data, size_t size)
+{
+    auto bytes = static_cast<uint8_t const *>(data);
+
+    for (size_t index = 0; index < size; ++index)
+    {
+        hash = (hash ^ bytes[index]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/// @brief Capture the state of a machine.
+MachineState captureState(Cpu::RegContext const& regs, Memory const& memory, Framebuffer const& framebuffer)
+{
+    MachineState state;
+
+    state.regs = regs;
+    std::copy(memory.data(), memory.data() + Memory::MEMORY_SIZE, state.memory.begin());
+    std::copy(framebuffer.rows(), framebuffer.rows() + Framebuffer::DISPLAY_HEIGHT, state.display.begin());
+
+    return state;
+}
+
+/// @brief Capture the state of an extended machine running a classic program.
+///
+/// Classic pixels are drawn as 2x2 blocks in low resolution, the top left
+/// pixel of each block stands for it.
+MachineState captureState(Cpu::RegContext const& regs,
+                          ExtendedMemory const& memory,
+                          ExtendedFramebuffer const& framebuffer)
+{
+    MachineState state;
+
+    state.regs = regs;
+    std::copy(memory.data(), memory.data() + Memory::MEMORY_SIZE, state.memory.begin());
+
+    for (uint8_t y = 0; y < Framebuffer::DISPLAY_HEIGHT; ++y)
+    {
+        Framebuffer::Row row = 0;
+
+        for (uint8_t x = 0; x < Framebuffer::DISPLAY_WIDTH; ++x)
+        {
+            row = (row << 1) | framebuffer.getPixel(2 * x, 2 * y);
+        }
+
+        state.display[y] = row;
+    }
+
+    return state;
+}
+
+/// @brief Load a classic program.
+void loadClassicProgram(Memory & memory, Rom const& rom)
+{
+    loadProgram(memory, rom);
+}
+
+/// @brief Load a classic program in extended memory.
+///
+/// The large fontset is cleared, so that both memories start alike.
+void loadClassicProgram(ExtendedMemory & memory, Rom const& rom)
+{
+    const uint8_t CLEARED[BIG_FONT_SET_SIZE] = {};
+
+    loadProgram(memory, rom);
+    memory.storeRange(FONT_SET_SIZE, CLEARED, BIG_FONT_SET_SIZE);
+}
+
+/// @brief Run a CPU for emulated cycles, ticking timers from the cycle count.
+///
+/// @param cpu    CPU to run.
+/// @param cycles Count of cycles.
+template<typename CPU>
+void drive(CPU & cpu, uint64_t cycles)
+{
+    auto scheduler = Scheduler{ borrow(cpu), CPU_RATE };
+
+    scheduler.addEvent(TIMER_RATE, [&cpu] { cpu.tickTimers(); });
+    scheduler.run(cycles);
+}
+
+/// @brief Machine over headless devices, no key is ever pressed.
+///
+/// @tparam CPU    CPU engine, `CpuImpl`, `ThreadedCpu`, their headless cores
+///                or `ExtendedCpu`.
+/// @tparam MEMORY Memory of the CPU.
+/// @tparam GPU    Headless GPU of the CPU.
+template<typename CPU, typename MEMORY = Memory, typename GPU = HeadlessGpu>
+class Machine
+{
+    public:
+        /// @brief Construct a machine with a loaded program.
+        ///
+        /// @param rom  Program loaded at the program start.
+        /// @param seed CXKK seed.
+        Machine(Rom const& rom, uint32_t seed)
+            : memory_{ }
+            , gpu_{ }
+            , keyboard_{ }
+            , cpu_{ borrow(memory_), borrow(keyboard_), borrow(gpu_) }
+        {
+            loadClassicProgram(memory_, rom);
+            cpu_.seedRandom(seed);
+        }
+
+        /// @brief Run the machine, then capture its state.
+        MachineState run(uint64_t cycles)
+        {
+            drive(cpu_, cycles);
+
+            return captureState(cpu_.getRegContext(), memory_, gpu_.framebuffer());
+        }
+
+    private:
+        MEMORY           memory_;
+        GPU              gpu_;
+        HeadlessKeyboard keyboard_;
+        CPU              cpu_;
+};
+
+/// @brief Run a program on a machine.
+template<typename CPU, typename MEMORY = Memory, typename GPU = HeadlessGpu>
+MachineState runMachine(Rom const& rom, size_t run, uint64_t cycles)
+{
+    return std::make_unique<Machine<CPU, MEMORY, GPU>>(rom, getRunSeed(run))->run(cycles);
+}
+
+/// @brief Run a program on all lanes of a lockstep CPU.
+std::unique_ptr<LockstepCpu> runLockstep(Rom const& rom, uint64_t cycles)
+{
+    auto cpu = std::make_unique<LockstepCpu>(rom, LockstepCpu::LANES);
+
+    for (size_t lane = 0; lane < LockstepCpu::LANES; ++lane)
+    {
+        cpu->seedLane(lane, getRunSeed(lane));
+    }
+
+    drive(*cpu, cycles);
+
+    return cpu;
+}
+
+/// @brief Capture the state of a lockstep lane.
+MachineState captureLane(LockstepCpu const& cpu, size_t lane)
+{
+    return captureState(cpu.getLaneContext(lane), cpu.getLaneMemory(lane), cpu.getLaneFramebuffer(lane));
+}
+
+/// @brief Format the registers of a state on one line.
+std::string formatRegisters(MachineState const& state)
+{
+    char line[128];
+    int size = std::snprintf(line, sizeof(line), "PC %03X  I %03X  SP %X  DT %02X  ST %02X  V ",
+                             state.regs.pc, state.regs.i, state.regs.sp, state.regs.dt, state.regs.st);
+
+    for (size_t index = 0; index < Cpu::REG_COUNT; ++index)
+    {
+        size += std::snprintf(line + size, sizeof(line) - size, "%02X", state.regs.vx[index]);
+    }
+
+    return line;
+}
+
+/// @brief Find the first cycle after which a run differs from the reference.
+///
+/// The states agree before the first cycle and differ after the given
+/// ones, so the cycle is bisected between them.  The caching engines run
+/// whole blocks within a span, so their states may only differ at the end
+/// of the diverging block.
+///
+/// @param engine Diverging engine.
+/// @param rom    Program.
+/// @param run    Diverging run.
+/// @param cycles Cycles after which the states differ.
+/// @return First diverging cycle.
+uint64_t bisect(Engine engine, Rom const& rom, size_t run, uint64_t cycles)
+{
+    uint64_t agreeing = 0;
+    uint64_t differing = cycles;
+
+    while (differing - agreeing > 1)
+    {
+        uint64_t middle = agreeing + (differing - agreeing) / 2;
+
+        if (runOnce(engine, rom, run, middle).hash() == runOnce(Engine::INTERP, rom, run, middle).hash())
+        {
+            agreeing = middle;
+        }
+        else
+        {
+            differing = middle;
+        }
+    }
+
+    return differing;
+}
+
+/// @brief Report a divergence, with the last cycles up to it.
+///
+/// Each cycle shows the instruction the reference ran and the states of
+/// both engines after it, the differing ones marked.
+///
+/// @param engine      Diverging engine.
+/// @param rom         Program.
+/// @param run         Diverging run.
+/// @param cycle       First diverging cycle.
+/// @param traceLength Count of cycles traced.
+/// @return Report.
+std::string trace(Engine engine, Rom const& rom, size_t run, uint64_t cycle, size_t traceLength)
+{
+    uint64_t first = (cycle > traceLength) ? cycle - traceLength + 1 : 1;
+    auto previous = runOnce(Engine::INTERP, rom, run, first - 1);
+    auto reference = previous;
+    auto diverged = previous;
+    char line[160];
+
+    std::string report;
+
+    for (uint64_t step = first; step <= cycle; ++step)
+    {
+        reference = runOnce(Engine::INTERP, rom, run, step);
+        diverged = runOnce(engine, rom, run, step);
+
+        uint16_t pc = previous.regs.pc & Memory::ADDRESS_MASK;
+        uint16_t opcode = (previous.memory[pc] << 8) | previous.memory[(pc + 1) & Memory::ADDRESS_MASK];
+
+        std::snprintf(line, sizeof(line), "    cycle %" PRIu64 "  %03X: %04X\n", step, pc, opcode);
+        report += line;
+
+        std::snprintf(line, sizeof(line), "      %-18s %s\n", getEngineName(Engine::INTERP),
+                      formatRegisters(reference).c_str());
+        report += line;
+
+        std::snprintf(line, sizeof(line), "      %-18s %s%s\n", getEngineName(engine),
+                      formatRegisters(diverged).c_str(),
+                      (reference.hash() != diverged.hash()) ? "  *" : "");
+        report += line;
+
+        previous = reference;
+    }
+
+    return "  after cycle " + std::to_string(cycle) + ": " + reference.describeDifference(diverged) + "\n" + report;
+}
+
+} // namespace
+
+/// @brief Return the name of an engine.
+///
+/// @param engine Engine.
+/// @return Name.
+char const * getEngineName(Engine engine)
+{
+    switch (engine)
+    {
+        case Engine::INTERP:            return "interp";
+        case Engine::HEADLESS_INTERP:   return "headless-interp";
+        case Engine::THREADED:          return "threaded";
+        case Engine::HEADLESS_THREADED: return "headless-threaded";
+        case Engine::LOCKSTEP:          return "lockstep";
+        case Engine::EXTENDED:          return "extended";
+    }
+
+    return "unknown";
+}
+
+/// @brief Hash the state, FNV-1a of each field in order.
+///
+/// @return State hash.
+uint64_t MachineState::hash() const
+{
+    uint64_t hash = FNV_OFFSET;
+
+    // Field by field, the register context has padding
+    hash = hashBytes(hash, &regs.pc, sizeof(regs.pc));
+    hash = hashBytes(hash, regs.vx, sizeof(regs.vx));
+    hash = hashBytes(hash, &regs.sp, sizeof(regs.sp));
+    hash = hashBytes(hash, regs.stack, sizeof(regs.stack));
+    hash = hashBytes(hash, &regs.i, sizeof(regs.i));
+    hash = hashBytes(hash, &regs.dt, sizeof(regs.dt));
+    hash = hashBytes(hash, &regs.st, sizeof(regs.st));
+    hash = hashBytes(hash, memory.data(), memory.size());
+    hash = hashBytes(hash, display.data(), display.size() * sizeof(Framebuffer::Row));
+
+    return hash;
+}
+
+/// @brief Describe how another state differs from this one.
+///
+/// @param other State compared.
+/// @return Differing fields, this value first.
+std::string MachineState::describeDifference(MachineState const& other) const
+{
+    std::string description;
+    char field[96];
+
+    auto add = [&description, &field] {
+        description += description.empty() ? "" : ", ";
+        description += field;
+    };
+
+    if (regs.pc != other.regs.pc)
+    {
+        std::snprintf(field, sizeof(field), "PC %03X/%03X", regs.pc, other.regs.pc);
+        add();
+    }
+
+    for (size_t index = 0; index < Cpu::REG_COUNT; ++index)
+    {
+        if (regs.vx[index] != other.regs.vx[index])
+        {
+            std::snprintf(field, sizeof(field), "V%zX %02X/%02X", index, regs.vx[index], other.regs.vx[index]);
+            add();
+        }
+    }
+
+    if (regs.i != other.regs.i)
+    {
+        std::snprintf(field, sizeof(field), "I %03X/%03X", regs.i, other.regs.i);
+        add();
+    }
+
+    if (regs.sp != other.regs.sp)
+    {
+        std::snprintf(field, sizeof(field), "SP %X/%X", regs.sp, other.regs.sp);
+        add();
+    }
+
+    for (size_t index = 0; index < Cpu::STACK_SIZE; ++index)
+    {
+        if (regs.stack[index] != other.regs.stack[index])
+        {
+            std::snprintf(field, sizeof(field), "stack %zu %03X/%03X",
+                          index, regs.stack[index], other.regs.stack[index]);
+            add();
+        }
+    }
+
+    if (regs.dt != other.regs.dt || regs.st != other.regs.st)
+    {
+        std::snprintf(field, sizeof(field), "DT %02X/%02X ST %02X/%02X",
+                      regs.dt, other.regs.dt, regs.st, other.regs.st);
+        add();
+    }
+
+    size_t memoryBytes = 0;
+    size_t firstAddress = 0;
+
+    for (size_t address = memory.size(); address-- > 0;)
+    {
+        if (memory[address] != other.memory[address])
+        {
+            ++memoryBytes;
+            firstAddress = address;
+        }
+    }
+
+    if (memoryBytes != 0)
+    {
+        std::snprintf(field, sizeof(field), "%zu memory bytes from %03zX %02X/%02X",
+                      memoryBytes, firstAddress, memory[firstAddress], other.memory[firstAddress]);
+        add();
+    }
+
+    for (size_t row = 0; row < display.size(); ++row)
+    {
+        if (display[row] != other.display[row])
+        {
+            std::snprintf(field, sizeof(field), "display from row %zu", row);
+            add();
+            break;
+        }
+    }
+
+    return description.empty() ? "same state" : description;
+}
+
+/// @brief Run a program on an engine, every run of a case.
+///
+/// @param engine Engine.
+/// @param rom    Program.
+/// @param cycles Count of cycles run.
+/// @return State after each run, see getRunCount().
+std::vector<MachineState> runEngine(Engine engine, Rom const& rom, uint64_t cycles)
+{
+    std::vector<MachineState> states;
+
+    if (engine == Engine::LOCKSTEP)
+    {
+        auto cpu = runLockstep(rom, cycles);
+
+        for (size_t lane = 0; lane < LockstepCpu::LANES; ++lane)
+        {
+            states.push_back(captureLane(*cpu, lane));
+        }
+
+        return states;
+    }
+
+    for (size_t run = 0; run < SEED_COUNT; ++run)
+    {
+        states.push_back(runOnce(engine, rom, run, cycles));
+    }
+
+    return states;
+}
+
+/// @brief Run a program on an engine, a single run of a case.
+///
+/// The lockstep engine runs all its lanes, as lanes only run alike with
+/// the same neighbours.
+///
+/// @param engine Engine.
+/// @param rom    Program.
+/// @param run    Run, selecting the seed or lane.
+/// @param cycles Count of cycles run.
+/// @return State after the run.
+MachineState runOnce(Engine engine, Rom const& rom, size_t run, uint64_t cycles)
+{
+    switch (engine)
+    {
+        case Engine::INTERP:            return runMachine<CpuImpl>(rom, run, cycles);
+        case Engine::HEADLESS_INTERP:   return runMachine<HeadlessCpu>(rom, run, cycles);
+        case Engine::THREADED:          return runMachine<ThreadedCpu>(rom, run, cycles);
+        case Engine::HEADLESS_THREADED: return runMachine<HeadlessThreadedCpu>(rom, run, cycles);
+        case Engine::LOCKSTEP:          return captureLane(*runLockstep(rom, cycles), run);
+        case Engine::EXTENDED:          return runMachine<ExtendedCpu, ExtendedMemory, HeadlessExtendedGpu>(rom, run, cycles);
+    }
+
+    return MachineState{};
+}
+
+/// @brief Run a case on every engine and compare each run to the reference.
+///
+/// A diverging run is bisected to the first cycle after which it differs,
+/// and traced over the cycles before it.
+///
+/// @param testCase    Case to run.
+/// @param cycles      Count of cycles run.
+/// @param traceLength Count of cycles traced up to a divergence.
+/// @return Case result.
+CaseResult checkCase(Case const& testCase, uint64_t cycles, size_t traceLength)
+{
+    using Clock = std::chrono::steady_clock;
+
+    CaseResult result{};
+    std::vector<MachineState> reference;
+
+    for (size_t index = 0; index < ENGINE_COUNT; ++index)
+    {
+        auto engine = static_cast<Engine>(index);
+
+        if (engine == Engine::EXTENDED && !testCase.extended)
+        {
+            continue;
+        }
+
+        auto start = Clock::now();
+        auto states = runEngine(engine, testCase.rom, cycles);
+
+        result.seconds[index] = std::chrono::duration<double>(Clock::now() - start).count();
+        result.instructions[index] = cycles * states.size();
+
+        if (engine == Engine::INTERP)
+        {
+            reference = std::move(states);
+            continue;
+        }
+
+        for (size_t run = 0; run < states.size(); ++run)
+        {
+            if (states[run].hash() == reference[run % SEED_COUNT].hash())
+            {
+                continue;
+            }
+
+            uint64_t cycle = bisect(engine, testCase.rom, run, cycles);
+
+            result.divergences.push_back(Divergence{
+                    engine, run, cycle, trace(engine, testCase.rom, run, cycle, traceLength) });
+        }
+    }
+
+    return result;
+}
+
+}  // conformance
+}  // chip8
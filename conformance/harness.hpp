@@ -0,0 +1,145 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_CONFORMANCE_HARNESS_HPP
+#define CHIP8_CONFORMANCE_HARNESS_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <cpu.hpp>
+#include <framebuffer.hpp>
+#include <lockstep_cpu.hpp>
+#include <memory.hpp>
+#include <rom.hpp>
+
+namespace chip8 {
+namespace conformance {
+
+/// @brief Emulated CPU rate, timers run at 60 Hz of it.
+constexpr uint32_t CPU_RATE = 500;
+
+/// @brief Timer rate.
+constexpr uint32_t TIMER_RATE = 60;
+
+/// @brief Seeds of CXKK each case runs with, lockstep lanes cycle through them.
+constexpr size_t SEED_COUNT = 4;
+
+/// @brief First seed of CXKK.
+constexpr uint32_t BASE_SEED = 0xC8C8;
+
+/// @brief Engines run by the harness.
+///
+/// The first one, the interpreter over virtual devices, is the reference
+/// every other engine is compared to.  The extended engine runs the
+/// classic programs in low resolution, and is compared on the first 4 KB
+/// of its memory and the top left pixel of each 2x2 block.  Generated
+/// programs draw DXY0, run past 4 KB or rewrite themselves into extended
+/// instructions, which the extended machine runs differently by design, so
+/// it only runs the ROMs.
+enum class Engine
+{
+    INTERP,
+    HEADLESS_INTERP,
+    THREADED,
+    HEADLESS_THREADED,
+    LOCKSTEP,
+    EXTENDED,
+};
+
+/// @brief Count of engines.
+constexpr size_t ENGINE_COUNT = 6;
+
+char const * getEngineName(Engine engine);
+
+/// @brief Machine state compared between engines.
+struct MachineState
+{
+    /// @brief Registers.
+    Cpu::RegContext regs;
+    /// @brief Memory image.
+    std::array<uint8_t, Memory::MEMORY_SIZE> memory;
+    /// @brief Display rows.
+    std::array<Framebuffer::Row, Framebuffer::DISPLAY_HEIGHT> display;
+
+    uint64_t    hash() const;
+    std::string describeDifference(MachineState const& other) const;
+};
+
+/// @brief Program run by every engine.
+struct Case
+{
+    /// @brief Case name, the ROM file or generated program name.
+    std::string name;
+    /// @brief Program.
+    Rom rom;
+    /// @brief Also run on the extended engine.
+    bool extended;
+};
+
+/// @brief Engine divergence from the reference.
+struct Divergence
+{
+    /// @brief Diverging engine.
+    Engine engine;
+    /// @brief Diverging run, the lane for the lockstep engine.
+    size_t lane;
+    /// @brief First cycle after which the states differ.
+    uint64_t cycle;
+    /// @brief Difference and trace leading to it.
+    std::string report;
+};
+
+/// @brief Outcome of a case.
+struct CaseResult
+{
+    /// @brief Divergences found, empty when all engines agree.
+    std::vector<Divergence> divergences;
+    /// @brief Instructions run per engine.
+    std::array<uint64_t, ENGINE_COUNT> instructions;
+    /// @brief Host seconds spent per engine.
+    std::array<double, ENGINE_COUNT> seconds;
+};
+
+/// @brief Return the count of runs of an engine per case.
+constexpr size_t getRunCount(Engine engine)
+{
+    return (engine == Engine::LOCKSTEP) ? LockstepCpu::LANES : SEED_COUNT;
+}
+
+/// @brief Return the CXKK seed of a run.
+constexpr uint32_t getRunSeed(size_t run)
+{
+    return BASE_SEED + static_cast<uint32_t>(run % SEED_COUNT);
+}
+
+std::vector<MachineState> runEngine(Engine engine, Rom const& rom, uint64_t cycles);
+MachineState              runOnce(Engine engine, Rom const& rom, size_t run, uint64_t cycles);
+
+CaseResult checkCase(Case const& testCase, uint64_t cycles, size_t traceLength);
+
+}  // conformance
+}  // chip8
+
+#endif  // CHIP8_CONFORMANCE_HARNESS_HPP
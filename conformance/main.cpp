@@ -0,0 +1,201 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "harness.hpp"
+#include "programs.hpp"
+
+#ifndef CHIP8_ROM_DIR
+#define CHIP8_ROM_DIR "roms"
+#endif
+
+namespace {
+
+/// @brief Default emulated cycles per run.
+const uint64_t DEFAULT_CYCLES = 100000;
+
+/// @brief Default count of generated programs.
+const size_t DEFAULT_PROGRAMS = 256;
+
+/// @brief Default cycles traced up to a divergence.
+const size_t DEFAULT_TRACE_LENGTH = 16;
+
+/// @brief Run cases over worker threads.
+///
+/// @param cases       Cases to run.
+/// @param threads     Worker threads.
+/// @param cycles      Count of cycles per run.
+/// @param traceLength Count of cycles traced up to a divergence.
+/// @return Result of each case, in case order.
+std::vector<chip8::conformance::CaseResult> runCases(std::vector<chip8::conformance::Case> const& cases,
+                                                     uint32_t threads,
+                                                     uint64_t cycles,
+                                                     size_t traceLength)
+{
+    std::vector<chip8::conformance::CaseResult> results(cases.size());
+    std::atomic<size_t> next{ 0 };
+    std::vector<std::thread> workers;
+
+    for (uint32_t worker = 0; worker < threads; ++worker)
+    {
+        workers.emplace_back([&] {
+            for (size_t index = next++; index < cases.size(); index = next++)
+            {
+                results[index] = chip8::conformance::checkCase(cases[index], cycles, traceLength);
+            }
+        });
+    }
+
+    for (auto & worker : workers)
+    {
+        worker.join();
+    }
+
+    return results;
+}
+
+} // namespace
+
+int main(int argc, char * argv[])
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::string romDirectory{ CHIP8_ROM_DIR };
+    uint64_t cycles = DEFAULT_CYCLES;
+    size_t programs = DEFAULT_PROGRAMS;
+    uint32_t seed = 1;
+    uint32_t threads = 0;
+    size_t traceLength = DEFAULT_TRACE_LENGTH;
+
+    for (int index = 1; index < argc; ++index)
+    {
+        std::string argument{ argv[index] };
+
+        if (argument.compare(0, 7, "--roms=") == 0)
+        {
+            romDirectory = argument.substr(7);
+        }
+        else if (argument.compare(0, 9, "--cycles=") == 0)
+        {
+            cycles = std::strtoull(argument.c_str() + 9, nullptr, 10);
+        }
+        else if (argument.compare(0, 11, "--programs=") == 0)
+        {
+            programs = std::strtoul(argument.c_str() + 11, nullptr, 10);
+        }
+        else if (argument.compare(0, 7, "--seed=") == 0)
+        {
+            seed = std::strtoul(argument.c_str() + 7, nullptr, 10);
+        }
+        else if (argument.compare(0, 10, "--threads=") == 0)
+        {
+            threads = std::strtoul(argument.c_str() + 10, nullptr, 10);
+        }
+        else if (argument.compare(0, 8, "--trace=") == 0)
+        {
+            traceLength = std::strtoul(argument.c_str() + 8, nullptr, 10);
+        }
+        else
+        {
+            std::printf("Unknown option `%s'\n", argument.c_str());
+            return 1;
+        }
+    }
+
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<chip8::conformance::Case> cases;
+
+    if (!romDirectory.empty() && !chip8::conformance::loadRomCases(romDirectory, cases))
+    {
+        return 1;
+    }
+
+    chip8::conformance::generateCases(programs, seed, cases);
+
+    auto start = Clock::now();
+    auto results = runCases(cases, threads, cycles, traceLength);
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    size_t divergences = 0;
+    uint64_t instructions[chip8::conformance::ENGINE_COUNT] = {};
+    double seconds[chip8::conformance::ENGINE_COUNT] = {};
+    uint64_t totalInstructions = 0;
+
+    for (size_t index = 0; index < cases.size(); ++index)
+    {
+        for (auto const& divergence : results[index].divergences)
+        {
+            std::printf("DIVERGED %s, %s run %zu, at cycle %llu\n%s",
+                        cases[index].name.c_str(),
+                        chip8::conformance::getEngineName(divergence.engine),
+                        divergence.lane,
+                        static_cast<unsigned long long>(divergence.cycle),
+                        divergence.report.c_str());
+            ++divergences;
+        }
+
+        for (size_t engine = 0; engine < chip8::conformance::ENGINE_COUNT; ++engine)
+        {
+            instructions[engine] += results[index].instructions[engine];
+            seconds[engine] += results[index].seconds[engine];
+            totalInstructions += results[index].instructions[engine];
+        }
+    }
+
+    std::printf("Checked %zu cases of %llu cycles on %u threads in %.3f s (%.0f instructions/s)\n",
+                cases.size(),
+                static_cast<unsigned long long>(cycles),
+                threads,
+                elapsed,
+                totalInstructions / elapsed);
+
+    // Seconds are summed over workers, so rates are per thread
+    for (size_t engine = 0; engine < chip8::conformance::ENGINE_COUNT; ++engine)
+    {
+        std::printf("  %-18s %14llu instructions %14.0f instructions/s per thread\n",
+                    chip8::conformance::getEngineName(static_cast<chip8::conformance::Engine>(engine)),
+                    static_cast<unsigned long long>(instructions[engine]),
+                    (seconds[engine] > 0) ? instructions[engine] / seconds[engine] : 0);
+    }
+
+    if (divergences != 0)
+    {
+        std::printf("%zu runs diverged from the reference\n", divergences);
+        return 1;
+    }
+
+    std::puts("All engines match the reference");
+
+    return 0;
+}
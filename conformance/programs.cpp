@@ -0,0 +1,178 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+#include "programs.hpp"
+
+namespace chip8 {
+namespace conformance {
+
+namespace {
+
+/// @brief Opcode template, random fields filled in.
+struct Template
+{
+    /// @brief Fixed bits.
+    uint16_t opcode;
+    /// @brief Random bits.
+    uint16_t fields;
+    /// @brief The NNN field is a code address within the program.
+    bool jump;
+};
+
+/// @brief Generated opcodes, every classic instruction but FX0A.
+///
+/// No key is ever pressed, so FX0A would park the program for good.
+const Template TEMPLATES[] = {
+    { 0x00E0, 0x0000, false },  // CLS
+    { 0x00EE, 0x0000, false },  // RET
+    { 0x1000, 0x0FFF, true  },  // JP NNN
+    { 0x2000, 0x0FFF, true  },  // CALL NNN
+    { 0x3000, 0x0FFF, false },  // SE VX, KK
+    { 0x4000, 0x0FFF, false },  // SNE VX, KK
+    { 0x5000, 0x0FF0, false },  // SE VX, VY
+    { 0x6000, 0x0FFF, false },  // LD VX, KK
+    { 0x6000, 0x0FFF, false },
+    { 0x7000, 0x0FFF, false },  // ADD VX, KK
+    { 0x7000, 0x0FFF, false },
+    { 0x8000, 0x0FF0, false },  // LD VX, VY
+    { 0x8001, 0x0FF0, false },  // OR VX, VY
+    { 0x8002, 0x0FF0, false },  // AND VX, VY
+    { 0x8003, 0x0FF0, false },  // XOR VX, VY
+    { 0x8004, 0x0FF0, false },  // ADD VX, VY
+    { 0x8005, 0x0FF0, false },  // SUB VX, VY
+    { 0x8006, 0x0FF0, false },  // SHR VX, VY
+    { 0x8007, 0x0FF0, false },  // SUBN VX, VY
+    { 0x800E, 0x0FF0, false },  // SHL VX, VY
+    { 0x9000, 0x0FF0, false },  // SNE VX, VY
+    { 0xA000, 0x0FFF, false },  // LD I, NNN
+    { 0xB000, 0x0FFF, true  },  // JP V0, NNN
+    { 0xC000, 0x0FFF, false },  // RND VX, KK
+    { 0xD000, 0x0FFF, false },  // DRW VX, VY, N
+    { 0xD000, 0x0FFF, false },
+    { 0xE09E, 0x0F00, false },  // SKP VX
+    { 0xE0A1, 0x0F00, false },  // SKNP VX
+    { 0xF007, 0x0F00, false },  // LD VX, DT
+    { 0xF015, 0x0F00, false },  // LD DT, VX
+    { 0xF018, 0x0F00, false },  // LD ST, VX
+    { 0xF01E, 0x0F00, false },  // ADD I, VX
+    { 0xF029, 0x0F00, false },  // LD F, VX
+    { 0xF033, 0x0F00, false },  // LD B, VX
+    { 0xF055, 0x0F00, false },  // LD [I], VX
+    { 0xF065, 0x0F00, false },  // LD VX, [I]
+};
+
+} // namespace
+
+/// @brief Add a case per ROM file of a directory, in name order.
+///
+/// @param directory Directory of ROM files.
+/// @param cases     Cases to add to.
+/// @return True when the directory was read, otherwise false.
+bool loadRomCases(std::string const& directory, std::vector<Case> & cases)
+{
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+
+    for (auto const& entry : std::filesystem::directory_iterator{ directory, error })
+    {
+        if (entry.is_regular_file())
+        {
+            files.push_back(entry.path());
+        }
+    }
+
+    if (error)
+    {
+        std::printf("Cannot list ROM directory `%s'\n", directory.c_str());
+        return false;
+    }
+
+    std::sort(files.begin(), files.end());
+
+    for (auto const& file : files)
+    {
+        Rom rom;
+
+        if (rom.load(file.string()))
+        {
+            cases.push_back(Case{ "rom/" + file.filename().string(), rom, true });
+        }
+    }
+
+    return true;
+}
+
+/// @brief Add generated program cases.
+///
+/// @param count Count of programs.
+/// @param seed  Seed of the first program, the next ones count up.
+/// @param cases Cases to add to.
+void generateCases(size_t count, uint32_t seed, std::vector<Case> & cases)
+{
+    for (size_t index = 0; index < count; ++index)
+    {
+        uint32_t programSeed = seed + static_cast<uint32_t>(index);
+
+        cases.push_back(Case{ "random/" + std::to_string(programSeed), generateProgram(programSeed), false });
+    }
+}
+
+/// @brief Generate a random program.
+///
+/// Jumps and calls land on opcodes of the program, so control flow stays
+/// in generated code; I may point anywhere, so stores rewrite code too,
+/// which the caching engines must notice.
+///
+/// @param seed Program seed, equal seeds give equal programs.
+/// @return Program.
+Rom generateProgram(uint32_t seed)
+{
+    const size_t TEMPLATE_COUNT = sizeof(TEMPLATES) / sizeof(TEMPLATES[0]);
+
+    std::mt19937 generator{ seed };
+    Memory::Bytes bytes;
+
+    for (size_t index = 0; index < PROGRAM_LENGTH; ++index)
+    {
+        auto const& pattern = TEMPLATES[generator() % TEMPLATE_COUNT];
+        uint16_t opcode = pattern.opcode | (generator() & pattern.fields);
+
+        if (pattern.jump)
+        {
+            opcode = pattern.opcode | (Cpu::PROGRAM_START + 2 * (generator() % PROGRAM_LENGTH));
+        }
+
+        bytes.push_back(opcode >> 8);
+        bytes.push_back(opcode & 0xFF);
+    }
+
+    return Rom{ std::move(bytes) };
+}
+
+}  // conformance
+}  // chip8
@@ -0,0 +1,46 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_CONFORMANCE_PROGRAMS_HPP
+#define CHIP8_CONFORMANCE_PROGRAMS_HPP
+
+#include <string>
+#include <vector>
+
+#include "harness.hpp"
+
+namespace chip8 {
+namespace conformance {
+
+/// @brief Opcodes per generated program.
+constexpr size_t PROGRAM_LENGTH = 512;
+
+bool loadRomCases(std::string const& directory, std::vector<Case> & cases);
+void generateCases(size_t count, uint32_t seed, std::vector<Case> & cases);
+
+Rom generateProgram(uint32_t seed);
+
+}  // conformance
+}  // chip8
+
+#endif  // CHIP8_CONFORMANCE_PROGRAMS_HPP
@@ -0,0 +1,65 @@
+import sys
+
+
+HEADER_SIZE = 8
+WIDTH = 64
+HEIGHT = 32
+
+
+def read_varint(data, offset):
+    value = 0
+    shift = 0
+
+    while True:
+        if offset >= len(data):
+            raise EOFError
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte & 0x80 == 0:
+            return value, offset
+
+
+def decode(stream_file):
+    data = stream_file.read()
+
+    if data[:4] != b'C8FS' or data[4] != 1 or data[5] != WIDTH or data[6] != HEIGHT:
+        sys.exit('Not a CHIP-8 frame stream')
+
+    plane = bytearray(WIDTH * HEIGHT // 8)
+    frame = 0
+    offset = HEADER_SIZE
+
+    try:
+        while offset < len(data):
+            frames, offset = read_varint(data, offset)
+            size, offset = read_varint(data, offset)
+            end = offset + size
+            index = 0
+
+            while offset < end:
+                zeros, offset = read_varint(data, offset)
+                count, offset = read_varint(data, offset)
+                index += zeros
+                for byte in data[offset:offset + count]:
+                    plane[index] ^= byte
+                    index += 1
+                offset += count
+
+            frame += frames
+            print('frame %u' % frame)
+
+            for y in range(HEIGHT):
+                row = plane[y * 8:(y + 1) * 8]
+                print(''.join('#' if row[x // 8] & (0x80 >> (x % 8)) else '.' for x in range(WIDTH)))
+    except EOFError:
+        print('truncated record')
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        sys.exit('Usage: chip8stream.py STREAM_FILE')
+
+    with open(sys.argv[1], 'rb') as stream_file:
+        decode(stream_file)
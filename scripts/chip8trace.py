@@ -0,0 +1,88 @@
+import struct
+import sys
+
+
+HEADER = struct.Struct('<4sHHQQ')
+RECORD = struct.Struct('<HHHBBBB16s')
+
+
+def disassemble(opcode):
+    x = (opcode >> 8) & 0xF
+    y = (opcode >> 4) & 0xF
+    n = opcode & 0xF
+    kk = opcode & 0xFF
+    nnn = opcode & 0xFFF
+
+    group = opcode >> 12
+
+    if opcode == 0x00E0:
+        return 'CLS'
+    if opcode == 0x00EE:
+        return 'RET'
+    if group == 0x0:
+        return 'SYS 0x%03X' % nnn
+    if group == 0x1:
+        return 'JP 0x%03X' % nnn
+    if group == 0x2:
+        return 'CALL 0x%03X' % nnn
+    if group == 0x3:
+        return 'SE V%X, 0x%02X' % (x, kk)
+    if group == 0x4:
+        return 'SNE V%X, 0x%02X' % (x, kk)
+    if group == 0x5 and n == 0x0:
+        return 'SE V%X, V%X' % (x, y)
+    if group == 0x6:
+        return 'LD V%X, 0x%02X' % (x, kk)
+    if group == 0x7:
+        return 'ADD V%X, 0x%02X' % (x, kk)
+    if group == 0x8:
+        names = {0x0: 'LD', 0x1: 'OR', 0x2: 'AND', 0x3: 'XOR', 0x4: 'ADD',
+                 0x5: 'SUB', 0x6: 'SHR', 0x7: 'SUBN', 0xE: 'SHL'}
+        if n in names:
+            return '%s V%X, V%X' % (names[n], x, y)
+    if group == 0x9 and n == 0x0:
+        return 'SNE V%X, V%X' % (x, y)
+    if group == 0xA:
+        return 'LD I, 0x%03X' % nnn
+    if group == 0xB:
+        return 'JP V0, 0x%03X' % nnn
+    if group == 0xC:
+        return 'RND V%X, 0x%02X' % (x, kk)
+    if group == 0xD:
+        return 'DRW V%X, V%X, %u' % (x, y, n)
+    if group == 0xE and kk == 0x9E:
+        return 'SKP V%X' % x
+    if group == 0xE and kk == 0xA1:
+        return 'SKNP V%X' % x
+    if group == 0xF:
+        formats = {0x07: 'LD V%X, DT', 0x0A: 'LD V%X, K', 0x15: 'LD DT, V%X',
+                   0x18: 'LD ST, V%X', 0x1E: 'ADD I, V%X', 0x29: 'LD F, V%X',
+                   0x33: 'LD B, V%X', 0x55: 'LD [I], V%X', 0x65: 'LD V%X, [I]'}
+        if kk in formats:
+            return formats[kk] % x
+
+    return '???'
+
+
+def decode(trace_file):
+    magic, version, record_size, dropped, count = HEADER.unpack(trace_file.read(HEADER.size))
+
+    if magic != b'C8TR' or version != 1 or record_size != RECORD.size:
+        sys.exit('Not a CHIP-8 trace file')
+
+    print('%u records, %u dropped before' % (count, dropped))
+
+    for index in range(count):
+        pc, opcode, i, sp, dt, st, _, vx = RECORD.unpack(trace_file.read(RECORD.size))
+        registers = ' '.join('%02X' % value for value in vx)
+
+        print('%10u  %04X  %04X  %-16s I=%04X SP=%02X DT=%02X ST=%02X V=%s' % (
+            dropped + index, pc, opcode, disassemble(opcode), i, sp, dt, st, registers))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        sys.exit('Usage: chip8trace.py TRACE_FILE')
+
+    with open(sys.argv[1], 'rb') as trace_file:
+        decode(trace_file)
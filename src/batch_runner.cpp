@@ -0,0 +1,327 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <type_traits>
+
+#include <headless.hpp>
+#include <scheduler.hpp>
+#include <threaded_cpu.hpp>
+#include "batch_runner.hpp"
+
+namespace chip8 {
+
+namespace {
+
+/// @brief Timer rate.
+const uint32_t TIMER_RATE = 60; // HZ
+
+} // namespace
+
+/// @brief Headless machine, all its state in one allocation.
+class alignas(BatchRunner::CACHE_LINE_SIZE) BatchRunner::Machine
+{
+    public:
+        virtual ~Machine() {}
+
+        virtual uint64_t run(uint64_t cycles) = 0;
+        virtual bool     isParked() const = 0;
+
+        virtual Cpu::RegContext const& getRegContext() const = 0;
+
+        /// @brief Return the classic display, null for an extended machine.
+        virtual Framebuffer const * getFramebuffer() const = 0;
+        /// @brief Return the extended display, null for a classic machine.
+        virtual ExtendedFramebuffer const * getExtendedFramebuffer() const = 0;
+};
+
+/// @brief Headless machine with a given CPU engine.
+///
+/// The memory and GPU are the ones the CPU is built for.
+///
+/// @tparam CPU CPU implementation.
+template<typename CPU>
+class BatchRunner::BasicMachine : public BatchRunner::Machine
+{
+    public:
+        /// @brief Construct a machine with a loaded program.
+        ///
+        /// @param rom      Program loaded at the program start, cut to fit memory.
+        /// @param cpuRate  Emulated CPU rate.
+        BasicMachine(Rom const& rom, uint32_t cpuRate)
+            : memory_{ }
+            , gpu_{ }
+            , keyboard_{ }
+            , cpu_{ borrow(memory_), borrow(keyboard_), borrow(gpu_) }
+            , scheduler_{ borrow<Cpu>(cpu_), cpuRate }
+        {
+            loadProgram(memory_, rom);
+
+            scheduler_.addEvent(TIMER_RATE, [this] {
+                cpu_.tickTimers();
+
+                if (cpu_.isWaitingForKey())
+                {
+                    scheduler_.stop();
+                }
+            });
+        }
+
+        uint64_t run(uint64_t cycles) override
+        {
+            return scheduler_.run(cycles);
+        }
+
+        bool isParked() const override
+        {
+            return cpu_.isWaitingForKey();
+        }
+
+        Cpu::RegContext const& getRegContext() const override
+        {
+            return cpu_.getRegContext();
+        }
+
+        Framebuffer const * getFramebuffer() const override
+        {
+            return select<Framebuffer>(gpu_.framebuffer());
+        }
+
+        ExtendedFramebuffer const * getExtendedFramebuffer() const override
+        {
+            return select<ExtendedFramebuffer>(gpu_.framebuffer());
+        }
+
+    private:
+        /// @brief Return the framebuffer if it has the wanted type, otherwise null.
+        template<typename WANTED, typename FRAMEBUFFER>
+        static WANTED const * select(FRAMEBUFFER const& framebuffer)
+        {
+            if constexpr (std::is_same_v<WANTED, FRAMEBUFFER>)
+            {
+                return &framebuffer;
+            }
+            else
+            {
+                return nullptr;
+            }
+        }
+
+        typename CPU::MemoryType memory_;
+        typename CPU::GpuType    gpu_;
+        HeadlessKeyboard         keyboard_;
+        CPU                      cpu_;
+        Scheduler                scheduler_;
+};
+
+/// @brief Construct a batch runner.
+///
+/// @param threadCount  Worker thread count, zero for one per hardware thread.
+/// @param engine       CPU engine of the machines.
+/// @param cpuRate      Emulated CPU rate, in Hz.
+BatchRunner::BatchRunner(size_t threadCount, Engine engine, uint32_t cpuRate)
+    : threadCount_{ threadCount }
+    , engine_{ engine }
+    , cpuRate_{ cpuRate }
+    , sessions_{ }
+    , workers_{ }
+    , totalCycles_{ 0 }
+    , elapsedSeconds_{ 0.0 }
+{
+    if (threadCount_ == 0)
+    {
+        threadCount_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t index = 0; index < threadCount_; ++index)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+/// @brief Destroy a batch runner.
+BatchRunner::~BatchRunner()
+{
+}
+
+/// @brief Add a session to run.
+///
+/// @param rom     Program loaded at the program start, shared by the sessions.
+/// @param cycles  Emulated cycles to run.
+/// @return Session index.
+size_t BatchRunner::addSession(Rom const& rom, uint64_t cycles)
+{
+    sessions_.push_back(Session{ rom, cycles, 0, false, nullptr });
+
+    return sessions_.size() - 1;
+}
+
+/// @brief Run all sessions to completion.
+///
+/// Sessions that already ran are run again from a fresh machine.
+void BatchRunner::run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    for (size_t index = 0; index < sessions_.size(); ++index)
+    {
+        workers_[index % threadCount_]->sessions.push_back(index);
+    }
+
+    auto startTime = Clock::now();
+
+    std::vector<std::thread> threads;
+
+    for (size_t index = 1; index < threadCount_; ++index)
+    {
+        threads.emplace_back(&BatchRunner::work, this, index);
+    }
+
+    // Calling thread is the first worker
+    work(0);
+
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    elapsedSeconds_ = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+    totalCycles_ = 0;
+
+    for (auto const& session : sessions_)
+    {
+        totalCycles_ += session.cyclesRan;
+    }
+}
+
+/// @brief Return the registers of a session that ran.
+///
+/// @param session Session index.
+/// @return Register context.
+Cpu::RegContext const& BatchRunner::getRegContext(size_t session) const
+{
+    return sessions_[session].machine->getRegContext();
+}
+
+/// @brief Return the display of a session that ran on a classic engine.
+///
+/// @param session Session index.
+/// @return Framebuffer.
+Framebuffer const& BatchRunner::getFramebuffer(size_t session) const
+{
+    return *sessions_[session].machine->getFramebuffer();
+}
+
+/// @brief Return the display of a session that ran on the extended engine.
+///
+/// @param session Session index.
+/// @return Framebuffer.
+ExtendedFramebuffer const& BatchRunner::getExtendedFramebuffer(size_t session) const
+{
+    return *sessions_[session].machine->getExtendedFramebuffer();
+}
+
+/// @brief Return the count of sessions that stopped parked on a key wait.
+size_t BatchRunner::getParkedCount() const
+{
+    return std::count_if(sessions_.begin(), sessions_.end(),
+                         [](Session const& session) { return session.parked; });
+}
+
+/// @brief Run sessions until none is left.
+///
+/// @param workerIndex Index of the worker.
+void BatchRunner::work(size_t workerIndex)
+{
+    size_t session = 0;
+
+    while (takeSession(workerIndex, session))
+    {
+        runSession(sessions_[session]);
+    }
+}
+
+/// @brief Take a session, our own first, otherwise stolen from another worker.
+///
+/// @param workerIndex  Index of the worker.
+/// @param session      Session index taken.
+/// @return True when a session was taken, otherwise false.
+bool BatchRunner::takeSession(size_t workerIndex, size_t & session)
+{
+    {
+        auto & worker = *workers_[workerIndex];
+        std::lock_guard<std::mutex> lock{ worker.mutex };
+
+        if (!worker.sessions.empty())
+        {
+            session = worker.sessions.front();
+            worker.sessions.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < threadCount_; ++offset)
+    {
+        auto & victim = *workers_[(workerIndex + offset) % threadCount_];
+        std::lock_guard<std::mutex> lock{ victim.mutex };
+
+        if (!victim.sessions.empty())
+        {
+            session = victim.sessions.back();
+            victim.sessions.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// @brief Build the machine of a session and run it.
+///
+/// The machine is built on the worker thread so its memory is first
+/// touched by the core running it.
+///
+/// @param session Session to run.
+void BatchRunner::runSession(Session & session)
+{
+    switch (engine_)
+    {
+        case Engine::INTERP:
+            session.machine = std::make_unique<BasicMachine<HeadlessCpu>>(session.rom, cpuRate_);
+            break;
+        case Engine::THREADED:
+            session.machine = std::make_unique<BasicMachine<HeadlessThreadedCpu>>(session.rom, cpuRate_);
+            break;
+        case Engine::EXTENDED:
+            session.machine = std::make_unique<BasicMachine<ExtendedCpu>>(session.rom, cpuRate_);
+            break;
+    }
+
+    session.cyclesRan = session.machine->run(session.cycles);
+    session.parked = session.machine->isParked();
+}
+
+}  // chip8
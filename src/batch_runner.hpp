@@ -0,0 +1,141 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_BATCHRUNNER_HPP
+#define CHIP8_BATCHRUNNER_HPP
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <core.hpp>
+#include <cpu.hpp>
+#include <framebuffer.hpp>
+#include <memory.hpp>
+#include <rom.hpp>
+
+namespace chip8 {
+
+/// @brief Run many independent headless machines over a thread pool.
+///
+/// Each session is a ROM run for a fixed count of emulated cycles on its
+/// own machine.  A machine holds all its devices in a single cache line
+/// aligned allocation, made by the worker thread that runs it.  Sessions
+/// are dealt round robin to the workers, and a worker out of sessions
+/// steals from the others.  SDL is never used.
+///
+/// The extended engine runs SUPER-CHIP and XO-CHIP machines, with their
+/// 64 KB memory and 128x64 display.
+///
+/// Machine keyboards are headless, so a session parked on FX0A would
+/// never wake up.  It is taken off the run queue at the next timer tick
+/// instead of idling through its remaining cycles.
+class BatchRunner
+{
+    public:
+        /// @brief CPU engine of the machines.
+        enum class Engine { INTERP, THREADED, EXTENDED };
+
+        /// @brief Cache line size, for machine alignment.
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+
+        BatchRunner(size_t threadCount, Engine engine, uint32_t cpuRate);
+        ~BatchRunner();
+
+        size_t addSession(Rom const& rom, uint64_t cycles);
+        void   run();
+
+        /// @brief Return the count of sessions.
+        size_t getSessionCount() const { return sessions_.size(); }
+
+        Cpu::RegContext const&     getRegContext(size_t session) const;
+        Framebuffer const&         getFramebuffer(size_t session) const;
+        ExtendedFramebuffer const& getExtendedFramebuffer(size_t session) const;
+
+        /// @brief Check if a session that ran stopped parked on a key wait.
+        bool isParked(size_t session) const { return sessions_[session].parked; }
+        size_t getParkedCount() const;
+
+        /// @brief Return the cycles ran by all sessions.
+        uint64_t getTotalCycles() const { return totalCycles_; }
+        /// @brief Return the wall clock duration of the last run.
+        double getElapsedSeconds() const { return elapsedSeconds_; }
+        /// @brief Return the aggregate instruction rate of the last run, zero
+        ///        before any run.
+        double getInstructionRate() const { return (elapsedSeconds_ > 0.0) ? totalCycles_ / elapsedSeconds_ : 0.0; }
+
+    private:
+        class Machine;
+
+        template<typename CPU>
+        class BasicMachine;
+
+        /// @brief Session to run.
+        struct Session
+        {
+            /// @brief Program loaded at the program start.
+            Rom rom;
+            /// @brief Cycles to run.
+            uint64_t cycles;
+            /// @brief Cycles ran.
+            uint64_t cyclesRan;
+            /// @brief Stopped parked on a key wait.
+            bool parked;
+            /// @brief Machine, built when the session runs.
+            std::unique_ptr<Machine> machine;
+        };
+
+        /// @brief Worker queue of session indices.
+        struct alignas(CACHE_LINE_SIZE) Worker
+        {
+            /// @brief Queue guard.
+            std::mutex mutex;
+            /// @brief Sessions left, taken from the front by the owner and
+            ///        stolen from the back by others.
+            std::deque<size_t> sessions;
+        };
+
+        void work(size_t workerIndex);
+        bool takeSession(size_t workerIndex, size_t & session);
+        void runSession(Session & session);
+
+        /// @brief Worker thread count.
+        size_t threadCount_;
+        /// @brief Machines CPU engine.
+        Engine engine_;
+        /// @brief Emulated CPU rate.
+        uint32_t cpuRate_;
+        /// @brief Sessions.
+        std::vector<Session> sessions_;
+        /// @brief Worker queues.
+        std::vector<std::unique_ptr<Worker>> workers_;
+        /// @brief Cycles ran by all sessions.
+        uint64_t totalCycles_;
+        /// @brief Wall clock duration of the last run.
+        double elapsedSeconds_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_BATCHRUNNER_HPP
@@ -35,6 +35,19 @@ namespace chip8 {
 /// @brief System memory size.
 constexpr uint16_t SYSTEM_MEMORY_SIZE = 4096;
 
+/// @brief Share an object without owning it.
+///
+/// Devices are wired with shared pointers; this lets a device that is a
+/// member of a larger object be shared for that object's lifetime.
+///
+/// @param object Object to share, must outlive the returned pointer.
+/// @return Non-owning shared pointer.
+template<typename TYPE>
+std::shared_ptr<TYPE> borrow(TYPE & object)
+{
+    return std::shared_ptr<TYPE>(std::shared_ptr<TYPE>{}, &object);
+}
+
 }  // chip8
 
 #endif  // CHIP8_CORE_HPP
@@ -23,152 +23,331 @@
  */
 #include <cstdio>
 
+#include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <fontset.hpp>
 #include <memory.hpp>
 #include <gpu.hpp>
 #include <keyboard.hpp>
+#include <headless.hpp>
 #include "cpu.hpp"
-#include "cpu_trace.hpp"
 
 
 namespace chip8 {
 
 namespace {
 
-const uint32_t DELAY_TIMER_TICK_RATE = 60; // HZ
-const uint32_t DELAY_TIMER_TICK_DURATION = 1000 / DELAY_TIMER_TICK_RATE;
-const uint32_t SOUND_TIMER_TICK_RATE = 60; // HZ
-const uint32_t SOUND_TIMER_TICK_DURATION = 1000 / SOUND_TIMER_TICK_RATE;
+/// @brief Decimal digits of a byte, hundreds first.
+using Digits = std::array<uint8_t, 3>;
+
+/// @brief Build the binary coded decimal table.
+///
+/// @return Digits of every byte value.
+constexpr std::array<Digits, 256> makeBinaryCodedDecimalTable()
+{
+    std::array<Digits, 256> table{ };
+
+    for (uint32_t value = 0; value < table.size(); ++value)
+    {
+        table[value] = Digits{
+            static_cast<uint8_t>(value / 100),
+            static_cast<uint8_t>((value / 10) % 10),
+            static_cast<uint8_t>(value % 10)
+        };
+    }
+
+    return table;
+}
+
+/// @brief Binary coded decimal of every byte value, for FX33.
+constexpr std::array<Digits, 256> BCD_TABLE = makeBinaryCodedDecimalTable();
 
 } // namespace
 
-const CpuImpl::OpcodeDecoder::InstructionTable CpuImpl::OpcodeDecoder::INSTRUCTION_TABLE = {
-    { opcode::OPCODE_00E0, &CpuImpl::opcodeClearDisplay },
-    { opcode::OPCODE_00EE, &CpuImpl::opcodeReturn },
-    { opcode::OPCODE_1NNN, &CpuImpl::opcodeJump },
-    { opcode::OPCODE_2NNN, &CpuImpl::opcodeCall },
-    { opcode::OPCODE_3XKK, &CpuImpl::opcodeSkipNextIfEquals },
-    { opcode::OPCODE_4XKK, &CpuImpl::opcodeSkipNextIfNotEquals },
-    { opcode::OPCODE_5XY0, &CpuImpl::opcodeSkipNextIfEqualsRegister },
-    { opcode::OPCODE_6XKK, &CpuImpl::opcodeLoadNumber },
-    { opcode::OPCODE_7XKK, &CpuImpl::opcodeAddNumber },
-    { opcode::OPCODE_8XY0, &CpuImpl::opcodeLoadRegister },
-    { opcode::OPCODE_8XY1, &CpuImpl::opcodeOrRegister },
-    { opcode::OPCODE_8XY2, &CpuImpl::opcodeAndRegister },
-    { opcode::OPCODE_8XY3, &CpuImpl::opcodeXorRegister },
-    { opcode::OPCODE_8XY4, &CpuImpl::opcodeAddRegister },
-    { opcode::OPCODE_8XY5, &CpuImpl::opcodeSubRegister },
-    { opcode::OPCODE_8XY6, &CpuImpl::opcodeShrRegister },
-    { opcode::OPCODE_8XY7, &CpuImpl::opcodeSubnRegister },
-    { opcode::OPCODE_8XYE, &CpuImpl::opcodeShlRegister },
-    { opcode::OPCODE_9XY0, &CpuImpl::opcodeSkipNextIfNotEqualsRegister },
-    { opcode::OPCODE_ANNN, &CpuImpl::opcodeLoadIRegister },
-    { opcode::OPCODE_BNNN, &CpuImpl::opcodeJumpOffset },
-    { opcode::OPCODE_CXKK, &CpuImpl::opcodeRandomNumber },
-    { opcode::OPCODE_DXYN, &CpuImpl::opcodeDraw },
-    { opcode::OPCODE_EX9E, &CpuImpl::opcodeSkipNextIfKeyEqualsRegister },
-    { opcode::OPCODE_EXA1, &CpuImpl::opcodeSkipNextIfKeyNotEqualsRegister },
-    { opcode::OPCODE_FX07, &CpuImpl::opcodeLoadRegisterFromDelayTimer },
-    { opcode::OPCODE_FX15, &CpuImpl::opcodeLoadDelayTimerFromRegister },
-    { opcode::OPCODE_FX18, &CpuImpl::opcodeLoadSoundTimerFromRegister },
-    { opcode::OPCODE_FX1E, &CpuImpl::opcodeAddIRegister },
-    { opcode::OPCODE_FX29, &CpuImpl::opcodeLoadIRegisterWithAddress },
-    { opcode::OPCODE_FX33, &CpuImpl::opcodeStoreBinaryCodedDecimal },
-    { opcode::OPCODE_FX55, &CpuImpl::opcodeStoreRegistersWithAddress },
-    { opcode::OPCODE_FX65, &CpuImpl::opcodeLoadRegistersWithAddress }
-};
+/// @brief Build the opcode dispatch table of the machine mode.
+///
+/// @return Classic instructions, plus the SUPER-CHIP and XO-CHIP ones on an
+///         extended machine.
+template<typename TRACE, typename DEVICES, typename MODE>
+constexpr typename CpuCore<TRACE, DEVICES, MODE>::OpcodeDecoder::InstructionTable CpuCore<TRACE, DEVICES, MODE>::OpcodeDecoder::makeInstructionTable()
+{
+    InstructionTable table({
+    { opcode::OPCODE_00E0, &CpuCore::opcodeClearDisplay },
+    { opcode::OPCODE_00EE, &CpuCore::opcodeReturn },
+    { opcode::OPCODE_1NNN, &CpuCore::opcodeJump },
+    { opcode::OPCODE_2NNN, &CpuCore::opcodeCall },
+    { opcode::OPCODE_3XKK, &CpuCore::opcodeSkipNextIfEquals },
+    { opcode::OPCODE_4XKK, &CpuCore::opcodeSkipNextIfNotEquals },
+    { opcode::OPCODE_5XY0, &CpuCore::opcodeSkipNextIfEqualsRegister },
+    { opcode::OPCODE_6XKK, &CpuCore::opcodeLoadNumber },
+    { opcode::OPCODE_7XKK, &CpuCore::opcodeAddNumber },
+    { opcode::OPCODE_8XY0, &CpuCore::opcodeLoadRegister },
+    { opcode::OPCODE_8XY1, &CpuCore::opcodeOrRegister },
+    { opcode::OPCODE_8XY2, &CpuCore::opcodeAndRegister },
+    { opcode::OPCODE_8XY3, &CpuCore::opcodeXorRegister },
+    { opcode::OPCODE_8XY4, &CpuCore::opcodeAddRegister },
+    { opcode::OPCODE_8XY5, &CpuCore::opcodeSubRegister },
+    { opcode::OPCODE_8XY6, &CpuCore::opcodeShrRegister },
+    { opcode::OPCODE_8XY7, &CpuCore::opcodeSubnRegister },
+    { opcode::OPCODE_8XYE, &CpuCore::opcodeShlRegister },
+    { opcode::OPCODE_9XY0, &CpuCore::opcodeSkipNextIfNotEqualsRegister },
+    { opcode::OPCODE_ANNN, &CpuCore::opcodeLoadIRegister },
+    { opcode::OPCODE_BNNN, &CpuCore::opcodeJumpOffset },
+    { opcode::OPCODE_CXKK, &CpuCore::opcodeRandomNumber },
+    { opcode::OPCODE_DXYN, &CpuCore::opcodeDraw },
+    { opcode::OPCODE_EX9E, &CpuCore::opcodeSkipNextIfKeyEqualsRegister },
+    { opcode::OPCODE_EXA1, &CpuCore::opcodeSkipNextIfKeyNotEqualsRegister },
+    { opcode::OPCODE_FX07, &CpuCore::opcodeLoadRegisterFromDelayTimer },
+    { opcode::OPCODE_FX0A, &CpuCore::opcodeLoadRegisterWithKey },
+    { opcode::OPCODE_FX15, &CpuCore::opcodeLoadDelayTimerFromRegister },
+    { opcode::OPCODE_FX18, &CpuCore::opcodeLoadSoundTimerFromRegister },
+    { opcode::OPCODE_FX1E, &CpuCore::opcodeAddIRegister },
+    { opcode::OPCODE_FX29, &CpuCore::opcodeLoadIRegisterWithAddress },
+    { opcode::OPCODE_FX33, &CpuCore::opcodeStoreBinaryCodedDecimal },
+    { opcode::OPCODE_FX55, &CpuCore::opcodeStoreRegistersWithAddress },
+    { opcode::OPCODE_FX65, &CpuCore::opcodeLoadRegistersWithAddress }
+});
+
+    if constexpr (MODE::EXTENDED)
+    {
+        table.add({
+            { opcode::OPCODE_00FB, &CpuCore::opcodeScrollRight },
+            { opcode::OPCODE_00FC, &CpuCore::opcodeScrollLeft },
+            { opcode::OPCODE_00FD, &CpuCore::opcodeExit },
+            { opcode::OPCODE_00FE, &CpuCore::opcodeLowResolution },
+            { opcode::OPCODE_00FF, &CpuCore::opcodeHighResolution },
+            { opcode::OPCODE_5XY2, &CpuCore::opcodeStoreRegisterRange },
+            { opcode::OPCODE_5XY3, &CpuCore::opcodeLoadRegisterRange },
+            { opcode::OPCODE_F000, &CpuCore::opcodeLoadIRegisterWithLongAddress },
+            { opcode::OPCODE_FN01, &CpuCore::opcodeSelectPlanes },
+            { opcode::OPCODE_FX30, &CpuCore::opcodeLoadIRegisterWithLargeFont },
+            { opcode::OPCODE_FX75, &CpuCore::opcodeStoreFlags },
+            { opcode::OPCODE_FX85, &CpuCore::opcodeLoadFlags }
+        });
+
+        for (uint16_t n = 0; n < 0x10; ++n)
+        {
+            table.assign(opcode::OPCODE_00CN | n, &CpuCore::opcodeScrollDown);
+            table.assign(opcode::OPCODE_00DN | n, &CpuCore::opcodeScrollUp);
+        }
+    }
+
+    return table;
+}
+
+template<typename TRACE, typename DEVICES, typename MODE>
+constexpr typename CpuCore<TRACE, DEVICES, MODE>::OpcodeDecoder::InstructionTable CpuCore<TRACE, DEVICES, MODE>::OpcodeDecoder::INSTRUCTION_TABLE = makeInstructionTable();
 
 /// @brief Construct an opcode decoder.
 ///
-/// @param cpu Reference to the CPU instance.
-CpuImpl::OpcodeDecoder::OpcodeDecoder(CpuImpl * cpu)
-    : cpu_{ cpu }
+/// @param memory Reference to memory to fetch opcodes from.
+template<typename TRACE, typename DEVICES, typename MODE>
+CpuCore<TRACE, DEVICES, MODE>::OpcodeDecoder::OpcodeDecoder(MemoryType & memory)
+    : memory_{ memory }
+    , slots_{ }
+    , valid_{ }
+    , uncached_{ }
 {
+    memory_.attach(this);
 }
 
-/// @brief Decode opcode.
-///
-/// @param opcode Opcode to decode and execute.
-void CpuImpl::OpcodeDecoder::decode(opcode::Opcode opcode)
+/// @brief Destroy an opcode decoder.
+template<typename TRACE, typename DEVICES, typename MODE>
+CpuCore<TRACE, DEVICES, MODE>::OpcodeDecoder::~OpcodeDecoder()
 {
-    uint16_t decodedInstruction = opcode::decodeInstruction(opcode);
+    memory_.detach(this);
+}
 
-    auto instructionIterator = INSTRUCTION_TABLE.find(decodedInstruction);
+/// @brief Invalidate slots overlapping a memory write.
+///
+/// @param address Address of the first byte written.
+/// @param size    Count of bytes written.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::OpcodeDecoder::onMemoryWrite(uint16_t address, size_t size)
+{
+    size_t first = address >> 1;
+    size_t last = std::min((address + size - 1) >> 1, SLOT_COUNT - 1);
 
-    if (instructionIterator != INSTRUCTION_TABLE.end())
+    for (size_t slot = first; slot <= last; ++slot)
     {
-        (cpu_->*(instructionIterator->second))();
+        valid_[slot] = false;
     }
 }
 
+/// @brief Decode opcode.
+///
+/// @param opcode      Opcode to decode.
+/// @param instruction Instruction to fill.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::OpcodeDecoder::decode(opcode::Opcode opcode, Instruction & instruction)
+{
+    instruction.func   = INSTRUCTION_TABLE.lookup(opcode);
+    instruction.opcode = opcode;
+    instruction.nnn    = opcode & 0x0FFF;
+    instruction.x      = (opcode >> 8) & 0xF;
+    instruction.y      = (opcode >> 4) & 0xF;
+    instruction.n      = opcode & 0xF;
+    instruction.kk     = opcode & 0xFF;
+}
+
 
 /// @brief Construct a CPU instance.
 ///
 /// @param memory Reference to memory.
 /// @param gpu    Reference to GPU displau.
-CpuImpl::CpuImpl(std::shared_ptr<Memory> memory,
-                 std::shared_ptr<Keyboard> keyboard,
-                 std::shared_ptr<Gpu> gpu)
+template<typename TRACE, typename DEVICES, typename MODE>
+CpuCore<TRACE, DEVICES, MODE>::CpuCore(std::shared_ptr<MemoryType> memory,
+                                 std::shared_ptr<KeyboardType> keyboard,
+                                 std::shared_ptr<GpuType> gpu)
     : memory_{ std::move(memory) }
     , keyboard_{ std::move(keyboard) }
     , gpu_{ std::move(gpu) }
     , regs_{ }
-    , opcodeDecoder_{ this }
+    , opcodeDecoder_{ *memory_ }
+    , instruction_{ nullptr }
     , opcode_{ 0x0000 }
-    , tick_{ 0 }
-    , delayTimerTick_{ 0 }
-    , soundTimerTick_{ 0 }
-    , randomizer_{ }
-    , bitGenerator_{ }
+    , random_{ }
+    , waitingForKey_{ false }
+    , idleCycles_{ 0 }
+    , flags_{ }
+    , trace_{ }
 {
     resetRegisters();
 }
 
 /// @brief Destroy a CPU instance.
-CpuImpl::~CpuImpl()
+template<typename TRACE, typename DEVICES, typename MODE>
+CpuCore<TRACE, DEVICES, MODE>::~CpuCore()
 {
 }
 
 /// @brief Reset cpu.
 ///
 /// Reset CPU states, such as program counter and registers.
-void CpuImpl::reset()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::reset()
 {
     resetRegisters();
 }
 
 /// @brief Update a cpu tick.
-void CpuImpl::update()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::update()
 {
-    opcode_ = memory_->load<opcode::Opcode>(regs_.pc);
+    step();
+}
 
-    regs_.pc += PC_INCR;
-    opcodeDecoder_.decode(opcode_);
+/// @brief Run cpu cycles.
+///
+/// @param cycles Count of cycles to run.
+/// @return Count of cycles ran.
+template<typename TRACE, typename DEVICES, typename MODE>
+uint32_t CpuCore<TRACE, DEVICES, MODE>::run(uint32_t cycles)
+{
+    for (uint32_t cycle = 0; cycle < cycles; ++cycle)
+    {
+        update();
 
-    updateTimer();
+        cycle += skipIdleLoop(cycles - cycle - 1);
+    }
+
+    return cycles;
 }
 
-/// @brief Update timer.
-void CpuImpl::updateTimer()
+/// @brief Fast-forward an idle loop the last jump closed.
+///
+/// Recognizes three loops from the decoded instructions at the jump target:
+///
+///     LD Vx, DT; SE/SNE Vx, kk; JP loop    waiting on the delay timer
+///     SKP/SKNP Vx; JP loop                 waiting on a key
+///     JP loop                              halted, jumping to itself
+///
+/// Timers and keys only change between runs, on scheduler events, so when
+/// the loop just ran a whole iteration without leaving, every iteration
+/// left in the run repeats it exactly.  Those are skipped, the remaining
+/// partial iteration runs as usual so the final state is unchanged.
+///
+/// @param remaining Cycles left in the run.
+/// @return Cycles skipped.
+template<typename TRACE, typename DEVICES, typename MODE>
+uint32_t CpuCore<TRACE, DEVICES, MODE>::fastForwardIdleLoop(uint32_t remaining)
 {
-    uint32_t delayTimerElapsed = tick_ - delayTimerTick_;
+    uint16_t head = regs_.pc;
 
-    if (delayTimerElapsed >= DELAY_TIMER_TICK_DURATION && regs_.dt > 0)
+    if ((head & 0x1) != 0 || head > MemoryType::MEMORY_SIZE - 3 * PC_INCR)
     {
-        --regs_.dt;
+        return 0;
     }
 
-    uint32_t soundTimerElapsed = tick_ - soundTimerTick_;
+    auto const& first = opcodeDecoder_.fetch(head);
+    auto const& second = opcodeDecoder_.fetch(head + PC_INCR);
+    uint32_t length = 0;
 
-    if (soundTimerElapsed >= SOUND_TIMER_TICK_DURATION && regs_.st > 0)
+    if (&first == instruction_)
+    {
+        length = 1;
+    }
+    else if (first.func == &CpuCore::opcodeLoadRegisterFromDelayTimer)
+    {
+        auto const& third = opcodeDecoder_.fetch(head + 2 * PC_INCR);
+        bool equals = (regs_.vx[first.x] == second.kk);
+
+        if (&third == instruction_ && second.x == first.x && regs_.vx[first.x] == regs_.dt &&
+            ((second.func == &CpuCore::opcodeSkipNextIfEquals && !equals) ||
+             (second.func == &CpuCore::opcodeSkipNextIfNotEquals && equals)))
+        {
+            length = 3;
+        }
+    }
+    else if (&second == instruction_)
+    {
+        bool pressed = keyboard_->isKeyPressed(regs_.vx[first.x]);
+
+        if ((first.func == &CpuCore::opcodeSkipNextIfKeyEqualsRegister && !pressed) ||
+            (first.func == &CpuCore::opcodeSkipNextIfKeyNotEqualsRegister && pressed))
+        {
+            length = 2;
+        }
+    }
+
+    uint32_t skipped = (length != 0) ? (remaining / length) * length : 0;
+    idleCycles_ += skipped;
+
+    return skipped;
+}
+
+/// @brief Tick delay and sound timers once.
+///
+/// Called by the scheduler at the 60 Hz timer rate.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::tickTimers()
+{
+    if (regs_.dt > 0)
+    {
+        --regs_.dt;
+    }
+
+    if (regs_.st > 0)
     {
         --regs_.st;
     }
 }
 
+/// @brief Restore a CPU state.
+///
+/// @param state State from getState(), of this or another CPU.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::setState(State const& state)
+{
+    regs_ = state.regs;
+    random_ = state.random;
+    waitingForKey_ = false;
+}
+
 /// @brief Reset CPU registers
-void CpuImpl::resetRegisters()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::resetRegisters()
 {
     regs_.pc = PROGRAM_START;
     std::fill(regs_.vx, regs_.vx + sizeof(regs_.vx), 0);
@@ -176,24 +355,25 @@ void CpuImpl::resetRegisters()
     regs_.i  = 0;
     regs_.dt = 0;
     regs_.st = 0;
+
+    waitingForKey_ = false;
 }
 
 /// @brief Clear display.
 ///
 /// Opcode 00E0 (CLS)
-void CpuImpl::opcodeClearDisplay()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeClearDisplay()
 {
-    CpuTrace trace(tracesEnabled_, this, opcode_, CpuTrace::NONE);
     gpu_->clearFrame();
 }
 
 /// @brief Return from subroutine.
 ///
 /// Opcode 00EE (RET)
-void CpuImpl::opcodeReturn()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeReturn()
 {
-    CpuTrace trace(tracesEnabled_, this, opcode_, CpuTrace::PC | CpuTrace::SP | CpuTrace::STACK);
-
     if (regs_.sp > 0)
     {
         --regs_.sp;
@@ -205,81 +385,80 @@ void CpuImpl::opcodeReturn()
 /// @brief Jump to location.
 ///
 /// Opcode 1NNN (jp addr)
-void CpuImpl::opcodeJump()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeJump()
 {
-    auto op = opcode::decode1NNN(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::PC);
+    auto const& op = *instruction_;
 
     regs_.pc = op.nnn;
 }
 
-/// @brief Return from subroutine.
+/// @brief Call subroutine.
 ///
 /// Opcode 2NNN (call addr)
-void CpuImpl::opcodeCall()
+///
+/// A call on a full stack replaces the deepest return address, as a return
+/// on an empty stack stays at the bottom.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeCall()
 {
-    auto op = opcode::decode2NNN(opcode_);
+    auto const& op = *instruction_;
+    uint8_t level = std::min<uint8_t>(regs_.sp, STACK_SIZE - 1);
 
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::PC | CpuTrace::SP | CpuTrace::STACK);
-
-    regs_.stack[regs_.sp++] = regs_.pc;
+    regs_.stack[level] = regs_.pc;
+    regs_.sp = level + 1;
     regs_.pc = op.nnn;
 }
 
 /// @brief Skip next opcode if equals byte.
 ///
 /// Opcode 3XKK (se Vx,byte)
-void CpuImpl::opcodeSkipNextIfEquals()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSkipNextIfEquals()
 {
-    auto op = opcode::decode3XKK(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::PC | CpuTrace::VX);
+    auto const& op = *instruction_;
 
     if (regs_.vx[op.x] == op.kk)
     {
-        regs_.pc += 2;
+        skipNext();
     }
 }
 
 /// @brief Skip next opcode if not equals byte.
 ///
 /// Opcode 4XKK (sne Vx,byte)
-void CpuImpl::opcodeSkipNextIfNotEquals()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSkipNextIfNotEquals()
 {
-    auto op = opcode::decode4XKK(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::PC | CpuTrace::VX);
+    auto const& op = *instruction_;
 
     if (regs_.vx[op.x] != op.kk)
     {
-        regs_.pc += 2;
+        skipNext();
     }
 }
 
 /// @brief Skip next opcode if Vx register equals Vy register.
 ///
 /// Opcode 5YX0 (se Vx,Vy)
-void CpuImpl::opcodeSkipNextIfEqualsRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSkipNextIfEqualsRegister()
 {
-    auto op = opcode::decode5XY0(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::PC | CpuTrace::VX);
+    auto const& op = *instruction_;
 
     if (regs_.vx[op.x] == regs_.vx[op.y])
     {
-        regs_.pc += 2;
+        skipNext();
     }
 }
 
 /// @brief Load a number to register Vx
 ///
 /// Opcode 6xkk (LD Vx,byte)
-void CpuImpl::opcodeLoadNumber()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadNumber()
 {
-    auto op = opcode::decode6XKK(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     regs_.vx[op.x] = op.kk;
 }
@@ -287,11 +466,10 @@ void CpuImpl::opcodeLoadNumber()
 /// @brief Add a number to register Vx
 ///
 /// Opcode 7xkk (ADD Vx,byte)
-void CpuImpl::opcodeAddNumber()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeAddNumber()
 {
-    auto op = opcode::decode7XKK(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     regs_.vx[op.x] += op.kk;
 }
@@ -299,11 +477,10 @@ void CpuImpl::opcodeAddNumber()
 /// @brief Load register Vy to register Vx
 ///
 /// Opcode 8xy0 (LD Vx,Vy)
-void CpuImpl::opcodeLoadRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadRegister()
 {
-    auto op = opcode::decode8XY0(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     regs_.vx[op.x] = regs_.vx[op.y];
 }
@@ -311,11 +488,10 @@ void CpuImpl::opcodeLoadRegister()
 /// @brief Or register Vy to register Vx
 ///
 /// Opcode 8xy1 (OR Vx,Vy)
-void CpuImpl::opcodeOrRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeOrRegister()
 {
-    auto op = opcode::decode8XY1(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     regs_.vx[op.x] |= regs_.vx[op.y];
 }
@@ -323,11 +499,10 @@ void CpuImpl::opcodeOrRegister()
 /// @brief And register Vy to register Vx
 ///
 /// Opcode 8xy2 (AND Vx,Vy)
-void CpuImpl::opcodeAndRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeAndRegister()
 {
-    auto op = opcode::decode8XY2(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     regs_.vx[op.x] &= regs_.vx[op.y];
 }
@@ -335,11 +510,10 @@ void CpuImpl::opcodeAndRegister()
 /// @brief Xor register Vy to register Vx
 ///
 /// Opcode 8xy3 (XOR Vx,Vy)
-void CpuImpl::opcodeXorRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeXorRegister()
 {
-    auto op = opcode::decode8XY3(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     regs_.vx[op.x] ^= regs_.vx[op.y];
 }
@@ -347,11 +521,10 @@ void CpuImpl::opcodeXorRegister()
 /// @brief Add register Vy to register Vx
 ///
 /// Opcode 8xy4 (ADD Vx,Vy)
-void CpuImpl::opcodeAddRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeAddRegister()
 {
-    auto op = opcode::decode8XY4(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     uint16_t sum = regs_.vx[op.x] + regs_.vx[op.y];
 
@@ -362,11 +535,10 @@ void CpuImpl::opcodeAddRegister()
 /// @brief Sub register Vy to register Vx
 ///
 /// Opcode 8xy5 (SUB Vx,Vy)
-void CpuImpl::opcodeSubRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSubRegister()
 {
-    auto op = opcode::decode8XY5(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     uint16_t difference = regs_.vx[op.x] - regs_.vx[op.y];
 
@@ -377,11 +549,10 @@ void CpuImpl::opcodeSubRegister()
 /// @brief Shift right register Vy to register Vx
 ///
 /// Opcode 8xy6 (SHR Vx,Vy)
-void CpuImpl::opcodeShrRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeShrRegister()
 {
-    auto op = opcode::decode8XY6(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     regs_.vx[0xF] = regs_.vx[op.y] & 0x1;
     regs_.vx[op.x] = regs_.vx[op.y] >> 1;
@@ -390,11 +561,10 @@ void CpuImpl::opcodeShrRegister()
 /// @brief Sub reverse register Vx to register Vy
 ///
 /// Opcode 8xy7 (SUBN Vx,Vy)
-void CpuImpl::opcodeSubnRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSubnRegister()
 {
-    auto op = opcode::decode8XY7(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     uint16_t difference = regs_.vx[op.y] - regs_.vx[op.x];
 
@@ -405,11 +575,10 @@ void CpuImpl::opcodeSubnRegister()
 /// @brief Shift left register Vy to register Vx
 ///
 /// Opcode 8xyE (SHL Vx,Vy)
-void CpuImpl::opcodeShlRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeShlRegister()
 {
-    auto op = opcode::decode8XY6(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     regs_.vx[0xF] = regs_.vx[op.y] & 0x80;
     regs_.vx[op.x] = regs_.vx[op.y] << 1;
@@ -418,26 +587,24 @@ void CpuImpl::opcodeShlRegister()
 /// @brief Skip next opcode if Vx not equals Vy.
 ///
 /// Opcode 9XY0 (sne Vx,Vy)
-void CpuImpl::opcodeSkipNextIfNotEqualsRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSkipNextIfNotEqualsRegister()
 {
-    auto op = opcode::decode9XY0(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
+    auto const& op = *instruction_;
 
     if (regs_.vx[op.x] != regs_.vx[op.y])
     {
-        regs_.pc += 2;
+        skipNext();
     }
 }
 
 /// @brief Load I register with 12-bit address
 ///
 /// Opcode Annn (LD I,addr)
-void CpuImpl::opcodeLoadIRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadIRegister()
 {
-    auto op = opcode::decodeANNN(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::I);
+    auto const& op = *instruction_;
 
     regs_.i = op.nnn;
 }
@@ -445,11 +612,10 @@ void CpuImpl::opcodeLoadIRegister()
 /// @brief Jump to address with offset.
 ///
 /// Opcode BNNN (JP V0,nnn)
-void CpuImpl::opcodeJumpOffset()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeJumpOffset()
 {
-    auto op = opcode::decodeBNNN(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::PC | CpuTrace::VX);
+    auto const& op = *instruction_;
 
     regs_.pc = op.nnn + regs_.vx[0];
 }
@@ -457,77 +623,120 @@ void CpuImpl::opcodeJumpOffset()
 /// @brief Random number at register Vx.
 ///
 /// Opcode Cxkk (RND Vx,byte)
-void CpuImpl::opcodeRandomNumber()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeRandomNumber()
 {
-    auto op = opcode::decodeCXKK(opcode_);
+    auto const& op = *instruction_;
 
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX);
-
-    uint8_t number = randomizer_(bitGenerator_);
+    uint8_t number = random_.next();
 
     regs_.vx[op.x] = number & op.kk;
 }
 
 /// @brief Draw sprite to gpu framebuffer.
 ///
+/// An extended machine reads N rows for each selected plane, and draws a
+/// 16x16 sprite for DXY0.
+///
 /// Opcode Dxyn (DRW Vx,Vy,nibble)
-void CpuImpl::opcodeDraw()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeDraw()
 {
-    auto op = opcode::decodeDXYN(opcode_);
+    auto const& op = *instruction_;
 
-    auto sprite = Memory::Bytes{};
+    if constexpr (MODE::EXTENDED)
+    {
+        size_t planes = gpu_->framebuffer().getSelectedPlaneCount();
 
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::I | CpuTrace::VX);
+        if (op.n == 0)
+        {
+            auto sprite = Sprite{ memory_->data(), memory_->getSize(), regs_.i, 32 * planes };
 
-    for (size_t offset = 0; offset < op.n; ++offset)
-    {
-        sprite.push_back(memory_->load<uint8_t>(regs_.i + offset));
-    }
+            if (gpu_->drawLargeSprite(regs_.vx[op.x], regs_.vx[op.y], sprite))
+            {
+                regs_.vx[0xF] = 0x1;
+            }
+
+            return;
+        }
 
-    if (gpu_->drawSprite(regs_.vx[op.x], regs_.vx[op.y], sprite))
+        auto sprite = Sprite{ memory_->data(), memory_->getSize(), regs_.i, op.n * planes };
+
+        if (gpu_->drawSprite(regs_.vx[op.x], regs_.vx[op.y], sprite))
+        {
+            regs_.vx[0xF] = 0x1;
+        }
+    }
+    else
     {
-        regs_.vx[0xF] = 0x1;
+        // Rows are read from memory, no copy
+        auto sprite = Sprite{ memory_->data(), memory_->getSize(), regs_.i, op.n };
+
+        if (gpu_->drawSprite(regs_.vx[op.x], regs_.vx[op.y], sprite))
+        {
+            regs_.vx[0xF] = 0x1;
+        }
     }
 }
 
 /// @brief Skip next instruction if key equals Vx value.
 ///
 /// Opcode Ex9E (SKP Vx)
-void CpuImpl::opcodeSkipNextIfKeyEqualsRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSkipNextIfKeyEqualsRegister()
 {
-    auto op = opcode::decodeEX9E(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::PC | CpuTrace::VX);
+    auto const& op = *instruction_;
 
     if (keyboard_->isKeyPressed(regs_.vx[op.x]))
     {
-        regs_.pc += 2;
+        skipNext();
     }
 }
 
 /// @brief Skip next instruction if key not equals Vx value.
 ///
 /// Opcode ExA1 (SKNP Vx)
-void CpuImpl::opcodeSkipNextIfKeyNotEqualsRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSkipNextIfKeyNotEqualsRegister()
 {
-    auto op = opcode::decodeEXA1(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::PC | CpuTrace::VX);
+    auto const& op = *instruction_;
 
     if (!keyboard_->isKeyPressed(regs_.vx[op.x]))
     {
-        regs_.pc += 2;
+        skipNext();
     }
 }
 
+/// @brief Wait for a key press and load the key in Vx.
+///
+/// Without a pressed key the program counter stays on this instruction
+/// and the CPU parks, runs then skip their cycles until a key is pressed.
+///
+/// Opcode Fx0A (LD Vx, K)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadRegisterWithKey()
+{
+    auto const& op = *instruction_;
+    uint16_t keys = keyboard_->getKeys();
+
+    if (keys != 0)
+    {
+        regs_.vx[op.x] = __builtin_ctz(keys);
+        waitingForKey_ = false;
+        return;
+    }
+
+    regs_.pc -= PC_INCR;
+    waitingForKey_ = true;
+}
+
 /// @brief Load delay timer from register.
 ///
 /// Opcode Fx15 (LD DT,Vx)
-void CpuImpl::opcodeLoadDelayTimerFromRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadDelayTimerFromRegister()
 {
-    auto op = opcode::decodeFX15(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX | CpuTrace::DT);
+    auto const& op = *instruction_;
 
     regs_.dt = regs_.vx[op.x];
 }
@@ -535,11 +744,10 @@ void CpuImpl::opcodeLoadDelayTimerFromRegister()
 /// @brief Load register from delay timer.
 ///
 /// Opcode Fx07 (LD Vx,DT)
-void CpuImpl::opcodeLoadRegisterFromDelayTimer()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadRegisterFromDelayTimer()
 {
-    auto op = opcode::decodeFX07(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX | CpuTrace::DT);
+    auto const& op = *instruction_;
 
     regs_.vx[op.x] = regs_.dt;
 }
@@ -547,11 +755,10 @@ void CpuImpl::opcodeLoadRegisterFromDelayTimer()
 /// @brief Load sound timer from register.
 ///
 /// Opcode Fx18 (LD ST,Vx)
-void CpuImpl::opcodeLoadSoundTimerFromRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadSoundTimerFromRegister()
 {
-    auto op = opcode::decodeFX18(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::VX | CpuTrace::ST);
+    auto const& op = *instruction_;
 
     regs_.st = regs_.vx[op.x];
 }
@@ -559,11 +766,10 @@ void CpuImpl::opcodeLoadSoundTimerFromRegister()
 /// @brief Add Vx to I register.
 ///
 /// Opcode Fx1E (ADD I, Vx)
-void CpuImpl::opcodeAddIRegister()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeAddIRegister()
 {
-    auto op = opcode::decodeFX1E(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::I | CpuTrace::VX);
+    auto const& op = *instruction_;
 
     regs_.i += regs_.vx[op.x];
 }
@@ -571,11 +777,10 @@ void CpuImpl::opcodeAddIRegister()
 /// @brief Load I register with font address.
 ///
 /// Opcode Fx29 (LD F, Vx)
-void CpuImpl::opcodeLoadIRegisterWithAddress()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadIRegisterWithAddress()
 {
-    auto op = opcode::decodeFX29(opcode_);
-
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::I | CpuTrace::VX);
+    auto const& op = *instruction_;
 
     auto font = regs_.vx[op.x];
 
@@ -585,52 +790,346 @@ void CpuImpl::opcodeLoadIRegisterWithAddress()
 /// @brief Store binary coded decimal from Vx.
 ///
 /// Opcode Fx33 (LD B, Vx)
-void CpuImpl::opcodeStoreBinaryCodedDecimal()
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeStoreBinaryCodedDecimal()
 {
-    const uint16_t MAX_ADDRESS_OFFSET = 3;
+    auto const& op = *instruction_;
 
-    auto op = opcode::decodeFX33(opcode_);
+    auto const& digits = BCD_TABLE[regs_.vx[op.x]];
 
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::I | CpuTrace::VX);
+    memory_->storeRange(regs_.i, digits.data(), digits.size());
+}
 
-    auto address = regs_.i;
-    auto data = regs_.vx[op.x];
+/// @brief Store registers V0 to Vx starting at address in I.
+///
+/// Opcode Fx55 (LD [I], Vx)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeStoreRegistersWithAddress()
+{
+    auto const& op = *instruction_;
+
+    memory_->storeRange(regs_.i, regs_.vx, op.x + 1);
+    regs_.i += op.x + 1;
+}
 
-    for (size_t index = 0; index < MAX_ADDRESS_OFFSET; ++index)
+/// @brief Load registers V0 to Vx from starting address in I.
+///
+/// Opcode Fx65 (LD Vx, [I])
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadRegistersWithAddress()
+{
+    auto const& op = *instruction_;
+
+    memory_->loadRange(regs_.i, regs_.vx, op.x + 1);
+    regs_.i += op.x + 1;
+}
+
+/// @brief Scroll the display down N rows.
+///
+/// Opcode 00CN (SCD nibble)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeScrollDown()
+{
+    if constexpr (MODE::EXTENDED)
     {
-        memory_->store(address + (MAX_ADDRESS_OFFSET - index - 1), (data % 10));
-        data /= 10;
+        gpu_->scrollDown(instruction_->n);
     }
 }
 
-/// @brief Store registers V0 to Vx starting at address in I.
+/// @brief Scroll the display up N rows.
 ///
-/// Opcode Fx55 (LD [I], Vx)
-void CpuImpl::opcodeStoreRegistersWithAddress()
+/// Opcode 00DN (SCU nibble)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeScrollUp()
 {
-    auto op = opcode::decodeFX55(opcode_);
+    if constexpr (MODE::EXTENDED)
+    {
+        gpu_->scrollUp(instruction_->n);
+    }
+}
 
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::I | CpuTrace::VX);
+/// @brief Scroll the display right 4 pixels.
+///
+/// Opcode 00FB (SCR)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeScrollRight()
+{
+    if constexpr (MODE::EXTENDED)
+    {
+        gpu_->scrollRight();
+    }
+}
 
-    for (uint16_t index = 0; index <= op.x; ++index)
+/// @brief Scroll the display left 4 pixels.
+///
+/// Opcode 00FC (SCL)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeScrollLeft()
+{
+    if constexpr (MODE::EXTENDED)
     {
-        memory_->store(regs_.i++, regs_.vx[index]);
+        gpu_->scrollLeft();
     }
 }
 
-/// @brief Load registers V0 to Vx from starting address in I.
+/// @brief Exit the interpreter.
 ///
-/// Opcode Fx65 (LD Vx, [I])
-void CpuImpl::opcodeLoadRegistersWithAddress()
+/// The program counter stays on this instruction, so the machine idles
+/// until it is stopped.
+///
+/// Opcode 00FD (EXIT)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeExit()
+{
+    regs_.pc -= PC_INCR;
+}
+
+/// @brief Switch the display to low resolution.
+///
+/// Opcode 00FE (LOW)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLowResolution()
+{
+    if constexpr (MODE::EXTENDED)
+    {
+        gpu_->setHighResolution(false);
+    }
+}
+
+/// @brief Switch the display to high resolution.
+///
+/// Opcode 00FF (HIGH)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeHighResolution()
+{
+    if constexpr (MODE::EXTENDED)
+    {
+        gpu_->setHighResolution(true);
+    }
+}
+
+/// @brief Store registers Vx to Vy, in either order, at address in I.
+///
+/// I is left unchanged.
+///
+/// Opcode 5XY2 (SAVE Vx - Vy)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeStoreRegisterRange()
+{
+    auto const& op = *instruction_;
+
+    int step = (op.x <= op.y) ? 1 : -1;
+    size_t count = std::abs(op.y - op.x) + 1;
+    uint8_t bytes[REG_COUNT];
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        bytes[index] = regs_.vx[op.x + step * static_cast<int>(index)];
+    }
+
+    memory_->storeRange(regs_.i, bytes, count);
+}
+
+/// @brief Load registers Vx to Vy, in either order, from address in I.
+///
+/// I is left unchanged.
+///
+/// Opcode 5XY3 (LOAD Vx - Vy)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadRegisterRange()
+{
+    auto const& op = *instruction_;
+
+    int step = (op.x <= op.y) ? 1 : -1;
+    size_t count = std::abs(op.y - op.x) + 1;
+    uint8_t bytes[REG_COUNT];
+
+    memory_->loadRange(regs_.i, bytes, count);
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        regs_.vx[op.x + step * static_cast<int>(index)] = bytes[index];
+    }
+}
+
+/// @brief Load I register with the 16-bit address in the next word.
+///
+/// Opcode F000 NNNN (LD I, long addr)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadIRegisterWithLongAddress()
+{
+    regs_.i = memory_->template load<uint16_t>(regs_.pc);
+    regs_.pc += PC_INCR;
+}
+
+/// @brief Select the display planes drawn, scrolled and cleared.
+///
+/// Opcode FN01 (PLANE n)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSelectPlanes()
+{
+    if constexpr (MODE::EXTENDED)
+    {
+        gpu_->selectPlanes(instruction_->x);
+    }
+}
+
+/// @brief Load I register with large font address.
+///
+/// The 10-byte digits follow the small font in memory.
+///
+/// Opcode Fx30 (LD HF, Vx)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadIRegisterWithLargeFont()
 {
-    auto op = opcode::decodeFX65(opcode_);
+    auto const& op = *instruction_;
 
-    CpuTrace trace(tracesEnabled_, this, opcode_, op, CpuTrace::I | CpuTrace::VX);
+    regs_.i = FONT_SET_SIZE + (regs_.vx[op.x] & 0xF) * BIG_FONT_SIZE;
+}
+
+/// @brief Store registers V0 to Vx in the flag registers.
+///
+/// Opcode Fx75 (LD R, Vx)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeStoreFlags()
+{
+    auto const& op = *instruction_;
+
+    std::copy_n(regs_.vx, op.x + 1, flags_);
+}
+
+/// @brief Load registers V0 to Vx from the flag registers.
+///
+/// Opcode Fx85 (LD Vx, R)
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeLoadFlags()
+{
+    auto const& op = *instruction_;
+
+    std::copy_n(flags_, op.x + 1, regs_.vx);
+}
+
+/// @brief Add register Vy to register Vx, the carry is never read.
+///
+/// Opcode 8xy4 (ADD Vx,Vy), when VF is written again before it is read.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeAddRegisterWithoutFlag()
+{
+    auto const& op = *instruction_;
+
+    regs_.vx[op.x] += regs_.vx[op.y];
+}
+
+/// @brief Sub register Vy to register Vx, the borrow is never read.
+///
+/// Opcode 8xy5 (SUB Vx,Vy), when VF is written again before it is read.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSubRegisterWithoutFlag()
+{
+    auto const& op = *instruction_;
+
+    regs_.vx[op.x] -= regs_.vx[op.y];
+}
+
+/// @brief Shift right register Vy to register Vx, the bit out is never read.
+///
+/// Opcode 8xy6 (SHR Vx,Vy), when VF is written again before it is read.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeShrRegisterWithoutFlag()
+{
+    auto const& op = *instruction_;
+
+    regs_.vx[op.x] = regs_.vx[op.y] >> 1;
+}
+
+/// @brief Sub reverse register Vx to register Vy, the borrow is never read.
+///
+/// Opcode 8xy7 (SUBN Vx,Vy), when VF is written again before it is read.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeSubnRegisterWithoutFlag()
+{
+    auto const& op = *instruction_;
+
+    regs_.vx[op.x] = regs_.vx[op.y] - regs_.vx[op.x];
+}
+
+/// @brief Shift left register Vy to register Vx, the bit out is never read.
+///
+/// Opcode 8xyE (SHL Vx,Vy), when VF is written again before it is read.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeShlRegisterWithoutFlag()
+{
+    auto const& op = *instruction_;
+
+    regs_.vx[op.x] = regs_.vx[op.y] << 1;
+}
+
+/// @brief Ignore an unknown opcode.
+///
+/// Threaded blocks run it in place of a null handler, so they call every
+/// handler without checking.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeNoOperation()
+{
+}
+
+/// @brief Run one iteration of a counted loop.
+///
+/// The superinstruction always retires three instructions.  The last
+/// iteration skips the jump, so the instruction after the loop runs in
+/// its cycle.
+///
+/// Superinstruction 7xkk 3xnn 1nnn, `kk` is the step, `y` the final count
+/// and `nnn` the loop start.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeCountedLoop()
+{
+    auto const& op = *instruction_;
 
-    for (uint16_t index = 0; index <= op.x; ++index)
+    regs_.vx[op.x] += op.kk;
+
+    if (regs_.vx[op.x] != op.y)
     {
-        regs_.vx[index] = memory_->load<uint8_t>(regs_.i++);
+        regs_.pc = op.nnn;
+        return;
     }
+
+    regs_.pc += 2 * PC_INCR;
+    CpuCore::update();
 }
 
+/// @brief Store the binary coded decimal of Vx, then load registers from I.
+///
+/// When the digits overwrite the load itself, it is decoded again and run
+/// as written.
+///
+/// Superinstruction Fx33 Fy65, `y` is the last register loaded.
+template<typename TRACE, typename DEVICES, typename MODE>
+void CpuCore<TRACE, DEVICES, MODE>::opcodeStoreAndLoadBinaryCodedDecimal()
+{
+    auto const& op = *instruction_;
+    auto const& digits = BCD_TABLE[regs_.vx[op.x]];
+    uint16_t load = regs_.pc;
+
+    memory_->storeRange(regs_.i, digits.data(), digits.size());
+
+    uint16_t offset = (load - regs_.i) & MemoryType::ADDRESS_MASK;
+
+    if (offset < digits.size() || offset == MemoryType::ADDRESS_MASK)
+    {
+        CpuCore::update();
+        return;
+    }
+
+    regs_.pc += PC_INCR;
+    memory_->loadRange(regs_.i, regs_.vx, op.y + 1);
+    regs_.i += op.y + 1;
+}
+
+template class CpuCore<NoTrace>;
+template class CpuCore<RingBufferTrace>;
+template class CpuCore<HotspotProfile>;
+template class CpuCore<NoTrace, HeadlessDevices>;
+template class CpuCore<NoTrace, ExtendedDevices, ExtendedMode>;
+
 } // namespace chip8
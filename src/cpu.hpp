@@ -24,16 +24,23 @@
 #ifndef CHIP8_CPU_HPP
 #define CHIP8_CPU_HPP
 
-#include <random>
-#include <unordered_map>
+#include <array>
 #include <core.hpp>
+#include <cpu_profile.hpp>
+#include <cpu_trace.hpp>
+#include <machine_mode.hpp>
+#include <memory.hpp>
 #include <opcode.hpp>
+#include <opcode_table.hpp>
+#include <random.hpp>
 
 namespace chip8 {
 
-class Memory;
 class Gpu;
 class Keyboard;
+class HeadlessGpu;
+class HeadlessExtendedGpu;
+class HeadlessKeyboard;
 
 /// @brief Represent a CHIP-8 CPU.
 class Cpu
@@ -70,60 +77,287 @@ class Cpu
             uint8_t  st;
         };
 
+        /// @brief Complete CPU state, to snapshot and restore a machine.
+        struct State
+        {
+            /// @brief Register context.
+            RegContext regs;
+            /// @brief Random number generator of CXKK.
+            Random     random;
+        };
+
         virtual ~Cpu() {}
 
-        virtual void tick(uint32_t tick) = 0;
         virtual void reset() = 0;
         virtual void update() = 0;
+        virtual uint32_t run(uint32_t cycles) = 0;
+        virtual void tickTimers() = 0;
 
         virtual void enableTraces() = 0;
         virtual void disableTraces() = 0;
         virtual RegContext const& getRegContext() const = 0;
         virtual opcode::Opcode    getOpcode() const = 0;
+        virtual bool              isWaitingForKey() const = 0;
+
+        virtual State getState() const = 0;
+        virtual void  setState(State const& state) = 0;
+};
+
+/// @brief Device policy reaching the devices through their interfaces.
+struct VirtualDevices
+{
+    using GpuType      = Gpu;
+    using KeyboardType = Keyboard;
+};
+
+/// @brief Device policy of headless machines.
+///
+/// The headless devices are final classes with inline members, so the CPU
+/// calls them directly and the compiler inlines them.
+struct HeadlessDevices
+{
+    using GpuType      = HeadlessGpu;
+    using KeyboardType = HeadlessKeyboard;
+};
+
+/// @brief Device policy of headless SUPER-CHIP and XO-CHIP machines.
+struct ExtendedDevices
+{
+    using GpuType      = HeadlessExtendedGpu;
+    using KeyboardType = HeadlessKeyboard;
 };
 
 /// @brief Represent a CHIP-8 CPU implementation.
-class CpuImpl : public Cpu
+///
+/// The trace policy is a template parameter so that the untraced core,
+/// `CpuImpl`, compiles tracing out entirely.  The device policy gives the
+/// static types of the GPU and keyboard, so a core over concrete devices
+/// makes no virtual calls to them.  The machine mode chooses the memory
+/// size and whether the SUPER-CHIP and XO-CHIP instructions are decoded,
+/// at compile time, so the classic core keeps its small layout.  The cores
+/// are explicitly instantiated in cpu.cpp.
+///
+/// @tparam TRACE   Trace policy, `NoTrace`, `RingBufferTrace` or `HotspotProfile`.
+/// @tparam DEVICES Device policy, `VirtualDevices`, `HeadlessDevices` or `ExtendedDevices`.
+/// @tparam MODE    Machine mode, `ClassicMode` or `ExtendedMode`.
+template<typename TRACE, typename DEVICES = VirtualDevices, typename MODE = ClassicMode>
+class CpuCore : public Cpu
 {
     public:
-        CpuImpl(std::shared_ptr<Memory> memory,
-                std::shared_ptr<Keyboard> keyboard,
-                std::shared_ptr<Gpu> gpu);
-        ~CpuImpl();
+        /// @brief Memory type.
+        using MemoryType = BasicMemory<MODE>;
+        /// @brief GPU type.
+        using GpuType = typename DEVICES::GpuType;
+        /// @brief Keyboard type.
+        using KeyboardType = typename DEVICES::KeyboardType;
+
+        /// @brief Count of SUPER-CHIP and XO-CHIP flag registers.
+        static constexpr uint8_t FLAG_COUNT = 16;
+
+        CpuCore(std::shared_ptr<MemoryType> memory,
+                std::shared_ptr<KeyboardType> keyboard,
+                std::shared_ptr<GpuType> gpu);
+        ~CpuCore();
 
-        virtual void tick(uint32_t tick) override { tick_ = tick; }
         virtual void reset() override;
         virtual void update() override;
+        virtual uint32_t run(uint32_t cycles) override;
+        virtual void tickTimers() override;
 
-        void enableTraces() override { tracesEnabled_ = true; }
-        void disableTraces() override { tracesEnabled_ = false; }
+        void enableTraces() override { trace_.enable(true); }
+        void disableTraces() override { trace_.enable(false); }
         RegContext const& getRegContext() const override { return regs_; }
         opcode::Opcode getOpcode() const override { return opcode_; }
+        bool isWaitingForKey() const override { return waitingForKey_; }
+
+        State getState() const override { return State{ regs_, random_ }; }
+        void  setState(State const& state) override;
+
+        /// @brief Replace the register context, e.g. to resume a machine.
+        void setRegContext(RegContext const& regs) { regs_ = regs; waitingForKey_ = false; }
+        /// @brief Seed the random number generator of CXKK.
+        void seedRandom(uint32_t seed) { random_.seed(seed); }
 
-    private:
+        /// @brief Return the trace recorder.
+        TRACE const& getTrace() const { return trace_; }
+
+        /// @brief Return the count of cycles skipped in idle loops.
+        uint64_t getIdleCycles() const { return idleCycles_; }
+
+    protected:
         void resetRegisters();
 
-        /// @brief An opcode decoder.
-        class OpcodeDecoder
+        using InstructionFunc = void (CpuCore::*)();
+
+        /// @brief Pre-decoded instruction.
+        ///
+        /// A superinstruction packs the operands of the instructions it fuses
+        /// in the fields the first one leaves unused, as its handler documents.
+        struct Instruction
+        {
+            /// @brief Handler, null for unknown opcodes.
+            InstructionFunc func;
+            /// @brief Raw opcode.
+            opcode::Opcode  opcode;
+            /// @brief Address operand.
+            uint16_t        nnn;
+            /// @brief Vx register operand.
+            uint8_t         x;
+            /// @brief Vy register operand.
+            uint8_t         y;
+            /// @brief Nibble operand.
+            uint8_t         n;
+            /// @brief Byte operand.
+            uint8_t         kk;
+        };
+
+        /// @brief An opcode decoder caching decoded instructions.
+        ///
+        /// Holds one slot per even address.  A slot is decoded on its first
+        /// fetch and invalidated when memory is written at its address, so
+        /// unchanged code is never decoded twice.  Odd addresses bypass the
+        /// cache.
+        class OpcodeDecoder : public MemoryType::WriteObserver
         {
             public:
                 OpcodeDecoder() = delete;
-                OpcodeDecoder(CpuImpl * cpu);
+                OpcodeDecoder(MemoryType & memory);
+                ~OpcodeDecoder();
+
+                /// @brief Fetch instruction.
+                ///
+                /// @param address Address of the instruction.
+                /// @return Decoded instruction.
+                Instruction const& fetch(uint16_t address)
+                {
+                    size_t slot = address >> 1;
+
+                    if ((address & 0x1) != 0 || slot >= SLOT_COUNT)
+                    {
+                        decode(memory_.template load<opcode::Opcode>(address), uncached_);
+                        return uncached_;
+                    }
+
+                    if (!valid_[slot])
+                    {
+                        decode(memory_.template load<opcode::Opcode>(address), slots_[slot]);
+                        valid_[slot] = true;
+                    }
 
-                void decode(opcode::Opcode opcode);
+                    return slots_[slot];
+                }
+
+                void onMemoryWrite(uint16_t address, size_t size) override;
 
             private:
-                using InstructionFunc = void (CpuImpl::*)();
-                using InstructionTable = std::unordered_map<opcode::Opcode, InstructionFunc>;
+                using InstructionTable = opcode::DispatchTable<InstructionFunc>;
+
+                /// @brief Cache slot count.
+                static constexpr size_t SLOT_COUNT = MemoryType::MEMORY_SIZE / 2;
+
+                static constexpr InstructionTable makeInstructionTable();
+                static void decode(opcode::Opcode opcode, Instruction & instruction);
 
                 /// @brief Opcode dispatch table.
                 static const InstructionTable INSTRUCTION_TABLE;
 
-                /// @brief Reference to cpu instance.
-                CpuImpl * cpu_;
+                /// @brief Reference to memory.
+                MemoryType & memory_;
+                /// @brief Decoded instruction slots.
+                std::array<Instruction, SLOT_COUNT> slots_;
+                /// @brief Slot valid flags.
+                std::array<bool, SLOT_COUNT> valid_;
+                /// @brief Instruction decoded outside of the cache.
+                Instruction uncached_;
         };
 
-        void updateTimer();
+        /// @brief Decode and run the instruction at the program counter.
+        ///
+        /// The body of update(), inline so that engines with their own run
+        /// loop call it directly.
+        void step()
+        {
+            instruction_ = &opcodeDecoder_.fetch(regs_.pc);
+            opcode_ = instruction_->opcode;
+
+            traceInstruction();
+
+            regs_.pc += PC_INCR;
+
+            if (instruction_->func != nullptr)
+            {
+                (this->*(instruction_->func))();
+            }
+
+            retireInstruction();
+        }
+
+        /// @brief Record the current instruction, before it runs.
+        void traceInstruction()
+        {
+            if constexpr (TRACE::ENABLED)
+            {
+                trace_.record(regs_, opcode_);
+            }
+        }
+
+        /// @brief Skip the cycles left of a run spent in an idle loop.
+        ///
+        /// Loops are only checked after a jump, so the common path costs two
+        /// compares.  A CPU parked on FX0A skips the whole run, the key is
+        /// checked again on the next one.  Traced cores run every cycle.
+        ///
+        /// @param remaining Cycles left in the run.
+        /// @return Cycles skipped, a whole count of loop iterations.
+        uint32_t skipIdleLoop(uint32_t remaining)
+        {
+            if constexpr (TRACE::ENABLED)
+            {
+                return 0;
+            }
+            else
+            {
+                if (instruction_->func == &CpuCore::opcodeJump)
+                {
+                    return fastForwardIdleLoop(remaining);
+                }
+
+                if (waitingForKey_)
+                {
+                    idleCycles_ += remaining;
+                    return remaining;
+                }
+
+                return 0;
+            }
+        }
+
+        uint32_t fastForwardIdleLoop(uint32_t remaining);
+
+        /// @brief Skip the next instruction.
+        ///
+        /// An extended machine skips both words of F000 NNNN.
+        void skipNext()
+        {
+            if constexpr (MODE::EXTENDED)
+            {
+                if (memory_->template load<opcode::Opcode>(regs_.pc) == opcode::OPCODE_F000)
+                {
+                    regs_.pc += PC_INCR;
+                }
+            }
+
+            regs_.pc += PC_INCR;
+        }
+
+        /// @brief Notify the trace policy that the current instruction ran.
+        void retireInstruction()
+        {
+            if constexpr (TRACE::ENABLED)
+            {
+                trace_.retire();
+            }
+        }
 
         void opcodeClearDisplay();
         void opcodeReturn();
@@ -150,6 +384,7 @@ class CpuImpl : public Cpu
         void opcodeDraw();
         void opcodeSkipNextIfKeyEqualsRegister();
         void opcodeSkipNextIfKeyNotEqualsRegister();
+        void opcodeLoadRegisterWithKey();
         void opcodeLoadDelayTimerFromRegister();
         void opcodeLoadRegisterFromDelayTimer();
         void opcodeLoadSoundTimerFromRegister();
@@ -159,34 +394,78 @@ class CpuImpl : public Cpu
         void opcodeStoreRegistersWithAddress();
         void opcodeLoadRegistersWithAddress();
 
+        void opcodeAddRegisterWithoutFlag();
+        void opcodeSubRegisterWithoutFlag();
+        void opcodeShrRegisterWithoutFlag();
+        void opcodeSubnRegisterWithoutFlag();
+        void opcodeShlRegisterWithoutFlag();
+
+        void opcodeNoOperation();
+        void opcodeCountedLoop();
+        void opcodeStoreAndLoadBinaryCodedDecimal();
+
+        void opcodeScrollDown();
+        void opcodeScrollUp();
+        void opcodeScrollRight();
+        void opcodeScrollLeft();
+        void opcodeExit();
+        void opcodeLowResolution();
+        void opcodeHighResolution();
+        void opcodeStoreRegisterRange();
+        void opcodeLoadRegisterRange();
+        void opcodeLoadIRegisterWithLongAddress();
+        void opcodeSelectPlanes();
+        void opcodeLoadIRegisterWithLargeFont();
+        void opcodeStoreFlags();
+        void opcodeLoadFlags();
+
         /// @brief Main memory instance.
-        std::shared_ptr<Memory> memory_;
+        std::shared_ptr<MemoryType> memory_;
         /// @brief Keyboard
-        std::shared_ptr<Keyboard> keyboard_;
+        std::shared_ptr<KeyboardType> keyboard_;
         /// @brief GPU display.
-        std::shared_ptr<Gpu> gpu_;
+        std::shared_ptr<GpuType> gpu_;
 
         /// @brief Register context.
         RegContext regs_;
         /// @brief Opcode decoder instance.
         OpcodeDecoder opcodeDecoder_;
+        /// @brief Current instruction.
+        Instruction const * instruction_;
         /// @brief Current opcode.
         opcode::Opcode opcode_;
-        /// @brief CPU tick
-        uint32_t tick_;
-        /// @brief Delay Timer tick
-        uint32_t delayTimerTick_;
-        /// @brief Sound Timer tick
-        uint32_t soundTimerTick_;
 
         /// @brief Random number generator.
-        std::uniform_int_distribution<uint8_t> randomizer_;
-        std::mt19937 bitGenerator_;
+        Random random_;
 
-        /// @brief Enable traces.
-        bool tracesEnabled_ = false;
+        /// @brief Parked on FX0A until a key is pressed.
+        bool waitingForKey_;
+        /// @brief Cycles skipped in idle loops.
+        uint64_t idleCycles_;
+        /// @brief SUPER-CHIP and XO-CHIP flag registers of FX75 and FX85.
+        uint8_t flags_[FLAG_COUNT];
+
+        /// @brief Trace recorder.
+        TRACE trace_;
 };
 
+extern template class CpuCore<NoTrace>;
+extern template class CpuCore<RingBufferTrace>;
+extern template class CpuCore<HotspotProfile>;
+extern template class CpuCore<NoTrace, HeadlessDevices>;
+extern template class CpuCore<NoTrace, ExtendedDevices, ExtendedMode>;
+
+/// @brief CPU implementation with tracing compiled out.
+using CpuImpl = CpuCore<NoTrace>;
+/// @brief CPU implementation recording a binary trace.
+using TracedCpu = CpuCore<RingBufferTrace>;
+/// @brief CPU implementation profiling instructions.
+using ProfiledCpu = CpuCore<HotspotProfile>;
+/// @brief CPU implementation over headless devices, with direct device calls.
+using HeadlessCpu = CpuCore<NoTrace, HeadlessDevices>;
+/// @brief SUPER-CHIP and XO-CHIP CPU implementation over headless devices.
+using ExtendedCpu = CpuCore<NoTrace, ExtendedDevices, ExtendedMode>;
+
 }  // chip8
 
 #endif  // CHIP8_CPU_HPP
@@ -0,0 +1,315 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <numeric>
+
+#include "cpu_profile.hpp"
+
+namespace chip8 {
+
+namespace {
+
+using ClassEntry = opcode::DispatchTable<uint8_t>::Entry;
+
+/// @brief Opcode classes, numbered from one.
+constexpr ClassEntry CLASS_ENTRIES[] = {
+    { opcode::OPCODE_00E0, 1 },
+    { opcode::OPCODE_00EE, 2 },
+    { opcode::OPCODE_1NNN, 3 },
+    { opcode::OPCODE_2NNN, 4 },
+    { opcode::OPCODE_3XKK, 5 },
+    { opcode::OPCODE_4XKK, 6 },
+    { opcode::OPCODE_5XY0, 7 },
+    { opcode::OPCODE_6XKK, 8 },
+    { opcode::OPCODE_7XKK, 9 },
+    { opcode::OPCODE_8XY0, 10 },
+    { opcode::OPCODE_8XY1, 11 },
+    { opcode::OPCODE_8XY2, 12 },
+    { opcode::OPCODE_8XY3, 13 },
+    { opcode::OPCODE_8XY4, 14 },
+    { opcode::OPCODE_8XY5, 15 },
+    { opcode::OPCODE_8XY6, 16 },
+    { opcode::OPCODE_8XY7, 17 },
+    { opcode::OPCODE_8XYE, 18 },
+    { opcode::OPCODE_9XY0, 19 },
+    { opcode::OPCODE_ANNN, 20 },
+    { opcode::OPCODE_BNNN, 21 },
+    { opcode::OPCODE_CXKK, 22 },
+    { opcode::OPCODE_DXYN, 23 },
+    { opcode::OPCODE_EX9E, 24 },
+    { opcode::OPCODE_EXA1, 25 },
+    { opcode::OPCODE_FX07, 26 },
+    { opcode::OPCODE_FX0A, 27 },
+    { opcode::OPCODE_FX15, 28 },
+    { opcode::OPCODE_FX18, 29 },
+    { opcode::OPCODE_FX1E, 30 },
+    { opcode::OPCODE_FX29, 31 },
+    { opcode::OPCODE_FX33, 32 },
+    { opcode::OPCODE_FX55, 33 },
+    { opcode::OPCODE_FX65, 34 }
+};
+
+/// @brief Opcode class names, by class.
+constexpr char const * CLASS_NAMES[] = {
+    "unknown",
+    "00E0 CLS",
+    "00EE RET",
+    "1NNN JP",
+    "2NNN CALL",
+    "3XKK SE",
+    "4XKK SNE",
+    "5XY0 SE",
+    "6XKK LD",
+    "7XKK ADD",
+    "8XY0 LD",
+    "8XY1 OR",
+    "8XY2 AND",
+    "8XY3 XOR",
+    "8XY4 ADD",
+    "8XY5 SUB",
+    "8XY6 SHR",
+    "8XY7 SUBN",
+    "8XYE SHL",
+    "9XY0 SNE",
+    "ANNN LD I",
+    "BNNN JP V0",
+    "CXKK RND",
+    "DXYN DRW",
+    "EX9E SKP",
+    "EXA1 SKNP",
+    "FX07 LD DT",
+    "FX0A LD K",
+    "FX15 LD DT",
+    "FX18 LD ST",
+    "FX1E ADD I",
+    "FX29 LD F",
+    "FX33 LD B",
+    "FX55 LD [I]",
+    "FX65 LD Vx"
+};
+
+static_assert(std::size(CLASS_NAMES) == HotspotProfile::CLASS_COUNT, "Every class has a name");
+static_assert(std::size(CLASS_ENTRIES) + 1 == HotspotProfile::CLASS_COUNT, "Every class has an entry");
+
+/// @brief Hotspots listed in the report.
+const size_t HOTSPOT_COUNT = 32;
+
+/// @brief Addresses per heat map row.
+const size_t HEAT_MAP_WIDTH = 128;
+
+/// @brief Heat map shades, from never run to the hottest address.
+const char HEAT_SHADES[] = " .:-=+*#%@";
+
+} // namespace
+
+/// @brief Opcode class of each instruction.
+const opcode::DispatchTable<uint8_t> HotspotProfile::CLASS_TABLE{ CLASS_ENTRIES };
+
+/// @brief Construct a hotspot profile.
+HotspotProfile::HotspotProfile()
+    : classCounts_{ }
+    , classTicks_{ }
+    , classSamples_{ }
+    , addressCounts_(ADDRESS_COUNT)
+    , addressTicks_(ADDRESS_COUNT)
+    , count_{ 0 }
+    , pc_{ 0 }
+    , opcode_{ 0 }
+    , start_{ 0 }
+    , untilSample_{ 0 }
+    , sampleWeight_{ 1 }
+    , jitter_{ 0x2545F491 }
+    , overheadTicks_{ 0 }
+    , enabledTime_{ }
+    , enabledTicks_{ 0 }
+    , enabled_{ false }
+{
+}
+
+/// @brief Destroy the hotspot profile.
+HotspotProfile::~HotspotProfile()
+{
+}
+
+/// @brief Enable or disable profiling.
+///
+/// Enabling measures the cost of reading the tick counter, which is taken
+/// off each timed instruction, and starts the tick to host time scale.
+///
+/// @param enabled True to profile the next instructions.
+void HotspotProfile::enable(bool enabled)
+{
+    if (enabled && !enabled_)
+    {
+        const int CALIBRATION_COUNT = 64;
+
+        overheadTicks_ = std::numeric_limits<uint64_t>::max();
+
+        for (int calibration = 0; calibration < CALIBRATION_COUNT; ++calibration)
+        {
+            uint64_t start = readTicks();
+            overheadTicks_ = std::min(overheadTicks_, readTicks() - start);
+        }
+
+        enabledTime_ = Clock::now();
+        enabledTicks_ = readTicks();
+
+        scheduleSample();
+    }
+
+    enabled_ = enabled;
+}
+
+/// @brief Return the executions of an opcode class.
+///
+/// @param instruction Instruction of the class, e.g. `OPCODE_8XY4`.
+/// @return Executions.
+uint64_t HotspotProfile::getClassCount(opcode::Opcode instruction) const
+{
+    return classCounts_[CLASS_TABLE.lookup(instruction)];
+}
+
+/// @brief Return the timed executions of an opcode class.
+///
+/// @param instruction Instruction of the class, e.g. `OPCODE_8XY4`.
+/// @return Executions whose host time was measured.
+uint64_t HotspotProfile::getClassSamples(opcode::Opcode instruction) const
+{
+    return classSamples_[CLASS_TABLE.lookup(instruction)];
+}
+
+/// @brief Return the host nanoseconds per tick, measured since enabled.
+double HotspotProfile::getNsPerTick() const
+{
+    uint64_t ticks = readTicks() - enabledTicks_;
+    double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - enabledTime_).count();
+
+    return (ticks != 0) ? elapsed / ticks : 0.0;
+}
+
+/// @brief Save the hotspot report.
+///
+/// Lists the opcode classes by estimated host time, the hottest addresses by count
+/// and a heat map of the address space.
+///
+/// @param filename File to write.
+/// @return True when saved, otherwise false.
+bool HotspotProfile::save(std::string const& filename) const
+{
+    std::FILE * reportFile = std::fopen(filename.c_str(), "w");
+
+    if (reportFile == nullptr)
+    {
+        std::printf("Cannot write profile file `%s'\n", filename.c_str());
+        return false;
+    }
+
+    double nsPerTick = getNsPerTick();
+    uint64_t totalTicks = std::accumulate(classTicks_.begin(), classTicks_.end(), uint64_t{ 0 });
+    double total = (count_ != 0) ? static_cast<double>(count_) : 1.0;
+
+    std::fprintf(reportFile, "Instructions: %llu, host time: %.3f ms\n\n",
+                 static_cast<unsigned long long>(count_), totalTicks * nsPerTick * 1e-6);
+
+    // Opcode classes, most host time first
+    std::vector<size_t> classes(CLASS_COUNT);
+    std::iota(classes.begin(), classes.end(), 0);
+    std::stable_sort(classes.begin(), classes.end(), [this](size_t a, size_t b) {
+        return classTicks_[a] > classTicks_[b];
+    });
+
+    std::fprintf(reportFile, "%-12s %14s %8s %10s %10s\n", "Class", "Count", "Count %", "Time %", "ns/op");
+
+    for (auto opcodeClass : classes)
+    {
+        if (classCounts_[opcodeClass] == 0)
+        {
+            continue;
+        }
+
+        std::fprintf(reportFile, "%-12s %14llu %8.2f %10.2f %10.2f\n",
+                     CLASS_NAMES[opcodeClass],
+                     static_cast<unsigned long long>(classCounts_[opcodeClass]),
+                     100.0 * classCounts_[opcodeClass] / total,
+                     (totalTicks != 0) ? 100.0 * classTicks_[opcodeClass] / totalTicks : 0.0,
+                     classTicks_[opcodeClass] * nsPerTick / classCounts_[opcodeClass]);
+    }
+
+    // Hottest addresses, most executions first
+    std::vector<uint16_t> addresses(ADDRESS_COUNT);
+    std::iota(addresses.begin(), addresses.end(), 0);
+    std::stable_sort(addresses.begin(), addresses.end(), [this](uint16_t a, uint16_t b) {
+        return addressCounts_[a] > addressCounts_[b];
+    });
+
+    std::fprintf(reportFile, "\n%-8s %14s %8s %10s %10s\n", "Address", "Count", "Count %", "Time %", "ns/op");
+
+    for (size_t index = 0; index < HOTSPOT_COUNT && addressCounts_[addresses[index]] != 0; ++index)
+    {
+        auto address = addresses[index];
+
+        std::fprintf(reportFile, "0x%03X    %14llu %8.2f %10.2f %10.2f\n",
+                     address,
+                     static_cast<unsigned long long>(addressCounts_[address]),
+                     100.0 * addressCounts_[address] / total,
+                     (totalTicks != 0) ? 100.0 * addressTicks_[address] / totalTicks : 0.0,
+                     addressTicks_[address] * nsPerTick / addressCounts_[address]);
+    }
+
+    // Heat map, shades scale with the log of the executions
+    uint64_t hottest = (count_ != 0) ? addressCounts_[addresses[0]] : 0;
+    double scale = (hottest > 1) ? (sizeof(HEAT_SHADES) - 2) / std::log2(static_cast<double>(hottest)) : 0.0;
+
+    std::fprintf(reportFile, "\nHeat map, %zu addresses per row, `%s' from cold to hot\n",
+                 HEAT_MAP_WIDTH, HEAT_SHADES);
+
+    for (size_t row = 0; row < ADDRESS_COUNT; row += HEAT_MAP_WIDTH)
+    {
+        char line[HEAT_MAP_WIDTH + 1] = { };
+
+        for (size_t column = 0; column < HEAT_MAP_WIDTH; ++column)
+        {
+            uint64_t count = addressCounts_[row + column];
+            size_t shade = (count == 0) ? 0 : 1 + static_cast<size_t>(std::log2(static_cast<double>(count)) * scale);
+
+            line[column] = HEAT_SHADES[std::min(shade, sizeof(HEAT_SHADES) - 2)];
+        }
+
+        std::fprintf(reportFile, "0x%03zX |%s|\n", row, line);
+    }
+
+    bool saved = std::fclose(reportFile) == 0;
+
+    if (!saved)
+    {
+        std::printf("Cannot write profile file `%s'\n", filename.c_str());
+    }
+
+    return saved;
+}
+
+}  // chip8
@@ -0,0 +1,198 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_CPUPROFILE_HPP
+#define CHIP8_CPUPROFILE_HPP
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <core.hpp>
+#include <opcode.hpp>
+#include <opcode_table.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace chip8 {
+
+/// @brief Trace policy counting instructions and their host time.
+///
+/// Counts executions per opcode class and per address, and estimates the
+/// host time each class and address spent from fetch to retire.  Reading the
+/// tick counter costs as much as a simple instruction, so only one
+/// instruction in `SAMPLE_PERIOD` on average is timed and weighted by the
+/// instructions since the last timed one.  The interval is jittered, so that
+/// loops whose length divides the period are still timed on every address.
+/// Nothing is formatted while running, the report is written on request.
+class HotspotProfile
+{
+    public:
+        /// @brief Tracing code is compiled.
+        static constexpr bool ENABLED = true;
+        /// @brief Profiled addresses, one per memory byte.
+        static constexpr size_t ADDRESS_COUNT = SYSTEM_MEMORY_SIZE;
+        /// @brief Opcode class count, unknown opcodes included.
+        static constexpr size_t CLASS_COUNT = 35;
+        /// @brief Mean instructions per timed instruction.
+        static constexpr uint32_t SAMPLE_PERIOD = 16;
+
+        HotspotProfile();
+        ~HotspotProfile();
+
+        void enable(bool enabled);
+
+        /// @brief Start profiling an instruction.
+        ///
+        /// @param regs    CPU registers, the program counter not yet incremented.
+        /// @param opcode  Opcode about to run.
+        template<typename REGS>
+        void record(REGS const& regs, uint16_t opcode)
+        {
+            if (!enabled_)
+            {
+                return;
+            }
+
+            pc_ = regs.pc & (ADDRESS_COUNT - 1);
+            opcode_ = opcode;
+
+            if (untilSample_ == 0)
+            {
+                start_ = readTicks();
+            }
+        }
+
+        /// @brief Account the instruction started by record().
+        void retire()
+        {
+            if (!enabled_)
+            {
+                return;
+            }
+
+            uint8_t opcodeClass = CLASS_TABLE.lookup(opcode_);
+
+            if (untilSample_ == 0)
+            {
+                uint64_t ticks = readTicks() - start_;
+                uint64_t elapsed = (ticks > overheadTicks_) ? (ticks - overheadTicks_) * sampleWeight_ : 0;
+
+                classTicks_[opcodeClass] += elapsed;
+                addressTicks_[pc_] += elapsed;
+                ++classSamples_[opcodeClass];
+
+                scheduleSample();
+            }
+            else
+            {
+                --untilSample_;
+            }
+
+            ++classCounts_[opcodeClass];
+            ++addressCounts_[pc_];
+            ++count_;
+        }
+
+        /// @brief Return the count of profiled instructions.
+        uint64_t getCount() const { return count_; }
+        /// @brief Return the executions of an address.
+        uint64_t getAddressCount(uint16_t address) const { return addressCounts_[address & (ADDRESS_COUNT - 1)]; }
+        uint64_t getClassCount(opcode::Opcode instruction) const;
+        uint64_t getClassSamples(opcode::Opcode instruction) const;
+
+        bool save(std::string const& filename) const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        /// @brief Read the host tick counter.
+        static uint64_t readTicks()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+#endif
+        }
+
+        /// @brief Pick the next timed instruction, 1 to `2 * SAMPLE_PERIOD - 1`
+        ///        instructions away.
+        void scheduleSample()
+        {
+            // xorshift32, enough to break the aliasing with short loops
+            jitter_ ^= jitter_ << 13;
+            jitter_ ^= jitter_ >> 17;
+            jitter_ ^= jitter_ << 5;
+
+            sampleWeight_ = 1 + jitter_ % (2 * SAMPLE_PERIOD - 1);
+            untilSample_ = sampleWeight_ - 1;
+        }
+
+        double getNsPerTick() const;
+
+        /// @brief Opcode class of each instruction, zero for unknown opcodes.
+        static const opcode::DispatchTable<uint8_t> CLASS_TABLE;
+
+        /// @brief Executions per opcode class.
+        std::array<uint64_t, CLASS_COUNT> classCounts_;
+        /// @brief Estimated host ticks per opcode class.
+        std::array<uint64_t, CLASS_COUNT> classTicks_;
+        /// @brief Timed executions per opcode class.
+        std::array<uint64_t, CLASS_COUNT> classSamples_;
+        /// @brief Executions per address.
+        std::vector<uint64_t> addressCounts_;
+        /// @brief Estimated host ticks per address.
+        std::vector<uint64_t> addressTicks_;
+        /// @brief Instructions profiled.
+        uint64_t count_;
+
+        /// @brief Address of the current instruction.
+        uint16_t pc_;
+        /// @brief Opcode of the current instruction.
+        uint16_t opcode_;
+        /// @brief Ticks when the last timed instruction started.
+        uint64_t start_;
+        /// @brief Instructions left before the next timed one.
+        uint32_t untilSample_;
+        /// @brief Instructions the next timed one stands for.
+        uint32_t sampleWeight_;
+        /// @brief Sampling interval generator state, never zero.
+        uint32_t jitter_;
+        /// @brief Ticks spent reading the tick counter, not accounted.
+        uint64_t overheadTicks_;
+
+        /// @brief Host time and ticks when profiling was enabled, to scale
+        ///        ticks to host time.
+        Clock::time_point enabledTime_;
+        uint64_t enabledTicks_;
+        /// @brief Profiling enabled.
+        bool enabled_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_CPUPROFILE_HPP
@@ -0,0 +1,111 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <cstdio>
+#include <cstring>
+
+#include "cpu_trace.hpp"
+
+namespace chip8 {
+
+namespace {
+
+/// @brief Trace file header, followed by the records oldest first.
+struct TraceHeader
+{
+    /// @brief File magic, "C8TR".
+    char     magic[4];
+    /// @brief File format version.
+    uint16_t version;
+    /// @brief Record size in bytes.
+    uint16_t recordSize;
+    /// @brief Records overwritten before the first one in the file.
+    uint64_t dropped;
+    /// @brief Records in the file.
+    uint64_t count;
+};
+
+/// @brief Trace file format version.
+const uint16_t TRACE_VERSION = 1;
+
+static_assert(sizeof(TraceHeader) == 24, "Trace header layout is part of the trace file format");
+
+} // namespace
+
+/// @brief Construct a ring buffer trace.
+RingBufferTrace::RingBufferTrace()
+    : records_(CAPACITY)
+    , count_{ 0 }
+    , enabled_{ false }
+{
+}
+
+/// @brief Destroy the ring buffer trace.
+RingBufferTrace::~RingBufferTrace()
+{
+}
+
+/// @brief Save the kept records to a trace file.
+///
+/// Fields are written in host byte order, little endian on supported hosts.
+///
+/// @param filename File to write.
+/// @return True when saved, otherwise false.
+bool RingBufferTrace::save(std::string const& filename) const
+{
+    std::FILE * traceFile = std::fopen(filename.c_str(), "wb");
+
+    if (traceFile == nullptr)
+    {
+        std::printf("Cannot write trace file `%s'\n", filename.c_str());
+        return false;
+    }
+
+    uint64_t kept = (count_ < CAPACITY) ? count_ : CAPACITY;
+
+    TraceHeader header{};
+    std::memcpy(header.magic, "C8TR", sizeof(header.magic));
+    header.version    = TRACE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.dropped    = count_ - kept;
+    header.count      = kept;
+
+    bool saved = std::fwrite(&header, sizeof(header), 1, traceFile) == 1;
+
+    // Oldest record first, the ring may have wrapped
+    for (uint64_t index = count_ - kept; saved && index < count_; ++index)
+    {
+        saved = std::fwrite(&records_[index & (CAPACITY - 1)], sizeof(TraceRecord), 1, traceFile) == 1;
+    }
+
+    saved = (std::fclose(traceFile) == 0) && saved;
+
+    if (!saved)
+    {
+        std::printf("Cannot write trace file `%s'\n", filename.c_str());
+    }
+
+    return saved;
+}
+
+}  // chip8
@@ -9,10 +9,10 @@
  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
  * copies of the Software, and to permit persons to whom the Software is
  * furnished to do so, subject to the following conditions:
- *
+ * 
  * The above copyright notice and this permission notice shall be included in all
  * copies or substantial portions of the Software.
- *
+ * 
  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
@@ -24,189 +24,118 @@
 #ifndef CHIP8_CPUTRACE_HPP
 #define CHIP8_CPUTRACE_HPP
 
-#include <cstdio>
+#include <string>
 #include <vector>
 
-#include "cpu.hpp"
+#include <core.hpp>
 
 namespace chip8 {
 
-/// @brief Represent a Cpu opcode tracing class.
-class CpuTrace
+/// @brief Trace policy compiling tracing out.
+struct NoTrace
 {
-    public:
-        /// @brief Cpu information indices
-        enum CpuInfoIndex : uint32_t
-        {
-            PC_INDEX    = 0,
-            VX_INDEX    = 1,
-            SP_INDEX    = 2,
-            I_INDEX     = 3,
-            DT_INDEX    = 4,
-            ST_INDEX    = 5,
-            STACK_INDEX = 6,
-
-            INFO_COUNT
-        };
-
-        /// @brief Cpu information to trace.
-        enum CpuInfo : uint32_t
-        {
-            NONE  = 0,
-            PC    = (1 <<  PC_INDEX),
-            VX    = (1 <<  VX_INDEX),
-            SP    = (1 <<  SP_INDEX),
-            I     = (1 <<  I_INDEX),
-            DT    = (1 <<  DT_INDEX),
-            ST    = (1 <<  ST_INDEX),
-            STACK = (1 <<  STACK_INDEX)
-        };
-
-
-        /// @brief Construct a CPU trace with decoded operand(s).
-        ///
-        /// RIAA style to trace opcode and trace info before executing the
-        /// opcode.
-        ///
-        /// @tparam OP Operand type.
-        /// @param enabled    Trace is enabled.
-        /// @param cpu        Reference to the CPU object.
-        /// @param opcode     Current opcode to trace.
-        /// @param op         Operand(s) decoded from opcode.
-        /// @param infoFlags  Information to trace flags.
-        template<typename OP>
-        CpuTrace(bool enabled, Cpu * cpu, opcode::Opcode opcode, OP const& op, uint32_t infoFlags)
-            : enabled_{ enabled }
-            , cpu_{ cpu }
-            , infoFlags_{ infoFlags }
-        {
-            if (enabled_ && infoFlags_ != NONE)
-            {
-                std::printf("Address: 0x%04X | ", cpu_->getRegContext().pc - Cpu::PC_INCR);
-                opcode::trace(opcode, op);
-                traceInfo();
-            }
-        }
+    /// @brief Tracing code is compiled.
+    static constexpr bool ENABLED = false;
 
-        /// @brief Construct a CPU trace with decoded operand(s).
-        ///
-        /// RIAA style to trace opcode and info before executing the opcode.
-        ///
-        /// @tparam OP Operand type.
-        /// @param enabled    Trace is enabled.
-        /// @param cpu        Reference to the CPU object.
-        /// @param opcode     Current opcode to trace.
-        /// @param infoFlags  Information to trace flags.
-        CpuTrace(bool enabled, Cpu * cpu, opcode::Opcode opcode, uint32_t infoFlags)
-            : enabled_{ enabled }
-            , cpu_{ cpu }
-            , infoFlags_{ infoFlags }
-        {
-            if (enabled_ && infoFlags_ != NONE)
-            {
-                opcode::trace(opcode);
-                traceInfo();
-            }
-        }
+    void enable(bool) {}
 
-        /// @brief Destroy the CPU trace instance.
-        ///
-        /// Trace the info after executing the opcode.
-        ~CpuTrace()
-        {
-            if (enabled_ && infoFlags_ != NONE)
-            {
-                traceInfo();
-            }
-        }
-
-    private:
-        using TraceFunc = void (CpuTrace::*)();
-        using TraceTable = std::vector<TraceFunc>;
+    template<typename REGS>
+    void record(REGS const&, uint16_t) {}
 
-        static const TraceTable TRACE_TABLE;
+    void retire() {}
+};
 
-        void traceProgramCounter()
-        {
-            std::printf("PC: 0x%04X;  ", cpu_->getRegContext().pc);
-        }
+/// @brief Trace record, the CPU state before an instruction runs.
+///
+/// Records are written as is to trace files, see scripts/chip8trace.py.
+struct TraceRecord
+{
+    /// @brief Instruction address.
+    uint16_t pc;
+    /// @brief Instruction opcode.
+    uint16_t opcode;
+    /// @brief I register.
+    uint16_t i;
+    /// @brief Stack pointer.
+    uint8_t  sp;
+    /// @brief Delay register.
+    uint8_t  dt;
+    /// @brief Sound register.
+    uint8_t  st;
+    /// @brief Padding.
+    uint8_t  reserved;
+    /// @brief General purpose registers.
+    uint8_t  vx[16];
+};
 
-        void traceGeneralPurposeRegisters()
-        {
-            for (uint32_t index = 0; index < Cpu::REG_COUNT; ++index)
-            {
-                std::printf("V%01X: 0x%02X;  ", index, cpu_->getRegContext().vx[index]);
-            }
-        }
+static_assert(sizeof(TraceRecord) == 26, "Trace record layout is part of the trace file format");
 
-        void traceStackPointer()
-        {
-            std::printf("SP: 0x%02X;  ", cpu_->getRegContext().sp);
-        }
+/// @brief Trace policy recording to a binary ring buffer.
+///
+/// Keeps the last `CAPACITY` records in memory, with no formatting nor
+/// I/O while running.  The buffer is written to a file on request and
+/// decoded offline.
+class RingBufferTrace
+{
+    public:
+        /// @brief Tracing code is compiled.
+        static constexpr bool ENABLED = true;
+        /// @brief Records kept, a power of two.
+        static constexpr size_t CAPACITY = 1 << 16;
 
-        void traceIRegister()
-        {
-            std::printf("I:  0x%04X;  ", cpu_->getRegContext().i);
-        }
+        RingBufferTrace();
+        ~RingBufferTrace();
 
-        void traceDelayRegister()
-        {
-            std::printf("DT: 0x%02X;  ", cpu_->getRegContext().dt);
-        }
+        /// @brief Enable or disable recording.
+        void enable(bool enabled) { enabled_ = enabled; }
 
-        void traceSoundRegister()
-        {
-            std::printf("ST: 0x%02X;  ", cpu_->getRegContext().dt);
-        }
+        /// @brief Return the count of records since construction.
+        uint64_t getCount() const { return count_; }
 
-        void traceStack()
+        /// @brief Record the CPU state before an instruction runs.
+        ///
+        /// @param regs    CPU registers, the program counter not yet incremented.
+        /// @param opcode  Opcode about to run.
+        template<typename REGS>
+        void record(REGS const& regs, uint16_t opcode)
         {
-            std::printf("Stack:");
-            for (std::size_t index = 0; index <= cpu_->getRegContext().sp; ++index)
+            if (!enabled_)
             {
-                std::printf(" 0x%04X", cpu_->getRegContext().stack[index]);
+                return;
             }
-            std::puts("");
-        }
 
-        void traceInfo()
-        {
-            for (uint32_t index = PC_INDEX; index < STACK_INDEX; ++index)
-            {
-                uint32_t flag = (1 << index);
+            auto & record = records_[count_ & (CAPACITY - 1)];
 
-                if (infoFlags_ & flag)
-                {
-                    (this->*(TRACE_TABLE[index]))();
-                }
-            }
+            record.pc       = regs.pc;
+            record.opcode   = opcode;
+            record.i        = regs.i;
+            record.sp       = regs.sp;
+            record.dt       = regs.dt;
+            record.st       = regs.st;
+            record.reserved = 0;
 
-            if (infoFlags_ & ~STACK)
+            for (size_t index = 0; index < sizeof(record.vx); ++index)
             {
-                std::puts("");
+                record.vx[index] = regs.vx[index];
             }
 
-            if (infoFlags_ & STACK)
-            {
-                traceStack();
-            }
+            ++count_;
         }
 
-        bool     enabled_;
-        Cpu *    cpu_;
-        uint32_t infoFlags_;
-};
+        /// @brief Called once the recorded instruction ran, nothing to do.
+        void retire() {}
+
+        bool save(std::string const& filename) const;
 
-/// @brief Trace table to call function based on flags.
-const CpuTrace::TraceTable CpuTrace::TRACE_TABLE = {
-    &CpuTrace::traceProgramCounter,
-    &CpuTrace::traceGeneralPurposeRegisters,
-    &CpuTrace::traceStackPointer,
-    &CpuTrace::traceIRegister,
-    &CpuTrace::traceDelayRegister,
-    &CpuTrace::traceSoundRegister
+    private:
+        /// @brief Record buffer.
+        std::vector<TraceRecord> records_;
+        /// @brief Records since construction.
+        uint64_t count_;
+        /// @brief Recording enabled.
+        bool enabled_;
 };
 
-} // namespace chip8
+}  // chip8
 
-#endif // CHIP8_CPUTRACE_HPP
+#endif  // CHIP8_CPUTRACE_HPP
@@ -51,12 +51,6 @@ Debugger::~Debugger()
 {
 }
 
-/// @brief Set tick to CPU.
-void Debugger::tick(uint32_t tick)
-{
-    cpu_->tick(tick);
-}
-
 /// @brief Reset CPU.
 void Debugger::reset()
 {
@@ -92,6 +86,26 @@ void Debugger::update()
     }
 }
 
+/// @brief Run CPU cycles one update at a time so each one is traced.
+///
+/// @param cycles Count of cycles to run.
+/// @return Count of cycles ran.
+uint32_t Debugger::run(uint32_t cycles)
+{
+    for (uint32_t cycle = 0; cycle < cycles; ++cycle)
+    {
+        update();
+    }
+
+    return cycles;
+}
+
+/// @brief Tick CPU timers.
+void Debugger::tickTimers()
+{
+    cpu_->tickTimers();
+}
+
 /// @brief Get CPU registers context.
 ///
 /// @return Registers context.
@@ -108,6 +122,30 @@ opcode::Opcode Debugger::getOpcode() const
     return cpu_->getOpcode();
 }
 
+/// @brief Check if the CPU is parked waiting for a key.
+///
+/// @return True when parked on FX0A.
+bool Debugger::isWaitingForKey() const
+{
+    return cpu_->isWaitingForKey();
+}
+
+/// @brief Get CPU state.
+///
+/// @return CPU state.
+Cpu::State Debugger::getState() const
+{
+    return cpu_->getState();
+}
+
+/// @brief Restore CPU state.
+///
+/// @param state CPU state.
+void Debugger::setState(State const& state)
+{
+    cpu_->setState(state);
+}
+
 /// @brief Trace opcode to console.
 void Debugger::traceOpcode()
 {
@@ -55,13 +55,18 @@ class Debugger : public Cpu
         uint8_t  getDelayTimer()const { return regContext_.dt; }
         uint8_t  getSoundTimer() const { return regContext_.st; }
 
-        void tick(uint32_t tick) override;
         void reset() override;
         void update() override;
+        uint32_t run(uint32_t cycles) override;
+        void tickTimers() override;
+
+        State getState() const override;
+        void  setState(State const& state) override;
 
     private:
         Cpu::RegContext const& getRegContext() const override;
         opcode::Opcode getOpcode() const override;
+        bool isWaitingForKey() const override;
 
         void traceRegContext();
         void traceOpcode();
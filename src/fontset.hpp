@@ -0,0 +1,81 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_FONTSET_HPP
+#define CHIP8_FONTSET_HPP
+
+#include <core.hpp>
+
+namespace chip8 {
+
+/// @brief Fontset sprites.
+constexpr uint8_t FONT_SET[] = {
+    0xF0, 0x90, 0x90, 0x90, 0xF0, // Character 0
+    0x20, 0x60, 0x20, 0x20, 0x70, // Character 1
+    0xF0, 0x10, 0xF0, 0x80, 0xF0, // Character 2
+    0xF0, 0x10, 0xF0, 0x10, 0xF0, // Character 3
+    0x90, 0x90, 0xF0, 0x10, 0x10, // Character 4
+    0xF0, 0x80, 0xF0, 0x10, 0xF0, // Character 5
+    0xF0, 0x80, 0xF0, 0x90, 0xF0, // Character 6
+    0xF0, 0x10, 0x20, 0x40, 0x40, // Character 7
+    0xF0, 0x90, 0xF0, 0x90, 0xF0, // Character 8
+    0xF0, 0x90, 0xF0, 0x10, 0xF0, // Character 9
+    0xF0, 0x90, 0xF0, 0x90, 0x90, // Character A
+    0xE0, 0x90, 0xE0, 0x90, 0xE0, // Character B
+    0xF0, 0x80, 0xF0, 0x80, 0xF0, // Character C
+    0xE0, 0x90, 0x90, 0x90, 0xE0, // Character D
+    0xF0, 0x80, 0xF0, 0x80, 0xF0, // Character E
+    0xF0, 0x80, 0xF0, 0x80, 0x80  // Character F
+};
+
+/// @brief Fontset size in bytes.
+constexpr size_t FONT_SET_SIZE = sizeof(FONT_SET) / sizeof(FONT_SET[0]);
+
+/// @brief SUPER-CHIP large fontset sprites, 8x10, stored after `FONT_SET`.
+constexpr uint8_t BIG_FONT_SET[] = {
+    0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, // Character 0
+    0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // Character 1
+    0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, // Character 2
+    0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, // Character 3
+    0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, // Character 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, // Character 5
+    0x3E, 0x7C, 0xC0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, // Character 6
+    0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, // Character 7
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, // Character 8
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C, // Character 9
+    0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // Character A
+    0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // Character B
+    0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // Character C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // Character D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // Character E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // Character F
+};
+
+/// @brief Large font character size in bytes.
+constexpr size_t BIG_FONT_SIZE = 10;
+/// @brief Large fontset size in bytes.
+constexpr size_t BIG_FONT_SET_SIZE = sizeof(BIG_FONT_SET) / sizeof(BIG_FONT_SET[0]);
+
+}  // chip8
+
+#endif  // CHIP8_FONTSET_HPP
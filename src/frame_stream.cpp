@@ -0,0 +1,569 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "frame_stream.hpp"
+
+namespace chip8 {
+
+namespace {
+
+/// @brief Stream magic.
+const char STREAM_MAGIC[] = "C8FS";
+
+/// @brief Largest payload, a literal run per byte pair plus its varints.
+const size_t MAX_PAYLOAD_SIZE = FrameStream::PLANE_SIZE * 2;
+
+/// @brief Largest varint of a frame delta.
+const size_t MAX_FRAME_DELTA_SIZE = 10;
+
+/// @brief Largest varint of a payload size.
+const size_t MAX_PAYLOAD_SIZE_SIZE = 2;
+
+static_assert(MAX_PAYLOAD_SIZE < (1 << (7 * MAX_PAYLOAD_SIZE_SIZE)), "Payload sizes fit their varint");
+
+/// @brief Largest record, frame delta, payload size and payload.
+const size_t MAX_RECORD_SIZE = MAX_FRAME_DELTA_SIZE + MAX_PAYLOAD_SIZE_SIZE + MAX_PAYLOAD_SIZE;
+
+/// @brief Build the XOR plane of two frames.
+///
+/// @param previous  Previous rows.
+/// @param current   Current rows.
+/// @param dirtyRows Rows that may differ.
+/// @param plane     XOR plane, rows most significant byte first.
+/// @return True when the frames differ, otherwise false.
+bool computeDelta(Framebuffer::Row const * previous,
+                  Framebuffer::Row const * current,
+                  Framebuffer::RowMask dirtyRows,
+                  uint8_t * plane)
+{
+    bool changed = false;
+
+    std::memset(plane, 0, FrameStream::PLANE_SIZE);
+
+    for (; dirtyRows != 0; dirtyRows &= dirtyRows - 1)
+    {
+        uint32_t y = __builtin_ctz(dirtyRows);
+        Framebuffer::Row delta = previous[y] ^ current[y];
+
+        for (uint32_t byte = 0; byte < sizeof(Framebuffer::Row); ++byte)
+        {
+            plane[y * sizeof(Framebuffer::Row) + byte] = static_cast<uint8_t>(delta >> (56 - 8 * byte));
+        }
+
+        changed = changed || (delta != 0);
+    }
+
+    return changed;
+}
+
+/// @brief Encode a varint, seven bits per byte, least significant first.
+///
+/// @param value Value to encode.
+/// @param out   Output, advanced past the encoded bytes.
+void putVarint(uint64_t value, uint8_t *& out)
+{
+    while (value >= 0x80)
+    {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+
+    *out++ = static_cast<uint8_t>(value);
+}
+
+} // namespace
+
+/// @brief Construct a closed frame stream.
+FrameStream::FrameStream()
+    : descriptor_{ -1 }
+    , owned_{ false }
+    , socket_{ false }
+    , failed_{ false }
+    , previous_{ }
+    , batch_{ }
+    , frameCount_{ 0 }
+    , recordFrame_{ 0 }
+    , flushFrame_{ 0 }
+    , byteCount_{ 0 }
+{
+    batch_.reserve(BATCH_SIZE + HEADER_SIZE + MAX_RECORD_SIZE);
+}
+
+/// @brief Destroy a frame stream, writing what is batched.
+FrameStream::~FrameStream()
+{
+    close();
+}
+
+/// @brief Open a stream target.
+///
+/// The target is `fd:N` for an open descriptor, `tcp:HOST:PORT` for a
+/// connection, otherwise a file or named pipe path.
+///
+/// @param target Stream target.
+/// @return True when opened, otherwise false.
+bool FrameStream::open(std::string const& target)
+{
+    close();
+
+    int descriptor = -1;
+    bool socket = false;
+
+    if (target.compare(0, 3, "fd:") == 0)
+    {
+        if (!parseDescriptor(target.substr(3), descriptor))
+        {
+            std::printf("Invalid stream descriptor `%s'\n", target.c_str());
+            return false;
+        }
+
+        attach(descriptor);
+        return true;
+    }
+    else if (target.compare(0, 4, "tcp:") == 0)
+    {
+        socket = connect(target.substr(4), descriptor);
+    }
+    else
+    {
+        descriptor = ::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+
+    if (descriptor < 0)
+    {
+        std::printf("Cannot open stream `%s'\n", target.c_str());
+        return false;
+    }
+
+    descriptor_ = descriptor;
+    owned_ = true;
+    socket_ = socket;
+    begin();
+
+    return true;
+}
+
+/// @brief Stream to a descriptor owned by the caller.
+///
+/// @param descriptor Descriptor to write.
+void FrameStream::attach(int descriptor)
+{
+    close();
+
+    descriptor_ = descriptor;
+    owned_ = false;
+    socket_ = false;
+    begin();
+}
+
+/// @brief Write what is batched and close the stream.
+void FrameStream::close()
+{
+    if (descriptor_ < 0)
+    {
+        return;
+    }
+
+    flush();
+
+    if (owned_)
+    {
+        ::close(descriptor_);
+    }
+
+    descriptor_ = -1;
+}
+
+/// @brief Write a frame.
+///
+/// @param rows      Display rows.
+/// @param dirtyRows Rows changed since the previous frame written.
+void FrameStream::write(Framebuffer::Row const * rows, Framebuffer::RowMask dirtyRows)
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    ++frameCount_;
+
+    uint8_t plane[PLANE_SIZE];
+
+    if (dirtyRows != 0 && computeDelta(previous_, rows, dirtyRows, plane))
+    {
+        // Encode the record in place, leaving room for the payload size
+        size_t start = batch_.size();
+        batch_.resize(start + MAX_RECORD_SIZE);
+
+        uint8_t * out = batch_.data() + start;
+        putVarint(frameCount_ - recordFrame_, out);
+
+        uint8_t * payloadSize = out;
+        uint8_t * payload = payloadSize + MAX_PAYLOAD_SIZE_SIZE;
+        out = payload;
+
+        for (size_t index = 0; index < PLANE_SIZE;)
+        {
+            size_t zeroStart = index;
+
+            while (index < PLANE_SIZE && plane[index] == 0)
+            {
+                ++index;
+            }
+
+            if (index == PLANE_SIZE)
+            {
+                break;
+            }
+
+            size_t literalStart = index;
+
+            while (index < PLANE_SIZE && plane[index] != 0)
+            {
+                ++index;
+            }
+
+            putVarint(literalStart - zeroStart, out);
+            putVarint(index - literalStart, out);
+            out = std::copy(plane + literalStart, plane + index, out);
+        }
+
+        putVarint(out - payload, payloadSize);
+
+        if (payloadSize != payload)
+        {
+            out = std::copy(payload, out, payloadSize);
+        }
+
+        batch_.resize(out - batch_.data());
+
+        std::copy(rows, rows + Framebuffer::DISPLAY_HEIGHT, previous_);
+        recordFrame_ = frameCount_;
+    }
+
+    if (batch_.size() >= BATCH_SIZE || (!batch_.empty() && frameCount_ - flushFrame_ >= BATCH_FRAMES))
+    {
+        flush();
+    }
+}
+
+/// @brief Write the batched bytes.
+///
+/// @return True when written, otherwise false.
+bool FrameStream::flush()
+{
+    flushFrame_ = frameCount_;
+
+    if (batch_.empty() || !isOpen())
+    {
+        return isOpen();
+    }
+
+    bool written = writeAll(batch_.data(), batch_.size());
+
+    if (written)
+    {
+        byteCount_ += batch_.size();
+    }
+    else
+    {
+        std::puts("Stream write failed, streaming stopped.");
+        failed_ = true;
+    }
+
+    batch_.clear();
+
+    return written;
+}
+
+/// @brief Parse the descriptor number of an `fd:N` target.
+///
+/// @param number     Descriptor number, in decimal.
+/// @param descriptor Parsed descriptor, unchanged on failure.
+/// @return True when the whole number is a valid descriptor.
+bool FrameStream::parseDescriptor(std::string const& number, int & descriptor)
+{
+    char const * start = number.c_str();
+    char * end = nullptr;
+
+    errno = 0;
+    long value = std::strtol(start, &end, 10);
+
+    if (end == start || *end != '\0' || errno != 0 || value < 0 || value > INT_MAX)
+    {
+        return false;
+    }
+
+    descriptor = static_cast<int>(value);
+    return true;
+}
+
+/// @brief Connect to a TCP address.
+///
+/// @param address    Address, `HOST:PORT`.
+/// @param descriptor Connected socket, negative on failure.
+/// @return True when the descriptor is a socket.
+bool FrameStream::connect(std::string const& address, int & descriptor)
+{
+    descriptor = -1;
+
+    size_t separator = address.rfind(':');
+
+    if (separator == std::string::npos)
+    {
+        return false;
+    }
+
+    std::string host = address.substr(0, separator);
+    std::string port = address.substr(separator + 1);
+
+    struct addrinfo hints{};
+    struct addrinfo * addresses = nullptr;
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0)
+    {
+        return false;
+    }
+
+    for (auto entry = addresses; entry != nullptr && descriptor < 0; entry = entry->ai_next)
+    {
+        descriptor = ::socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol);
+
+        if (descriptor >= 0 && ::connect(descriptor, entry->ai_addr, entry->ai_addrlen) != 0)
+        {
+            ::close(descriptor);
+            descriptor = -1;
+        }
+    }
+
+    ::freeaddrinfo(addresses);
+
+    return descriptor >= 0;
+}
+
+/// @brief Reset the stream state and batch the header.
+void FrameStream::begin()
+{
+    failed_ = false;
+    std::fill(previous_, previous_ + Framebuffer::DISPLAY_HEIGHT, 0);
+    frameCount_ = 0;
+    recordFrame_ = 0;
+    flushFrame_ = 0;
+    byteCount_ = 0;
+
+    batch_.assign(HEADER_SIZE, 0);
+    std::memcpy(batch_.data(), STREAM_MAGIC, 4);
+    batch_[4] = VERSION;
+    batch_[5] = Framebuffer::DISPLAY_WIDTH;
+    batch_[6] = Framebuffer::DISPLAY_HEIGHT;
+}
+
+/// @brief Write bytes, retrying partial and interrupted writes.
+///
+/// Sockets are written without raising SIGPIPE.
+///
+/// @param data Bytes to write.
+/// @param size Count of bytes.
+/// @return True when all bytes were written, otherwise false.
+bool FrameStream::writeAll(uint8_t const * data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = socket_ ? ::send(descriptor_, data, size, MSG_NOSIGNAL)
+                                  : ::write(descriptor_, data, size);
+
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (written <= 0)
+        {
+            return false;
+        }
+
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+/// @brief Construct a frame decoder at the start of a stream.
+FrameDecoder::FrameDecoder()
+    : plane_{ }
+    , frame_{ 0 }
+{
+}
+
+/// @brief Decode the stream header.
+///
+/// @param data Stream bytes, advanced past the header.
+/// @param size Count of bytes, reduced by the header size.
+/// @return True when the header is valid, otherwise false.
+bool FrameDecoder::decodeHeader(uint8_t const *& data, size_t & size)
+{
+    if (size < FrameStream::HEADER_SIZE ||
+        std::memcmp(data, STREAM_MAGIC, 4) != 0 ||
+        data[4] != FrameStream::VERSION ||
+        data[5] != Framebuffer::DISPLAY_WIDTH ||
+        data[6] != Framebuffer::DISPLAY_HEIGHT)
+    {
+        return false;
+    }
+
+    data += FrameStream::HEADER_SIZE;
+    size -= FrameStream::HEADER_SIZE;
+
+    return true;
+}
+
+/// @brief Decode a record, applying it to the display.
+///
+/// @param data Stream bytes, advanced past the record.
+/// @param size Count of bytes, reduced by the record size.
+/// @return True when a whole record was decoded, otherwise false and
+///         nothing is consumed.
+bool FrameDecoder::decode(uint8_t const *& data, size_t & size)
+{
+    uint8_t const * in = data;
+    uint8_t const * end = data + size;
+    uint64_t frames = 0;
+    uint64_t payloadSize = 0;
+
+    if (!decodeVarint(in, end, frames) || !decodeVarint(in, end, payloadSize) ||
+        payloadSize > static_cast<uint64_t>(end - in))
+    {
+        return false;
+    }
+
+    uint8_t const * payloadEnd = in + payloadSize;
+    size_t index = 0;
+    auto plane = plane_;
+
+    while (in < payloadEnd)
+    {
+        uint64_t zeroRun = 0;
+        uint64_t literalCount = 0;
+
+        if (!decodeVarint(in, payloadEnd, zeroRun) || !decodeVarint(in, payloadEnd, literalCount) ||
+            index + zeroRun + literalCount > FrameStream::PLANE_SIZE ||
+            literalCount > static_cast<uint64_t>(payloadEnd - in))
+        {
+            return false;
+        }
+
+        for (index += zeroRun; literalCount != 0; --literalCount, ++index, ++in)
+        {
+            size_t y = index / sizeof(Framebuffer::Row);
+            size_t shift = 56 - 8 * (index % sizeof(Framebuffer::Row));
+
+            plane[y] ^= static_cast<Framebuffer::Row>(*in) << shift;
+        }
+    }
+
+    plane_ = plane;
+    frame_ += frames;
+
+    size -= payloadEnd - data;
+    data = payloadEnd;
+
+    return true;
+}
+
+/// @brief Decode a varint.
+///
+/// @param data  Bytes, advanced past the varint.
+/// @param end   End of the bytes.
+/// @param value Decoded value.
+/// @return True when decoded, otherwise false.
+bool FrameDecoder::decodeVarint(uint8_t const *& data, uint8_t const * end, uint64_t & value)
+{
+    value = 0;
+
+    for (uint32_t shift = 0; data < end && shift < 64; shift += 7)
+    {
+        uint8_t byte = *data++;
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// @brief Construct a streaming GPU instance, streaming nowhere until opened.
+StreamGpu::StreamGpu()
+    : framebuffer_{ }
+    , stream_{ }
+{
+}
+
+/// @brief Destroy the streaming GPU instance.
+StreamGpu::~StreamGpu()
+{
+}
+
+/// @brief Clear frame buffer.
+void StreamGpu::clearFrame()
+{
+    framebuffer_.clear();
+}
+
+/// @brief Draw a sprite.
+///
+/// @param x       X coordinate on display screen.
+/// @param y       Y coordinate on display screen.
+/// @param sprite  Spite 8xN
+/// @return True when a pixel is erased, otherwise false.
+bool StreamGpu::drawSprite(uint8_t x, uint8_t y, Sprite const& sprite)
+{
+    return framebuffer_.drawSprite(x, y, sprite);
+}
+
+/// @brief Stream the frame, only its changes are encoded.
+void StreamGpu::draw()
+{
+    stream_.write(framebuffer_.rows(), framebuffer_.getDirtyRows());
+    framebuffer_.markClean();
+}
+
+}  // chip8
@@ -0,0 +1,170 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_FRAMESTREAM_HPP
+#define CHIP8_FRAMESTREAM_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <core.hpp>
+#include <framebuffer.hpp>
+#include <gpu.hpp>
+
+namespace chip8 {
+
+/// @brief Frame stream writer, sending display changes to a descriptor.
+///
+/// The stream starts with a header, the magic "C8FS", a version byte, the
+/// display width and height and a zero byte.  Each changed frame then is
+/// a record:
+///
+///     varint  frames elapsed since the previous record
+///     varint  payload size
+///     payload (varint zero run, varint literal count, literals)...
+///
+/// The payload encodes the XOR of the frame against the previous one, a
+/// 256-byte plane of the rows in order, each row most significant byte
+/// first.  Zero bytes past the last literal are omitted.  Unchanged frames
+/// only count as elapsed, so the stream grows with display changes and
+/// not with the frame rate.
+///
+/// Records are encoded in place in a batch buffer, written with a single
+/// system call once it is full or a few frames old.
+class FrameStream
+{
+    public:
+        /// @brief Stream format version.
+        static constexpr uint8_t VERSION = 1;
+        /// @brief Header size in bytes.
+        static constexpr size_t HEADER_SIZE = 8;
+        /// @brief Plane size in bytes.
+        static constexpr size_t PLANE_SIZE = Framebuffer::DISPLAY_HEIGHT * sizeof(Framebuffer::Row);
+        /// @brief Batch size that triggers a write.
+        static constexpr size_t BATCH_SIZE = 4096;
+        /// @brief Frames after which a batch is written anyway.
+        static constexpr uint64_t BATCH_FRAMES = 30;
+
+        FrameStream();
+        ~FrameStream();
+
+        FrameStream(FrameStream const&) = delete;
+        FrameStream & operator=(FrameStream const&) = delete;
+
+        bool open(std::string const& target);
+        void attach(int descriptor);
+        void close();
+
+        void write(Framebuffer::Row const * rows, Framebuffer::RowMask dirtyRows);
+        bool flush();
+
+        /// @brief Check if the stream is open and writable.
+        bool isOpen() const { return descriptor_ >= 0 && !failed_; }
+        /// @brief Return the count of frames written, changed or not.
+        uint64_t getFrameCount() const { return frameCount_; }
+        /// @brief Return the bytes written.
+        uint64_t getByteCount() const { return byteCount_; }
+
+        static bool connect(std::string const& address, int & descriptor);
+        static bool parseDescriptor(std::string const& number, int & descriptor);
+
+    private:
+        void begin();
+        bool writeAll(uint8_t const * data, size_t size);
+
+        /// @brief Descriptor written, negative when closed.
+        int descriptor_;
+        /// @brief The stream owns the descriptor.
+        bool owned_;
+        /// @brief The descriptor is a socket.
+        bool socket_;
+        /// @brief A write failed, nothing more is written.
+        bool failed_;
+
+        /// @brief Previous frame rows.
+        Framebuffer::Row previous_[Framebuffer::DISPLAY_HEIGHT];
+        /// @brief Batched bytes.
+        std::vector<uint8_t> batch_;
+        /// @brief Frames written.
+        uint64_t frameCount_;
+        /// @brief Frame of the last record.
+        uint64_t recordFrame_;
+        /// @brief Frame of the last batch written.
+        uint64_t flushFrame_;
+        /// @brief Bytes written.
+        uint64_t byteCount_;
+};
+
+/// @brief Frame stream reader, for tools and tests.
+class FrameDecoder
+{
+    public:
+        /// @brief Display plane, rows in order.
+        using Plane = std::array<Framebuffer::Row, Framebuffer::DISPLAY_HEIGHT>;
+
+        FrameDecoder();
+
+        bool decodeHeader(uint8_t const *& data, size_t & size);
+        bool decode(uint8_t const *& data, size_t & size);
+
+        /// @brief Return the display of the last decoded record.
+        Plane const& getPlane() const { return plane_; }
+        /// @brief Return the frame index of the last decoded record.
+        uint64_t getFrame() const { return frame_; }
+
+    private:
+        static bool decodeVarint(uint8_t const *& data, uint8_t const * end, uint64_t & value);
+
+        /// @brief Current display.
+        Plane plane_;
+        /// @brief Current frame index.
+        uint64_t frame_;
+};
+
+/// @brief Represent a GPU streaming the display instead of presenting it.
+class StreamGpu : public Gpu
+{
+    public:
+        StreamGpu();
+        ~StreamGpu();
+
+        void clearFrame() override;
+        bool drawSprite(uint8_t x, uint8_t y, Sprite const& sprite) override;
+        void draw() override;
+
+        Framebuffer & getFramebuffer() override { return framebuffer_; }
+
+        /// @brief Return the frame stream.
+        FrameStream & stream() { return stream_; }
+
+    private:
+        /// @brief Framebuffer containing the pixels.
+        Framebuffer framebuffer_;
+        /// @brief Stream of the drawn frames.
+        FrameStream stream_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_FRAMESTREAM_HPP
@@ -0,0 +1,426 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <cstring>
+
+#include "framebuffer.hpp"
+
+namespace chip8 {
+
+namespace {
+
+/// @brief Rotate a row right, wrapping pixels around the display.
+///
+/// @param row    Row to rotate.
+/// @param shift  Pixel count, below the row width.
+/// @return Rotated row.
+template<typename ROW, uint32_t BITS>
+ROW rotateRight(ROW row, uint32_t shift)
+{
+    return (row >> shift) | (row << ((BITS - shift) & (BITS - 1)));
+}
+
+/// @brief Double every bit of a sprite row, for low resolution.
+///
+/// @param bits Sprite row of up to 16 pixels.
+/// @return Sprite row of twice the pixels.
+uint32_t spreadBits(uint32_t bits)
+{
+    bits = (bits | (bits << 8)) & 0x00FF00FF;
+    bits = (bits | (bits << 4)) & 0x0F0F0F0F;
+    bits = (bits | (bits << 2)) & 0x33333333;
+    bits = (bits | (bits << 1)) & 0x55555555;
+
+    return bits | (bits << 1);
+}
+
+} // namespace
+
+/// @brief Construct a framebuffer instance.
+///
+/// All rows start dirty so that the first frame is presented.  An extended
+/// display starts in low resolution with the first plane selected.
+template<typename MODE>
+BasicFramebuffer<MODE>::BasicFramebuffer()
+    : rows_{ }
+    , dirtyRows_{ static_cast<RowMask>(~RowMask{ 0 }) }
+    , planes_{ 0x1 }
+    , highResolution_{ !MODE::EXTENDED }
+{
+    static_assert(sizeof(RowMask) * 8 == DISPLAY_HEIGHT, "Dirty row mask must cover the display");
+    static_assert(sizeof(Row) * 8 == DISPLAY_WIDTH, "A row must cover the display width");
+    static_assert(DISPLAY_WIDTH % pixel::ROW_WIDTH == 0, "Pixel expansion must cover a display row");
+}
+
+/// @brief Destroy the framebuffer instance.
+template<typename MODE>
+BasicFramebuffer<MODE>::~BasicFramebuffer()
+{
+}
+
+/// @brief Set pixel value of the first plane.
+///
+/// @param x     X coordinate in display.
+/// @param y     Y coordinate in display.
+/// @param byte  Pixel value.
+template<typename MODE>
+void BasicFramebuffer<MODE>::setPixel(uint8_t x, uint8_t y, uint8_t pixel)
+{
+    auto rowIndex = y & (DISPLAY_HEIGHT - 1);
+    auto & row = rows_[0][rowIndex];
+    auto mask = computePixelMask(x);
+    auto previous = row;
+
+    row = (pixel & 0x1) ? (row | mask) : (row & ~mask);
+
+    if (row != previous)
+    {
+        dirtyRows_ |= RowMask{ 1 } << rowIndex;
+    }
+}
+
+/// @brief Get pixel value of the first plane.
+///
+/// @param x     X coordinate in display.
+/// @param y     Y coordinate in display.
+/// @return Pixel value.
+template<typename MODE>
+uint8_t BasicFramebuffer<MODE>::getPixel(uint8_t x, uint8_t y) const
+{
+    auto row = rows_[0][y & (DISPLAY_HEIGHT - 1)];
+    return (row & computePixelMask(x)) != 0;
+}
+
+/// @brief Replace all pixels of the first plane, e.g. to restore a snapshot.
+///
+/// Only rows that change become dirty.
+///
+/// @param rows Display rows, DISPLAY_HEIGHT of them.
+template<typename MODE>
+void BasicFramebuffer<MODE>::loadRows(Row const * rows)
+{
+    for (uint32_t y = 0; y < DISPLAY_HEIGHT; ++y)
+    {
+        if (rows_[0][y] != rows[y])
+        {
+            rows_[0][y] = rows[y];
+            dirtyRows_ |= RowMask{ 1 } << y;
+        }
+    }
+}
+
+/// @brief Switch between low and high resolution.
+///
+/// The display is cleared, as by SUPER-CHIP and XO-CHIP interpreters.  A
+/// classic display stays in its only resolution.
+///
+/// @param enabled True for high resolution.
+template<typename MODE>
+void BasicFramebuffer<MODE>::setHighResolution(bool enabled)
+{
+    if constexpr (MODE::EXTENDED)
+    {
+        auto planes = planes_;
+
+        highResolution_ = enabled;
+
+        selectPlanes(0xFF);
+        clear();
+        selectPlanes(planes);
+    }
+}
+
+/// @brief Clear all pixels of the selected planes.
+///
+/// Only rows with lit pixels become dirty.
+template<typename MODE>
+void BasicFramebuffer<MODE>::clear()
+{
+    for (uint32_t plane = 0; plane < PLANE_COUNT; ++plane)
+    {
+        if ((planes_ & (1u << plane)) == 0)
+        {
+            continue;
+        }
+
+        for (uint32_t y = 0; y < DISPLAY_HEIGHT; ++y)
+        {
+            if (rows_[plane][y] != 0)
+            {
+                dirtyRows_ |= RowMask{ 1 } << y;
+            }
+        }
+
+        std::fill(std::begin(rows_[plane]), std::end(rows_[plane]), 0);
+    }
+}
+
+/// @brief Draw a sprite.
+///
+/// Each sprite row is rotated to its X coordinate and XORed with the
+/// display row in a single word operation.
+///
+/// @param x       X coordinate on display screen.
+/// @param y       Y coordinate on display screen.
+/// @param sprite  Spite 8xN, N rows per selected plane.
+/// @return True when a pixel is erased, otherwise false.
+template<typename MODE>
+bool BasicFramebuffer<MODE>::drawSprite(uint8_t x, uint8_t y, Sprite const& sprite)
+{
+    size_t planes = std::max<size_t>(getSelectedPlaneCount(), 1);
+
+    return blit<8>(x, y, sprite, sprite.size() / planes);
+}
+
+/// @brief Draw a SUPER-CHIP 16x16 sprite.
+///
+/// @param x       X coordinate on display screen.
+/// @param y       Y coordinate on display screen.
+/// @param sprite  Sprite of 16 rows of two bytes per selected plane.
+/// @return True when a pixel is erased, otherwise false.
+template<typename MODE>
+bool BasicFramebuffer<MODE>::drawLargeSprite(uint8_t x, uint8_t y, Sprite const& sprite)
+{
+    return blit<16>(x, y, sprite, 16);
+}
+
+/// @brief Scroll the selected planes down.
+///
+/// @param count Count of rows, doubled in low resolution.
+template<typename MODE>
+void BasicFramebuffer<MODE>::scrollDown(uint8_t count)
+{
+    scrollVertical(highResolution_ ? count : 2 * count);
+}
+
+/// @brief Scroll the selected planes up.
+///
+/// @param count Count of rows, doubled in low resolution.
+template<typename MODE>
+void BasicFramebuffer<MODE>::scrollUp(uint8_t count)
+{
+    scrollVertical(-(highResolution_ ? count : 2 * count));
+}
+
+/// @brief Scroll the selected planes 4 pixels left, 8 in low resolution.
+template<typename MODE>
+void BasicFramebuffer<MODE>::scrollLeft()
+{
+    scrollHorizontal(highResolution_ ? -4 : -8);
+}
+
+/// @brief Scroll the selected planes 4 pixels right, 8 in low resolution.
+template<typename MODE>
+void BasicFramebuffer<MODE>::scrollRight()
+{
+    scrollHorizontal(highResolution_ ? 4 : 8);
+}
+
+/// @brief Expand the display to RGBA pixels.
+///
+/// Each display pixel becomes a scale x scale block.  A row is expanded
+/// once and copied to the following lines of the block.  The planes are
+/// presented as their union.
+///
+/// @param pixels    Destination of (DISPLAY_WIDTH x rowCount) x scale pixels.
+/// @param pitch     Destination line size in bytes.
+/// @param palette   Pixel colors.
+/// @param scale     Scale factor.
+/// @param firstRow  First display row to expand.
+/// @param rowCount  Count of display rows to expand.
+template<typename MODE>
+void BasicFramebuffer<MODE>::expand(void * pixels,
+                                    size_t pitch,
+                                    pixel::Palette const& palette,
+                                    uint32_t scale,
+                                    uint32_t firstRow,
+                                    uint32_t rowCount) const
+{
+    auto line = static_cast<uint8_t *>(pixels);
+    size_t lineSize = DISPLAY_WIDTH * scale * PIXEL_SIZE;
+
+    for (uint32_t y = firstRow; y < firstRow + rowCount; ++y)
+    {
+        auto first = line;
+        Row row = rows_[0][y];
+
+        for (uint32_t plane = 1; plane < PLANE_COUNT; ++plane)
+        {
+            row |= rows_[plane][y];
+        }
+
+        for (uint32_t word = 0; word < DISPLAY_WIDTH / pixel::ROW_WIDTH; ++word)
+        {
+            auto bits = static_cast<uint64_t>(row >> (DISPLAY_WIDTH - pixel::ROW_WIDTH * (word + 1)));
+            auto start = reinterpret_cast<Pixel *>(first) + word * pixel::ROW_WIDTH * scale;
+
+            pixel::expandRow(bits, palette, scale, start);
+        }
+
+        line += pitch;
+
+        for (uint32_t copy = 1; copy < scale; ++copy, line += pitch)
+        {
+            std::memcpy(line, first, lineSize);
+        }
+    }
+}
+
+/// @brief Compute the row mask of a pixel.
+///
+/// @param x  X coordinate, wrapped around the display.
+/// @return Row with only the pixel bit set.
+template<typename MODE>
+typename BasicFramebuffer<MODE>::Row BasicFramebuffer<MODE>::computePixelMask(uint8_t x)
+{
+    return Row{ 1 } << (DISPLAY_WIDTH - 1 - (x & (DISPLAY_WIDTH - 1)));
+}
+
+/// @brief Draw sprite rows to the selected planes.
+///
+/// Each selected plane takes the next `height` rows of the sprite.  In low
+/// resolution the coordinates are doubled and each row is spread to twice
+/// its pixels and drawn on two display rows.
+///
+/// @tparam WIDTH  Sprite width, 8 or 16 pixels.
+/// @param  x      X coordinate on display screen.
+/// @param  y      Y coordinate on display screen.
+/// @param  sprite Sprite rows.
+/// @param  height Count of rows per plane.
+/// @return True when a pixel is erased, otherwise false.
+template<typename MODE>
+template<uint32_t WIDTH>
+bool BasicFramebuffer<MODE>::blit(uint8_t x, uint8_t y, Sprite const& sprite, size_t height)
+{
+    constexpr uint32_t BYTES = WIDTH / 8;
+
+    Row collision = 0;
+    size_t offset = 0;
+
+    for (uint32_t plane = 0; plane < PLANE_COUNT; ++plane)
+    {
+        if ((planes_ & (1u << plane)) == 0)
+        {
+            continue;
+        }
+
+        for (size_t spriteY = 0; spriteY < height; ++spriteY, offset += BYTES)
+        {
+            uint32_t bits = sprite[offset];
+
+            if constexpr (BYTES == 2)
+            {
+                bits = (bits << 8) | sprite[offset + 1];
+            }
+
+            if (!MODE::EXTENDED || highResolution_)
+            {
+                Row spriteRow = rotateRight<Row, DISPLAY_WIDTH>(static_cast<Row>(bits) << (DISPLAY_WIDTH - WIDTH),
+                                                                x & (DISPLAY_WIDTH - 1));
+
+                collision |= xorRow(plane, y + spriteY, spriteRow);
+            }
+            else
+            {
+                Row spriteRow = rotateRight<Row, DISPLAY_WIDTH>(static_cast<Row>(spreadBits(bits)) << (DISPLAY_WIDTH - 2 * WIDTH),
+                                                                (2 * x) & (DISPLAY_WIDTH - 1));
+                uint32_t rowIndex = 2 * (y + spriteY);
+
+                collision |= xorRow(plane, rowIndex, spriteRow);
+                collision |= xorRow(plane, rowIndex + 1, spriteRow);
+            }
+        }
+    }
+
+    return collision != 0;
+}
+
+/// @brief Move the rows of the selected planes.
+///
+/// Rows scrolled in are blank.
+///
+/// @param count Count of rows, positive down.
+template<typename MODE>
+void BasicFramebuffer<MODE>::scrollVertical(int32_t count)
+{
+    for (uint32_t plane = 0; plane < PLANE_COUNT; ++plane)
+    {
+        if ((planes_ & (1u << plane)) == 0)
+        {
+            continue;
+        }
+
+        Row moved[DISPLAY_HEIGHT];
+        auto & rows = rows_[plane];
+
+        for (int32_t y = 0; y < static_cast<int32_t>(DISPLAY_HEIGHT); ++y)
+        {
+            int32_t from = y - count;
+
+            moved[y] = (from >= 0 && from < static_cast<int32_t>(DISPLAY_HEIGHT)) ? rows[from] : 0;
+        }
+
+        for (uint32_t y = 0; y < DISPLAY_HEIGHT; ++y)
+        {
+            if (rows[y] != moved[y])
+            {
+                rows[y] = moved[y];
+                dirtyRows_ |= RowMask{ 1 } << y;
+            }
+        }
+    }
+}
+
+/// @brief Shift the rows of the selected planes, one word shift per row.
+///
+/// Pixels scrolled in are blank.
+///
+/// @param count Count of pixels, positive right.
+template<typename MODE>
+void BasicFramebuffer<MODE>::scrollHorizontal(int32_t count)
+{
+    for (uint32_t plane = 0; plane < PLANE_COUNT; ++plane)
+    {
+        if ((planes_ & (1u << plane)) == 0)
+        {
+            continue;
+        }
+
+        for (uint32_t y = 0; y < DISPLAY_HEIGHT; ++y)
+        {
+            auto & row = rows_[plane][y];
+
+            if (row != 0)
+            {
+                row = (count > 0) ? (row >> count) : (row << -count);
+                dirtyRows_ |= RowMask{ 1 } << y;
+            }
+        }
+    }
+}
+
+template class BasicFramebuffer<ClassicMode>;
+template class BasicFramebuffer<ExtendedMode>;
+
+} // namespace chip8
@@ -0,0 +1,251 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_FRAMEBUFFER_HPP
+#define CHIP8_FRAMEBUFFER_HPP
+
+#include <core.hpp>
+#include <machine_mode.hpp>
+#include <memory.hpp>
+#include <pixel_expand.hpp>
+
+namespace chip8 {
+
+/// @brief Non-owning view of sprite rows, one byte per row.
+///
+/// Reads straight from memory without copying.  Rows past the end of
+/// memory wrap around to its start.
+class Sprite
+{
+    public:
+        /// @brief Construct a view of sprite rows in memory.
+        ///
+        /// @param memory      Memory bytes.
+        /// @param memorySize  Memory size in bytes.
+        /// @param address     Address of the first row.
+        /// @param length      Count of rows.
+        Sprite(uint8_t const * memory, size_t memorySize, uint16_t address, size_t length)
+            : memory_{ memory }
+            , memorySize_{ memorySize }
+            , start_{ (memorySize != 0) ? address % memorySize : 0 }
+            , length_{ length }
+        {
+        }
+
+        /// @brief Construct a view of all bytes of a buffer.
+        ///
+        /// @param bytes Buffer to view, must outlive the sprite.
+        Sprite(Memory::Bytes const& bytes)
+            : Sprite(bytes.data(), bytes.size(), 0, bytes.size())
+        {
+        }
+
+        /// @brief Return the count of rows.
+        size_t size() const { return length_; }
+
+        /// @brief Return a sprite row.
+        uint8_t operator[](size_t row) const
+        {
+            size_t index = start_ + row;
+
+            if (index >= memorySize_)
+            {
+                index -= memorySize_;
+            }
+
+            return memory_[index];
+        }
+
+    private:
+        /// @brief Memory bytes.
+        uint8_t const * memory_;
+        /// @brief Memory size in bytes.
+        size_t memorySize_;
+        /// @brief Offset of the first row.
+        size_t start_;
+        /// @brief Count of rows.
+        size_t length_;
+};
+
+/// @brief Framebuffer holding the CHIP-8 display pixels.
+///
+/// The display is a 1 bit per pixel plane of one word per row, the most
+/// significant bit being the leftmost pixel.  Pixels are expanded to RGBA
+/// only when a frame is presented.  Rows changed since the last
+/// presentation are tracked so unchanged frames cost nothing.
+///
+/// The extended display has 128-bit rows and two planes.  Drawing and
+/// scrolling apply to the selected planes, and in low resolution every
+/// pixel is drawn as a 2x2 block, so both resolutions share the same
+/// blitter.  Both framebuffers are explicitly instantiated in
+/// framebuffer.cpp.
+///
+/// @tparam MODE Machine mode, `ClassicMode` or `ExtendedMode`.
+template<typename MODE>
+class BasicFramebuffer
+{
+    public:
+        /// @brief Display width in pixels.
+        static constexpr uint32_t DISPLAY_WIDTH = MODE::DISPLAY_WIDTH;
+        /// @brief Display height in pixels.
+        static constexpr uint32_t DISPLAY_HEIGHT = MODE::DISPLAY_HEIGHT;
+        /// @brief Display bit plane count.
+        static constexpr uint32_t PLANE_COUNT = MODE::PLANE_COUNT;
+
+        /// @brief Display row, one bit per pixel.
+        using Row = typename MODE::Row;
+        /// @brief Pixel type, in RGBA8888 format.
+        using Pixel = pixel::Pixel;
+
+        /// @brief Display pixel count.
+        static constexpr size_t PIXEL_COUNT = DISPLAY_WIDTH * DISPLAY_HEIGHT;
+        /// @brief Pixel size in bytes
+        static constexpr size_t PIXEL_SIZE = sizeof(Pixel);
+        /// @brief Pixel row size in bytes.
+        static constexpr size_t PITCH = DISPLAY_WIDTH * PIXEL_SIZE;
+
+        BasicFramebuffer();
+        ~BasicFramebuffer();
+
+        /// @brief Dirty row mask, one bit per row.
+        using RowMask = typename MODE::RowMask;
+
+        /// @brief Return the display rows of a plane.
+        Row const * rows(uint32_t plane = 0) const
+        {
+            return rows_[plane];
+        }
+
+        uint8_t getPixel(uint8_t x, uint8_t y) const;
+        void    setPixel(uint8_t x, uint8_t y, uint8_t byte);
+
+        /// @brief Return the rows changed since the last `markClean()`.
+        RowMask getDirtyRows() const
+        {
+            return dirtyRows_;
+        }
+
+        /// @brief Forget changed rows, once presented.
+        void markClean()
+        {
+            dirtyRows_ = 0;
+        }
+
+        /// @brief Select the planes drawn, scrolled and cleared.
+        ///
+        /// @param planes Plane mask, bit 0 for the first plane.
+        void selectPlanes(uint8_t planes)
+        {
+            planes_ = planes & ((1u << PLANE_COUNT) - 1);
+        }
+
+        /// @brief Return the selected plane mask.
+        uint8_t getSelectedPlanes() const
+        {
+            return planes_;
+        }
+
+        /// @brief Return the count of selected planes.
+        uint32_t getSelectedPlaneCount() const
+        {
+            return __builtin_popcount(planes_);
+        }
+
+        /// @brief Return true in high resolution, always for a classic display.
+        bool isHighResolution() const
+        {
+            return highResolution_;
+        }
+
+        void setHighResolution(bool enabled);
+
+        void clear();
+        void loadRows(Row const * rows);
+        bool drawSprite(uint8_t x, uint8_t y, Sprite const& sprite);
+        bool drawLargeSprite(uint8_t x, uint8_t y, Sprite const& sprite);
+
+        void scrollDown(uint8_t count);
+        void scrollUp(uint8_t count);
+        void scrollLeft();
+        void scrollRight();
+
+        void expand(void * pixels,
+                    size_t pitch,
+                    pixel::Palette const& palette = pixel::DEFAULT_PALETTE,
+                    uint32_t scale = 1,
+                    uint32_t firstRow = 0,
+                    uint32_t rowCount = DISPLAY_HEIGHT) const;
+
+    private:
+        static Row computePixelMask(uint8_t x);
+
+        template<uint32_t WIDTH>
+        bool blit(uint8_t x, uint8_t y, Sprite const& sprite, size_t height);
+
+        void scrollVertical(int32_t count);
+        void scrollHorizontal(int32_t count);
+
+        /// @brief XOR a sprite row into a display row.
+        ///
+        /// @param plane     Plane index.
+        /// @param rowIndex  Row index, wrapped around the display.
+        /// @param spriteRow Sprite row at its X coordinate.
+        /// @return Pixels erased.
+        Row xorRow(uint32_t plane, uint32_t rowIndex, Row spriteRow)
+        {
+            rowIndex &= DISPLAY_HEIGHT - 1;
+
+            auto & row = rows_[plane][rowIndex];
+            Row collision = row & spriteRow;
+
+            row ^= spriteRow;
+
+            if (spriteRow != 0)
+            {
+                dirtyRows_ |= RowMask{ 1 } << rowIndex;
+            }
+
+            return collision;
+        }
+
+        /// @brief Display rows.
+        Row rows_[PLANE_COUNT][DISPLAY_HEIGHT];
+        /// @brief Rows changed since last presented.
+        RowMask dirtyRows_;
+        /// @brief Selected planes.
+        uint8_t planes_;
+        /// @brief High resolution, pixels are not doubled.
+        bool highResolution_;
+};
+
+extern template class BasicFramebuffer<ClassicMode>;
+extern template class BasicFramebuffer<ExtendedMode>;
+
+/// @brief Classic 64x32 framebuffer.
+using Framebuffer = BasicFramebuffer<ClassicMode>;
+/// @brief SUPER-CHIP and XO-CHIP 128x64 framebuffer of two planes.
+using ExtendedFramebuffer = BasicFramebuffer<ExtendedMode>;
+
+}  // chip8
+
+#endif  // CHIP8_FRAMEBUFFER_HPP
@@ -21,6 +21,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include <algorithm>
 #include <cstdio>
 #include <SDL2/SDL.h>
 
@@ -29,140 +30,133 @@
 
 namespace chip8 {
 
-/// @brief Construct a framebuffer instance.
+namespace {
+
+/// @brief Pixel format to use.
+const uint32_t PIXEL_FORMAT = SDL_PIXELFORMAT_RGBA8888;
+
+} // namespace
+
+/// @brief Construct a GPU instance with framebuffer.
 ///
-/// @param renderer  Reference to renderer to construct texture frame.
-Framebuffer::Framebuffer(SDL_Renderer * renderer)
-    : pixelbuffer_{ }
+/// The texture is already scaled, so a window of the scaled display size
+/// presents it without renderer scaling.
+///
+/// @param renderer  Instance of gpu renderer.
+/// @param scale     Display scale factor.
+/// @param palette   Pixel colors.
+GpuImpl::GpuImpl(SDL_Renderer * renderer, uint32_t scale, pixel::Palette const& palette)
+    : renderer_{ renderer }
     , frame_{ nullptr }
+    , framebuffer_{ std::make_unique<Framebuffer>() }
+    , frames_{ std::make_unique<TripleBuffer<Frame>>() }
+    , presented_{ std::make_unique<Framebuffer>() }
+    , scale_{ scale }
+    , palette_{ palette }
+    , droppedFrames_{ 0 }
 {
     frame_ = SDL_CreateTexture(renderer,
                                PIXEL_FORMAT,
                                SDL_TEXTUREACCESS_STREAMING,
-                               DISPLAY_WIDTH,
-                               DISPLAY_HEIGHT);
+                               Framebuffer::DISPLAY_WIDTH * scale_,
+                               Framebuffer::DISPLAY_HEIGHT * scale_);
 }
 
-/// @brief Destroy the framebuffer instance.
-Framebuffer::~Framebuffer()
+/// @brief Destroy the GPU instance.
+GpuImpl::~GpuImpl()
 {
     SDL_DestroyTexture(frame_);
+    SDL_DestroyRenderer(renderer_);
 }
 
-/// @brief Set pixel value.
+/// @brief Clear frame buffer.
 ///
-/// @param x     X coordinate in display.
-/// @param y     Y coordinate in display.
-/// @param byte  Pixel value.
-void Framebuffer::setPixel(uint8_t x, uint8_t y, uint8_t pixel)
+/// The cleared frame is presented on the next draw.
+void GpuImpl::clearFrame()
 {
-    auto address = computeLinearAddress(x, y);
-    pixelbuffer_[address] = (0xFFFFFF00 * pixel) | 0x000000FF;
+    framebuffer_->clear();
 }
 
-/// @brief Get pixel value.
+/// @brief Draw a sprite.
 ///
-/// @param x     X coordinate in display.
-/// @param y     Y coordinate in display.
-/// @return Pixel value.
-uint8_t Framebuffer::getPixel(uint8_t x, uint8_t y)
-{
-    auto address = computeLinearAddress(x, y);
-    auto pixel = (pixelbuffer_[address] >> 8);
-    return pixel & 0x1;
-}
-
-/// @brief Draw framebuffer to frame texture.
-void Framebuffer::draw()
+/// @param x       X coordinate on display screen.
+/// @param y       Y coordinate on display screen.
+/// @param sprite  Spite 8xN
+/// @return True when a pixel is erased, otherwise false.
+bool GpuImpl::drawSprite(uint8_t x, uint8_t y, Sprite const& sprite)
 {
-    SDL_UpdateTexture(frame_, nullptr, pixelbuffer_, DISPLAY_WIDTH * PIXEL_SIZE);
+    return framebuffer_->drawSprite(x, y, sprite);
 }
 
-/// @brief Compute address from (x,y) coords.
+/// @brief Hand the framebuffer to the presentation thread.
 ///
-/// @param x  X coordinate.
-/// @param y  Y coordinate.
-/// @return 16-bit address.
-uint16_t Framebuffer::computeLinearAddress(uint8_t x, uint8_t y)
+/// Called from the emulation thread, never blocks.  Nothing is handed
+/// over when the display did not change.  A frame handed over while the
+/// previous one was still waiting is counted as dropped.
+void GpuImpl::draw()
 {
-    // Wrap around screen
-    x &= (DISPLAY_WIDTH - 1);
-    y &= (DISPLAY_HEIGHT - 1);
-
-    return DISPLAY_WIDTH * y + x;
-}
+    if (framebuffer_->getDirtyRows() == 0)
+    {
+        return;
+    }
 
-/// @brief Construct a GPU instance with framebuffer.
-///
-/// @param renderer  Instance of gpu renderer.
-GpuImpl::GpuImpl(SDL_Renderer * renderer)
-    : renderer_{ renderer }
-    , framebuffer_{ std::make_unique<Framebuffer>(renderer) }
-{
-}
+    auto & frame = frames_->back();
+    std::copy(framebuffer_->rows(), framebuffer_->rows() + Framebuffer::DISPLAY_HEIGHT, frame.begin());
+    if (frames_->publish())
+    {
+        ++droppedFrames_;
+    }
 
-/// @brief Destroy the GPU instance.
-GpuImpl::~GpuImpl()
-{
-    SDL_DestroyRenderer(renderer_);
+    framebuffer_->markClean();
 }
 
-/// @brief Clear frame buffer.
-void GpuImpl::clearFrame()
+/// @brief Present the newest frame to the window.
+///
+/// Called from the presentation thread.  Only the span of rows changed
+/// since the last presented frame is uploaded.
+///
+/// @return True when a frame was presented, otherwise false.
+bool GpuImpl::present()
 {
-    for (size_t y = 0; y < Framebuffer::DISPLAY_HEIGHT; ++y)
+    if (!frames_->update())
     {
-        for (size_t x = 0; x < Framebuffer::DISPLAY_WIDTH; ++x)
-        {
-            framebuffer_->setPixel(x, y, 0);
-        }
+        return false;
     }
 
-    draw();
-}
+    presented_->loadRows(frames_->front().data());
 
-/// @brief Draw a sprite.
-///
-/// @param x       X coordinate on display screen.
-/// @param y       Y coordinate on display screen.
-/// @param sprite  Spite 8xN
-/// @return True when a pixel is erased, otherwise false.
-bool GpuImpl::drawSprite(uint8_t x, uint8_t y, Sprite const& sprite)
-{
-    bool erased = false;
+    auto dirtyRows = presented_->getDirtyRows();
 
-    for (size_t spriteY = 0; spriteY < sprite.size(); ++spriteY)
+    if (dirtyRows == 0)
     {
-        for (size_t spriteX = 0; spriteX < 8; ++spriteX)
-        {
-            uint8_t currentPixel = framebuffer_->getPixel(x + spriteX, y + spriteY);
-            uint8_t spritePixel = (sprite[spriteY] >> (7 - spriteX)) & 0x1;
+        return false;
+    }
 
-            if (currentPixel == 1 && spritePixel == 1)
-            {
-                erased = true;
-            }
+    uint32_t firstRow = __builtin_ctz(dirtyRows);
+    uint32_t rowCount = Framebuffer::DISPLAY_HEIGHT - __builtin_clz(dirtyRows) - firstRow;
 
-            currentPixel ^= spritePixel;
+    SDL_Rect area{ 0,
+                   static_cast<int>(firstRow * scale_),
+                   static_cast<int>(Framebuffer::DISPLAY_WIDTH * scale_),
+                   static_cast<int>(rowCount * scale_) };
 
-            uint8_t fbX = x + spriteX;
-            uint8_t fbY = y + spriteY;
+    void * pixels = nullptr;
+    int pitch = 0;
 
-            framebuffer_->setPixel(fbX, fbY, currentPixel);
-        }
+    // Expand straight into texture memory, locked pixels are write only
+    if (SDL_LockTexture(frame_, &area, &pixels, &pitch) == 0)
+    {
+        presented_->expand(pixels, pitch, palette_, scale_, firstRow, rowCount);
+        SDL_UnlockTexture(frame_);
     }
 
-    return erased;
-}
-
-/// @brief Draw framebuffer to window.
-void GpuImpl::draw()
-{
-    framebuffer_->draw();
+    presented_->markClean();
 
     SDL_RenderClear(renderer_);
-    SDL_RenderCopy(renderer_, framebuffer_->frame(), nullptr, nullptr);
+    SDL_RenderCopy(renderer_, frame_, nullptr, nullptr);
     SDL_RenderPresent(renderer_);
+
+    return true;
 }
 
 } // namespace chip8
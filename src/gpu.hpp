@@ -24,60 +24,16 @@
 #ifndef CHIP8_GPU_HPP
 #define CHIP8_GPU_HPP
 
-#include <SDL2/SDL.h>
+#include <array>
 
 #include <core.hpp>
-#include <memory.hpp>
+#include <framebuffer.hpp>
+#include <triple_buffer.hpp>
 
-namespace chip8 {
-
-using Sprite = Memory::Bytes;
-
-class GpuImpl;
-
-/// @brief  Framebuffer for the GpuImpl.
-class Framebuffer
-{
-    public:
-        /// @brief Display width for CHIP-8
-        static const uint32_t DISPLAY_WIDTH = 64;
-        /// @brief Display height for CHIP-8
-        static const uint32_t DISPLAY_HEIGHT = 32;
-
-        Framebuffer(SDL_Renderer * renderer);
-        ~Framebuffer();
-
-        /// @brief Return a refernce to the frame texture.
-        SDL_Texture * frame()
-        {
-            return frame_;
-        }
-
-        uint8_t getPixel(uint8_t x, uint8_t y);
-        void    setPixel(uint8_t x, uint8_t y, uint8_t byte);
-
-        void draw();
-
-    private:
-        /// @brief Pixel type.
-        using Pixel = uint32_t;
-
-        /// @brief Pixel format to use.
-        static const uint32_t PIXEL_FORMAT = SDL_PIXELFORMAT_RGBA8888;
-        /// @brief Pixel size in bytes
-        static const size_t PIXEL_SIZE = sizeof(Pixel);
+struct SDL_Renderer;
+struct SDL_Texture;
 
-        /// @brief GPU framebuffer size.
-        static constexpr uint16_t FRAMEBUFFER_SIZE = DISPLAY_WIDTH * DISPLAY_HEIGHT;
-
-        static uint16_t computeLinearAddress(uint8_t x, uint8_t y);
-
-        /// @brief Texture representing the CHIP-8 display
-        SDL_Texture *  frame_;
-
-        /// @brief Local copy of pixel values.
-        Pixel pixelbuffer_[FRAMEBUFFER_SIZE];
-};
+namespace chip8 {
 
 /// @brief Represent the CHIP-8 GPU.
 class Gpu
@@ -88,27 +44,59 @@ class Gpu
         virtual void clearFrame() = 0;
         virtual bool drawSprite(uint8_t x, uint8_t y, Sprite const& sprite) = 0;
         virtual void draw() = 0;
+
+        virtual Framebuffer & getFramebuffer() = 0;
 };
 
 /// @brief Represent the CHIP-8 GPU implementation.
+///
+/// The emulation thread draws to the framebuffer and hands finished frames
+/// to the presentation thread through a triple buffer, so the emulation
+/// never waits on the display.  A frame is the 1 bpp display, 256 bytes.
 class GpuImpl : public Gpu
 {
     public:
-        GpuImpl(SDL_Renderer * renderer);
+        /// @brief Default display scale factor.
+        static constexpr uint32_t DEFAULT_SCALE = 16;
+
+        /// @brief Frame handed to the presentation thread.
+        using Frame = std::array<Framebuffer::Row, Framebuffer::DISPLAY_HEIGHT>;
+
+        GpuImpl(SDL_Renderer * renderer,
+                uint32_t scale = DEFAULT_SCALE,
+                pixel::Palette const& palette = pixel::DEFAULT_PALETTE);
         ~GpuImpl();
 
         void clearFrame() override;
         bool drawSprite(uint8_t x, uint8_t y, Sprite const& sprite) override;
         void draw() override;
+        bool present();
+
+        Framebuffer & getFramebuffer() override { return *framebuffer_; }
+
+        /// @brief Return the frames replaced before being presented, from
+        ///        the emulation thread.
+        uint64_t getDroppedFrameCount() const { return droppedFrames_; }
 
     private:
         /// @brief Renderer to display pixels.
         SDL_Renderer * renderer_;
+        /// @brief Texture representing the CHIP-8 display
+        SDL_Texture * frame_;
         /// @brief Framebuffer containing the pixels.
         std::unique_ptr<Framebuffer> framebuffer_;
+        /// @brief Frames from the emulation thread to the presentation thread.
+        std::unique_ptr<TripleBuffer<Frame>> frames_;
+        /// @brief Framebuffer of the presented frame, on the presentation thread.
+        std::unique_ptr<Framebuffer> presented_;
+        /// @brief Display scale factor.
+        uint32_t scale_;
+        /// @brief Pixel colors.
+        pixel::Palette palette_;
+        /// @brief Frames replaced before being presented.
+        uint64_t droppedFrames_;
 };
 
 }  // chip8
 
 #endif  // CHIP8_GPU_HPP
-
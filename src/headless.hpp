@@ -0,0 +1,185 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_HEADLESS_HPP
+#define CHIP8_HEADLESS_HPP
+
+#include <core.hpp>
+#include <framebuffer.hpp>
+#include <gpu.hpp>
+#include <keyboard.hpp>
+
+namespace chip8 {
+
+/// @brief Represent a GPU drawing to a framebuffer that is never presented.
+///
+/// Final with inline members, so a `HeadlessCpu` calls it directly.
+class HeadlessGpu final : public Gpu
+{
+    public:
+        HeadlessGpu();
+        ~HeadlessGpu();
+
+        /// @brief Clear frame buffer.
+        void clearFrame() override
+        {
+            framebuffer_.clear();
+        }
+
+        /// @brief Draw a sprite.
+        ///
+        /// @param x       X coordinate on display screen.
+        /// @param y       Y coordinate on display screen.
+        /// @param sprite  Spite 8xN
+        /// @return True when a pixel is erased, otherwise false.
+        bool drawSprite(uint8_t x, uint8_t y, Sprite const& sprite) override
+        {
+            return framebuffer_.drawSprite(x, y, sprite);
+        }
+
+        /// @brief Draw framebuffer, nothing is presented.
+        void draw() override
+        {
+        }
+
+        Framebuffer & getFramebuffer() override { return framebuffer_; }
+
+        /// @brief Return the framebuffer.
+        Framebuffer const& framebuffer() const
+        {
+            return framebuffer_;
+        }
+
+    private:
+        /// @brief Framebuffer containing the pixels.
+        Framebuffer framebuffer_;
+};
+
+/// @brief Represent a SUPER-CHIP and XO-CHIP GPU drawing to a framebuffer
+///        that is never presented.
+///
+/// Final with inline members, so an `ExtendedCpu` calls it directly.  It
+/// has no virtual base, the `Gpu` interface presents classic displays.
+class HeadlessExtendedGpu final
+{
+    public:
+        HeadlessExtendedGpu();
+        ~HeadlessExtendedGpu();
+
+        /// @brief Clear the selected planes.
+        void clearFrame()
+        {
+            framebuffer_.clear();
+        }
+
+        /// @brief Draw a sprite.
+        ///
+        /// @param x       X coordinate on display screen.
+        /// @param y       Y coordinate on display screen.
+        /// @param sprite  Spite 8xN, N rows per selected plane.
+        /// @return True when a pixel is erased, otherwise false.
+        bool drawSprite(uint8_t x, uint8_t y, Sprite const& sprite)
+        {
+            return framebuffer_.drawSprite(x, y, sprite);
+        }
+
+        /// @brief Draw a 16x16 sprite.
+        ///
+        /// @param x       X coordinate on display screen.
+        /// @param y       Y coordinate on display screen.
+        /// @param sprite  Sprite of 32 bytes per selected plane.
+        /// @return True when a pixel is erased, otherwise false.
+        bool drawLargeSprite(uint8_t x, uint8_t y, Sprite const& sprite)
+        {
+            return framebuffer_.drawLargeSprite(x, y, sprite);
+        }
+
+        void scrollDown(uint8_t count) { framebuffer_.scrollDown(count); }
+        void scrollUp(uint8_t count) { framebuffer_.scrollUp(count); }
+        void scrollLeft() { framebuffer_.scrollLeft(); }
+        void scrollRight() { framebuffer_.scrollRight(); }
+
+        void setHighResolution(bool enabled) { framebuffer_.setHighResolution(enabled); }
+        void selectPlanes(uint8_t planes) { framebuffer_.selectPlanes(planes); }
+
+        /// @brief Draw framebuffer, nothing is presented.
+        void draw()
+        {
+        }
+
+        ExtendedFramebuffer & getFramebuffer() { return framebuffer_; }
+
+        /// @brief Return the framebuffer.
+        ExtendedFramebuffer const& framebuffer() const
+        {
+            return framebuffer_;
+        }
+
+    private:
+        /// @brief Framebuffer containing the pixels.
+        ExtendedFramebuffer framebuffer_;
+};
+
+/// @brief Represent a keyboard with no key ever pressed.
+///
+/// Final with inline members, so a `HeadlessCpu` calls it directly.
+class HeadlessKeyboard final : public Keyboard
+{
+    public:
+        HeadlessKeyboard();
+        ~HeadlessKeyboard();
+
+        /// @brief Check if quit is requested.
+        ///
+        /// @return Always false, a headless run ends on its cycle count.
+        bool isQuitRequested() const override
+        {
+            return false;
+        }
+
+        /// @brief Is key currently pressed.
+        ///
+        /// @param key  The key to check.
+        /// @return Always false.
+        bool isKeyPressed(uint16_t /*key*/) const override
+        {
+            return false;
+        }
+
+        /// @brief Return the pressed keys.
+        ///
+        /// @return Always none.
+        uint16_t getKeys() const override
+        {
+            return 0;
+        }
+
+        /// @brief Update keyboard events, there are none.
+        void update() override
+        {
+        }
+};
+
+}  // chip8
+
+#endif  // CHIP8_HEADLESS_HPP
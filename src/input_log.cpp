@@ -0,0 +1,310 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <cstring>
+
+#include "input_log.hpp"
+
+namespace chip8 {
+
+namespace {
+
+/// @brief Input log header, followed by the records.
+struct InputLogHeader
+{
+    /// @brief File magic, "C8IN".
+    char     magic[4];
+    /// @brief File format version.
+    uint16_t version;
+    /// @brief Random generator algorithm of the CPU.
+    uint16_t random;
+    /// @brief Random seed of the CPU.
+    uint32_t seed;
+    /// @brief Emulated CPU rate.
+    uint32_t cpuRate;
+};
+
+/// @brief Input log format version.
+const uint16_t INPUT_LOG_VERSION = 1;
+
+/// @brief Record type of the session end, other unknown types also end a log.
+const uint8_t END_TYPE = 0xF;
+
+static_assert(sizeof(InputLogHeader) == 16, "Input log header layout is part of the log format");
+
+} // namespace
+
+/// @brief Construct a closed input recorder.
+InputRecorder::InputRecorder()
+    : file_{ nullptr }
+    , cycle_{ 0 }
+    , eventCount_{ 0 }
+{
+}
+
+/// @brief Destroy an input recorder, the log is left without end record.
+InputRecorder::~InputRecorder()
+{
+    if (file_ != nullptr)
+    {
+        std::fclose(file_);
+    }
+}
+
+/// @brief Create a log and write its header.
+///
+/// Fields are written in host byte order, little endian on supported hosts.
+///
+/// @param filename  File to write.
+/// @param algorithm Random generator algorithm of the CPU.
+/// @param seed      Random seed of the CPU.
+/// @param cpuRate   Emulated CPU rate.
+/// @return True when created, otherwise false.
+bool InputRecorder::open(std::string const& filename, Random::Algorithm algorithm, uint32_t seed, uint32_t cpuRate)
+{
+    file_ = std::fopen(filename.c_str(), "wb");
+
+    if (file_ == nullptr)
+    {
+        std::printf("Cannot write input log `%s'\n", filename.c_str());
+        return false;
+    }
+
+    InputLogHeader header{};
+    std::memcpy(header.magic, "C8IN", sizeof(header.magic));
+    header.version = INPUT_LOG_VERSION;
+    header.random  = static_cast<uint16_t>(algorithm);
+    header.seed    = seed;
+    header.cpuRate = cpuRate;
+
+    cycle_ = 0;
+    eventCount_ = 0;
+
+    return std::fwrite(&header, sizeof(header), 1, file_) == 1;
+}
+
+/// @brief Record an applied event.
+///
+/// @param cycle Cycle the event was applied at.
+/// @param event Event applied.
+void InputRecorder::record(uint64_t cycle, InputEvent const& event)
+{
+    if (file_ == nullptr)
+    {
+        return;
+    }
+
+    put(cycle, static_cast<uint8_t>(event.type), event.key);
+    ++eventCount_;
+
+    // Input is rare, flushing each change keeps the log readable live
+    std::fflush(file_);
+}
+
+/// @brief Write the end record and close the log.
+///
+/// @param cycle Cycle the session stopped at.
+/// @return True when the whole log was written, otherwise false.
+bool InputRecorder::close(uint64_t cycle)
+{
+    if (file_ == nullptr)
+    {
+        return false;
+    }
+
+    put(cycle, END_TYPE, 0);
+
+    bool written = (std::ferror(file_) == 0);
+    written = (std::fclose(file_) == 0) && written;
+    file_ = nullptr;
+
+    if (!written)
+    {
+        std::puts("Cannot write input log.");
+    }
+
+    return written;
+}
+
+/// @brief Write a record.
+///
+/// @param cycle Cycle of the record.
+/// @param type  Record type.
+/// @param key   Key of the record.
+void InputRecorder::put(uint64_t cycle, uint8_t type, uint8_t key)
+{
+    uint64_t delta = cycle - cycle_;
+    cycle_ = cycle;
+
+    while (delta >= 0x80)
+    {
+        std::fputc(static_cast<uint8_t>(delta | 0x80), file_);
+        delta >>= 7;
+    }
+
+    std::fputc(static_cast<uint8_t>(delta), file_);
+    std::fputc((type << 4) | (key & 0xF), file_);
+}
+
+/// @brief Construct a closed input replay.
+InputReplay::InputReplay()
+    : file_{ nullptr }
+    , randomAlgorithm_{ Random::Algorithm::PCG32 }
+    , seed_{ 0 }
+    , cpuRate_{ 0 }
+    , cycle_{ 0 }
+    , pending_{ }
+    , hasPending_{ false }
+    , atEnd_{ false }
+    , endCycle_{ 0 }
+{
+}
+
+/// @brief Destroy an input replay.
+InputReplay::~InputReplay()
+{
+    close();
+}
+
+/// @brief Open a log and read its header.
+///
+/// @param filename File to read.
+/// @return True when opened and valid, otherwise false.
+bool InputReplay::open(std::string const& filename)
+{
+    close();
+
+    file_ = std::fopen(filename.c_str(), "rb");
+
+    if (file_ == nullptr)
+    {
+        std::printf("Cannot read input log `%s'\n", filename.c_str());
+        return false;
+    }
+
+    InputLogHeader header{};
+
+    if (std::fread(&header, sizeof(header), 1, file_) != 1 ||
+        std::memcmp(header.magic, "C8IN", sizeof(header.magic)) != 0 ||
+        header.version != INPUT_LOG_VERSION ||
+        header.random > static_cast<uint16_t>(Random::Algorithm::PCG32) ||
+        header.cpuRate == 0)
+    {
+        std::printf("Invalid input log `%s'\n", filename.c_str());
+        close();
+        return false;
+    }
+
+    randomAlgorithm_ = static_cast<Random::Algorithm>(header.random);
+    seed_ = header.seed;
+    cpuRate_ = header.cpuRate;
+    cycle_ = 0;
+    hasPending_ = false;
+    atEnd_ = false;
+    endCycle_ = 0;
+
+    return true;
+}
+
+/// @brief Close the log.
+void InputReplay::close()
+{
+    if (file_ != nullptr)
+    {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+/// @brief Queue the events read ahead, until the queue is full.
+///
+/// Events keep their recorded cycle, the keyboard applies each one at the
+/// first input update at or after it.  A truncated log ends like one with
+/// an end record at its last event.
+///
+/// @param queue Queue of the replayed keyboard.
+void InputReplay::pump(InputQueue & queue)
+{
+    while (!atEnd_)
+    {
+        if (!hasPending_ && !read(pending_))
+        {
+            break;
+        }
+
+        hasPending_ = true;
+
+        if (!queue.push(pending_))
+        {
+            break;
+        }
+
+        hasPending_ = false;
+    }
+}
+
+/// @brief Read a record.
+///
+/// @param event Event read.
+/// @return True when an event was read, otherwise false at the end.
+bool InputReplay::read(InputEvent & event)
+{
+    uint64_t delta = 0;
+    int byte = 0;
+
+    for (uint32_t shift = 0; shift < 64; shift += 7)
+    {
+        byte = std::fgetc(file_);
+
+        if (byte == EOF)
+        {
+            break;
+        }
+
+        delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            break;
+        }
+    }
+
+    int record = (byte == EOF) ? EOF : std::fgetc(file_);
+
+    if (record == EOF || (record >> 4) > static_cast<int>(InputEvent::Type::QUIT))
+    {
+        atEnd_ = true;
+        endCycle_ = (record == EOF) ? cycle_ : cycle_ + delta;
+        return false;
+    }
+
+    cycle_ += delta;
+
+    event.cycle = cycle_;
+    event.type = static_cast<InputEvent::Type>(record >> 4);
+    event.key = record & 0xF;
+
+    return true;
+}
+
+}  // chip8
@@ -0,0 +1,130 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_INPUTLOG_HPP
+#define CHIP8_INPUTLOG_HPP
+
+#include <cstdio>
+#include <string>
+
+#include <core.hpp>
+#include <input_queue.hpp>
+#include <random.hpp>
+
+namespace chip8 {
+
+/// @brief Input log writer, recording applied input to replay a session.
+///
+/// The log starts with a header holding the random generator algorithm,
+/// the random seed and the CPU rate of the session, followed by one record
+/// per keyboard state change:
+///
+///     varint  emulated cycles since the previous record
+///     byte    event type in the high nibble, key in the low nibble
+///
+/// Events are stamped with the cycle they were applied at, so a replay
+/// sees every change at the same cycle.  A last record of type END holds
+/// the cycle the session stopped at.  Records are appended as they come,
+/// so the log of a running session can be read back at any time.
+class InputRecorder
+{
+    public:
+        InputRecorder();
+        ~InputRecorder();
+
+        InputRecorder(InputRecorder const&) = delete;
+        InputRecorder & operator=(InputRecorder const&) = delete;
+
+        bool open(std::string const& filename, Random::Algorithm algorithm, uint32_t seed, uint32_t cpuRate);
+        void record(uint64_t cycle, InputEvent const& event);
+        bool close(uint64_t cycle);
+
+        /// @brief Check if a log is open.
+        bool isOpen() const { return file_ != nullptr; }
+        /// @brief Return the count of events recorded.
+        uint64_t getEventCount() const { return eventCount_; }
+
+    private:
+        void put(uint64_t cycle, uint8_t type, uint8_t key);
+
+        /// @brief Log file.
+        std::FILE * file_;
+        /// @brief Cycle of the last record.
+        uint64_t cycle_;
+        /// @brief Events recorded.
+        uint64_t eventCount_;
+};
+
+/// @brief Input log reader, feeding recorded input to an input queue.
+class InputReplay
+{
+    public:
+        InputReplay();
+        ~InputReplay();
+
+        InputReplay(InputReplay const&) = delete;
+        InputReplay & operator=(InputReplay const&) = delete;
+
+        bool open(std::string const& filename);
+        void close();
+        void pump(InputQueue & queue);
+
+        /// @brief Check if a log is open.
+        bool isOpen() const { return file_ != nullptr; }
+        /// @brief Return the random generator algorithm of the session.
+        Random::Algorithm getRandomAlgorithm() const { return randomAlgorithm_; }
+        /// @brief Return the random seed of the session.
+        uint32_t getSeed() const { return seed_; }
+        /// @brief Return the CPU rate of the session.
+        uint32_t getCpuRate() const { return cpuRate_; }
+        /// @brief Check if the end record was read.
+        bool isAtEnd() const { return atEnd_; }
+        /// @brief Return the cycle the session stopped at, once at the end.
+        uint64_t getEndCycle() const { return endCycle_; }
+
+    private:
+        bool read(InputEvent & event);
+
+        /// @brief Log file.
+        std::FILE * file_;
+        /// @brief Random generator algorithm of the session.
+        Random::Algorithm randomAlgorithm_;
+        /// @brief Random seed of the session.
+        uint32_t seed_;
+        /// @brief CPU rate of the session.
+        uint32_t cpuRate_;
+        /// @brief Cycle of the last record read.
+        uint64_t cycle_;
+        /// @brief Event read and not queued yet.
+        InputEvent pending_;
+        /// @brief An event is pending.
+        bool hasPending_;
+        /// @brief The end record was read.
+        bool atEnd_;
+        /// @brief Cycle the session stopped at.
+        uint64_t endCycle_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_INPUTLOG_HPP
@@ -0,0 +1,94 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "input_queue.hpp"
+
+namespace chip8 {
+
+/// @brief Construct an empty input queue.
+InputQueue::InputQueue()
+    : events_{ }
+    , tail_{ 0 }
+    , head_{ 0 }
+{
+}
+
+/// @brief Destroy an input queue.
+InputQueue::~InputQueue()
+{
+}
+
+/// @brief Push an event, from the producer.
+///
+/// @param event Event to push.
+/// @return True when pushed, false when the queue is full.
+bool InputQueue::push(InputEvent const& event)
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+
+    if (tail - head_.load(std::memory_order_acquire) == CAPACITY)
+    {
+        return false;
+    }
+
+    events_[tail & (CAPACITY - 1)] = event;
+    tail_.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+/// @brief Read the oldest event without removing it, from the consumer.
+///
+/// @param event Oldest event.
+/// @return True when an event is queued, otherwise false.
+bool InputQueue::peek(InputEvent & event) const
+{
+    size_t head = head_.load(std::memory_order_relaxed);
+
+    if (head == tail_.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    event = events_[head & (CAPACITY - 1)];
+
+    return true;
+}
+
+/// @brief Remove the oldest event, from the consumer.
+///
+/// @param event Oldest event.
+/// @return True when an event was queued, otherwise false.
+bool InputQueue::pop(InputEvent & event)
+{
+    if (!peek(event))
+    {
+        return false;
+    }
+
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    return true;
+}
+
+}  // chip8
@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_INPUTQUEUE_HPP
+#define CHIP8_INPUTQUEUE_HPP
+
+#include <array>
+#include <atomic>
+
+#include <core.hpp>
+
+namespace chip8 {
+
+/// @brief Input event, stamped with the emulated cycle it applies at.
+struct InputEvent
+{
+    /// @brief Event type.
+    enum class Type : uint8_t { KEY_DOWN, KEY_UP, QUIT };
+
+    /// @brief Emulated cycle, the event applies at the first input update
+    ///        at or after it.
+    uint64_t cycle;
+    /// @brief Event type.
+    Type     type;
+    /// @brief Key, for key events.
+    uint8_t  key;
+};
+
+/// @brief Lock-free single producer, single consumer queue of input events.
+///
+/// The producer, e.g. an SDL event pump, an input thread or a replay, only
+/// pushes and the emulation thread only pops, so neither ever blocks.
+class InputQueue
+{
+    public:
+        /// @brief Event capacity, a power of two.
+        static constexpr size_t CAPACITY = 256;
+
+        InputQueue();
+        ~InputQueue();
+
+        bool push(InputEvent const& event);
+        bool peek(InputEvent & event) const;
+        bool pop(InputEvent & event);
+
+    private:
+        /// @brief Cache line size, so both ends do not share a line.
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Capacity must be a power of two");
+
+        /// @brief Event ring.
+        std::array<InputEvent, CAPACITY> events_;
+        /// @brief Count of events pushed, written by the producer.
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;
+        /// @brief Count of events popped, written by the consumer.
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_INPUTQUEUE_HPP
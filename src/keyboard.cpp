@@ -21,42 +21,19 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
-#include <cstring>
-#include <unordered_map>
-
 #include "keyboard.hpp"
 
 namespace chip8 {
 
-namespace {
-
-/// @brief Key mapping
-const std::unordered_map<SDL_Keycode, size_t> KEYMAP = {
-    { SDLK_0,  0 },
-    { SDLK_1,  1 },
-    { SDLK_2,  2 },
-    { SDLK_3,  3 },
-    { SDLK_4,  4 },
-    { SDLK_5,  5 },
-    { SDLK_6,  6 },
-    { SDLK_7,  7 },
-    { SDLK_8,  8 },
-    { SDLK_9,  9 },
-    { SDLK_a, 10 },
-    { SDLK_b, 11 },
-    { SDLK_c, 12 },
-    { SDLK_d, 13 },
-    { SDLK_e, 14 },
-    { SDLK_f, 15 },
-};
-
-} // namespace
-
 /// @brief Construct a keyboard implementation instance.
-KeyboardImpl::KeyboardImpl()
-    : quit_{ false }
+///
+/// @param queue Input events to apply.
+KeyboardImpl::KeyboardImpl(std::shared_ptr<InputQueue> queue)
+    : queue_{ std::move(queue) }
+    , recorder_{ nullptr }
+    , quit_{ false }
+    , keys_{ 0 }
 {
-    std::memset(&keys_, false, sizeof(bool) * KEY_COUNT);
 }
 
 /// @brief Destroy the keyboard instance.
@@ -64,45 +41,45 @@ KeyboardImpl::~KeyboardImpl()
 {
 }
 
-/// @brief Is key currently pressed.
+/// @brief Apply the queued events due at an emulated cycle.
 ///
-/// @param key  The key to check.
-/// @return True when pressed, otherwise false.
-bool KeyboardImpl::isKeyPressed(uint16_t key) const
-{
-    return keys_[key];
-}
-
-/// @brief Update keyboard events.
-void KeyboardImpl::update()
+/// Events stamped later stay queued for a later update.  Events changing
+/// the state are recorded at this cycle, events for keys past `KEY_COUNT`
+/// are dropped.
+///
+/// @param cycle Current emulated cycle.
+void KeyboardImpl::update(uint64_t cycle)
 {
-    SDL_Event event;
+    InputEvent event;
 
-    while (SDL_PollEvent(&event) != 0)
+    while (queue_->peek(event) && event.cycle <= cycle)
     {
-        if (event.type == SDL_QUIT)
+        queue_->pop(event);
+
+        if (event.type != InputEvent::Type::QUIT && event.key >= KEY_COUNT)
         {
-            quit_ = true;
+            continue;
         }
 
-        if (event.type == SDL_KEYDOWN)
-        {
-            auto entry = KEYMAP.find(event.key.keysym.sym);
+        uint16_t keys = keys_;
+        bool quit = quit_;
 
-            if (entry != KEYMAP.end())
-            {
-                keys_[entry->second] = true;
-            }
+        switch (event.type)
+        {
+            case InputEvent::Type::KEY_DOWN:
+                keys_ |= (1 << event.key);
+                break;
+            case InputEvent::Type::KEY_UP:
+                keys_ &= ~(1 << event.key);
+                break;
+            case InputEvent::Type::QUIT:
+                quit_ = true;
+                break;
         }
 
-        if (event.type == SDL_KEYUP)
+        if (recorder_ != nullptr && (keys != keys_ || quit != quit_))
         {
-            auto entry = KEYMAP.find(event.key.keysym.sym);
-
-            if (entry != KEYMAP.end())
-            {
-                keys_[entry->second] = false;
-            }
+            recorder_->record(cycle, event);
         }
     }
 }
@@ -25,9 +25,12 @@
 #define CHIP8_KEYBOARD_HPP
 
 #include <cstdio>
-#include <SDL2/SDL.h>
+#include <limits>
+#include <memory>
 
 #include <core.hpp>
+#include <input_log.hpp>
+#include <input_queue.hpp>
 
 
 namespace chip8 {
@@ -42,30 +45,59 @@ class Keyboard
 
         virtual bool isQuitRequested() const = 0;
         virtual bool isKeyPressed(uint16_t key) const  = 0;
+        /// @brief Return the pressed keys, bit n set for key n.
+        virtual uint16_t getKeys() const = 0;
         virtual void update() = 0;
 };
 
-/// @brief Keyboard implementation.
+/// @brief Keyboard implementation, driven by an input event queue.
+///
+/// Any producer fills the queue, the emulation thread applies the events
+/// at emulated cycle boundaries, so the CPU never polls for events.
 class KeyboardImpl : public Keyboard
 {
     public:
-        KeyboardImpl();
+        KeyboardImpl(std::shared_ptr<InputQueue> queue);
         ~KeyboardImpl();
 
         /// @brief Check if quit is requested.
-        bool isQuitRequested() const
+        bool isQuitRequested() const override
         {
             return quit_;
         }
 
-        bool isKeyPressed(uint16_t key) const override;
-        void update() override;
+        /// @brief Is key currently pressed, false for keys past `KEY_COUNT`.
+        bool isKeyPressed(uint16_t key) const override
+        {
+            return (key < KEY_COUNT) && ((keys_ >> key) & 0x1);
+        }
+
+        /// @brief Return the pressed keys, bit n set for key n.
+        uint16_t getKeys() const override
+        {
+            return keys_;
+        }
+
+        /// @brief Apply all queued events.
+        void update() override
+        {
+            update(std::numeric_limits<uint64_t>::max());
+        }
+
+        void update(uint64_t cycle);
+
+        /// @brief Record the state changes to an input log, null for none.
+        void setRecorder(InputRecorder * recorder) { recorder_ = recorder; }
 
     private:
+        /// @brief Input events.
+        std::shared_ptr<InputQueue> queue_;
+        /// @brief Recorder of the state changes.
+        InputRecorder * recorder_;
         /// @brief Quit event set.
         bool quit_;
-        /// @brief The keys state.
-        bool keys_[KEY_COUNT];
+        /// @brief The keys state, bit n for key n.
+        uint16_t keys_;
 };
 
 }  // chip8
@@ -0,0 +1,649 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <cstring>
+
+#include "lockstep_cpu.hpp"
+
+namespace chip8 {
+
+namespace {
+
+/// @brief Flag register index.
+const uint8_t VF = 0xF;
+
+/// @brief Build the byte masks of eight lanes.
+///
+/// @return Mask of each eight lane bits, 0xFF in the byte of each set bit.
+constexpr std::array<uint64_t, 256> makeByteMasks()
+{
+    std::array<uint64_t, 256> masks{};
+
+    for (size_t bits = 0; bits < masks.size(); ++bits)
+    {
+        for (size_t lane = 0; lane < 8; ++lane)
+        {
+            if ((bits >> lane) & 0x1)
+            {
+                masks[bits] |= uint64_t{ 0xFF } << (8 * lane);
+            }
+        }
+    }
+
+    return masks;
+}
+
+/// @brief Byte masks of eight lanes, the first in the low byte.
+constexpr std::array<uint64_t, 256> BYTE_MASKS = makeByteMasks();
+
+/// @brief Check if lanes running an opcode may go on at different PCs.
+///
+/// @param opcode Opcode.
+/// @return True for skips, computed jumps, returns and FX0A.
+bool isBranch(opcode::Opcode opcode)
+{
+    switch (opcode::decodeInstruction(opcode))
+    {
+        case opcode::OPCODE_00EE:
+        case opcode::OPCODE_3XKK:
+        case opcode::OPCODE_4XKK:
+        case opcode::OPCODE_5XY0:
+        case opcode::OPCODE_9XY0:
+        case opcode::OPCODE_BNNN:
+        case opcode::OPCODE_EX9E:
+        case opcode::OPCODE_EXA1:
+        case opcode::OPCODE_FX0A:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief Call a function with the index of each lane of a group.
+///
+/// @param group Lanes, one bit per lane.
+/// @param func  Function called with the lane index.
+template<typename FUNC>
+void forEachLane(uint32_t group, FUNC && func)
+{
+    for (; group != 0; group &= group - 1)
+    {
+        func(static_cast<size_t>(__builtin_ctz(group)));
+    }
+}
+
+} // namespace
+
+/// @brief Construct lane devices with a loaded program.
+///
+/// @param rom Program loaded at the program start.
+LockstepCpu::Lane::Lane(Rom const& rom)
+    : memory{ }
+    , gpu{ }
+    , keyboard{ }
+    , random{ }
+{
+    loadProgram(memory, rom);
+}
+
+/// @brief Construct a lockstep CPU.
+///
+/// @param rom        Program run by all lanes.
+/// @param laneCount  Count of lanes, at most LANES.
+LockstepCpu::LockstepCpu(Rom const& rom, size_t laneCount)
+    : laneCount_{ std::min(laneCount, LANES) }
+    , lanes_{ }
+    , pc_{ }
+    , vx_{ }
+    , i_{ }
+    , sp_{ }
+    , stack_{ }
+    , dt_{ }
+    , st_{ }
+    , waiting_{ }
+    , leaderContext_{ }
+    , opcode_{ 0x0000 }
+    , vectorSteps_{ 0 }
+    , scalarSteps_{ 0 }
+{
+    for (size_t lane = 0; lane < laneCount_; ++lane)
+    {
+        lanes_[lane] = std::make_unique<Lane>(rom);
+    }
+
+    reset();
+}
+
+/// @brief Destroy a lockstep CPU.
+LockstepCpu::~LockstepCpu()
+{
+}
+
+/// @brief Reset all lanes.
+///
+/// Stacks are kept, as on the scalar CPU.
+void LockstepCpu::reset()
+{
+    for (size_t lane = 0; lane < laneCount_; ++lane)
+    {
+        auto regs = getLaneContext(lane);
+
+        regs.pc = PROGRAM_START;
+        std::fill(regs.vx, regs.vx + REG_COUNT, 0);
+        regs.sp = 0;
+        regs.i  = 0;
+        regs.dt = 0;
+        regs.st = 0;
+
+        setLaneContext(lane, regs);
+    }
+}
+
+/// @brief Run one cycle on all lanes.
+void LockstepCpu::update()
+{
+    runLanes(1);
+}
+
+/// @brief Run cycles on all lanes.
+///
+/// Once all lanes are parked on FX0A the cycles are skipped, lane
+/// keyboards are headless so no key ever wakes them.
+///
+/// @param cycles Count of cycles to run.
+/// @return Count of cycles ran.
+uint32_t LockstepCpu::run(uint32_t cycles)
+{
+    if (!isWaitingForKey())
+    {
+        runLanes(cycles);
+    }
+
+    return cycles;
+}
+
+/// @brief Run the same count of cycles on each lane.
+///
+/// Lanes sharing their PC and opcode run as one group, lanes may run
+/// different code once they rewrote it.  Lanes only interact through the
+/// timers, ticked between runs, so within a run a lane need not run its
+/// cycles in step with the others: the group with the lowest PC runs
+/// first, and lanes ahead of it in the code wait until it joins them.
+/// Lanes split by a skip run together again once the others caught up.
+///
+/// A lane parked on FX0A stays parked for the rest of the run.
+///
+/// @param cycles Count of cycles to run on each lane.
+void LockstepCpu::runLanes(uint32_t cycles)
+{
+    std::array<uint32_t, LANES> remaining;
+    uint32_t active = (cycles != 0) ? (1u << laneCount_) - 1 : 0;
+    uint32_t candidates = 0;
+
+    remaining.fill(cycles);
+
+    while (active != 0)
+    {
+        // After an opcode moving all lanes alike, they are still together
+        if (candidates == 0)
+        {
+            size_t lowest = __builtin_ctz(active);
+
+            forEachLane(active, [&](size_t lane) {
+                if (pc_[lane] < pc_[lowest])
+                {
+                    lowest = lane;
+                }
+            });
+
+            forEachLane(active, [&](size_t lane) {
+                candidates |= static_cast<uint32_t>(pc_[lane] == pc_[lowest]) << lane;
+            });
+        }
+
+        size_t leader = __builtin_ctz(candidates);
+        uint16_t pc = pc_[leader];
+        auto opcode = lanes_[leader]->memory.load<opcode::Opcode>(pc);
+        uint32_t group = 0;
+
+        forEachLane(candidates, [&](size_t lane) {
+            if (lanes_[lane]->memory.load<opcode::Opcode>(pc) == opcode)
+            {
+                group |= 1u << lane;
+            }
+        });
+
+        if ((group & 0x1) != 0)
+        {
+            opcode_ = opcode;
+        }
+
+        stepGroup(opcode, group);
+
+        bool together = (group == active) && !isBranch(opcode);
+
+        forEachLane(group, [&](size_t lane) {
+            if (--remaining[lane] == 0 || waiting_[lane])
+            {
+                active &= ~(1u << lane);
+            }
+        });
+
+        candidates = together ? active : 0;
+    }
+}
+
+/// @brief Tick delay and sound timers of all lanes.
+void LockstepCpu::tickTimers()
+{
+    dt_ -= reinterpret_cast<ByteLanes>(dt_ != 0) & 0x1;
+    st_ -= reinterpret_cast<ByteLanes>(st_ != 0) & 0x1;
+}
+
+/// @brief Check if all lanes are parked waiting for a key.
+bool LockstepCpu::isWaitingForKey() const
+{
+    return std::all_of(waiting_.begin(), waiting_.begin() + laneCount_, [](bool waiting) { return waiting; });
+}
+
+/// @brief Return the register context of lane 0.
+Cpu::RegContext const& LockstepCpu::getRegContext() const
+{
+    leaderContext_ = getLaneContext(0);
+
+    return leaderContext_;
+}
+
+/// @brief Return the state of lane 0.
+Cpu::State LockstepCpu::getState() const
+{
+    return State{ getLaneContext(0), lanes_[0]->random };
+}
+
+/// @brief Restore the state of lane 0.
+///
+/// @param state CPU state.
+void LockstepCpu::setState(State const& state)
+{
+    lanes_[0]->random = state.random;
+    setLaneContext(0, state.regs);
+}
+
+/// @brief Gather the register context of a lane.
+///
+/// @param lane Lane index.
+/// @return Register context.
+Cpu::RegContext LockstepCpu::getLaneContext(size_t lane) const
+{
+    RegContext regs{};
+
+    regs.pc = pc_[lane];
+    regs.i  = i_[lane];
+    regs.sp = sp_[lane];
+    regs.dt = dt_[lane];
+    regs.st = st_[lane];
+
+    for (size_t index = 0; index < REG_COUNT; ++index)
+    {
+        regs.vx[index] = vx_[index][lane];
+    }
+
+    for (size_t level = 0; level < STACK_SIZE; ++level)
+    {
+        regs.stack[level] = stack_[level][lane];
+    }
+
+    return regs;
+}
+
+/// @brief Scatter a register context to a lane.
+///
+/// A lane parked on FX0A runs it again, as on the scalar CPU.
+///
+/// @param lane Lane index.
+/// @param regs Register context.
+void LockstepCpu::setLaneContext(size_t lane, RegContext const& regs)
+{
+    pc_[lane] = regs.pc;
+    i_[lane]  = regs.i;
+    sp_[lane] = regs.sp;
+    dt_[lane] = regs.dt;
+    st_[lane] = regs.st;
+
+    waiting_[lane] = false;
+
+    for (size_t index = 0; index < REG_COUNT; ++index)
+    {
+        vx_[index][lane] = regs.vx[index];
+    }
+
+    for (size_t level = 0; level < STACK_SIZE; ++level)
+    {
+        stack_[level][lane] = regs.stack[level];
+    }
+}
+
+/// @brief Seed the CXKK random generator of a lane.
+///
+/// @param lane Lane index.
+/// @param seed Seed.
+void LockstepCpu::seedLane(size_t lane, uint32_t seed)
+{
+    lanes_[lane]->random.seed(seed);
+}
+
+/// @brief Return the memory of a lane.
+///
+/// @param lane Lane index.
+/// @return Memory.
+Memory const& LockstepCpu::getLaneMemory(size_t lane) const
+{
+    return lanes_[lane]->memory;
+}
+
+/// @brief Return the display of a lane.
+///
+/// @param lane Lane index.
+/// @return Framebuffer.
+Framebuffer const& LockstepCpu::getLaneFramebuffer(size_t lane) const
+{
+    return lanes_[lane]->gpu.framebuffer();
+}
+
+/// @brief Run one instruction on a group of lanes.
+///
+/// @param opcode Opcode at the PC of the group.
+/// @param group  Lanes, one bit per lane.
+void LockstepCpu::stepGroup(opcode::Opcode opcode, uint32_t group)
+{
+    size_t count = 0;
+
+    forEachLane(group, [&](size_t lane) {
+        pc_[lane] += PC_INCR;
+        ++count;
+    });
+
+    if (stepVector(opcode, group))
+    {
+        vectorSteps_ += count;
+        return;
+    }
+
+    stepLanes(opcode, group);
+    scalarSteps_ += count;
+}
+
+/// @brief Run a non ALU opcode lane by lane.
+///
+/// Each case is the scalar handler of the opcode, on the arrays and the
+/// lane devices.  PCs already point to the next instruction, unknown
+/// opcodes do nothing.
+///
+/// @param opcode Opcode to run.
+/// @param group  Lanes, one bit per lane.
+void LockstepCpu::stepLanes(opcode::Opcode opcode, uint32_t group)
+{
+    uint16_t nnn = opcode & 0x0FFF;
+    uint8_t  x   = (opcode >> 8) & 0xF;
+    uint8_t  y   = (opcode >> 4) & 0xF;
+    uint8_t  n   = opcode & 0xF;
+    uint8_t  kk  = opcode & 0xFF;
+
+    switch (opcode::decodeInstruction(opcode))
+    {
+        case opcode::OPCODE_00E0:
+            forEachLane(group, [&](size_t lane) { lanes_[lane]->gpu.clearFrame(); });
+            break;
+        case opcode::OPCODE_00EE:
+            forEachLane(group, [&](size_t lane) {
+                if (sp_[lane] > 0)
+                {
+                    --sp_[lane];
+                }
+
+                pc_[lane] = stack_[sp_[lane]][lane];
+            });
+            break;
+        case opcode::OPCODE_1NNN:
+            forEachLane(group, [&](size_t lane) { pc_[lane] = nnn; });
+            break;
+        case opcode::OPCODE_2NNN:
+            forEachLane(group, [&](size_t lane) {
+                uint8_t level = std::min<uint8_t>(sp_[lane], STACK_SIZE - 1);
+
+                stack_[level][lane] = pc_[lane];
+                sp_[lane] = level + 1;
+                pc_[lane] = nnn;
+            });
+            break;
+        case opcode::OPCODE_3XKK:
+            forEachLane(group, [&](size_t lane) { pc_[lane] += (vx_[x][lane] == kk) ? PC_INCR : 0; });
+            break;
+        case opcode::OPCODE_4XKK:
+            forEachLane(group, [&](size_t lane) { pc_[lane] += (vx_[x][lane] != kk) ? PC_INCR : 0; });
+            break;
+        case opcode::OPCODE_5XY0:
+            forEachLane(group, [&](size_t lane) { pc_[lane] += (vx_[x][lane] == vx_[y][lane]) ? PC_INCR : 0; });
+            break;
+        case opcode::OPCODE_9XY0:
+            forEachLane(group, [&](size_t lane) { pc_[lane] += (vx_[x][lane] != vx_[y][lane]) ? PC_INCR : 0; });
+            break;
+        case opcode::OPCODE_ANNN:
+            forEachLane(group, [&](size_t lane) { i_[lane] = nnn; });
+            break;
+        case opcode::OPCODE_BNNN:
+            forEachLane(group, [&](size_t lane) { pc_[lane] = nnn + vx_[0][lane]; });
+            break;
+        case opcode::OPCODE_CXKK:
+            forEachLane(group, [&](size_t lane) { vx_[x][lane] = lanes_[lane]->random.next() & kk; });
+            break;
+        case opcode::OPCODE_DXYN:
+            forEachLane(group, [&](size_t lane) {
+                auto & memory = lanes_[lane]->memory;
+                auto sprite = Sprite{ memory.data(), memory.getSize(), i_[lane], n };
+
+                if (lanes_[lane]->gpu.drawSprite(vx_[x][lane], vx_[y][lane], sprite))
+                {
+                    vx_[VF][lane] = 0x1;
+                }
+            });
+            break;
+        case opcode::OPCODE_EX9E:
+            forEachLane(group, [&](size_t lane) {
+                pc_[lane] += lanes_[lane]->keyboard.isKeyPressed(vx_[x][lane]) ? PC_INCR : 0;
+            });
+            break;
+        case opcode::OPCODE_EXA1:
+            forEachLane(group, [&](size_t lane) {
+                pc_[lane] += !lanes_[lane]->keyboard.isKeyPressed(vx_[x][lane]) ? PC_INCR : 0;
+            });
+            break;
+        case opcode::OPCODE_FX07:
+            forEachLane(group, [&](size_t lane) { vx_[x][lane] = dt_[lane]; });
+            break;
+        case opcode::OPCODE_FX0A:
+            forEachLane(group, [&](size_t lane) {
+                uint16_t keys = lanes_[lane]->keyboard.getKeys();
+
+                waiting_[lane] = (keys == 0);
+
+                if (keys != 0)
+                {
+                    vx_[x][lane] = __builtin_ctz(keys);
+                    return;
+                }
+
+                pc_[lane] -= PC_INCR;
+            });
+            break;
+        case opcode::OPCODE_FX15:
+            forEachLane(group, [&](size_t lane) { dt_[lane] = vx_[x][lane]; });
+            break;
+        case opcode::OPCODE_FX18:
+            forEachLane(group, [&](size_t lane) { st_[lane] = vx_[x][lane]; });
+            break;
+        case opcode::OPCODE_FX1E:
+            forEachLane(group, [&](size_t lane) { i_[lane] += vx_[x][lane]; });
+            break;
+        case opcode::OPCODE_FX29:
+            forEachLane(group, [&](size_t lane) { i_[lane] = vx_[x][lane] * 5; });
+            break;
+        case opcode::OPCODE_FX33:
+            forEachLane(group, [&](size_t lane) {
+                uint8_t value = vx_[x][lane];
+                uint8_t digits[] = { static_cast<uint8_t>(value / 100),
+                                     static_cast<uint8_t>((value / 10) % 10),
+                                     static_cast<uint8_t>(value % 10) };
+
+                lanes_[lane]->memory.storeRange(i_[lane], digits, sizeof(digits));
+            });
+            break;
+        case opcode::OPCODE_FX55:
+            forEachLane(group, [&](size_t lane) {
+                uint8_t registers[REG_COUNT];
+
+                for (size_t index = 0; index <= x; ++index)
+                {
+                    registers[index] = vx_[index][lane];
+                }
+
+                lanes_[lane]->memory.storeRange(i_[lane], registers, x + 1);
+                i_[lane] += x + 1;
+            });
+            break;
+        case opcode::OPCODE_FX65:
+            forEachLane(group, [&](size_t lane) {
+                uint8_t registers[REG_COUNT];
+
+                lanes_[lane]->memory.loadRange(i_[lane], registers, x + 1);
+
+                for (size_t index = 0; index <= x; ++index)
+                {
+                    vx_[index][lane] = registers[index];
+                }
+
+                i_[lane] += x + 1;
+            });
+            break;
+        default:
+            break;
+    }
+}
+
+/// @brief Run an ALU opcode on the masked lanes.
+///
+/// Flags are written before the result, and shifts read Vy after the
+/// flag, exactly as the scalar handlers do when X or Y is VF.
+///
+/// @param opcode Opcode to run.
+/// @param group  Lanes to update, one bit per lane.
+/// @return True when the opcode ran, false when it is not an ALU opcode.
+bool LockstepCpu::stepVector(opcode::Opcode opcode, uint32_t group)
+{
+    if (opcode < opcode::OPCODE_6XKK || opcode >= opcode::OPCODE_9XY0)
+    {
+        return false;
+    }
+
+    static_assert(LANES == 16, "Masks are built from two eight lane halves");
+
+    uint64_t halves[] = { BYTE_MASKS[group & 0xFF], BYTE_MASKS[(group >> 8) & 0xFF] };
+    ByteLanes mask;
+
+    std::memcpy(&mask, halves, sizeof(mask));
+
+    auto blend = [mask](ByteLanes value, ByteLanes previous) {
+        return (mask & value) | (~mask & previous);
+    };
+
+    auto x = (opcode >> 8) & 0xF;
+    auto y = (opcode >> 4) & 0xF;
+
+    switch (opcode::decodeInstruction(opcode))
+    {
+        case opcode::OPCODE_6XKK:
+        {
+            auto op = opcode::decode6XKK(opcode);
+            vx_[op.x] = blend(ByteLanes{ } + static_cast<uint8_t>(op.kk), vx_[op.x]);
+            return true;
+        }
+        case opcode::OPCODE_7XKK:
+        {
+            auto op = opcode::decode7XKK(opcode);
+            vx_[op.x] = blend(vx_[op.x] + static_cast<uint8_t>(op.kk), vx_[op.x]);
+            return true;
+        }
+        case opcode::OPCODE_8XY0:
+            vx_[x] = blend(vx_[y], vx_[x]);
+            return true;
+        case opcode::OPCODE_8XY1:
+            vx_[x] = blend(vx_[x] | vx_[y], vx_[x]);
+            return true;
+        case opcode::OPCODE_8XY2:
+            vx_[x] = blend(vx_[x] & vx_[y], vx_[x]);
+            return true;
+        case opcode::OPCODE_8XY3:
+            vx_[x] = blend(vx_[x] ^ vx_[y], vx_[x]);
+            return true;
+        case opcode::OPCODE_8XY4:
+        {
+            ByteLanes sum = vx_[x] + vx_[y];
+            ByteLanes carry = reinterpret_cast<ByteLanes>(sum < vx_[x]) & 0x1;
+
+            vx_[VF] = blend(carry, vx_[VF]);
+            vx_[x] = blend(sum, vx_[x]);
+            return true;
+        }
+        case opcode::OPCODE_8XY5:
+        {
+            ByteLanes difference = vx_[x] - vx_[y];
+            ByteLanes noBorrow = reinterpret_cast<ByteLanes>(vx_[x] > vx_[y]) & 0x1;
+
+            vx_[VF] = blend(noBorrow, vx_[VF]);
+            vx_[x] = blend(difference, vx_[x]);
+            return true;
+        }
+        case opcode::OPCODE_8XY6:
+            vx_[VF] = blend(vx_[y] & 0x1, vx_[VF]);
+            vx_[x] = blend(vx_[y] >> 1, vx_[x]);
+            return true;
+        case opcode::OPCODE_8XY7:
+        {
+            ByteLanes difference = vx_[y] - vx_[x];
+            ByteLanes noBorrow = reinterpret_cast<ByteLanes>(vx_[y] > vx_[x]) & 0x1;
+
+            vx_[VF] = blend(noBorrow, vx_[VF]);
+            vx_[x] = blend(difference, vx_[x]);
+            return true;
+        }
+        case opcode::OPCODE_8XYE:
+            vx_[VF] = blend(vx_[y] & 0x80, vx_[VF]);
+            vx_[x] = blend(vx_[y] << 1, vx_[x]);
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // chip8
@@ -0,0 +1,146 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_LOCKSTEPCPU_HPP
+#define CHIP8_LOCKSTEPCPU_HPP
+
+#include <array>
+#include <memory>
+
+#include <core.hpp>
+#include <cpu.hpp>
+#include <headless.hpp>
+#include <memory.hpp>
+#include <random.hpp>
+#include <rom.hpp>
+
+namespace chip8 {
+
+/// @brief Represent CHIP-8 machines running the same program in lockstep.
+///
+/// Registers of all lanes are kept in structure of arrays layout, one
+/// vector per register, and are the only copy of them.  Lanes are grouped
+/// by PC and opcode, lanes ahead in the code waiting within a run for the
+/// others to join them.  A group runs ALU opcodes (6XKK, 7XKK, 8XY0 to
+/// 8XYE) as a single masked vector operation, and every other opcode lane
+/// by lane on the arrays, with the lane memory, display, keyboard and
+/// random generator.  Each lane ends in the exact state it would reach on
+/// its own.
+///
+/// As a `Cpu`, the engine runs the cycles of a run on every lane and
+/// reports lane 0 through `getRegContext()`, so it can be driven by a
+/// `Scheduler`.
+class LockstepCpu : public Cpu
+{
+    public:
+        /// @brief Lane count, one byte register per vector element.
+        static constexpr size_t LANES = 16;
+
+        LockstepCpu(Rom const& rom, size_t laneCount);
+        ~LockstepCpu();
+
+        void reset() override;
+        void update() override;
+        uint32_t run(uint32_t cycles) override;
+        void tickTimers() override;
+
+        void enableTraces() override {}
+        void disableTraces() override {}
+        RegContext const& getRegContext() const override;
+        opcode::Opcode getOpcode() const override { return opcode_; }
+        bool isWaitingForKey() const override;
+
+        State getState() const override;
+        void  setState(State const& state) override;
+
+        /// @brief Return the count of active lanes.
+        size_t getLaneCount() const { return laneCount_; }
+
+        RegContext getLaneContext(size_t lane) const;
+        void       setLaneContext(size_t lane, RegContext const& regs);
+        void       seedLane(size_t lane, uint32_t seed);
+
+        Memory const&      getLaneMemory(size_t lane) const;
+        Framebuffer const& getLaneFramebuffer(size_t lane) const;
+
+        /// @brief Return lane steps ran as vector operations.
+        uint64_t getVectorSteps() const { return vectorSteps_; }
+        /// @brief Return lane steps ran lane by lane.
+        uint64_t getScalarSteps() const { return scalarSteps_; }
+
+    private:
+        /// @brief Byte register of all lanes.
+        using ByteLanes = uint8_t __attribute__((vector_size(LANES)));
+
+        /// @brief Devices of one machine, the registers are in the arrays.
+        struct Lane
+        {
+            Lane(Rom const& rom);
+
+            Memory           memory;
+            HeadlessGpu      gpu;
+            HeadlessKeyboard keyboard;
+            Random           random;
+        };
+
+        void runLanes(uint32_t cycles);
+        void stepGroup(opcode::Opcode opcode, uint32_t group);
+        void stepLanes(opcode::Opcode opcode, uint32_t group);
+        bool stepVector(opcode::Opcode opcode, uint32_t group);
+
+        /// @brief Active lane count.
+        size_t laneCount_;
+        /// @brief Lane machines.
+        std::array<std::unique_ptr<Lane>, LANES> lanes_;
+
+        /// @brief Program counters.
+        std::array<uint16_t, LANES> pc_;
+        /// @brief General purpose registers, one vector per register.
+        ByteLanes vx_[REG_COUNT];
+        /// @brief I registers.
+        std::array<uint16_t, LANES> i_;
+        /// @brief Stack pointers.
+        std::array<uint8_t, LANES> sp_;
+        /// @brief Stacks, one array per level.
+        std::array<uint16_t, LANES> stack_[STACK_SIZE];
+        /// @brief Delay timers.
+        ByteLanes dt_;
+        /// @brief Sound timers.
+        ByteLanes st_;
+        /// @brief True for lanes parked on FX0A.
+        std::array<bool, LANES> waiting_;
+
+        /// @brief Lane 0 context, as returned by getRegContext().
+        mutable RegContext leaderContext_;
+        /// @brief Last opcode of the first lane.
+        opcode::Opcode opcode_;
+
+        /// @brief Lane steps ran as vector operations.
+        uint64_t vectorSteps_;
+        /// @brief Lane steps ran lane by lane.
+        uint64_t scalarSteps_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_LOCKSTEPCPU_HPP
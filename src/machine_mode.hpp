@@ -0,0 +1,74 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_MACHINEMODE_HPP
+#define CHIP8_MACHINEMODE_HPP
+
+#include <core.hpp>
+
+namespace chip8 {
+
+/// @brief Classic CHIP-8 machine, 4 KB of memory and a 64x32 display.
+struct ClassicMode
+{
+    /// @brief SUPER-CHIP and XO-CHIP instructions are decoded.
+    static constexpr bool EXTENDED = false;
+    /// @brief Memory size in bytes, a power of two.
+    static constexpr size_t MEMORY_SIZE = SYSTEM_MEMORY_SIZE;
+    /// @brief Display width in pixels.
+    static constexpr uint32_t DISPLAY_WIDTH = 64;
+    /// @brief Display height in pixels.
+    static constexpr uint32_t DISPLAY_HEIGHT = 32;
+    /// @brief Display bit plane count.
+    static constexpr uint32_t PLANE_COUNT = 1;
+
+    /// @brief Display row, one bit per pixel.
+    using Row = uint64_t;
+    /// @brief Dirty row mask, one bit per row.
+    using RowMask = uint32_t;
+};
+
+/// @brief SUPER-CHIP and XO-CHIP machine, 64 KB of memory, a 128x64
+///        display of two bit planes and a 64x32 low resolution mode.
+struct ExtendedMode
+{
+    /// @brief SUPER-CHIP and XO-CHIP instructions are decoded.
+    static constexpr bool EXTENDED = true;
+    /// @brief Memory size in bytes, a power of two.
+    static constexpr size_t MEMORY_SIZE = 0x10000;
+    /// @brief Display width in pixels.
+    static constexpr uint32_t DISPLAY_WIDTH = 128;
+    /// @brief Display height in pixels.
+    static constexpr uint32_t DISPLAY_HEIGHT = 64;
+    /// @brief Display bit plane count.
+    static constexpr uint32_t PLANE_COUNT = 2;
+
+    /// @brief Display row, one bit per pixel.
+    using Row = unsigned __int128;
+    /// @brief Dirty row mask, one bit per row.
+    using RowMask = uint64_t;
+};
+
+}  // chip8
+
+#endif  // CHIP8_MACHINEMODE_HPP
@@ -21,27 +21,49 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include <algorithm>
 #include <cstring>
 #include <core.hpp>
 #include "memory.hpp"
 
 namespace chip8 {
 
-/// @brief Construct memory instance.
+/// @brief Construct memory instance, cleared.
+template<typename MODE>
+BasicMemory<MODE>::BasicMemory()
+    : memory_{ }
+    , pages_(MEMORY_SIZE / PAGE_SIZE)
+    , dirtyPages_(pages_.size(), true)
+    , observers_{ }
+{
+}
+
+/// @brief Attach a write observer.
 ///
-/// @param size Memory size.
-Memory::Memory(size_t size)
-    : memory_(size)
+/// @param observer Observer to notify of writes.
+template<typename MODE>
+void BasicMemory<MODE>::attach(WriteObserver * observer)
 {
+    observers_.push_back(observer);
+}
+
+/// @brief Detach a write observer.
+///
+/// @param observer Observer to stop notifying.
+template<typename MODE>
+void BasicMemory<MODE>::detach(WriteObserver * observer)
+{
+    observers_.erase(std::remove(observers_.begin(), observers_.end(), observer), observers_.end());
 }
 
 /// @brief Store buffer from 8-bit byte list.
 ///
 /// @param startAddress Address of start point.
 /// @param buffer       Reference to buffer.
-void Memory::storeBuffer(uint16_t startAddress, Bytes const& buffer)
+template<typename MODE>
+void BasicMemory<MODE>::storeBuffer(uint16_t startAddress, Bytes const& buffer)
 {
-    std::memcpy(memory_.data() + startAddress, buffer.data(), buffer.size());
+    storeRange(startAddress, buffer.data(), buffer.size());
 }
 
 /// @brief Store program from 16-bit word list.
@@ -49,58 +71,131 @@ void Memory::storeBuffer(uint16_t startAddress, Bytes const& buffer)
 /// @param startAddress Address of start point.
 /// @param buffer       Reference to buffer.
 /// @param endian       Buffer data endianness.
-void Memory::storeBuffer(uint16_t startAddress, Words const& buffer, Endian endian)
+template<typename MODE>
+void BasicMemory<MODE>::storeBuffer(uint16_t startAddress, Words const& buffer, Endian endian)
 {
     for (uint16_t index = 0; index < buffer.size(); ++index)
     {
-        uint16_t address = startAddress + 2 * index;
+        uint16_t address = (startAddress + 2 * index) & ADDRESS_MASK;
+        uint16_t next = (address + 1) & ADDRESS_MASK;
 
         switch (endian)
         {
             case Endian::LITTLE:
-                memory_[address    ] = (buffer[index] >> 8) & 0xFF;
-                memory_[address + 1] = buffer[index] & 0xFF;
+                memory_[address] = (buffer[index] >> 8) & 0xFF;
+                memory_[next   ] = buffer[index] & 0xFF;
                 break;
             case Endian::BIG:
-                memory_[address    ] = buffer[index] & 0xFF;
-                memory_[address + 1] = (buffer[index] >> 8) & 0xFF;
+                memory_[address] = buffer[index] & 0xFF;
+                memory_[next   ] = (buffer[index] >> 8) & 0xFF;
                 break;
         }
     }
+
+    notifyWrite(startAddress & ADDRESS_MASK, 2 * buffer.size());
 }
 
-/// @brief Store a byte.
+/// @brief Capture the memory image.
+///
+/// Only the pages written since the last snapshot or restore are copied,
+/// the others are shared with the previous snapshot.
 ///
-/// @param address Address at which to store the byte.
-/// @param byte    Byte to store.
-void Memory::store(uint16_t address, uint8_t byte)
+/// @return Memory pages.
+template<typename MODE>
+typename BasicMemory<MODE>::PageTable BasicMemory<MODE>::snapshot()
 {
-    memory_[address] = byte;
+    for (size_t page = 0; page < pages_.size(); ++page)
+    {
+        if (dirtyPages_[page])
+        {
+            auto copy = std::make_shared<Page>();
+            size_t offset = page * PAGE_SIZE;
+            size_t size = std::min(PAGE_SIZE, memory_.size() - offset);
+
+            std::memcpy(copy->data(), memory_.data() + offset, size);
+
+            pages_[page] = std::move(copy);
+            dirtyPages_[page] = false;
+        }
+    }
+
+    return pages_;
 }
 
-/// @brief Load 16-bit word from memory address.
+/// @brief Restore a memory image.
 ///
-/// @param address Memory address to load as opcode.
-/// @return Opcode converted from big-endian to little-endian.
-template<>
-uint16_t Memory::load(uint16_t address)
+/// Only the pages written since, or differing from, the last snapshot or
+/// restore are copied back.
+///
+/// @param pages Memory pages of a snapshot of this memory.
+template<typename MODE>
+void BasicMemory<MODE>::restore(PageTable const& pages)
 {
-    uint16_t opcode = 0x0000;
+    for (size_t page = 0; page < pages_.size(); ++page)
+    {
+        if (dirtyPages_[page] || pages_[page] != pages[page])
+        {
+            size_t offset = page * PAGE_SIZE;
+            size_t size = std::min(PAGE_SIZE, memory_.size() - offset);
 
-    opcode |= static_cast<uint16_t>(memory_[address++]) << 8;
-    opcode |= static_cast<uint16_t>(memory_[address]);
+            std::memcpy(memory_.data() + offset, pages[page]->data(), size);
 
-    return opcode;
+            pages_[page] = pages[page];
+            dirtyPages_[page] = false;
+
+            for (auto observer : observers_)
+            {
+                observer->onMemoryWrite(static_cast<uint16_t>(offset), size);
+            }
+        }
+    }
+}
+
+/// @brief Notify observers of a write.
+///
+/// A write wrapping around the end of memory is notified as two ranges.
+///
+/// @param address Address of the first byte written, masked.
+/// @param size    Count of bytes written.
+template<typename MODE>
+void BasicMemory<MODE>::notifyWrite(uint16_t address, size_t size)
+{
+    size = std::min<size_t>(size, MEMORY_SIZE);
+
+    size_t first = std::min<size_t>(size, MEMORY_SIZE - address);
+
+    notifyRange(address, first);
+
+    if (size > first)
+    {
+        notifyRange(0, size - first);
+    }
 }
 
-/// @brief Load data from memory address.
+/// @brief Notify observers of a write within memory.
 ///
-/// @param address Memory address to load data.
-/// @return Data byte.
-template<>
-uint8_t Memory::load(uint16_t address)
+/// @param address Address of the first byte written.
+/// @param size    Count of bytes written.
+template<typename MODE>
+void BasicMemory<MODE>::notifyRange(uint16_t address, size_t size)
 {
-    return memory_[address];
+    if (size != 0)
+    {
+        size_t last = (address + size - 1) / PAGE_SIZE;
+
+        for (size_t page = address / PAGE_SIZE; page <= last && page < dirtyPages_.size(); ++page)
+        {
+            dirtyPages_[page] = true;
+        }
+    }
+
+    for (auto observer : observers_)
+    {
+        observer->onMemoryWrite(address, size);
+    }
 }
 
+template class BasicMemory<ClassicMode>;
+template class BasicMemory<ExtendedMode>;
+
 }  // chip8
@@ -24,13 +24,26 @@
 #ifndef CHIP8_MEMORY_HPP
 #define CHIP8_MEMORY_HPP
 
+#include <array>
+#include <memory>
+#include <type_traits>
 #include <vector>
 #include <core.hpp>
+#include <machine_mode.hpp>
 
 namespace chip8 {
 
 /// @brief Memory class.
-class Memory
+///
+/// The address space is a fixed array, addresses wrap around its end like
+/// the address bus, so loads and stores are inline, branch free and never
+/// out of bounds.  Its size is the machine mode's, so the classic 4 KB
+/// image stays cache resident.  Both memories are explicitly instantiated
+/// in memory.cpp.
+///
+/// @tparam MODE Machine mode, `ClassicMode` or `ExtendedMode`.
+template<typename MODE>
+class BasicMemory
 {
     public:
         using Bytes = std::vector<uint8_t>;
@@ -38,23 +51,133 @@ class Memory
 
         enum class Endian { BIG, LITTLE };
 
-        Memory(size_t size);
+        /// @brief Memory size in bytes.
+        static constexpr size_t MEMORY_SIZE = MODE::MEMORY_SIZE;
+        /// @brief Page size, the copy-on-write unit of snapshots.
+        static constexpr size_t PAGE_SIZE = 256;
+        /// @brief Mask of a valid address.
+        static constexpr uint16_t ADDRESS_MASK = MEMORY_SIZE - 1;
+        /// @brief Cache line size, the alignment of the address space.
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+
+        static_assert((MEMORY_SIZE & ADDRESS_MASK) == 0, "Memory size must be a power of two");
+        static_assert(MEMORY_SIZE <= 0x10000, "Memory must be addressed by 16 bits");
+
+        using Page = std::array<uint8_t, PAGE_SIZE>;
+        /// @brief Memory image as shared read-only pages.
+        using PageTable = std::vector<std::shared_ptr<Page const>>;
+
+        /// @brief Observer notified after memory is written.
+        class WriteObserver
+        {
+            public:
+                virtual ~WriteObserver() {}
+
+                virtual void onMemoryWrite(uint16_t address, size_t size) = 0;
+        };
+
+        BasicMemory();
+
+        void attach(WriteObserver * observer);
+        void detach(WriteObserver * observer);
 
         void storeBuffer(uint16_t startAddress, Bytes const& buffer);
         void storeBuffer(uint16_t startAddress, Words const& buffer, Endian endian);
 
-        void store(uint16_t address, uint8_t byte);
+        /// @brief Load consecutive bytes, wrapping around the end of memory.
+        ///
+        /// @param address Address of the first byte.
+        /// @param bytes   Bytes loaded.
+        /// @param size    Count of bytes.
+        void loadRange(uint16_t address, uint8_t * bytes, size_t size) const
+        {
+            for (size_t index = 0; index < size; ++index)
+            {
+                bytes[index] = memory_[(address + index) & ADDRESS_MASK];
+            }
+        }
+
+        /// @brief Store consecutive bytes, wrapping around the end of memory.
+        ///
+        /// @param address Address of the first byte.
+        /// @param bytes   Bytes to store.
+        /// @param size    Count of bytes.
+        void storeRange(uint16_t address, uint8_t const * bytes, size_t size)
+        {
+            for (size_t index = 0; index < size; ++index)
+            {
+                memory_[(address + index) & ADDRESS_MASK] = bytes[index];
+            }
+
+            notifyWrite(address & ADDRESS_MASK, size);
+        }
+
+        /// @brief Store a byte.
+        ///
+        /// @param address Address at which to store the byte.
+        /// @param byte    Byte to store.
+        void store(uint16_t address, uint8_t byte)
+        {
+            address &= ADDRESS_MASK;
+            memory_[address] = byte;
+
+            notifyWrite(address, 1);
+        }
 
         size_t getSize() const { return memory_.size(); }
+        uint8_t const * data() const { return memory_.data(); }
 
+        /// @brief Load a byte, or a big-endian 16-bit word such as an opcode.
+        ///
+        /// @tparam TYPE    `uint8_t` or `uint16_t`.
+        /// @param  address Memory address to load.
+        /// @return Byte, or word converted from big-endian.
         template<typename TYPE>
-        TYPE load(uint16_t address);
+        TYPE load(uint16_t address) const
+        {
+            static_assert(std::is_same_v<TYPE, uint8_t> || std::is_same_v<TYPE, uint16_t>,
+                          "Memory loads bytes and words");
+
+            if constexpr (std::is_same_v<TYPE, uint16_t>)
+            {
+                uint16_t opcode = 0x0000;
+
+                opcode |= static_cast<uint16_t>(memory_[address & ADDRESS_MASK]) << 8;
+                opcode |= static_cast<uint16_t>(memory_[(address + 1) & ADDRESS_MASK]);
+
+                return opcode;
+            }
+            else
+            {
+                return memory_[address & ADDRESS_MASK];
+            }
+        }
+
+        PageTable snapshot();
+        void restore(PageTable const& pages);
 
     private:
+        void notifyWrite(uint16_t address, size_t size);
+        void notifyRange(uint16_t address, size_t size);
+
         /// @brief Memory buffer in bytes.
-        std::vector<uint8_t> memory_;
+        alignas(CACHE_LINE_SIZE) std::array<uint8_t, MEMORY_SIZE> memory_;
+        /// @brief Pages of the last snapshot or restore.
+        PageTable pages_;
+        /// @brief Pages written since the last snapshot or restore.
+        std::vector<bool> dirtyPages_;
+        /// @brief Write observers.
+        std::vector<WriteObserver *> observers_;
 };
 
+extern template class BasicMemory<ClassicMode>;
+extern template class BasicMemory<ExtendedMode>;
+
+/// @brief Classic 4 KB memory.
+using Memory = BasicMemory<ClassicMode>;
+/// @brief SUPER-CHIP and XO-CHIP 64 KB memory.
+using ExtendedMemory = BasicMemory<ExtendedMode>;
+
 }  // chip8
 
 #endif  // CHIP8_MEMORY_HPP
@@ -0,0 +1,578 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "frame_stream.hpp"
+#include "metrics.hpp"
+
+namespace chip8 {
+
+namespace {
+
+/// @brief Largest HTTP request read, the rest is ignored.
+const size_t MAX_REQUEST_SIZE = 4096;
+
+/// @brief Wait for a connection before checking for a stop.
+const int ACCEPT_TIMEOUT = 100; // MS
+
+/// @brief Wait for a request before dropping the connection.
+const int REQUEST_TIMEOUT = 1000; // MS
+
+/// @brief Prometheus text format content type.
+const char CONTENT_TYPE[] = "text/plain; version=0.0.4";
+
+/// @brief Append formatted text.
+void appendFormat(std::string & text, char const * format, ...) __attribute__((format(printf, 2, 3)));
+
+void appendFormat(std::string & text, char const * format, ...)
+{
+    char line[256];
+
+    va_list arguments;
+    va_list copy;
+    va_start(arguments, format);
+    va_copy(copy, arguments);
+
+    int size = std::vsnprintf(line, sizeof(line), format, arguments);
+
+    if (size >= static_cast<int>(sizeof(line)))
+    {
+        // Long labels, format again at full size
+        size_t offset = text.size();
+        text.resize(offset + size + 1);
+        std::vsnprintf(&text[offset], size + 1, format, copy);
+        text.resize(offset + size);
+    }
+    else if (size > 0)
+    {
+        text.append(line, size);
+    }
+
+    va_end(copy);
+    va_end(arguments);
+}
+
+/// @brief Append the help and type header of a metric.
+void appendHeader(std::string & text, char const * name, char const * type, char const * help)
+{
+    appendFormat(text, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/// @brief Append a sample of a metric.
+void appendSample(std::string & text, char const * name, std::string const& labels, char const * value)
+{
+    if (labels.empty())
+    {
+        appendFormat(text, "%s %s\n", name, value);
+    }
+    else
+    {
+        appendFormat(text, "%s{%s} %s\n", name, labels.c_str(), value);
+    }
+}
+
+/// @brief Append a counter.
+void appendCounter(std::string & text, char const * name, char const * help,
+                   std::string const& labels, uint64_t value)
+{
+    char number[32];
+    std::snprintf(number, sizeof(number), "%" PRIu64, value);
+
+    appendHeader(text, name, "counter", help);
+    appendSample(text, name, labels, number);
+}
+
+/// @brief Append a gauge.
+void appendGauge(std::string & text, char const * name, char const * help,
+                 std::string const& labels, double value)
+{
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.6g", value);
+
+    appendHeader(text, name, "gauge", help);
+    appendSample(text, name, labels, number);
+}
+
+/// @brief Append a duration histogram, in seconds.
+void appendHistogram(std::string & text, char const * name, char const * help,
+                     std::string const& labels, Histogram const& histogram)
+{
+    std::string bucketName = std::string{ name } + "_bucket";
+    std::string separator = labels.empty() ? "" : ",";
+    char number[32];
+    uint64_t count = 0;
+
+    appendHeader(text, name, "histogram", help);
+
+    for (size_t bucket = 0; bucket < Histogram::BUCKET_COUNT; ++bucket)
+    {
+        char bound[32];
+
+        if (bucket < Histogram::BUCKET_COUNT - 1)
+        {
+            std::snprintf(bound, sizeof(bound), "%g", Histogram::getBound(bucket) * 1e-9);
+        }
+        else
+        {
+            std::snprintf(bound, sizeof(bound), "+Inf");
+        }
+
+        count += histogram.getBucket(bucket);
+        std::snprintf(number, sizeof(number), "%" PRIu64, count);
+
+        appendSample(text, bucketName.c_str(), labels + separator + "le=\"" + bound + "\"", number);
+    }
+
+    // The sum is read last, so it may hold samples not counted yet
+    std::snprintf(number, sizeof(number), "%.9f", histogram.getSum() * 1e-9);
+    appendSample(text, (std::string{ name } + "_sum").c_str(), labels, number);
+
+    std::snprintf(number, sizeof(number), "%" PRIu64, count);
+    appendSample(text, (std::string{ name } + "_count").c_str(), labels, number);
+}
+
+} // namespace
+
+/// @brief Construct an empty histogram.
+Histogram::Histogram()
+    : buckets_{ }
+    , sum_{ }
+    , countdown_{ 1 }
+{
+}
+
+/// @brief Return the count of samples.
+///
+/// @return Samples of all buckets.
+uint64_t Histogram::getCount() const
+{
+    uint64_t count = 0;
+
+    for (auto const& bucket : buckets_)
+    {
+        count += bucket.get();
+    }
+
+    return count;
+}
+
+/// @brief Construct metrics, starting their wall clock.
+///
+/// @param cpuRate Emulated CPU rate, in Hz.
+Metrics::Metrics(uint32_t cpuRate)
+    : cpuRate{ cpuRate }
+    , startTime{ Clock::now() }
+    , instructions{ }
+    , frames{ }
+    , presentedFrames{ }
+    , droppedFrames{ }
+    , keyboardUpdate{ }
+    , cpuRun{ }
+    , gpuDraw{ }
+{
+}
+
+/// @brief Format the metrics in Prometheus text format.
+///
+/// The rates are averages since the metrics started.  An emulated over
+/// wall clock ratio below one means the host does not keep up with the
+/// CPU rate.
+///
+/// @param labels Labels of every sample, e.g. `rom="pong"`, may be empty.
+/// @return Metrics text.
+std::string Metrics::format(std::string const& labels) const
+{
+    std::string text;
+    double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    uint64_t instructionCount = instructions.get();
+
+    text.reserve(4096);
+
+    appendCounter(text, "chip8_instructions_total", "Instructions executed.", labels, instructionCount);
+    appendGauge(text, "chip8_uptime_seconds", "Wall clock time since the machine started.", labels, seconds);
+    appendGauge(text, "chip8_cpu_rate_hertz", "Emulated CPU rate.", labels, cpuRate);
+    appendGauge(text, "chip8_instructions_per_second", "Instructions executed per wall clock second.",
+                labels, (seconds > 0) ? instructionCount / seconds : 0);
+    appendGauge(text, "chip8_emulated_wall_ratio", "Emulated time over wall clock time.",
+                labels, (seconds > 0) ? instructionCount / (static_cast<double>(cpuRate) * seconds) : 0);
+    appendCounter(text, "chip8_frames_total", "Frames drawn by the emulation.", labels, frames.get());
+    appendCounter(text, "chip8_frames_presented_total", "Frames presented to the window.",
+                  labels, presentedFrames.get());
+    appendCounter(text, "chip8_frames_dropped_total", "Frames replaced before being presented.",
+                  labels, droppedFrames.get());
+    appendHistogram(text, "chip8_keyboard_update_seconds", "Duration of sampled keyboard updates.",
+                    labels, keyboardUpdate);
+    appendHistogram(text, "chip8_cpu_run_seconds", "Duration of sampled CPU runs between events.", labels, cpuRun);
+    appendHistogram(text, "chip8_gpu_draw_seconds", "Duration of sampled GPU draws.", labels, gpuDraw);
+
+    return text;
+}
+
+/// @brief Escape a label value, backslashes, quotes and line feeds.
+///
+/// @param value Label value.
+/// @return Value to write between quotes.
+std::string escapeLabel(std::string const& value)
+{
+    std::string escaped;
+
+    for (char c : value)
+    {
+        switch (c)
+        {
+            case '\\': escaped += "\\\\"; break;
+            case '"':  escaped += "\\\""; break;
+            case '\n': escaped += "\\n";  break;
+            default:   escaped += c;      break;
+        }
+    }
+
+    return escaped;
+}
+
+/// @brief Construct a closed metrics exporter.
+///
+/// @param metrics  Metrics exported, outliving the exporter.
+/// @param labels   Labels of every sample, may be empty.
+/// @param interval Interval between snapshots, in milliseconds.
+MetricsExporter::MetricsExporter(Metrics const& metrics, std::string labels, uint32_t interval)
+    : metrics_{ metrics }
+    , labels_{ std::move(labels) }
+    , interval_{ interval }
+    , descriptor_{ -1 }
+    , owned_{ false }
+    , socket_{ false }
+    , port_{ 0 }
+    , snapshotCount_{ 0 }
+    , thread_{ }
+    , mutex_{ }
+    , wakeUp_{ }
+    , stopping_{ false }
+{
+}
+
+/// @brief Destroy a metrics exporter, stopping it.
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+
+    if (descriptor_ >= 0 && owned_)
+    {
+        ::close(descriptor_);
+    }
+}
+
+/// @brief Open an export target.
+///
+/// @param target Export target.
+/// @return True when opened, otherwise false.
+bool MetricsExporter::open(std::string const& target)
+{
+    int descriptor = -1;
+    bool socket = false;
+    bool owned = true;
+
+    if (target.compare(0, 5, "http:") == 0)
+    {
+        return listen(target.substr(5));
+    }
+    else if (target.compare(0, 3, "fd:") == 0)
+    {
+        if (!FrameStream::parseDescriptor(target.substr(3), descriptor))
+        {
+            std::printf("Invalid metrics descriptor `%s'\n", target.c_str());
+            return false;
+        }
+
+        owned = false;
+    }
+    else if (target.compare(0, 4, "tcp:") == 0)
+    {
+        socket = FrameStream::connect(target.substr(4), descriptor);
+    }
+    else
+    {
+        descriptor = ::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+
+    if (descriptor < 0)
+    {
+        std::printf("Cannot open metrics `%s'\n", target.c_str());
+        return false;
+    }
+
+    descriptor_ = descriptor;
+    owned_ = owned;
+    socket_ = socket;
+
+    return true;
+}
+
+/// @brief Start exporting from the exporter thread.
+void MetricsExporter::start()
+{
+    if (descriptor_ < 0 || thread_.joinable())
+    {
+        return;
+    }
+
+    stopping_ = false;
+
+    if (port_ != 0)
+    {
+        thread_ = std::thread{ &MetricsExporter::serve, this };
+    }
+    else
+    {
+        thread_ = std::thread{ &MetricsExporter::push, this };
+    }
+}
+
+/// @brief Stop exporting, a pushing exporter writes a last snapshot.
+void MetricsExporter::stop()
+{
+    if (!thread_.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{ mutex_ };
+        stopping_ = true;
+    }
+
+    wakeUp_.notify_all();
+    thread_.join();
+}
+
+/// @brief Listen for scrapes.
+///
+/// @param address Address, `[HOST:]PORT`, port zero for any free one.
+/// @return True when listening, otherwise false.
+bool MetricsExporter::listen(std::string const& address)
+{
+    size_t separator = address.rfind(':');
+    std::string host = (separator == std::string::npos) ? "" : address.substr(0, separator);
+    std::string port = (separator == std::string::npos) ? address : address.substr(separator + 1);
+
+    struct addrinfo hints{};
+    struct addrinfo * addresses = nullptr;
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addresses) != 0)
+    {
+        std::printf("Cannot listen for metrics on `%s'\n", address.c_str());
+        return false;
+    }
+
+    int descriptor = -1;
+
+    for (auto entry = addresses; entry != nullptr && descriptor < 0; entry = entry->ai_next)
+    {
+        descriptor = ::socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol);
+
+        int reuse = 1;
+
+        if (descriptor >= 0 &&
+            (::setsockopt(descriptor, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+             ::bind(descriptor, entry->ai_addr, entry->ai_addrlen) != 0 ||
+             ::listen(descriptor, SOMAXCONN) != 0))
+        {
+            ::close(descriptor);
+            descriptor = -1;
+        }
+    }
+
+    ::freeaddrinfo(addresses);
+
+    struct sockaddr_storage bound{};
+    socklen_t size = sizeof(bound);
+
+    if (descriptor < 0 || ::getsockname(descriptor, reinterpret_cast<sockaddr *>(&bound), &size) != 0)
+    {
+        std::printf("Cannot listen for metrics on `%s'\n", address.c_str());
+
+        if (descriptor >= 0)
+        {
+            ::close(descriptor);
+        }
+
+        return false;
+    }
+
+    port_ = ntohs(bound.ss_family == AF_INET6 ? reinterpret_cast<sockaddr_in6 *>(&bound)->sin6_port
+                                              : reinterpret_cast<sockaddr_in *>(&bound)->sin_port);
+    descriptor_ = descriptor;
+    owned_ = true;
+    socket_ = true;
+
+    return true;
+}
+
+/// @brief Write a snapshot every interval until stopped, then a last one.
+void MetricsExporter::push()
+{
+    std::unique_lock<std::mutex> lock{ mutex_ };
+    bool stopped = false;
+
+    while (!stopped)
+    {
+        stopped = wakeUp_.wait_for(lock, interval_, [this] { return stopping_; });
+        lock.unlock();
+
+        // Snapshots are separated by a blank line
+        if (!writeAll(descriptor_, metrics_.format(labels_) + "\n", socket_))
+        {
+            std::puts("Metrics write failed, exporting stopped.");
+            return;
+        }
+
+        ++snapshotCount_;
+        lock.lock();
+    }
+}
+
+/// @brief Answer scrapes until stopped.
+void MetricsExporter::serve()
+{
+    std::unique_lock<std::mutex> lock{ mutex_ };
+
+    while (!stopping_)
+    {
+        lock.unlock();
+
+        struct pollfd listened{ descriptor_, POLLIN, 0 };
+
+        if (::poll(&listened, 1, ACCEPT_TIMEOUT) > 0)
+        {
+            int client = ::accept(descriptor_, nullptr, nullptr);
+
+            if (client >= 0)
+            {
+                answer(client);
+                ::close(client);
+            }
+        }
+
+        lock.lock();
+    }
+}
+
+/// @brief Answer a request, the metrics at `/metrics` and not found
+///        anywhere else.
+///
+/// @param client Connected client.
+void MetricsExporter::answer(int client)
+{
+    std::string request;
+    char buffer[512];
+
+    while (request.size() < MAX_REQUEST_SIZE && request.find("\r\n\r\n") == std::string::npos)
+    {
+        struct pollfd readable{ client, POLLIN, 0 };
+
+        if (::poll(&readable, 1, REQUEST_TIMEOUT) <= 0)
+        {
+            return;
+        }
+
+        ssize_t size = ::recv(client, buffer, sizeof(buffer), 0);
+
+        if (size < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (size <= 0)
+        {
+            return;
+        }
+
+        request.append(buffer, size);
+    }
+
+    bool found = request.compare(0, 13, "GET /metrics ") == 0 ||
+                 request.compare(0, 13, "GET /metrics?") == 0;
+    std::string body = found ? metrics_.format(labels_) : "Not found\n";
+    std::string response;
+
+    appendFormat(response, "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                 found ? "200 OK" : "404 Not Found", found ? CONTENT_TYPE : "text/plain", body.size());
+
+    if (writeAll(client, response + body, true) && found)
+    {
+        ++snapshotCount_;
+    }
+}
+
+/// @brief Write text, retrying partial and interrupted writes.
+///
+/// Sockets are written without raising SIGPIPE.
+///
+/// @param descriptor Descriptor to write.
+/// @param text       Text to write.
+/// @param socket     The descriptor is a socket.
+/// @return True when all the text was written, otherwise false.
+bool MetricsExporter::writeAll(int descriptor, std::string const& text, bool socket)
+{
+    char const * data = text.data();
+    size_t size = text.size();
+
+    while (size > 0)
+    {
+        ssize_t written = socket ? ::send(descriptor, data, size, MSG_NOSIGNAL)
+                                 : ::write(descriptor, data, size);
+
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (written <= 0)
+        {
+            return false;
+        }
+
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+}  // chip8
@@ -0,0 +1,275 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_METRICS_HPP
+#define CHIP8_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <core.hpp>
+
+namespace chip8 {
+
+/// @brief Event counter, written by a single thread and read by any.
+///
+/// The writer adds with a plain load and store, no locked instruction, so
+/// counting from the emulation loop costs about as much as a plain
+/// increment.  Readers always see a whole value.
+class Counter
+{
+    public:
+        Counter() : value_{ 0 } {}
+
+        Counter(Counter const&) = delete;
+        Counter & operator=(Counter const&) = delete;
+
+        /// @brief Add to the counter, from the writer.
+        void add(uint64_t count)
+        {
+            value_.store(value_.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        }
+
+        /// @brief Set the counter, from the writer.
+        void set(uint64_t value) { value_.store(value, std::memory_order_relaxed); }
+
+        /// @brief Return the counter value.
+        uint64_t get() const { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        /// @brief Counter value.
+        std::atomic<uint64_t> value_;
+};
+
+/// @brief Duration histogram, written by a single thread and read by any.
+///
+/// Buckets grow by a factor of four from one microsecond, the last one
+/// holding everything slower.  A reader may see a sample in a bucket before
+/// it is in the sum, which a scrape does not mind.
+///
+/// Reading the clock costs more than a short CPU run, so timers only time
+/// one duration every sample period.  Counts are of samples.
+class Histogram
+{
+    public:
+        /// @brief Count of buckets, the last one unbounded.
+        static constexpr size_t BUCKET_COUNT = 10;
+        /// @brief Durations per sample timed.
+        static constexpr uint32_t SAMPLE_PERIOD = 64;
+
+        Histogram();
+
+        Histogram(Histogram const&) = delete;
+        Histogram & operator=(Histogram const&) = delete;
+
+        /// @brief Record a duration, from the writer.
+        ///
+        /// @param nanoseconds Duration.
+        void record(uint64_t nanoseconds)
+        {
+            buckets_[findBucket(nanoseconds)].add(1);
+            sum_.add(nanoseconds);
+        }
+
+        /// @brief Check if the next duration is to be timed, from the writer.
+        ///
+        /// The first one is, then one every sample period.
+        bool sample()
+        {
+            if (--countdown_ != 0)
+            {
+                return false;
+            }
+
+            countdown_ = SAMPLE_PERIOD;
+            return true;
+        }
+
+        /// @brief Return the samples of a bucket, not cumulated.
+        uint64_t getBucket(size_t bucket) const { return buckets_[bucket].get(); }
+        /// @brief Return the sum of the samples, in nanoseconds.
+        uint64_t getSum() const { return sum_.get(); }
+
+        uint64_t getCount() const;
+
+        /// @brief Return the upper bound of a bounded bucket, in nanoseconds.
+        static constexpr uint64_t getBound(size_t bucket) { return 1000ull << (2 * bucket); }
+
+        /// @brief Find the bucket of a duration.
+        static constexpr size_t findBucket(uint64_t nanoseconds)
+        {
+            // Bucket n holds (4^(n-1), 4^n] microseconds
+            uint64_t micros = (nanoseconds == 0) ? 0 : (nanoseconds - 1) / 1000;
+            size_t bucket = (micros == 0) ? 0 : (65 - __builtin_clzll(micros)) / 2;
+
+            return (bucket < BUCKET_COUNT - 1) ? bucket : BUCKET_COUNT - 1;
+        }
+
+    private:
+        /// @brief Samples per bucket.
+        Counter buckets_[BUCKET_COUNT];
+        /// @brief Sum of the samples, in nanoseconds.
+        Counter sum_;
+        /// @brief Durations until the next sample, owned by the writer.
+        uint32_t countdown_;
+};
+
+/// @brief Runtime metrics of a virtual machine.
+///
+/// Each metric has a single writer: the emulation thread, except presented
+/// frames counted by the presentation thread.  Any thread may format them.
+struct Metrics
+{
+    using Clock = std::chrono::steady_clock;
+
+    explicit Metrics(uint32_t cpuRate);
+
+    std::string format(std::string const& labels) const;
+
+    /// @brief Emulated CPU rate.
+    uint32_t cpuRate;
+    /// @brief Wall clock time metrics started.
+    Clock::time_point startTime;
+
+    /// @brief Instructions executed.
+    Counter instructions;
+    /// @brief Frames drawn by the emulation.
+    Counter frames;
+    /// @brief Frames presented to the window.
+    Counter presentedFrames;
+    /// @brief Frames replaced before being presented.
+    Counter droppedFrames;
+
+    /// @brief Duration of keyboard updates.
+    Histogram keyboardUpdate;
+    /// @brief Duration of CPU runs between events.
+    Histogram cpuRun;
+    /// @brief Duration of GPU draws.
+    Histogram gpuDraw;
+};
+
+/// @brief Record the lifetime of a scope to a histogram, when sampled.
+class ScopedTimer
+{
+    public:
+        /// @brief Start timing.
+        ///
+        /// @param histogram Histogram recording the duration, none to not time.
+        explicit ScopedTimer(Histogram * histogram)
+            : histogram_{ (histogram != nullptr && histogram->sample()) ? histogram : nullptr }
+            , start_{ histogram_ ? Metrics::Clock::now() : Metrics::Clock::time_point{} }
+        {
+        }
+
+        ScopedTimer(ScopedTimer const&) = delete;
+        ScopedTimer & operator=(ScopedTimer const&) = delete;
+
+        /// @brief Record the duration.
+        ~ScopedTimer()
+        {
+            if (histogram_ != nullptr)
+            {
+                histogram_->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        Metrics::Clock::now() - start_).count());
+            }
+        }
+
+    private:
+        /// @brief Histogram recording the duration.
+        Histogram * histogram_;
+        /// @brief Time the scope started.
+        Metrics::Clock::time_point start_;
+};
+
+/// @brief Metrics exporter, in Prometheus text format, from its own thread.
+///
+/// The target `http:[HOST:]PORT` serves the metrics to scrapers at
+/// `/metrics`.  Any other target, `fd:N`, `tcp:HOST:PORT` or a file path as
+/// for frame streams, receives a snapshot every interval and a last one
+/// when stopped, each written with a single system call.
+class MetricsExporter
+{
+    public:
+        /// @brief Default interval between snapshots.
+        static constexpr uint32_t DEFAULT_INTERVAL = 1000; // MS
+
+        MetricsExporter(Metrics const& metrics, std::string labels, uint32_t interval = DEFAULT_INTERVAL);
+        ~MetricsExporter();
+
+        MetricsExporter(MetricsExporter const&) = delete;
+        MetricsExporter & operator=(MetricsExporter const&) = delete;
+
+        bool open(std::string const& target);
+        void start();
+        void stop();
+
+        /// @brief Return the port listened to, zero when not serving.
+        uint16_t getPort() const { return port_; }
+        /// @brief Return the snapshots written or served.
+        uint64_t getSnapshotCount() const { return snapshotCount_; }
+
+    private:
+        bool listen(std::string const& address);
+
+        void push();
+        void serve();
+        void answer(int client);
+        bool writeAll(int descriptor, std::string const& text, bool socket);
+
+        /// @brief Exported metrics.
+        Metrics const& metrics_;
+        /// @brief Labels of every sample, e.g. `rom="pong"`.
+        std::string labels_;
+        /// @brief Interval between snapshots.
+        std::chrono::milliseconds interval_;
+
+        /// @brief Descriptor written or listened to, negative when closed.
+        int descriptor_;
+        /// @brief The exporter owns the descriptor.
+        bool owned_;
+        /// @brief The descriptor is a socket.
+        bool socket_;
+        /// @brief Port listened to, zero when pushing.
+        uint16_t port_;
+        /// @brief Snapshots written or served.
+        std::atomic<uint64_t> snapshotCount_;
+
+        /// @brief Exporting thread.
+        std::thread thread_;
+        /// @brief Guards the stop request.
+        std::mutex mutex_;
+        /// @brief Wakes the exporting thread on stop.
+        std::condition_variable wakeUp_;
+        /// @brief Stop requested.
+        bool stopping_;
+};
+
+std::string escapeLabel(std::string const& value);
+
+}  // chip8
+
+#endif  // CHIP8_METRICS_HPP
@@ -69,14 +69,30 @@ enum OpcodeEncoding
     OPCODE_FX29 = 0xF029,
     OPCODE_FX33 = 0xF033,
     OPCODE_FX55 = 0xF055,
-    OPCODE_FX65 = 0xF065
+    OPCODE_FX65 = 0xF065,
+
+    // SUPER-CHIP and XO-CHIP extensions
+    OPCODE_00CN = 0x00C0,
+    OPCODE_00DN = 0x00D0,
+    OPCODE_00FB = 0x00FB,
+    OPCODE_00FC = 0x00FC,
+    OPCODE_00FD = 0x00FD,
+    OPCODE_00FE = 0x00FE,
+    OPCODE_00FF = 0x00FF,
+    OPCODE_5XY2 = 0x5002,
+    OPCODE_5XY3 = 0x5003,
+    OPCODE_F000 = 0xF000,
+    OPCODE_FN01 = 0xF001,
+    OPCODE_FX30 = 0xF030,
+    OPCODE_FX75 = 0xF075,
+    OPCODE_FX85 = 0xF085
 };
 
 /// @brief Decode instruction from opcode.
 ///
 /// @param opcode  Opcode.
 /// @return Decoded instruction.
-inline Opcode decodeInstruction(Opcode opcode)
+constexpr Opcode decodeInstruction(Opcode opcode)
 {
     uint16_t decodedOpcode = opcode & 0xF000;
 
@@ -84,7 +100,7 @@ inline Opcode decodeInstruction(Opcode opcode)
     {
         decodedOpcode |= (opcode & 0x00FF);
     }
-    else if (decodedOpcode == 0x5000 | decodedOpcode == 0x8000 || decodedOpcode == 0x9000)
+    else if (decodedOpcode == 0x5000 || decodedOpcode == 0x8000 || decodedOpcode == 0x9000)
     {
         decodedOpcode |= (opcode & 0x000F);
     }
@@ -1070,6 +1086,128 @@ inline Operand::X decodeFX65(Opcode opcode)
     return Operand::split<Operand::X>(opcode);
 }
 
+/// @brief Encode opcode 00CN
+///
+/// @param n  Row count.
+/// @return Opcode.
+inline Opcode encode00CN(uint16_t n)
+{
+    return OPCODE_00CN | (n & 0xF);
+}
+
+/// @brief Encode opcode 00DN
+///
+/// @param n  Row count.
+/// @return Opcode.
+inline Opcode encode00DN(uint16_t n)
+{
+    return OPCODE_00DN | (n & 0xF);
+}
+
+/// @brief Encode opcode 00FB
+///
+/// @return Opcode.
+inline Opcode encode00FB()
+{
+    return OPCODE_00FB;
+}
+
+/// @brief Encode opcode 00FC
+///
+/// @return Opcode.
+inline Opcode encode00FC()
+{
+    return OPCODE_00FC;
+}
+
+/// @brief Encode opcode 00FD
+///
+/// @return Opcode.
+inline Opcode encode00FD()
+{
+    return OPCODE_00FD;
+}
+
+/// @brief Encode opcode 00FE
+///
+/// @return Opcode.
+inline Opcode encode00FE()
+{
+    return OPCODE_00FE;
+}
+
+/// @brief Encode opcode 00FF
+///
+/// @return Opcode.
+inline Opcode encode00FF()
+{
+    return OPCODE_00FF;
+}
+
+/// @brief Encode opcode 5XY2
+///
+/// @param x  Register Vx.
+/// @param y  Register Vy.
+/// @return Opcode.
+inline Opcode encode5XY2(uint16_t x, uint16_t y)
+{
+    return OPCODE_5XY2 | Operand::join(Operand::XY(x, y));
+}
+
+/// @brief Encode opcode 5XY3
+///
+/// @param x  Register Vx.
+/// @param y  Register Vy.
+/// @return Opcode.
+inline Opcode encode5XY3(uint16_t x, uint16_t y)
+{
+    return OPCODE_5XY3 | Operand::join(Operand::XY(x, y));
+}
+
+/// @brief Encode opcode F000
+///
+/// @return Opcode.
+inline Opcode encodeF000()
+{
+    return OPCODE_F000;
+}
+
+/// @brief Encode opcode FN01
+///
+/// @param n  Plane mask.
+/// @return Opcode.
+inline Opcode encodeFN01(uint16_t n)
+{
+    return OPCODE_FN01 | Operand::join(Operand::X(n));
+}
+
+/// @brief Encode opcode FX30
+///
+/// @param x  Register Vx.
+/// @return Opcode.
+inline Opcode encodeFX30(uint16_t x)
+{
+    return OPCODE_FX30 | Operand::join(Operand::X(x));
+}
+
+/// @brief Encode opcode FX75
+///
+/// @param x  Register Vx.
+/// @return Opcode.
+inline Opcode encodeFX75(uint16_t x)
+{
+    return OPCODE_FX75 | Operand::join(Operand::X(x));
+}
+
+/// @brief Encode opcode FX85
+///
+/// @param x  Register Vx.
+/// @return Opcode.
+inline Opcode encodeFX85(uint16_t x)
+{
+    return OPCODE_FX85 | Operand::join(Operand::X(x));
+}
+
 }  // opcode
 }  // chip8
 
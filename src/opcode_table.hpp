@@ -0,0 +1,169 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_OPCODETABLE_HPP
+#define CHIP8_OPCODETABLE_HPP
+
+#include <array>
+#include <core.hpp>
+#include <opcode.hpp>
+
+namespace chip8 {
+namespace opcode {
+
+/// @brief Compile-time two-level opcode dispatch table.
+///
+/// The first level is indexed by the opcode top nibble and gives the
+/// sub-opcode mask and the offset of the nibble's second level.  The second
+/// level is indexed by the masked sub-opcode and gives an index into the
+/// handler list.  Index zero is reserved for unknown opcodes and holds a null
+/// handler.
+///
+/// Sub-opcode masks are the ones applied by decodeInstruction(), so looking up
+/// an opcode gives the same handler as looking up its decoded instruction.
+///
+/// @tparam FUNC Handler type.
+template<typename FUNC>
+class DispatchTable
+{
+    public:
+        /// @brief Maximum handler count, unknown handler included.
+        static constexpr size_t MAX_HANDLERS = 64;
+
+        /// @brief Instruction and its handler.
+        struct Entry
+        {
+            Opcode instruction;
+            FUNC   func;
+        };
+
+        /// @brief Construct a dispatch table.
+        ///
+        /// @param entries Instruction list.
+        template<size_t COUNT>
+        constexpr DispatchTable(Entry const (&entries)[COUNT])
+            : groups_{ }
+            , indices_{ }
+            , handlers_{ }
+            , count_{ 1 }
+        {
+            uint16_t offset = 0;
+
+            for (uint16_t nibble = 0; nibble < NIBBLE_COUNT; ++nibble)
+            {
+                uint16_t mask = decodeInstruction((nibble << 12) | 0x0FFF) & 0x0FFF;
+
+                groups_[nibble].mask = mask;
+                groups_[nibble].offset = offset;
+
+                offset += mask + 1;
+            }
+
+            add(entries);
+        }
+
+        /// @brief Add instructions, e.g. the ones of an extended machine.
+        ///
+        /// @param entries Instruction list.
+        template<size_t COUNT>
+        constexpr void add(Entry const (&entries)[COUNT])
+        {
+            static_assert(COUNT < MAX_HANDLERS, "Too many instructions");
+
+            for (size_t index = 0; index < COUNT; ++index)
+            {
+                assign(entries[index].instruction, entries[index].func);
+            }
+        }
+
+        /// @brief Assign a handler to an instruction.
+        ///
+        /// Instructions sharing a handler, such as the sub-opcodes of a
+        /// nibble operand, share its handler list entry.
+        ///
+        /// @param instruction Instruction.
+        /// @param func        Handler.
+        constexpr void assign(Opcode instruction, FUNC func)
+        {
+            size_t index = 1;
+
+            while (index < count_ && handlers_[index] != func)
+            {
+                ++index;
+            }
+
+            if (index == count_)
+            {
+                handlers_[count_++] = func;
+            }
+
+            indices_[locate(instruction)] = index;
+        }
+
+        /// @brief Lookup the handler of an opcode.
+        ///
+        /// @param opcode Opcode to lookup.
+        /// @return Handler, or null when the opcode is unknown.
+        constexpr FUNC lookup(Opcode opcode) const
+        {
+            return handlers_[indices_[locate(opcode)]];
+        }
+
+    private:
+        /// @brief First level entry.
+        struct Group
+        {
+            uint16_t mask;
+            uint16_t offset;
+        };
+
+        /// @brief First level size.
+        static constexpr size_t NIBBLE_COUNT = 16;
+        /// @brief Second level size, 0x0, 0xE and 0xF use a byte and 0x5, 0x8
+        ///        and 0x9 use a nibble.
+        static constexpr size_t INDEX_COUNT = 3 * 256 + 3 * 16 + 10;
+
+        /// @brief Compute second level location of an opcode.
+        ///
+        /// @param opcode Opcode.
+        /// @return Second level index.
+        constexpr uint16_t locate(Opcode opcode) const
+        {
+            auto const& group = groups_[opcode >> 12];
+            return group.offset + (opcode & group.mask);
+        }
+
+        /// @brief First level table.
+        std::array<Group, NIBBLE_COUNT> groups_;
+        /// @brief Second level table.
+        std::array<uint8_t, INDEX_COUNT> indices_;
+        /// @brief Handler list.
+        std::array<FUNC, MAX_HANDLERS> handlers_;
+        /// @brief Count of handlers, unknown handler included.
+        size_t count_;
+};
+
+}  // opcode
+}  // chip8
+
+#endif  // CHIP8_OPCODETABLE_HPP
@@ -0,0 +1,256 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "pixel_expand.hpp"
+
+namespace chip8 {
+
+namespace pixel {
+
+namespace {
+
+/// @brief Select a palette color for a pixel.
+inline Pixel selectPixel(uint64_t row, uint32_t x, Palette const& palette)
+{
+    return ((row >> (ROW_WIDTH - 1 - x)) & 0x1) ? palette.on : palette.off;
+}
+
+#if defined(__SSE2__) || defined(__AVX2__)
+
+/// @brief Expand four pixels from the top nibble of `bits`.
+inline __m128i expand4(uint32_t bits, __m128i on, __m128i off)
+{
+    const __m128i PIXEL_BITS = _mm_set_epi32(0x1, 0x2, 0x4, 0x8);
+
+    __m128i mask = _mm_and_si128(_mm_set1_epi32(bits), PIXEL_BITS);
+    mask = _mm_cmpeq_epi32(mask, PIXEL_BITS);
+
+    return _mm_or_si128(_mm_and_si128(mask, on), _mm_andnot_si128(mask, off));
+}
+
+/// @brief SSE2 kernel, four pixels per store.
+///
+/// @return False when the scale is not handled.
+bool expandRowSse2(uint64_t row, Palette const& palette, uint32_t scale, Pixel * pixels)
+{
+    __m128i on = _mm_set1_epi32(palette.on);
+    __m128i off = _mm_set1_epi32(palette.off);
+    __m128i * out = reinterpret_cast<__m128i *>(pixels);
+
+    if (scale == 1 || scale == 2)
+    {
+        for (uint32_t x = 0; x < ROW_WIDTH; x += 4)
+        {
+            uint32_t nibble = (row >> (ROW_WIDTH - 4 - x)) & 0xF;
+            __m128i quad = expand4(nibble, on, off);
+
+            if (scale == 1)
+            {
+                _mm_storeu_si128(out++, quad);
+            }
+            else
+            {
+                _mm_storeu_si128(out++, _mm_unpacklo_epi32(quad, quad));
+                _mm_storeu_si128(out++, _mm_unpackhi_epi32(quad, quad));
+            }
+        }
+
+        return true;
+    }
+
+    if (scale % 4 == 0)
+    {
+        for (uint32_t x = 0; x < ROW_WIDTH; ++x)
+        {
+            __m128i pixel = _mm_set1_epi32(selectPixel(row, x, palette));
+
+            for (uint32_t count = 0; count < scale; count += 4)
+            {
+                _mm_storeu_si128(out++, pixel);
+            }
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+#endif
+
+#if defined(__AVX2__)
+
+/// @brief AVX2 kernel, eight pixels per store.
+///
+/// @return False when the scale is not handled.
+bool expandRowAvx2(uint64_t row, Palette const& palette, uint32_t scale, Pixel * pixels)
+{
+    __m256i * out = reinterpret_cast<__m256i *>(pixels);
+
+    if (scale == 1)
+    {
+        const __m256i PIXEL_BITS = _mm256_set_epi32(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+
+        __m256i on = _mm256_set1_epi32(palette.on);
+        __m256i off = _mm256_set1_epi32(palette.off);
+
+        for (uint32_t x = 0; x < ROW_WIDTH; x += 8)
+        {
+            uint32_t byte = (row >> (ROW_WIDTH - 8 - x)) & 0xFF;
+
+            __m256i mask = _mm256_and_si256(_mm256_set1_epi32(byte), PIXEL_BITS);
+            mask = _mm256_cmpeq_epi32(mask, PIXEL_BITS);
+
+            _mm256_storeu_si256(out++, _mm256_blendv_epi8(off, on, mask));
+        }
+
+        return true;
+    }
+
+    if (scale % 8 == 0)
+    {
+        for (uint32_t x = 0; x < ROW_WIDTH; ++x)
+        {
+            __m256i pixel = _mm256_set1_epi32(selectPixel(row, x, palette));
+
+            for (uint32_t count = 0; count < scale; count += 8)
+            {
+                _mm256_storeu_si256(out++, pixel);
+            }
+        }
+
+        return true;
+    }
+
+    return expandRowSse2(row, palette, scale, pixels);
+}
+
+#endif
+
+#if defined(__ARM_NEON)
+
+/// @brief NEON kernel, four pixels per store.
+///
+/// @return False when the scale is not handled.
+bool expandRowNeon(uint64_t row, Palette const& palette, uint32_t scale, Pixel * pixels)
+{
+    if (scale == 1)
+    {
+        const uint32_t BITS[4] = { 0x8, 0x4, 0x2, 0x1 };
+
+        uint32x4_t pixelBits = vld1q_u32(BITS);
+        uint32x4_t on = vdupq_n_u32(palette.on);
+        uint32x4_t off = vdupq_n_u32(palette.off);
+
+        for (uint32_t x = 0; x < ROW_WIDTH; x += 4, pixels += 4)
+        {
+            uint32_t nibble = (row >> (ROW_WIDTH - 4 - x)) & 0xF;
+            uint32x4_t mask = vtstq_u32(vdupq_n_u32(nibble), pixelBits);
+
+            vst1q_u32(pixels, vbslq_u32(mask, on, off));
+        }
+
+        return true;
+    }
+
+    if (scale % 4 == 0)
+    {
+        for (uint32_t x = 0; x < ROW_WIDTH; ++x)
+        {
+            uint32x4_t pixel = vdupq_n_u32(selectPixel(row, x, palette));
+
+            for (uint32_t count = 0; count < scale; count += 4, pixels += 4)
+            {
+                vst1q_u32(pixels, pixel);
+            }
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+#endif
+
+} // namespace
+
+char const * kernelName()
+{
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#elif defined(__ARM_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void expandRow(uint64_t row, Palette const& palette, uint32_t scale, Pixel * pixels)
+{
+#if defined(__AVX2__)
+    if (expandRowAvx2(row, palette, scale, pixels))
+    {
+        return;
+    }
+#elif defined(__SSE2__)
+    if (expandRowSse2(row, palette, scale, pixels))
+    {
+        return;
+    }
+#elif defined(__ARM_NEON)
+    if (expandRowNeon(row, palette, scale, pixels))
+    {
+        return;
+    }
+#endif
+
+    expandRowScalar(row, palette, scale, pixels);
+}
+
+void expandRowScalar(uint64_t row, Palette const& palette, uint32_t scale, Pixel * pixels)
+{
+    for (uint32_t x = 0; x < ROW_WIDTH; ++x)
+    {
+        Pixel pixel = selectPixel(row, x, palette);
+
+        for (uint32_t count = 0; count < scale; ++count)
+        {
+            *pixels++ = pixel;
+        }
+    }
+}
+
+}  // pixel
+
+}  // chip8
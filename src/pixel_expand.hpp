@@ -0,0 +1,73 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_PIXELEXPAND_HPP
+#define CHIP8_PIXELEXPAND_HPP
+
+#include <core.hpp>
+
+namespace chip8 {
+
+namespace pixel {
+
+/// @brief Pixel type, in RGBA8888 format.
+using Pixel = uint32_t;
+
+/// @brief Colors of unlit and lit pixels.
+struct Palette
+{
+    /// @brief Unlit pixel color.
+    Pixel off;
+    /// @brief Lit pixel color.
+    Pixel on;
+};
+
+/// @brief Default black and white palette.
+constexpr Palette DEFAULT_PALETTE{ 0x000000FF, 0xFFFFFFFF };
+
+/// @brief Bits expanded per row.
+constexpr uint32_t ROW_WIDTH = 64;
+
+/// @brief Name of the kernel selected at build time.
+char const * kernelName();
+
+/// @brief Expand a 1 bit per pixel row to pixels.
+///
+/// The most significant bit is the leftmost pixel.  Each bit is repeated
+/// `scale` times, so `ROW_WIDTH * scale` pixels are written.  Uses the
+/// widest vector unit the build targets.
+///
+/// @param row      Row bits.
+/// @param palette  Pixel colors.
+/// @param scale    Horizontal scale factor.
+/// @param pixels   Destination pixels.
+void expandRow(uint64_t row, Palette const& palette, uint32_t scale, Pixel * pixels);
+
+/// @brief Scalar reference of `expandRow`.
+void expandRowScalar(uint64_t row, Palette const& palette, uint32_t scale, Pixel * pixels);
+
+}  // pixel
+
+}  // chip8
+
+#endif  // CHIP8_PIXELEXPAND_HPP
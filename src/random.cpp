@@ -0,0 +1,234 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <sstream>
+
+#include "random.hpp"
+
+namespace chip8 {
+
+/// @brief Construct a PCG32 generator with the default seed.
+Random::Random()
+    : Random{ Algorithm::PCG32 }
+{
+}
+
+/// @brief Construct a generator.
+///
+/// @param algorithm Generator algorithm.
+/// @param seed      Seed.
+Random::Random(Algorithm algorithm, uint32_t seed)
+    : algorithm_{ algorithm }
+    , state_{ 0 }
+    , compatible_{ }
+{
+    if (algorithm_ == Algorithm::MT19937)
+    {
+        compatible_ = std::make_unique<std::mt19937>();
+    }
+
+    this->seed(seed);
+}
+
+/// @brief Copy a generator, with its state.
+///
+/// @param other Generator to copy.
+Random::Random(Random const& other)
+    : algorithm_{ other.algorithm_ }
+    , state_{ other.state_ }
+    , compatible_{ }
+{
+    if (other.compatible_)
+    {
+        compatible_ = std::make_unique<std::mt19937>(*other.compatible_);
+    }
+}
+
+/// @brief Destroy a generator.
+Random::~Random()
+{
+}
+
+/// @brief Copy a generator, with its state.
+///
+/// @param other Generator to copy.
+/// @return This generator.
+Random & Random::operator=(Random const& other)
+{
+    if (this != &other)
+    {
+        algorithm_ = other.algorithm_;
+        state_ = other.state_;
+
+        if (!other.compatible_)
+        {
+            compatible_.reset();
+        }
+        else if (compatible_)
+        {
+            *compatible_ = *other.compatible_;
+        }
+        else
+        {
+            compatible_ = std::make_unique<std::mt19937>(*other.compatible_);
+        }
+    }
+
+    return *this;
+}
+
+/// @brief Restart the sequence from a seed.
+///
+/// PCG32 is seeded as the reference implementation does, so seeds next to
+/// each other still give unrelated sequences.
+///
+/// @param seed Seed.
+void Random::seed(uint32_t seed)
+{
+    if (algorithm_ == Algorithm::MT19937)
+    {
+        compatible_->seed(seed);
+        return;
+    }
+
+    state_ = PCG_INCREMENT;
+    state_ = (state_ + seed) * PCG_MULTIPLIER + PCG_INCREMENT;
+}
+
+/// @brief Store the generator state as words.
+///
+/// @param words    Words to fill.
+/// @param capacity Word capacity, STATE_CAPACITY always fits.
+/// @return Count of words stored, zero when they do not fit.
+size_t Random::save(uint32_t * words, size_t capacity) const
+{
+    if (algorithm_ == Algorithm::PCG32)
+    {
+        if (capacity < 2)
+        {
+            return 0;
+        }
+
+        words[0] = static_cast<uint32_t>(state_);
+        words[1] = static_cast<uint32_t>(state_ >> 32);
+        return 2;
+    }
+
+    std::stringstream stream;
+    stream << *compatible_;
+
+    size_t count = 0;
+    unsigned long word = 0;
+
+    while (stream >> word)
+    {
+        if (count == capacity)
+        {
+            return 0;
+        }
+
+        words[count++] = static_cast<uint32_t>(word);
+    }
+
+    return count;
+}
+
+/// @brief Load a generator state stored with save().
+///
+/// @param algorithm Generator algorithm.
+/// @param words     Stored words.
+/// @param count     Count of stored words.
+/// @return True when loaded, false when the state is invalid and this
+///         generator is left unchanged.
+bool Random::load(Algorithm algorithm, uint32_t const * words, size_t count)
+{
+    if (algorithm == Algorithm::PCG32)
+    {
+        if (count != 2)
+        {
+            return false;
+        }
+
+        algorithm_ = algorithm;
+        state_ = words[0] | (static_cast<uint64_t>(words[1]) << 32);
+        compatible_.reset();
+        return true;
+    }
+
+    if (algorithm != Algorithm::MT19937)
+    {
+        return false;
+    }
+
+    std::stringstream stream;
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        stream << words[index] << ' ';
+    }
+
+    auto generator = std::make_unique<std::mt19937>();
+
+    if (!(stream >> *generator))
+    {
+        return false;
+    }
+
+    algorithm_ = algorithm;
+    compatible_ = std::move(generator);
+    return true;
+}
+
+/// @brief Parse an algorithm name, `pcg32` or `mt19937`.
+///
+/// @param name      Name to parse.
+/// @param algorithm Algorithm parsed.
+/// @return True when parsed, otherwise false.
+bool Random::parseAlgorithm(std::string const& name, Algorithm & algorithm)
+{
+    if (name == "pcg32")
+    {
+        algorithm = Algorithm::PCG32;
+        return true;
+    }
+
+    if (name == "mt19937")
+    {
+        algorithm = Algorithm::MT19937;
+        return true;
+    }
+
+    return false;
+}
+
+/// @brief Return a random byte from mt19937, as older versions drew them.
+///
+/// @return Random byte.
+uint8_t Random::nextCompatible()
+{
+    std::uniform_int_distribution<uint8_t> distribution{ };
+
+    return distribution(*compatible_);
+}
+
+}  // chip8
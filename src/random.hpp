@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_RANDOM_HPP
+#define CHIP8_RANDOM_HPP
+
+#include <memory>
+#include <random>
+#include <string>
+
+#include <core.hpp>
+
+namespace chip8 {
+
+/// @brief Random number generator of CXKK.
+///
+/// The default algorithm is PCG32, a 64-bit state copied with the rest of
+/// the CPU state, so snapshots stay cheap.  The mt19937 algorithm keeps the
+/// number sequence of older savestates and input logs, its 2.5 KB state is
+/// only allocated when selected.
+///
+/// Unlike the trace and device policies, the algorithm is chosen at run
+/// time: a savestate or input log selects it when loaded into a CPU already
+/// built, so one CPU type runs both.  The PCG32 path stays inline, only the
+/// mt19937 one goes out of line.
+class Random
+{
+    public:
+        /// @brief Generator algorithm, stored in savestates and input logs.
+        ///
+        /// Formats that predate the choice hold zero, so mt19937 is zero.
+        enum class Algorithm : uint8_t { MT19937, PCG32 };
+
+        /// @brief Default seed, the one of std::mt19937.
+        static constexpr uint32_t DEFAULT_SEED = std::mt19937::default_seed;
+        /// @brief Largest state, in 32-bit words.
+        static constexpr size_t STATE_CAPACITY = 625;
+
+        Random();
+        explicit Random(Algorithm algorithm, uint32_t seed = DEFAULT_SEED);
+        Random(Random const& other);
+        Random(Random && other) noexcept = default;
+        ~Random();
+
+        Random & operator=(Random const& other);
+        Random & operator=(Random && other) noexcept = default;
+
+        void seed(uint32_t seed);
+
+        /// @brief Return the generator algorithm.
+        Algorithm getAlgorithm() const { return algorithm_; }
+
+        /// @brief Return a uniformly distributed random byte.
+        uint8_t next()
+        {
+            if (algorithm_ != Algorithm::PCG32)
+            {
+                return nextCompatible();
+            }
+
+            uint64_t state = state_;
+            state_ = state * PCG_MULTIPLIER + PCG_INCREMENT;
+
+            uint32_t shifted = static_cast<uint32_t>(((state >> 18) ^ state) >> 27);
+            uint32_t rotation = static_cast<uint32_t>(state >> 59);
+            uint32_t output = (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+
+            return static_cast<uint8_t>(output >> 24);
+        }
+
+        size_t save(uint32_t * words, size_t capacity) const;
+        bool   load(Algorithm algorithm, uint32_t const * words, size_t count);
+
+        static bool parseAlgorithm(std::string const& name, Algorithm & algorithm);
+
+    private:
+        /// @brief PCG32 state multiplier.
+        static constexpr uint64_t PCG_MULTIPLIER = 6364136223846793005ULL;
+        /// @brief PCG32 state increment, selecting its stream.
+        static constexpr uint64_t PCG_INCREMENT = 1442695040888963407ULL;
+
+        uint8_t nextCompatible();
+
+        /// @brief Generator algorithm.
+        Algorithm algorithm_;
+        /// @brief PCG32 state.
+        uint64_t state_;
+        /// @brief mt19937 generator, only with that algorithm.
+        std::unique_ptr<std::mt19937> compatible_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_RANDOM_HPP
@@ -0,0 +1,192 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdio>
+
+#include <fontset.hpp>
+#include "rom.hpp"
+
+namespace chip8 {
+
+/// @brief Construct an empty ROM.
+Rom::Rom()
+    : image_{ std::make_shared<Memory::Bytes const>() }
+{
+}
+
+/// @brief Construct a ROM from program bytes.
+///
+/// @param bytes Program bytes, cut to fit memory when loaded.
+Rom::Rom(Memory::Bytes bytes)
+    : image_{ std::make_shared<Memory::Bytes const>(std::move(bytes)) }
+{
+}
+
+/// @brief Read a ROM file in one call.
+///
+/// @param filename File to read.
+/// @param maxSize  Largest program, `MAX_EXTENDED_SIZE` for an extended machine.
+/// @return True when read, false when missing, empty or too large.
+bool Rom::load(std::string const& filename, size_t maxSize)
+{
+    std::FILE * romFile = std::fopen(filename.c_str(), "rb");
+
+    if (romFile == nullptr)
+    {
+        std::printf("No such file `%s'\n", filename.c_str());
+        return false;
+    }
+
+    long fileSize = -1;
+
+    if (std::fseek(romFile, 0, SEEK_END) == 0)
+    {
+        fileSize = std::ftell(romFile);
+        std::rewind(romFile);
+    }
+
+    if (fileSize <= 0 || static_cast<unsigned long>(fileSize) > maxSize)
+    {
+        std::printf("Invalid ROM file `%s', %ld bytes for at most %zu\n", filename.c_str(), fileSize, maxSize);
+        std::fclose(romFile);
+        return false;
+    }
+
+    Memory::Bytes bytes(static_cast<size_t>(fileSize));
+
+    bool read = std::fread(bytes.data(), 1, bytes.size(), romFile) == bytes.size();
+    std::fclose(romFile);
+
+    if (!read)
+    {
+        std::printf("Cannot read ROM file `%s'\n", filename.c_str());
+        return false;
+    }
+
+    image_ = std::make_shared<Memory::Bytes const>(std::move(bytes));
+
+    return true;
+}
+
+/// @brief Copy a ROM from a buffer.
+///
+/// @param data Program bytes.
+/// @param size    Program size in bytes.
+/// @param maxSize Largest program, `MAX_EXTENDED_SIZE` for an extended machine.
+/// @return True when copied, false when empty or too large.
+bool Rom::load(uint8_t const * data, size_t size, size_t maxSize)
+{
+    if (size == 0 || size > maxSize)
+    {
+        std::printf("Invalid ROM buffer, %zu bytes for at most %zu\n", size, maxSize);
+        return false;
+    }
+
+    image_ = std::make_shared<Memory::Bytes const>(data, data + size);
+
+    return true;
+}
+
+/// @brief Construct an empty ROM catalogue.
+RomCatalogue::RomCatalogue()
+    : roms_{ }
+{
+}
+
+/// @brief Destroy the ROM catalogue.
+RomCatalogue::~RomCatalogue()
+{
+}
+
+/// @brief Read a ROM file once, named by its filename.
+///
+/// @param filename File to read, kept when already in the catalogue.
+/// @return True when in the catalogue, otherwise false.
+bool RomCatalogue::add(std::string const& filename)
+{
+    if (roms_.count(filename) != 0)
+    {
+        return true;
+    }
+
+    Rom rom;
+
+    if (!rom.load(filename))
+    {
+        return false;
+    }
+
+    roms_.emplace(filename, std::move(rom));
+
+    return true;
+}
+
+/// @brief Name a ROM, replacing any ROM of that name.
+///
+/// @param name ROM name.
+/// @param rom  ROM, its image is shared.
+void RomCatalogue::add(std::string const& name, Rom const& rom)
+{
+    roms_[name] = rom;
+}
+
+/// @brief Find a ROM by name.
+///
+/// @param name ROM name.
+/// @return ROM, null when not in the catalogue.
+Rom const * RomCatalogue::find(std::string const& name) const
+{
+    auto found = roms_.find(name);
+
+    return (found != roms_.end()) ? &found->second : nullptr;
+}
+
+/// @brief Load the fontset and a program in memory.
+///
+/// @param memory  Memory to load.
+/// @param rom     Program loaded at the program start, cut to fit memory.
+void loadProgram(Memory & memory, Rom const& rom)
+{
+    size_t romSize = std::min<size_t>(rom.size(), memory.getSize() - Cpu::PROGRAM_START);
+
+    memory.storeRange(0, FONT_SET, FONT_SET_SIZE);
+    memory.storeRange(Cpu::PROGRAM_START, rom.data(), romSize);
+}
+
+/// @brief Load both fontsets and a program in extended memory.
+///
+/// The large fontset follows the small one, where FX30 points.
+///
+/// @param memory  Memory to load.
+/// @param rom     Program loaded at the program start, cut to fit memory.
+void loadProgram(ExtendedMemory & memory, Rom const& rom)
+{
+    size_t romSize = std::min<size_t>(rom.size(), memory.getSize() - Cpu::PROGRAM_START);
+
+    memory.storeRange(0, FONT_SET, FONT_SET_SIZE);
+    memory.storeRange(FONT_SET_SIZE, BIG_FONT_SET, BIG_FONT_SET_SIZE);
+    memory.storeRange(Cpu::PROGRAM_START, rom.data(), romSize);
+}
+
+}  // chip8
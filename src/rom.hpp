@@ -0,0 +1,99 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_ROM_HPP
+#define CHIP8_ROM_HPP
+
+#include <string>
+#include <unordered_map>
+
+#include <core.hpp>
+#include <cpu.hpp>
+#include <memory.hpp>
+
+namespace chip8 {
+
+/// @brief Read-only program image.
+///
+/// Copies share the same image, so any count of machines can load a ROM
+/// that was read once.
+class Rom
+{
+    public:
+        /// @brief Largest program, from the program start to the end of memory.
+        static constexpr size_t MAX_SIZE = SYSTEM_MEMORY_SIZE - Cpu::PROGRAM_START;
+        /// @brief Largest program of an extended machine.
+        static constexpr size_t MAX_EXTENDED_SIZE = ExtendedMemory::MEMORY_SIZE - Cpu::PROGRAM_START;
+
+        Rom();
+        Rom(Memory::Bytes bytes);
+
+        bool load(std::string const& filename, size_t maxSize = MAX_SIZE);
+        bool load(uint8_t const * data, size_t size, size_t maxSize = MAX_SIZE);
+
+        /// @brief Return the program bytes.
+        uint8_t const * data() const
+        {
+            return image_->data();
+        }
+
+        /// @brief Return the program size in bytes.
+        size_t size() const
+        {
+            return image_->size();
+        }
+
+    private:
+        /// @brief Shared program image.
+        std::shared_ptr<Memory::Bytes const> image_;
+};
+
+/// @brief ROMs read once and looked up by name.
+class RomCatalogue
+{
+    public:
+        RomCatalogue();
+        ~RomCatalogue();
+
+        bool add(std::string const& filename);
+        void add(std::string const& name, Rom const& rom);
+
+        Rom const * find(std::string const& name) const;
+
+        /// @brief Return the count of ROMs.
+        size_t size() const
+        {
+            return roms_.size();
+        }
+
+    private:
+        /// @brief ROMs by name.
+        std::unordered_map<std::string, Rom> roms_;
+};
+
+void loadProgram(Memory & memory, Rom const& rom);
+void loadProgram(ExtendedMemory & memory, Rom const& rom);
+
+}  // chip8
+
+#endif  // CHIP8_ROM_HPP
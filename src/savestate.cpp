@@ -0,0 +1,208 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "savestate.hpp"
+
+namespace chip8 {
+
+namespace {
+
+/// @brief Savestate file format version.
+const uint32_t SAVESTATE_VERSION = 2;
+
+} // namespace
+
+/// @brief Save a snapshot to a savestate file.
+///
+/// @param filename File to write.
+/// @param snapshot Snapshot to save.
+/// @return True when saved, otherwise false.
+bool saveState(std::string const& filename, Snapshot const& snapshot)
+{
+    auto image = std::make_unique<SavestateImage>();
+    std::memset(image.get(), 0, sizeof(SavestateImage));
+
+    std::memcpy(image->magic, "C8SS", sizeof(image->magic));
+    image->version = SAVESTATE_VERSION;
+    image->size    = sizeof(SavestateImage);
+
+    auto const& regs = snapshot.cpu.regs;
+
+    image->pc = regs.pc;
+    image->i  = regs.i;
+    image->sp = regs.sp;
+    image->dt = regs.dt;
+    image->st = regs.st;
+    std::copy(std::begin(regs.stack), std::end(regs.stack), image->stack);
+    std::copy(std::begin(regs.vx), std::end(regs.vx), image->vx);
+
+    auto const& random = snapshot.cpu.random;
+
+    image->randomAlgorithm = static_cast<uint8_t>(random.getAlgorithm());
+    image->randomSize = static_cast<uint32_t>(random.save(image->random, SavestateImage::RANDOM_CAPACITY));
+
+    if (image->randomSize == 0)
+    {
+        std::printf("Cannot save random generator state to `%s'\n", filename.c_str());
+        return false;
+    }
+
+    std::copy(snapshot.display.begin(), snapshot.display.end(), image->display);
+
+    for (size_t page = 0; page < snapshot.memory.size(); ++page)
+    {
+        size_t offset = page * Memory::PAGE_SIZE;
+        size_t size = std::min(Memory::PAGE_SIZE, sizeof(image->memory) - offset);
+
+        std::memcpy(image->memory + offset, snapshot.memory[page]->data(), size);
+    }
+
+    std::FILE * stateFile = std::fopen(filename.c_str(), "wb");
+
+    if (stateFile == nullptr)
+    {
+        std::printf("Cannot write savestate file `%s'\n", filename.c_str());
+        return false;
+    }
+
+    bool saved = std::fwrite(image.get(), sizeof(SavestateImage), 1, stateFile) == 1;
+    saved = (std::fclose(stateFile) == 0) && saved;
+
+    if (!saved)
+    {
+        std::printf("Cannot write savestate file `%s'\n", filename.c_str());
+    }
+
+    return saved;
+}
+
+/// @brief Construct a closed savestate mapping.
+MappedSavestate::MappedSavestate()
+    : image_{ nullptr }
+{
+}
+
+/// @brief Destroy a savestate mapping.
+MappedSavestate::~MappedSavestate()
+{
+    close();
+}
+
+/// @brief Map a savestate file.
+///
+/// @param filename File to map.
+/// @return True when mapped and valid, otherwise false.
+bool MappedSavestate::open(std::string const& filename)
+{
+    close();
+
+    int descriptor = ::open(filename.c_str(), O_RDONLY);
+
+    if (descriptor < 0)
+    {
+        std::printf("Cannot read savestate file `%s'\n", filename.c_str());
+        return false;
+    }
+
+    struct stat status{};
+    void * mapping = MAP_FAILED;
+
+    if (::fstat(descriptor, &status) == 0 && status.st_size == sizeof(SavestateImage))
+    {
+        mapping = ::mmap(nullptr, sizeof(SavestateImage), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    }
+
+    ::close(descriptor);
+
+    if (mapping == MAP_FAILED)
+    {
+        std::printf("Invalid savestate file `%s'\n", filename.c_str());
+        return false;
+    }
+
+    image_ = static_cast<SavestateImage const *>(mapping);
+
+    // Version 1 only differs by the random algorithm, zero for mt19937
+    Random random{ };
+
+    if (std::memcmp(image_->magic, "C8SS", sizeof(image_->magic)) != 0 ||
+        image_->version == 0 || image_->version > SAVESTATE_VERSION ||
+        image_->size != sizeof(SavestateImage) ||
+        image_->sp > Cpu::STACK_SIZE ||
+        image_->pc >= sizeof(image_->memory) ||
+        image_->i >= sizeof(image_->memory) ||
+        image_->randomSize > SavestateImage::RANDOM_CAPACITY ||
+        !random.load(static_cast<Random::Algorithm>(image_->randomAlgorithm), image_->random, image_->randomSize))
+    {
+        std::printf("Invalid savestate file `%s'\n", filename.c_str());
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Unmap the savestate file.
+void MappedSavestate::close()
+{
+    if (image_ != nullptr)
+    {
+        ::munmap(const_cast<SavestateImage *>(image_), sizeof(SavestateImage));
+        image_ = nullptr;
+    }
+}
+
+/// @brief Restore the mapped state.
+///
+/// Memory and display are copied straight from the mapping.
+///
+/// @param cpu         CPU to restore.
+/// @param memory      Memory to restore.
+/// @param framebuffer Display to restore.
+void MappedSavestate::restore(Cpu & cpu, Memory & memory, Framebuffer & framebuffer) const
+{
+    Cpu::State state{ };
+
+    state.regs.pc = image_->pc;
+    state.regs.i  = image_->i;
+    state.regs.sp = image_->sp;
+    state.regs.dt = image_->dt;
+    state.regs.st = image_->st;
+    std::copy(std::begin(image_->stack), std::end(image_->stack), state.regs.stack);
+    std::copy(std::begin(image_->vx), std::end(image_->vx), state.regs.vx);
+    state.random.load(static_cast<Random::Algorithm>(image_->randomAlgorithm), image_->random, image_->randomSize);
+
+    cpu.setState(state);
+    memory.storeRange(0, image_->memory, std::min(memory.getSize(), sizeof(image_->memory)));
+    framebuffer.loadRows(image_->display);
+}
+
+}  // chip8
@@ -0,0 +1,113 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_SAVESTATE_HPP
+#define CHIP8_SAVESTATE_HPP
+
+#include <string>
+
+#include <core.hpp>
+#include <snapshot.hpp>
+
+namespace chip8 {
+
+/// @brief Savestate file, used in place once mapped.
+///
+/// The layout is fixed and has no implicit padding.  Fields are in host
+/// byte order, little endian on supported hosts, and unused bytes are zero,
+/// so equal states give byte identical files.
+struct SavestateImage
+{
+    /// @brief Random generator state capacity, in 32-bit words.
+    static constexpr size_t RANDOM_CAPACITY = Random::STATE_CAPACITY;
+
+    /// @brief File magic, "C8SS".
+    char     magic[4];
+    /// @brief File format version.
+    uint32_t version;
+    /// @brief File size in bytes.
+    uint32_t size;
+    /// @brief Reserved, zero.
+    uint32_t reserved;
+
+    /// @brief Program counter.
+    uint16_t pc;
+    /// @brief I register.
+    uint16_t i;
+    /// @brief Stack.
+    uint16_t stack[Cpu::STACK_SIZE];
+    /// @brief General purpose registers.
+    uint8_t  vx[Cpu::REG_COUNT];
+    /// @brief Stack pointer.
+    uint8_t  sp;
+    /// @brief Delay timer.
+    uint8_t  dt;
+    /// @brief Sound timer.
+    uint8_t  st;
+    /// @brief Random generator algorithm, zero (mt19937) before version 2.
+    uint8_t  randomAlgorithm;
+
+    /// @brief Random generator words used.
+    uint32_t randomSize;
+    /// @brief Random generator state words, unused ones are zero.
+    uint32_t random[RANDOM_CAPACITY];
+
+    /// @brief Display rows.
+    Framebuffer::Row display[Framebuffer::DISPLAY_HEIGHT];
+    /// @brief Memory image.
+    uint8_t  memory[SYSTEM_MEMORY_SIZE];
+};
+
+static_assert(sizeof(SavestateImage) == 6928, "Savestate layout is part of the savestate file format");
+
+bool saveState(std::string const& filename, Snapshot const& snapshot);
+
+/// @brief Savestate file mapped read-only.
+class MappedSavestate
+{
+    public:
+        MappedSavestate();
+        ~MappedSavestate();
+
+        MappedSavestate(MappedSavestate const&) = delete;
+        MappedSavestate & operator=(MappedSavestate const&) = delete;
+
+        bool open(std::string const& filename);
+        void close();
+
+        /// @brief Return the mapped image, null when not open.
+        SavestateImage const * image() const
+        {
+            return image_;
+        }
+
+        void restore(Cpu & cpu, Memory & memory, Framebuffer & framebuffer) const;
+
+    private:
+        /// @brief Mapped file image.
+        SavestateImage const * image_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_SAVESTATE_HPP
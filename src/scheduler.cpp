@@ -0,0 +1,158 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <limits>
+
+#include "metrics.hpp"
+#include "scheduler.hpp"
+
+namespace chip8 {
+
+/// @brief Construct a scheduler.
+///
+/// @param cpu      CPU to drive.
+/// @param cpuRate  Emulated CPU rate, in Hz.
+Scheduler::Scheduler(std::shared_ptr<Cpu> cpu, uint32_t cpuRate)
+    : cpu_{ std::move(cpu) }
+    , cpuRate_{ cpuRate }
+    , cycles_{ 0 }
+    , events_{ }
+    , stopRequested_{ false }
+    , metrics_{ nullptr }
+{
+}
+
+/// @brief Destroy a scheduler.
+Scheduler::~Scheduler()
+{
+}
+
+/// @brief Add a periodic event.
+///
+/// The event first fires one period after the current cycle.
+///
+/// @param frequency Event frequency, in Hz.
+/// @param callback  Function to call when the event fires.
+void Scheduler::addEvent(uint32_t frequency, Callback callback)
+{
+    Event event{ frequency, 0, 0, std::move(callback) };
+
+    // Count periods from cycle zero so that event timing does not depend
+    // on when the event was added.
+    event.count = cycles_ * frequency / cpuRate_;
+    event.nextCycle = computeNextCycle(event);
+
+    events_.push_back(std::move(event));
+}
+
+/// @brief Measure the CPU runs.
+///
+/// Each run between events is timed and its instructions counted.
+///
+/// @param metrics Metrics to update, none to stop measuring.
+void Scheduler::setMetrics(Metrics * metrics)
+{
+    metrics_ = metrics;
+}
+
+/// @brief Run the CPU, firing events when they are due.
+///
+/// The CPU runs whole spans between events.  Running stops after the
+/// given cycles or once an event requested a stop.
+///
+/// @param cycles Count of cycles to run.
+/// @return Count of cycles ran.
+uint64_t Scheduler::run(uint64_t cycles)
+{
+    const uint64_t MAX_SPAN = std::numeric_limits<uint32_t>::max();
+
+    uint64_t startCycle = cycles_;
+    // Saturate, so the largest count runs until stopped
+    uint64_t stopCycle = (cycles > std::numeric_limits<uint64_t>::max() - cycles_)
+                         ? std::numeric_limits<uint64_t>::max()
+                         : cycles_ + cycles;
+
+    stopRequested_ = false;
+
+    while (cycles_ < stopCycle && !stopRequested_)
+    {
+        uint64_t spanEnd = std::min(findNextEventCycle(), stopCycle);
+        uint64_t span = std::min(spanEnd - cycles_, MAX_SPAN);
+
+        if (metrics_ != nullptr)
+        {
+            ScopedTimer timer{ &metrics_->cpuRun };
+            uint32_t ran = cpu_->run(static_cast<uint32_t>(span));
+
+            metrics_->instructions.add(ran);
+            cycles_ += ran;
+        }
+        else
+        {
+            cycles_ += cpu_->run(static_cast<uint32_t>(span));
+        }
+
+        fireEvents();
+    }
+
+    return cycles_ - startCycle;
+}
+
+/// @brief Compute the cycle at which an event fires next.
+///
+/// That is the first cycle at or after the exact event time.
+uint64_t Scheduler::computeNextCycle(Event const& event) const
+{
+    return ((event.count + 1) * cpuRate_ + event.frequency - 1) / event.frequency;
+}
+
+/// @brief Find the cycle of the earliest pending event.
+uint64_t Scheduler::findNextEventCycle() const
+{
+    uint64_t nextCycle = std::numeric_limits<uint64_t>::max();
+
+    for (auto const& event : events_)
+    {
+        nextCycle = std::min(nextCycle, event.nextCycle);
+    }
+
+    return nextCycle;
+}
+
+/// @brief Fire the events due at the current cycle.
+///
+/// An event faster than the CPU may fire more than once per cycle.
+void Scheduler::fireEvents()
+{
+    for (auto & event : events_)
+    {
+        while (event.nextCycle <= cycles_)
+        {
+            ++event.count;
+            event.nextCycle = computeNextCycle(event);
+            event.callback();
+        }
+    }
+}
+
+}  // chip8
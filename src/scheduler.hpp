@@ -0,0 +1,100 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_SCHEDULER_HPP
+#define CHIP8_SCHEDULER_HPP
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <core.hpp>
+#include <cpu.hpp>
+
+namespace chip8 {
+
+struct Metrics;
+
+/// @brief Emulated clock driving the CPU and periodic events.
+///
+/// The master clock counts CPU cycles.  An event of frequency `hz` fires
+/// for the n-th time at cycle `n * rate / hz`, rounded up, so event timing
+/// only depends on the emulated cycle count and never on the host clock.
+/// Events due on the same cycle fire in the order they were added.
+class Scheduler
+{
+    public:
+        /// @brief Event callback.
+        using Callback = std::function<void()>;
+
+        Scheduler(std::shared_ptr<Cpu> cpu, uint32_t cpuRate);
+        ~Scheduler();
+
+        void addEvent(uint32_t frequency, Callback callback);
+        void setMetrics(Metrics * metrics);
+
+        uint64_t run(uint64_t cycles);
+        void     stop() { stopRequested_ = true; }
+
+        /// @brief Return whether a stop was requested.
+        bool isStopped() const { return stopRequested_; }
+        /// @brief Return the emulated CPU rate.
+        uint32_t getCpuRate() const { return cpuRate_; }
+        /// @brief Return the emulated cycles elapsed.
+        uint64_t getCycles() const { return cycles_; }
+
+    private:
+        /// @brief Periodic event.
+        struct Event
+        {
+            /// @brief Event frequency.
+            uint32_t frequency;
+            /// @brief Times the event fired.
+            uint64_t count;
+            /// @brief Cycle at which the event fires next.
+            uint64_t nextCycle;
+            /// @brief Event callback.
+            Callback callback;
+        };
+
+        uint64_t computeNextCycle(Event const& event) const;
+        uint64_t findNextEventCycle() const;
+        void     fireEvents();
+
+        /// @brief Driven CPU.
+        std::shared_ptr<Cpu> cpu_;
+        /// @brief Emulated CPU rate.
+        uint32_t cpuRate_;
+        /// @brief Emulated cycles elapsed.
+        uint64_t cycles_;
+        /// @brief Periodic events.
+        std::vector<Event> events_;
+        /// @brief An event requested to stop running.
+        bool stopRequested_;
+        /// @brief Metrics of the CPU runs, none when not measured.
+        Metrics * metrics_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_SCHEDULER_HPP
@@ -0,0 +1,119 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <array>
+#include <SDL2/SDL.h>
+
+#include "sdl_input.hpp"
+
+namespace chip8 {
+
+namespace {
+
+/// @brief Unmapped key code.
+const int8_t NO_KEY = -1;
+
+/// @brief Key codes mapped, SDL key codes of printable keys are ASCII.
+const size_t KEYMAP_SIZE = 128;
+
+/// @brief Build the key mapping, indexed with the SDL key code.
+constexpr std::array<int8_t, KEYMAP_SIZE> makeKeymap()
+{
+    std::array<int8_t, KEYMAP_SIZE> keymap{ };
+
+    for (auto & key : keymap)
+    {
+        key = NO_KEY;
+    }
+
+    for (int8_t key = 0; key < 10; ++key)
+    {
+        keymap[SDLK_0 + key] = key;
+    }
+
+    for (int8_t key = 10; key < 16; ++key)
+    {
+        keymap[SDLK_a + key - 10] = key;
+    }
+
+    return keymap;
+}
+
+/// @brief Key mapping
+constexpr std::array<int8_t, KEYMAP_SIZE> KEYMAP = makeKeymap();
+
+/// @brief Map an SDL key code.
+///
+/// @return CHIP-8 key, or NO_KEY.
+int8_t mapKey(SDL_Keycode code)
+{
+    return (code >= 0 && static_cast<size_t>(code) < KEYMAP_SIZE) ? KEYMAP[code] : NO_KEY;
+}
+
+} // namespace
+
+/// @brief Construct an SDL input producer.
+///
+/// @param queue Queue to fill.
+SdlInput::SdlInput(std::shared_ptr<InputQueue> queue)
+    : queue_{ std::move(queue) }
+{
+}
+
+/// @brief Destroy an SDL input producer.
+SdlInput::~SdlInput()
+{
+}
+
+/// @brief Pump SDL events into the queue.
+///
+/// Events are dropped while the queue is full, the consumer applies them
+/// at the same rate they are pumped so it only fills up on a stall.
+///
+/// @param cycle Emulated cycle to stamp the events with.
+void SdlInput::poll(uint64_t cycle)
+{
+    SDL_Event event;
+
+    while (SDL_PollEvent(&event) != 0)
+    {
+        if (event.type == SDL_QUIT)
+        {
+            queue_->push(InputEvent{ cycle, InputEvent::Type::QUIT, 0 });
+        }
+
+        if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+        {
+            int8_t key = mapKey(event.key.keysym.sym);
+
+            if (key != NO_KEY)
+            {
+                auto type = (event.type == SDL_KEYDOWN) ? InputEvent::Type::KEY_DOWN : InputEvent::Type::KEY_UP;
+
+                queue_->push(InputEvent{ cycle, type, static_cast<uint8_t>(key) });
+            }
+        }
+    }
+}
+
+}  // chip8
@@ -0,0 +1,54 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_SDLINPUT_HPP
+#define CHIP8_SDLINPUT_HPP
+
+#include <memory>
+
+#include <core.hpp>
+#include <input_queue.hpp>
+
+namespace chip8 {
+
+/// @brief Input producer translating SDL events to input events.
+///
+/// SDL events must be pumped by the thread owning the window, so the
+/// pump runs on the presentation thread and the queue carries the events
+/// to the emulation thread.
+class SdlInput
+{
+    public:
+        SdlInput(std::shared_ptr<InputQueue> queue);
+        ~SdlInput();
+
+        void poll(uint64_t cycle);
+
+    private:
+        /// @brief Queue filled with the events.
+        std::shared_ptr<InputQueue> queue_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_SDLINPUT_HPP
@@ -0,0 +1,60 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include "snapshot.hpp"
+
+namespace chip8 {
+
+/// @brief Capture a machine state.
+///
+/// @param cpu         CPU to capture.
+/// @param memory      Memory to capture, its written pages are copied.
+/// @param framebuffer Display to capture.
+/// @return Snapshot.
+Snapshot takeSnapshot(Cpu const& cpu, Memory & memory, Framebuffer const& framebuffer)
+{
+    Snapshot snapshot{ cpu.getState(), memory.snapshot(), { } };
+
+    std::copy_n(framebuffer.rows(), Framebuffer::DISPLAY_HEIGHT, snapshot.display.begin());
+
+    return snapshot;
+}
+
+/// @brief Restore a machine state.
+///
+/// The memory must be the one the snapshot was taken from, or one of the
+/// same size.
+///
+/// @param snapshot    Snapshot to restore.
+/// @param cpu         CPU to restore.
+/// @param memory      Memory to restore, only changed pages are copied.
+/// @param framebuffer Display to restore, changed rows become dirty.
+void restoreSnapshot(Snapshot const& snapshot, Cpu & cpu, Memory & memory, Framebuffer & framebuffer)
+{
+    cpu.setState(snapshot.cpu);
+    memory.restore(snapshot.memory);
+    framebuffer.loadRows(snapshot.display.data());
+}
+
+}  // chip8
@@ -0,0 +1,56 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_SNAPSHOT_HPP
+#define CHIP8_SNAPSHOT_HPP
+
+#include <array>
+
+#include <core.hpp>
+#include <cpu.hpp>
+#include <framebuffer.hpp>
+#include <memory.hpp>
+
+namespace chip8 {
+
+/// @brief Machine state captured at an instruction boundary.
+///
+/// Memory is held as copy-on-write pages shared with the other snapshots
+/// of the same memory, so a snapshot costs the CPU state, the display and
+/// the pages written since the previous one.
+struct Snapshot
+{
+    /// @brief CPU registers, stack, timers and random generator.
+    Cpu::State cpu;
+    /// @brief Memory pages.
+    Memory::PageTable memory;
+    /// @brief Display rows.
+    std::array<Framebuffer::Row, Framebuffer::DISPLAY_HEIGHT> display;
+};
+
+Snapshot takeSnapshot(Cpu const& cpu, Memory & memory, Framebuffer const& framebuffer);
+void restoreSnapshot(Snapshot const& snapshot, Cpu & cpu, Memory & memory, Framebuffer & framebuffer);
+
+}  // chip8
+
+#endif  // CHIP8_SNAPSHOT_HPP
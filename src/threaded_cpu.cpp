@@ -0,0 +1,722 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <algorithm>
+#include <headless.hpp>
+#include "threaded_cpu.hpp"
+
+namespace chip8 {
+
+/// @brief Construct a block cache.
+///
+/// @param memory  Reference to memory to observe.
+/// @param decoder Reference to decoder providing the instructions.
+template<typename DEVICES>
+ThreadedCore<DEVICES>::BlockCache::BlockCache(Memory & memory, OpcodeDecoder & decoder)
+    : memory_{ memory }
+    , decoder_{ decoder }
+    , blocks_{ }
+    , entries_{ }
+    , instructions_{ }
+    , addresses_{ }
+    , built_{ }
+    , coverage_{ }
+{
+    memory_.attach(this);
+}
+
+/// @brief Destroy a block cache.
+template<typename DEVICES>
+ThreadedCore<DEVICES>::BlockCache::~BlockCache()
+{
+    memory_.detach(this);
+}
+
+/// @brief Lookup the block starting at an address, building it if needed.
+///
+/// @param address Block start address.
+/// @return Block, or null when the instruction wraps around the end of
+///         memory or its address was not visited enough yet.
+template<typename DEVICES>
+typename ThreadedCore<DEVICES>::BlockCache::Block const * ThreadedCore<DEVICES>::BlockCache::lookup(uint16_t address)
+{
+    if (address >= BLOCK_COUNT - 1)
+    {
+        return nullptr;
+    }
+
+    auto & block = blocks_[address];
+
+    if (block.length == 0)
+    {
+        if (++block.visits < BUILD_VISITS)
+        {
+            return nullptr;
+        }
+
+        block.visits = 0;
+        build(address, block);
+    }
+
+    return &block;
+}
+
+/// @brief Invalidate blocks overlapping a memory write.
+///
+/// Writes to bytes no block covers, such as data, return at once.
+/// Otherwise the built blocks are checked, a trace covering scattered
+/// bytes.
+///
+/// @param address Address of the first byte written.
+/// @param size    Count of bytes written.
+template<typename DEVICES>
+void ThreadedCore<DEVICES>::BlockCache::onMemoryWrite(uint16_t address, size_t size)
+{
+    size_t first = address;
+    size_t last = std::min<size_t>(address + size - 1, BLOCK_COUNT - 1);
+
+    auto coverageStart = coverage_.begin() + first;
+    auto coverageEnd = coverage_.begin() + last + 1;
+
+    if (std::all_of(coverageStart, coverageEnd, [](uint16_t count) { return count == 0; }))
+    {
+        return;
+    }
+
+    for (size_t built = 0; built < built_.size();)
+    {
+        uint16_t start = built_[built];
+        auto & block = blocks_[start];
+
+        if (overlaps(start, block, first, last))
+        {
+            cover(start, block, -1);
+            block.length = 0;
+
+            built_[built] = built_.back();
+            built_.pop_back();
+        }
+        else
+        {
+            ++built;
+        }
+    }
+}
+
+/// @brief Count a block in the coverage of its bytes.
+///
+/// An instruction covers two bytes from its address per cycle it runs, the
+/// next instruction of the trace starts where it goes on.
+///
+/// @param address Block start address.
+/// @param block   Built block.
+/// @param count   One when built, minus one when invalidated.
+template<typename DEVICES>
+void ThreadedCore<DEVICES>::BlockCache::cover(uint16_t address, Block const& block, int16_t count)
+{
+    uint8_t cycles = 0;
+    auto blockEntries = getEntries(block);
+
+    for (auto entry = blockEntries; entry != blockEntries + block.count; ++entry)
+    {
+        size_t end = address + (entry->cycles - cycles) * PC_INCR;
+
+        for (size_t covered = address; covered < end; ++covered)
+        {
+            coverage_[covered] += count;
+        }
+
+        cycles = entry->cycles;
+        address = entry->next;
+    }
+}
+
+/// @brief Check if a block covers a byte of a range.
+///
+/// @param address Block start address.
+/// @param block   Built block.
+/// @param first   First byte of the range.
+/// @param last    Last byte of the range.
+/// @return True when the block covers a byte of the range.
+template<typename DEVICES>
+bool ThreadedCore<DEVICES>::BlockCache::overlaps(uint16_t address, Block const& block, size_t first, size_t last) const
+{
+    uint8_t cycles = 0;
+    auto blockEntries = getEntries(block);
+
+    for (auto entry = blockEntries; entry != blockEntries + block.count; ++entry)
+    {
+        size_t end = address + (entry->cycles - cycles) * PC_INCR;
+
+        if (address <= last && end > first)
+        {
+            return true;
+        }
+
+        cycles = entry->cycles;
+        address = entry->next;
+    }
+
+    return false;
+}
+
+/// @brief Check if an instruction ends a block.
+///
+/// @param opcode Opcode of the instruction.
+/// @return True when the instruction goes to an address only known when it
+///         runs or may write code, otherwise false.
+template<typename DEVICES>
+bool ThreadedCore<DEVICES>::BlockCache::isBlockEnd(opcode::Opcode opcode)
+{
+    switch (opcode::decodeInstruction(opcode))
+    {
+        case opcode::OPCODE_00EE:
+        case opcode::OPCODE_BNNN:
+        case opcode::OPCODE_FX0A:
+        case opcode::OPCODE_FX33:
+        case opcode::OPCODE_FX55:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief Check if an instruction jumps, or calls, to its address.
+///
+/// @param opcode Opcode of the instruction.
+/// @return True for 1NNN and 2NNN, otherwise false.
+template<typename DEVICES>
+bool ThreadedCore<DEVICES>::BlockCache::isJump(opcode::Opcode opcode)
+{
+    switch (opcode::decodeInstruction(opcode))
+    {
+        case opcode::OPCODE_1NNN:
+        case opcode::OPCODE_2NNN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief Check if an instruction may skip the next one, leaving the block.
+///
+/// @param opcode Opcode of the instruction.
+/// @return True for conditional skips, otherwise false.
+template<typename DEVICES>
+bool ThreadedCore<DEVICES>::BlockCache::isSkip(opcode::Opcode opcode)
+{
+    switch (opcode::decodeInstruction(opcode))
+    {
+        case opcode::OPCODE_3XKK:
+        case opcode::OPCODE_4XKK:
+        case opcode::OPCODE_5XY0:
+        case opcode::OPCODE_9XY0:
+        case opcode::OPCODE_EX9E:
+        case opcode::OPCODE_EXA1:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief Check if an instruction reads VF.
+///
+/// @param instruction Decoded instruction.
+/// @return True when VF is an operand, or for unknown instructions.
+template<typename DEVICES>
+bool ThreadedCore<DEVICES>::BlockCache::readsFlag(Instruction const& instruction)
+{
+    bool x = (instruction.x == 0xF);
+    bool y = (instruction.y == 0xF);
+
+    switch (opcode::decodeInstruction(instruction.opcode))
+    {
+        case opcode::OPCODE_00E0:
+        case opcode::OPCODE_1NNN:
+        case opcode::OPCODE_2NNN:
+        case opcode::OPCODE_6XKK:
+        case opcode::OPCODE_ANNN:
+        case opcode::OPCODE_BNNN:
+        case opcode::OPCODE_CXKK:
+        case opcode::OPCODE_FX07:
+        case opcode::OPCODE_FX0A:
+        case opcode::OPCODE_FX65:
+            return false;
+        case opcode::OPCODE_3XKK:
+        case opcode::OPCODE_4XKK:
+        case opcode::OPCODE_7XKK:
+        case opcode::OPCODE_EX9E:
+        case opcode::OPCODE_EXA1:
+        case opcode::OPCODE_FX15:
+        case opcode::OPCODE_FX18:
+        case opcode::OPCODE_FX1E:
+        case opcode::OPCODE_FX29:
+        case opcode::OPCODE_FX33:
+        case opcode::OPCODE_FX55:
+            return x;
+        case opcode::OPCODE_8XY0:
+        case opcode::OPCODE_8XY6:
+        case opcode::OPCODE_8XYE:
+            return y;
+        case opcode::OPCODE_5XY0:
+        case opcode::OPCODE_8XY1:
+        case opcode::OPCODE_8XY2:
+        case opcode::OPCODE_8XY3:
+        case opcode::OPCODE_8XY4:
+        case opcode::OPCODE_8XY5:
+        case opcode::OPCODE_8XY7:
+        case opcode::OPCODE_9XY0:
+        case opcode::OPCODE_DXYN:
+            return x || y;
+        default:
+            return true;
+    }
+}
+
+/// @brief Check if an instruction overwrites VF whatever its value.
+///
+/// DXYN only sets VF on a collision, so it does not overwrite it.
+///
+/// @param instruction Decoded instruction.
+/// @return True when VF is always written.
+template<typename DEVICES>
+bool ThreadedCore<DEVICES>::BlockCache::writesFlag(Instruction const& instruction)
+{
+    bool x = (instruction.x == 0xF);
+
+    switch (opcode::decodeInstruction(instruction.opcode))
+    {
+        case opcode::OPCODE_8XY4:
+        case opcode::OPCODE_8XY5:
+        case opcode::OPCODE_8XY6:
+        case opcode::OPCODE_8XY7:
+        case opcode::OPCODE_8XYE:
+            return true;
+        case opcode::OPCODE_6XKK:
+        case opcode::OPCODE_7XKK:
+        case opcode::OPCODE_8XY0:
+        case opcode::OPCODE_8XY1:
+        case opcode::OPCODE_8XY2:
+        case opcode::OPCODE_8XY3:
+        case opcode::OPCODE_CXKK:
+        case opcode::OPCODE_FX07:
+        case opcode::OPCODE_FX65:
+            return x;
+        default:
+            return false;
+    }
+}
+
+/// @brief Check if an instruction skips computing VF.
+///
+/// @param instruction Block instruction.
+/// @return True when dead flag elimination replaced its handler.
+template<typename DEVICES>
+bool ThreadedCore<DEVICES>::BlockCache::skipsFlag(Instruction const& instruction)
+{
+    return instruction.func == &ThreadedCore::opcodeAddRegisterWithoutFlag ||
+           instruction.func == &ThreadedCore::opcodeSubRegisterWithoutFlag ||
+           instruction.func == &ThreadedCore::opcodeShrRegisterWithoutFlag ||
+           instruction.func == &ThreadedCore::opcodeSubnRegisterWithoutFlag ||
+           instruction.func == &ThreadedCore::opcodeShlRegisterWithoutFlag;
+}
+
+/// @brief Skip computing VF in ALU instructions where it is never read.
+///
+/// VF is live at the end of a block and at the skips leaving it.  Walking
+/// the block backward, the VF written by an ALU instruction is dead when a
+/// later instruction of the block overwrites VF before any reads it, its
+/// handler is then replaced by one that only writes Vx.
+///
+/// @param instructions Instructions of a block.
+template<typename DEVICES>
+void ThreadedCore<DEVICES>::BlockCache::eliminateDeadFlags(std::vector<Instruction> & instructions)
+{
+    bool live = true;
+
+    for (size_t index = instructions.size(); index-- > 0;)
+    {
+        auto & instruction = instructions[index];
+        bool reads = readsFlag(instruction);
+        bool writes = writesFlag(instruction);
+
+        // The handlers may write VF before reading Vy
+        if (!live && instruction.x != 0xF && instruction.y != 0xF)
+        {
+            if (instruction.func == &ThreadedCore::opcodeAddRegister)
+            {
+                instruction.func = &ThreadedCore::opcodeAddRegisterWithoutFlag;
+            }
+            else if (instruction.func == &ThreadedCore::opcodeSubRegister)
+            {
+                instruction.func = &ThreadedCore::opcodeSubRegisterWithoutFlag;
+            }
+            else if (instruction.func == &ThreadedCore::opcodeShrRegister)
+            {
+                instruction.func = &ThreadedCore::opcodeShrRegisterWithoutFlag;
+            }
+            else if (instruction.func == &ThreadedCore::opcodeSubnRegister)
+            {
+                instruction.func = &ThreadedCore::opcodeSubnRegisterWithoutFlag;
+            }
+            else if (instruction.func == &ThreadedCore::opcodeShlRegister)
+            {
+                instruction.func = &ThreadedCore::opcodeShlRegisterWithoutFlag;
+            }
+        }
+
+        live = reads || isSkip(instruction.opcode) || (live && !writes);
+    }
+}
+
+/// @brief Build the block starting at an address.
+///
+/// The trace follows jumps and calls to addresses not already in it, a
+/// jump back into the trace closes a loop and ends the block.  It stops
+/// before an instruction wrapping around the end of memory.
+///
+/// @param address Block start address.
+/// @param block   Block to build.
+template<typename DEVICES>
+void ThreadedCore<DEVICES>::BlockCache::build(uint16_t address, Block & block)
+{
+    if (entries_.size() + MAX_BLOCK_LENGTH > POOL_CAPACITY)
+    {
+        flush();
+    }
+
+    instructions_.clear();
+    addresses_.clear();
+    block.length = 0;
+
+    uint16_t next = address;
+
+    while (block.length < MAX_BLOCK_LENGTH && next < BLOCK_COUNT - 1)
+    {
+        // Odd addresses decode in a scratch slot of the decoder
+        auto const& instruction = decoder_.fetch(next);
+
+        instructions_.push_back(instruction);
+        addresses_.push_back(next);
+        ++block.length;
+
+        if (isBlockEnd(instruction.opcode))
+        {
+            break;
+        }
+
+        if (isJump(instruction.opcode))
+        {
+            next = instruction.nnn;
+
+            if (std::find(addresses_.begin(), addresses_.end(), next) != addresses_.end())
+            {
+                break;
+            }
+        }
+        else
+        {
+            next += PC_INCR;
+        }
+    }
+
+    block.idle = ((addresses_.back() & 0x1) == 0 && isIdleLoop(addresses_.back(), instructions_.back()));
+
+    eliminateDeadFlags(instructions_);
+    fuse(block);
+
+    cover(address, block, 1);
+    built_.push_back(address);
+}
+
+/// @brief Drop every block, to reuse the entry pool from its start.
+template<typename DEVICES>
+void ThreadedCore<DEVICES>::BlockCache::flush()
+{
+    for (auto start : built_)
+    {
+        blocks_[start].length = 0;
+    }
+
+    built_.clear();
+    entries_.clear();
+    coverage_.fill(0);
+}
+
+/// @brief Check if a jump closes a loop the CPU skips as idle.
+///
+/// The loop shapes are the ones of CpuCore::fastForwardIdleLoop(), whether
+/// the loop is idle is only known when it runs.
+///
+/// @param address Address of the jump.
+/// @param jump    Decoded jump.
+/// @return True when the jump goes back to itself, to LD Vx, DT two
+///         instructions before, or to SKP/SKNP Vx just before.
+template<typename DEVICES>
+bool ThreadedCore<DEVICES>::BlockCache::isIdleLoop(uint16_t address, Instruction const& jump)
+{
+    if (jump.func != &ThreadedCore::opcodeJump)
+    {
+        return false;
+    }
+
+    uint16_t head = jump.nnn;
+
+    if (head == address)
+    {
+        return true;
+    }
+
+    auto const& first = decoder_.fetch(head);
+
+    return (first.func == &ThreadedCore::opcodeLoadRegisterFromDelayTimer && address == head + 2 * PC_INCR) ||
+           ((first.func == &ThreadedCore::opcodeSkipNextIfKeyEqualsRegister ||
+             first.func == &ThreadedCore::opcodeSkipNextIfKeyNotEqualsRegister) && address == head + PC_INCR);
+}
+
+/// @brief Fuse common opcode sequences of a block into superinstructions.
+///
+/// A block ending with 7XKK 3XKK 1NNN runs it as one iteration of a
+/// counted loop, and a block ending with FX33 before an FX65 takes the load
+/// in.  The block still covers one cycle per instruction.
+///
+/// Between an instruction skipping VF and the one overwriting it, VF does
+/// not hold its value, so runs may not stop there.
+///
+/// @param block Block to optimize, its entries are filled.
+template<typename DEVICES>
+void ThreadedCore<DEVICES>::BlockCache::fuse(Block & block)
+{
+    auto & instructions = instructions_;
+    size_t count = instructions.size();
+    uint16_t nextAddress = addresses_.back() + PC_INCR;
+
+    if (count >= 3 &&
+        instructions[count - 3].func == &ThreadedCore::opcodeAddNumber &&
+        instructions[count - 2].func == &ThreadedCore::opcodeSkipNextIfEquals &&
+        instructions[count - 1].func == &ThreadedCore::opcodeJump &&
+        instructions[count - 3].x == instructions[count - 2].x)
+    {
+        auto & loop = instructions[count - 3];
+
+        loop.func = &ThreadedCore::opcodeCountedLoop;
+        loop.y = instructions[count - 2].kk;
+        loop.nnn = instructions[count - 1].nnn;
+
+        instructions.resize(count - 2);
+    }
+    else if (block.length < MAX_BLOCK_LENGTH && nextAddress < BLOCK_COUNT - 1 &&
+             instructions[count - 1].func == &ThreadedCore::opcodeStoreBinaryCodedDecimal)
+    {
+        auto const& next = decoder_.fetch(nextAddress);
+
+        if (next.func == &ThreadedCore::opcodeLoadRegistersWithAddress)
+        {
+            auto & bcd = instructions[count - 1];
+
+            bcd.func = &ThreadedCore::opcodeStoreAndLoadBinaryCodedDecimal;
+            bcd.y = next.x;
+
+            addresses_.push_back(nextAddress);
+            ++block.length;
+        }
+    }
+
+    block.first = static_cast<uint16_t>(entries_.size());
+
+    uint8_t cycles = 0;
+    bool pending = false;
+
+    for (size_t index = 0; index < instructions.size(); ++index)
+    {
+        auto instruction = instructions[index];
+
+        // Blocks call every handler, unknown opcodes do nothing
+        if (instruction.func == nullptr)
+        {
+            instruction.func = &ThreadedCore::opcodeNoOperation;
+        }
+
+        pending = skipsFlag(instruction) || (pending && !writesFlag(instruction));
+        ++cycles;
+
+        // The last instruction covers the rest of the block, a counted loop
+        // or a load taken in
+        if (index + 1 < instructions.size())
+        {
+            entries_.push_back({ instruction, addresses_[index + 1], cycles, !pending });
+        }
+        else
+        {
+            entries_.push_back({ instruction, static_cast<uint16_t>(addresses_.back() + PC_INCR), block.length, !pending });
+        }
+    }
+
+    block.count = static_cast<uint8_t>(entries_.size() - block.first);
+}
+
+/// @brief Construct a threaded CPU instance.
+///
+/// @param memory   Reference to memory.
+/// @param keyboard Reference to keyboard.
+/// @param gpu      Reference to GPU display.
+template<typename DEVICES>
+ThreadedCore<DEVICES>::ThreadedCore(std::shared_ptr<Memory> memory,
+                                    std::shared_ptr<KeyboardType> keyboard,
+                                    std::shared_ptr<GpuType> gpu)
+    : Base{ std::move(memory), std::move(keyboard), std::move(gpu) }
+    , blockCache_{ *memory_, opcodeDecoder_ }
+    , idleUpdates_{ 0 }
+{
+}
+
+/// @brief Destroy a threaded CPU instance.
+template<typename DEVICES>
+ThreadedCore<DEVICES>::~ThreadedCore()
+{
+}
+
+/// @brief Run cpu cycles.
+///
+/// Blocks run as far as they fit in the remaining cycles, so the cycle
+/// count is exact.  When not even the first instruction of a block fits,
+/// or the program counter cannot start one, a single update runs.
+///
+/// Idle loops run with updates too: parked on FX0A the CPU only polls the
+/// keys, and once an idle loop is skipped the next run starts within it.
+/// Its few instructions then land on the loop jump without a block lookup,
+/// until a jump runs without skipping.
+///
+/// @param cycles Count of cycles to run.
+/// @return Count of cycles ran.
+template<typename DEVICES>
+uint32_t ThreadedCore<DEVICES>::run(uint32_t cycles)
+{
+    uint32_t executed = 0;
+
+    while (executed < cycles)
+    {
+        bool idle = waitingForKey_ || idleUpdates_ != 0;
+        auto block = !idle ? blockCache_.lookup(regs_.pc) : nullptr;
+        uint32_t ran = (block != nullptr) ? execute(*block, cycles - executed) : 0;
+
+        if (ran != 0)
+        {
+            executed += ran;
+
+            // Only blocks closing an idle loop may skip one
+            if (block->idle)
+            {
+                uint32_t skipped = skipIdleLoop(cycles - executed);
+
+                executed += skipped;
+                idleUpdates_ = (skipped != 0) ? 2 * IDLE_LOOP_LENGTH : 0;
+            }
+
+            continue;
+        }
+
+        step();
+        ++executed;
+
+        uint32_t skipped = skipIdleLoop(cycles - executed);
+        executed += skipped;
+
+        if (skipped != 0)
+        {
+            idleUpdates_ = 2 * IDLE_LOOP_LENGTH;
+        }
+        else if (idleUpdates_ != 0)
+        {
+            idleUpdates_ = (instruction_->func != &ThreadedCore::opcodeJump) ? idleUpdates_ - 1 : 0;
+        }
+    }
+
+    return executed;
+}
+
+/// @brief Execute a block, up to a count of cycles.
+///
+/// Instructions run one after the other while they go on to the next one of
+/// the block.  A run shorter than the block stops after the last instruction
+/// fitting in the cycles and leaving VF exact.  The current instruction is
+/// left on the decoded last instruction when the whole block ran, or the
+/// one a superinstruction ran after it, so idle loops are recognized as
+/// after update().
+///
+/// @param block  Block to execute.
+/// @param cycles Count of cycles to run at most.
+/// @return Count of cycles ran, zero when not even the first instruction fits.
+template<typename DEVICES>
+inline uint32_t ThreadedCore<DEVICES>::execute(typename BlockCache::Block const& block, uint32_t cycles)
+{
+    auto entry = blockCache_.getEntries(block);
+    auto last = entry + block.count - 1;
+    auto end = entry + block.count;
+
+    if (cycles < block.length)
+    {
+        end = entry;
+
+        for (auto fit = entry; fit->cycles <= cycles; ++fit)
+        {
+            if (fit->exact)
+            {
+                end = fit + 1;
+            }
+        }
+
+        if (end == entry)
+        {
+            return 0;
+        }
+    }
+
+    // Handlers read the operands from the current instruction, the opcode
+    // is only looked at between runs
+    typename BlockCache::Entry const * current;
+
+    do
+    {
+        current = entry++;
+        instruction_ = &current->instruction;
+        regs_.pc += PC_INCR;
+
+        (this->*(current->instruction.func))();
+    }
+    while (regs_.pc == current->next && entry != end);
+
+    if (instruction_ == &last->instruction && (last->next & 0x1) == 0)
+    {
+        instruction_ = &opcodeDecoder_.fetch(last->next - PC_INCR);
+    }
+
+    opcode_ = instruction_->opcode;
+
+    return current->cycles;
+}
+
+template class ThreadedCore<VirtualDevices>;
+template class ThreadedCore<HeadlessDevices>;
+
+}  // chip8
@@ -0,0 +1,192 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_THREADEDCPU_HPP
+#define CHIP8_THREADEDCPU_HPP
+
+#include <array>
+#include <vector>
+#include <cpu.hpp>
+
+namespace chip8 {
+
+/// @brief Represent a CHIP-8 CPU running basic blocks of threaded code.
+///
+/// A block is a trace of pre-decoded instructions, following jumps and
+/// calls, until a jump back into the block, a return, or a store that may
+/// rewrite code.  Blocks run their handlers back to back without going
+/// through update(), leaving at the first instruction that does not go on
+/// to the next one of the trace, such as a skip taken.  A memory write to
+/// code invalidates the blocks covering it.
+///
+/// Blocks are optimized when built: ALU instructions whose VF is written
+/// again before anything reads it skip computing it, and common opcode
+/// sequences are fused into superinstructions run by a single handler.
+///
+/// @tparam DEVICES Device policy, `VirtualDevices` or `HeadlessDevices`.
+template<typename DEVICES>
+class ThreadedCore : public CpuCore<NoTrace, DEVICES>
+{
+    using Base = CpuCore<NoTrace, DEVICES>;
+
+    public:
+        using typename Base::GpuType;
+        using typename Base::KeyboardType;
+
+        ThreadedCore(std::shared_ptr<Memory> memory,
+                     std::shared_ptr<KeyboardType> keyboard,
+                     std::shared_ptr<GpuType> gpu);
+        ~ThreadedCore();
+
+        uint32_t run(uint32_t cycles) override;
+
+    private:
+        using typename Base::Instruction;
+        using typename Base::OpcodeDecoder;
+        using Base::PC_INCR;
+        using Base::memory_;
+        using Base::regs_;
+        using Base::opcodeDecoder_;
+        using Base::instruction_;
+        using Base::opcode_;
+        using Base::waitingForKey_;
+        using Base::step;
+        using Base::skipIdleLoop;
+
+        /// @brief Block cache, one block per start address.
+        class BlockCache : public Memory::WriteObserver
+        {
+            public:
+                /// @brief Maximum instruction count in a block.
+                static constexpr uint8_t MAX_BLOCK_LENGTH = 8;
+                /// @brief Count of visits to an address before its block is
+                ///        built, code running once is only updated.
+                static constexpr uint8_t BUILD_VISITS = 4;
+                /// @brief Count of entries of all the blocks, a full pool is
+                ///        flushed.
+                static constexpr size_t POOL_CAPACITY = 4096;
+
+                /// @brief Block instruction.
+                struct Entry
+                {
+                    /// @brief Optimized instruction, or superinstruction.
+                    Instruction instruction;
+                    /// @brief Program counter of the next instruction of the
+                    ///        trace.
+                    uint16_t next;
+                    /// @brief Count of cycles covered up to it, included.
+                    uint8_t cycles;
+                    /// @brief True when VF holds its value once it ran, so a
+                    ///        run may stop after it.
+                    bool exact;
+                };
+
+                /// @brief Cached block.
+                struct Block
+                {
+                    /// @brief Index of the first entry in the pool.
+                    uint16_t first;
+                    /// @brief Count of entries, superinstructions fused.
+                    uint8_t count;
+                    /// @brief Count of instructions, or cycles, covered by the
+                    ///        block, zero when not built.
+                    uint8_t length;
+                    /// @brief Count of visits while not built.
+                    uint8_t visits;
+                    /// @brief True when the block ends with a jump closing an
+                    ///        idle loop, so runs check for one after it.
+                    bool idle;
+                };
+
+                BlockCache() = delete;
+                BlockCache(Memory & memory, OpcodeDecoder & decoder);
+                ~BlockCache();
+
+                Block const * lookup(uint16_t address);
+
+                /// @brief Return the first entry of a block.
+                Entry const * getEntries(Block const& block) const { return entries_.data() + block.first; }
+
+                void onMemoryWrite(uint16_t address, size_t size) override;
+
+            private:
+                /// @brief Cache block count, code may start at odd addresses.
+                static constexpr size_t BLOCK_COUNT = SYSTEM_MEMORY_SIZE;
+
+                static bool isBlockEnd(opcode::Opcode opcode);
+                static bool isJump(opcode::Opcode opcode);
+                static bool isSkip(opcode::Opcode opcode);
+                static bool readsFlag(Instruction const& instruction);
+                static bool writesFlag(Instruction const& instruction);
+                static bool skipsFlag(Instruction const& instruction);
+                static void eliminateDeadFlags(std::vector<Instruction> & instructions);
+
+                void build(uint16_t address, Block & block);
+                void cover(uint16_t address, Block const& block, int16_t count);
+                bool overlaps(uint16_t address, Block const& block, size_t first, size_t last) const;
+                void fuse(Block & block);
+                void flush();
+                bool isIdleLoop(uint16_t address, Instruction const& jump);
+
+                /// @brief Reference to memory.
+                Memory & memory_;
+                /// @brief Reference to decoder owning the instructions.
+                OpcodeDecoder & decoder_;
+                /// @brief Blocks.
+                std::array<Block, BLOCK_COUNT> blocks_;
+                /// @brief Entries of the built blocks, one range per block.
+                std::vector<Entry> entries_;
+                /// @brief Instructions of the block being built.
+                std::vector<Instruction> instructions_;
+                /// @brief Addresses of the instructions being built.
+                std::vector<uint16_t> addresses_;
+                /// @brief Start addresses of the built blocks.
+                std::vector<uint16_t> built_;
+                /// @brief Count of built blocks covering each byte, so that
+                ///        writes to data never scan the blocks.
+                std::array<uint16_t, BLOCK_COUNT> coverage_;
+        };
+
+        uint32_t execute(typename BlockCache::Block const& block, uint32_t cycles);
+
+        /// @brief Instruction count of the longest idle loop skipped.
+        static constexpr uint8_t IDLE_LOOP_LENGTH = 3;
+
+        /// @brief Block cache instance.
+        BlockCache blockCache_;
+        /// @brief Count of updates left to run an idle loop, when the
+        ///        last one was skipped, zero once a jump leaves it.
+        uint8_t idleUpdates_;
+};
+
+extern template class ThreadedCore<VirtualDevices>;
+extern template class ThreadedCore<HeadlessDevices>;
+
+/// @brief Threaded CPU over the device interfaces.
+using ThreadedCpu = ThreadedCore<VirtualDevices>;
+/// @brief Threaded CPU over headless devices, with direct device calls.
+using HeadlessThreadedCpu = ThreadedCore<HeadlessDevices>;
+
+}  // chip8
+
+#endif  // CHIP8_THREADEDCPU_HPP
@@ -0,0 +1,117 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_TRIPLEBUFFER_HPP
+#define CHIP8_TRIPLEBUFFER_HPP
+
+#include <array>
+#include <atomic>
+
+#include <core.hpp>
+
+namespace chip8 {
+
+/// @brief Lock-free triple buffer handing values from one writer thread
+///        to one reader thread.
+///
+/// The writer fills the back buffer and publishes it, the reader takes
+/// the latest published buffer.  Publishing swaps the back buffer with
+/// the middle one and taking swaps the middle buffer with the front one,
+/// so neither side ever waits and the reader always gets the newest
+/// complete value.  Values published while the reader was busy are
+/// dropped.
+///
+/// @tparam T Value type.
+template<typename T>
+class TripleBuffer
+{
+    public:
+        TripleBuffer()
+            : buffers_{ }
+            , back_{ 0 }
+            , middle_{ 1 }
+            , front_{ 2 }
+        {
+        }
+
+        /// @brief Return the buffer to fill, from the writer.
+        T & back() { return buffers_[back_].value; }
+
+        /// @brief Publish the back buffer, from the writer.
+        ///
+        /// @return True when the value replaced one the reader never took.
+        bool publish()
+        {
+            uint8_t previous = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel);
+            back_ = previous & INDEX_MASK;
+
+            return (previous & FRESH) != 0;
+        }
+
+        /// @brief Take the newest published buffer, from the reader.
+        ///
+        /// @return True when a new buffer was taken, otherwise false and the
+        ///         front buffer is unchanged.
+        bool update()
+        {
+            if ((middle_.load(std::memory_order_relaxed) & FRESH) == 0)
+            {
+                return false;
+            }
+
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+
+            return true;
+        }
+
+        /// @brief Return the buffer taken last, from the reader.
+        T const& front() const { return buffers_[front_].value; }
+
+    private:
+        /// @brief Cache line size, so the sides do not share a line.
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+
+        /// @brief Middle index flag, set when published and not yet taken.
+        static constexpr uint8_t FRESH = 0x4;
+        /// @brief Buffer index bits.
+        static constexpr uint8_t INDEX_MASK = 0x3;
+
+        /// @brief Buffer, on its own cache lines.
+        struct alignas(CACHE_LINE_SIZE) Slot
+        {
+            T value;
+        };
+
+        /// @brief Buffers.
+        std::array<Slot, 3> buffers_;
+        /// @brief Back buffer index, owned by the writer.
+        alignas(CACHE_LINE_SIZE) uint8_t back_;
+        /// @brief Middle buffer index and fresh flag, exchanged by both.
+        alignas(CACHE_LINE_SIZE) std::atomic<uint8_t> middle_;
+        /// @brief Front buffer index, owned by the reader.
+        alignas(CACHE_LINE_SIZE) uint8_t front_;
+};
+
+}  // chip8
+
+#endif  // CHIP8_TRIPLEBUFFER_HPP
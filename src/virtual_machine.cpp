@@ -21,9 +21,15 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
-#include <unistd.h>
+#include <limits>
+#include <thread>
 
 #include "virtual_machine.hpp"
 
@@ -32,41 +38,27 @@ namespace chip8 {
 
 namespace {
 
-/// @brief Fontset sprites.
-uint8_t FONT_SET[] = {
-    0xF0, 0x90, 0x90, 0x90, 0xF0, // Character 0
-    0x20, 0x60, 0x20, 0x20, 0x70, // Character 1
-    0xF0, 0x10, 0xF0, 0x80, 0xF0, // Character 2
-    0xF0, 0x10, 0xF0, 0x10, 0xF0, // Character 3
-    0x90, 0x90, 0xF0, 0x10, 0x10, // Character 4
-    0xF0, 0x80, 0xF0, 0x10, 0xF0, // Character 5
-    0xF0, 0x80, 0xF0, 0x90, 0xF0, // Character 6
-    0xF0, 0x10, 0x20, 0x40, 0x40, // Character 7
-    0xF0, 0x90, 0xF0, 0x90, 0xF0, // Character 8
-    0xF0, 0x90, 0xF0, 0x10, 0xF0, // Character 9
-    0xF0, 0x90, 0xF0, 0x90, 0x90, // Character A
-    0xE0, 0x90, 0xE0, 0x90, 0xE0, // Character B
-    0xF0, 0x80, 0xF0, 0x80, 0xF0, // Character C
-    0xE0, 0x90, 0x90, 0x90, 0xE0, // Character D
-    0xF0, 0x80, 0xF0, 0x80, 0xF0, // Character E
-    0xF0, 0x80, 0xF0, 0x80, 0x80  // Character F
-};
-
-const std::size_t FONT_SET_SIZE = sizeof(FONT_SET) / sizeof(FONT_SET[0]);
-
-/// @brief Check file.
+/// @brief Parse a palette as `OFF,ON` RGB hexadecimal colors.
 ///
-/// @param filename Filename to check.
-bool checkFile(std::string const& filename)
+/// @param value    Palette text, e.g. `000000,FFFFFF`.
+/// @param palette  Palette to fill.
+/// @return True when parsed, otherwise false.
+bool parsePalette(std::string const& value, pixel::Palette & palette)
 {
-    int fileStatus = ::access(filename.c_str(), F_OK);
+    unsigned int off = 0;
+    unsigned int on = 0;
+    char end = 0;
 
-    if (fileStatus == -1)
+    if (std::sscanf(value.c_str(), "%6x,%6x%c", &off, &on, &end) != 2)
     {
-        std::printf("No such file `%s'\n", filename.c_str());
+        std::printf("Invalid palette `%s'\n", value.c_str());
         return false;
     }
 
+    // RGB to RGBA8888, opaque
+    palette.off = (off << 8) | 0xFF;
+    palette.on = (on << 8) | 0xFF;
+
     return true;
 }
 
@@ -75,18 +67,53 @@ bool checkFile(std::string const& filename)
 /// @brief Construct a CHIP-8 VM instance.
 VirtualMachine::VirtualMachine()
     : window_{ nullptr }
+    , headless_{ false }
+    , cycleLimit_{ 0 }
+    , cpuRate_{ DEFAULT_CPU_RATE }
+    , profileFile_{ }
+    , saveStateFile_{ }
+    , streamTarget_{ }
+    , metricsTarget_{ }
+    , metricsInterval_{ MetricsExporter::DEFAULT_INTERVAL }
+    , metrics_{ }
+    , metricsExporter_{ }
+    , recordFile_{ }
+    , inputRecorder_{ }
+    , inputReplay_{ }
+    , seed_{ Random::DEFAULT_SEED }
+    , randomAlgorithm_{ Random::Algorithm::PCG32 }
+    , loadState_{ }
+    , scale_{ GpuImpl::DEFAULT_SCALE }
+    , palette_{ pixel::DEFAULT_PALETTE }
+    , instanceCount_{ 1 }
+    , threadCount_{ 0 }
+    , batchRom_{ }
+    , batchEngine_{ BatchRunner::Engine::INTERP }
 {
 }
 
 /// @brief Destroy a CHIP-8
 VirtualMachine::~VirtualMachine()
 {
+    // The exporter reads the metrics until stopped
+    metricsExporter_.reset();
+
+    // Devices hold SDL resources, release them before quitting SDL
+    cpu_.reset();
+    gpu_.reset();
+    display_.reset();
+    keyboard_.reset();
+    sdlInput_.reset();
+
     if (window_ != nullptr)
     {
         SDL_DestroyWindow(window_);
     }
 
-    SDL_Quit();
+    if (!headless_)
+    {
+        SDL_Quit();
+    }
 }
 
 /// @brief Initialize the virtual machine.
@@ -96,27 +123,331 @@ VirtualMachine::~VirtualMachine()
 /// @return True when initialized, otherwise false.
 bool VirtualMachine::initialize(int argc, char * argv[])
 {
+    std::string filename;
+    std::string engine{ "interp" };
+
+    for (int index = 1; index < argc; ++index)
+    {
+        std::string argument{ argv[index] };
+
+        if (argument.compare(0, 9, "--engine=") == 0)
+        {
+            engine = argument.substr(9);
+        }
+        else if (argument == "--headless")
+        {
+            headless_ = true;
+        }
+        else if (argument.compare(0, 9, "--cycles=") == 0)
+        {
+            cycleLimit_ = std::strtoull(argument.c_str() + 9, nullptr, 10);
+        }
+        else if (argument.compare(0, 11, "--cpu-rate=") == 0)
+        {
+            cpuRate_ = std::strtoul(argument.c_str() + 11, nullptr, 10);
+        }
+        else if (argument.compare(0, 12, "--instances=") == 0)
+        {
+            instanceCount_ = std::strtoul(argument.c_str() + 12, nullptr, 10);
+        }
+        else if (argument.compare(0, 10, "--threads=") == 0)
+        {
+            threadCount_ = std::strtoul(argument.c_str() + 10, nullptr, 10);
+        }
+        else if (argument.compare(0, 8, "--trace=") == 0)
+        {
+            traceFile_ = argument.substr(8);
+        }
+        else if (argument.compare(0, 10, "--profile=") == 0)
+        {
+            profileFile_ = argument.substr(10);
+        }
+        else if (argument.compare(0, 13, "--save-state=") == 0)
+        {
+            saveStateFile_ = argument.substr(13);
+        }
+        else if (argument.compare(0, 13, "--load-state=") == 0)
+        {
+            if (!loadState_.open(argument.substr(13)))
+            {
+                return false;
+            }
+        }
+        else if (argument.compare(0, 9, "--record=") == 0)
+        {
+            recordFile_ = argument.substr(9);
+        }
+        else if (argument.compare(0, 9, "--replay=") == 0)
+        {
+            if (!inputReplay_.open(argument.substr(9)))
+            {
+                return false;
+            }
+        }
+        else if (argument.compare(0, 7, "--seed=") == 0)
+        {
+            seed_ = std::strtoul(argument.c_str() + 7, nullptr, 10);
+        }
+        else if (argument.compare(0, 6, "--rng=") == 0)
+        {
+            if (!Random::parseAlgorithm(argument.substr(6), randomAlgorithm_))
+            {
+                std::printf("Unknown random generator `%s'\n", argument.c_str() + 6);
+                return false;
+            }
+        }
+        else if (argument.compare(0, 9, "--stream=") == 0)
+        {
+            streamTarget_ = argument.substr(9);
+        }
+        else if (argument.compare(0, 10, "--metrics=") == 0)
+        {
+            metricsTarget_ = argument.substr(10);
+        }
+        else if (argument.compare(0, 19, "--metrics-interval=") == 0)
+        {
+            metricsInterval_ = std::strtoul(argument.c_str() + 19, nullptr, 10);
+        }
+        else if (argument.compare(0, 8, "--scale=") == 0)
+        {
+            scale_ = std::strtoul(argument.c_str() + 8, nullptr, 10);
+        }
+        else if (argument.compare(0, 10, "--palette=") == 0)
+        {
+            if (!parsePalette(argument.substr(10), palette_))
+            {
+                return false;
+            }
+        }
+        else if (argument.compare(0, 2, "--") == 0)
+        {
+            std::printf("Unknown option `%s'\n", argument.c_str());
+            return false;
+        }
+        else
+        {
+            filename = argument;
+        }
+    }
+
     // check for a file
-    if (argc < 2)
+    if (filename.empty())
     {
         std::puts("No file.");
         return false;
     }
 
-    std::string filename{ argv[1] };
+    // Extended machines run larger programs
+    bool extended = (engine == "extended");
+    Rom rom;
+
+    if (!rom.load(filename, extended ? Rom::MAX_EXTENDED_SIZE : Rom::MAX_SIZE))
+    {
+        return false;
+    }
+
+    if (engine != "interp" && engine != "threaded" && !extended)
+    {
+        std::printf("Unknown engine `%s'\n", engine.c_str());
+        return false;
+    }
+
+    if ((!traceFile_.empty() || !profileFile_.empty()) && engine != "interp")
+    {
+        std::puts("Tracing and profiling need the interp engine.");
+        return false;
+    }
+
+    if (!traceFile_.empty() && !profileFile_.empty())
+    {
+        std::puts("Tracing and profiling cannot be combined.");
+        return false;
+    }
+
+    if (instanceCount_ != 1 &&
+        (!headless_ || cycleLimit_ == 0 || !traceFile_.empty() || !profileFile_.empty() ||
+         !saveStateFile_.empty() || loadState_.image()))
+    {
+        std::puts("Multiple instances need --headless and --cycles, without --trace, --profile nor savestates.");
+        return false;
+    }
+
+    if (extended &&
+        (!headless_ || cycleLimit_ == 0 || !streamTarget_.empty() || !metricsTarget_.empty() ||
+         !recordFile_.empty() || inputReplay_.isOpen() || !saveStateFile_.empty() || loadState_.image()))
+    {
+        std::puts("The extended engine needs --headless and --cycles, without --stream, --metrics, input logs nor savestates.");
+        return false;
+    }
+
+    if (!streamTarget_.empty() && (!headless_ || instanceCount_ != 1))
+    {
+        std::puts("Streaming needs --headless, with a single instance.");
+        return false;
+    }
+
+    if (!metricsTarget_.empty() && instanceCount_ != 1)
+    {
+        std::puts("Metrics need a single instance.");
+        return false;
+    }
+
+    if (inputReplay_.isOpen() && (!headless_ || instanceCount_ != 1 || !recordFile_.empty()))
+    {
+        std::puts("Replaying needs --headless, with a single instance and without --record.");
+        return false;
+    }
+
+    if (!recordFile_.empty() && instanceCount_ != 1)
+    {
+        std::puts("Recording needs a single instance.");
+        return false;
+    }
+
+    if (inputReplay_.isOpen())
+    {
+        // The session is replayed as recorded
+        seed_ = inputReplay_.getSeed();
+        randomAlgorithm_ = inputReplay_.getRandomAlgorithm();
+        cpuRate_ = inputReplay_.getCpuRate();
+    }
+
+    if (cpuRate_ == 0)
+    {
+        std::puts("CPU rate must be positive.");
+        return false;
+    }
+
+    if (scale_ == 0)
+    {
+        std::puts("Scale must be positive.");
+        return false;
+    }
+
+    if (metricsInterval_ == 0)
+    {
+        std::puts("Metrics interval must be positive.");
+        return false;
+    }
+
+    if (instanceCount_ != 1 || extended)
+    {
+        // Batch machines, and extended ones, are built by the batch runner
+        batchRom_ = rom;
+
+        if (extended)
+        {
+            batchEngine_ = BatchRunner::Engine::EXTENDED;
+        }
+        else if (engine == "threaded")
+        {
+            batchEngine_ = BatchRunner::Engine::THREADED;
+        }
+        else
+        {
+            batchEngine_ = BatchRunner::Engine::INTERP;
+        }
+
+        return true;
+    }
+
+    inputQueue_ = std::make_shared<chip8::InputQueue>();
+    keyboard_ = std::make_shared<chip8::KeyboardImpl>(inputQueue_);
+
+    if (!streamTarget_.empty() || !metricsTarget_.empty())
+    {
+        // A reader closing the pipe fails the write instead of killing us
+        std::signal(SIGPIPE, SIG_IGN);
+    }
+
+    if (!streamTarget_.empty())
+    {
+        streamGpu_ = std::make_shared<chip8::StreamGpu>();
+
+        if (!streamGpu_->stream().open(streamTarget_))
+        {
+            return false;
+        }
 
-    if (!checkFile(filename))
+        gpu_ = streamGpu_;
+    }
+    else if (headless_)
+    {
+        gpu_ = std::make_shared<chip8::HeadlessGpu>();
+    }
+    else if (!initializeDisplay())
     {
         return false;
     }
 
+    memory_ = std::make_shared<chip8::Memory>();
+
+    if (!traceFile_.empty())
+    {
+        tracedCpu_ = std::make_shared<chip8::TracedCpu>(memory_, keyboard_, gpu_);
+        cpu_ = tracedCpu_;
+    }
+    else if (!profileFile_.empty())
+    {
+        profiledCpu_ = std::make_shared<chip8::ProfiledCpu>(memory_, keyboard_, gpu_);
+        cpu_ = profiledCpu_;
+    }
+    else if (engine == "threaded")
+    {
+        cpu_ = std::make_shared<chip8::ThreadedCpu>(memory_, keyboard_, gpu_);
+    }
+    else
+    {
+        cpu_ = std::make_shared<chip8::CpuImpl>(memory_, keyboard_, gpu_);
+    }
+
+    if (!recordFile_.empty())
+    {
+        if (!inputRecorder_.open(recordFile_, randomAlgorithm_, seed_, cpuRate_))
+        {
+            return false;
+        }
+
+        keyboard_->setRecorder(&inputRecorder_);
+    }
+
+    if (!metricsTarget_.empty())
+    {
+        std::string romName = filename.substr(filename.find_last_of('/') + 1);
+
+        metrics_ = std::make_unique<chip8::Metrics>(cpuRate_);
+        metricsExporter_ = std::make_unique<chip8::MetricsExporter>(
+                *metrics_, "rom=\"" + escapeLabel(romName) + "\"", metricsInterval_);
+
+        if (!metricsExporter_->open(metricsTarget_))
+        {
+            return false;
+        }
+
+        if (metricsExporter_->getPort() != 0)
+        {
+            std::printf("Serving metrics on port %u\n", metricsExporter_->getPort());
+        }
+    }
+
+    loadProgram(*memory_, rom);
+
+    return true;
+}
+
+/// @brief Initialize SDL display and keyboard.
+///
+/// @return True when initialized, otherwise false.
+bool VirtualMachine::initializeDisplay()
+{
     if (SDL_Init(SDL_INIT_EVERYTHING) < 0)
     {
         return false;
     }
 
-    const int WIN_WIDTH = 1024;
-    const int WIN_HEIGHT = 512;
+    // Texture is already scaled, the window matches it
+    const int WIN_WIDTH = Framebuffer::DISPLAY_WIDTH * scale_;
+    const int WIN_HEIGHT = Framebuffer::DISPLAY_HEIGHT * scale_;
 
     window_ = SDL_CreateWindow("CHIP-8",
             SDL_WINDOWPOS_UNDEFINED,
@@ -132,75 +463,261 @@ bool VirtualMachine::initialize(int argc, char * argv[])
 
     SDL_Renderer * renderer = SDL_CreateRenderer(window_, -1, 0);
 
-    gpu_ = std::make_shared<chip8::GpuImpl>(renderer);
-    keyboard_ = std::make_shared<chip8::KeyboardImpl>();
-    memory_ = std::make_shared<chip8::Memory>(chip8::SYSTEM_MEMORY_SIZE);
-    cpu_ = std::make_shared<chip8::CpuImpl>(memory_, keyboard_, gpu_);
-
-    loadFontset();
-    loadFile(filename);
+    display_ = std::make_shared<chip8::GpuImpl>(renderer, scale_, palette_);
+    gpu_ = display_;
+    sdlInput_ = std::make_unique<chip8::SdlInput>(inputQueue_);
 
     return true;
 }
 
 /// @brief Start the virtual machine.
+///
+/// The scheduler drives the CPU and fires the timer, display and input
+/// events at fixed emulated intervals.  With a display, the run is paced
+/// to wall clock at each frame and frames are presented from another
+/// thread; headless runs as fast as possible.
 void VirtualMachine::start()
 {
-    const uint32_t FRAME_RATE = 30;
-    const uint32_t FRAME_DURATION = 1000 / FRAME_RATE;
-    const uint32_t CPU_CYCLE = 2;
+    using Clock = std::chrono::steady_clock;
+
+    if (instanceCount_ != 1 || batchEngine_ == BatchRunner::Engine::EXTENDED)
+    {
+        runBatch();
+        return;
+    }
+
+    const uint32_t TIMER_RATE = 60; // HZ
+    const uint32_t FRAME_RATE = 60; // HZ
+    const uint32_t INPUT_RATE = 60; // HZ
 
     gpu_->clearFrame();
     cpu_->reset();
     cpu_->enableTraces();
 
-    uint32_t gpuTick = SDL_GetTicks();
+    auto state = cpu_->getState();
+    state.random = Random{ randomAlgorithm_, seed_ };
+    cpu_->setState(state);
 
-    while (!keyboard_->isQuitRequested())
+    if (loadState_.image() != nullptr)
     {
-        cpu_->tick(SDL_GetTicks());
-        cpu_->update();
+        loadState_.restore(*cpu_, *memory_, gpu_->getFramebuffer());
+        loadState_.close();
+    }
+
+    auto scheduler = Scheduler{ cpu_, cpuRate_ };
+    auto startTime = Clock::now();
 
-        keyboard_->update();
+    if (metrics_)
+    {
+        metrics_->startTime = startTime;
+        scheduler.setMetrics(metrics_.get());
+        metricsExporter_->start();
+    }
 
-        uint32_t gpuTimeElapsed = SDL_GetTicks() - gpuTick;
+    scheduler.addEvent(TIMER_RATE, [this] {
+        cpu_->tickTimers();
+    });
 
-        if (gpuTimeElapsed >= FRAME_DURATION)
+    scheduler.addEvent(FRAME_RATE, [this, &scheduler, startTime] {
         {
+            ScopedTimer timer{ metrics_ ? &metrics_->gpuDraw : nullptr };
             gpu_->draw();
-            gpuTick = SDL_GetTicks();
         }
 
-        SDL_Delay(CPU_CYCLE);
+        if (metrics_)
+        {
+            metrics_->frames.add(1);
+            metrics_->droppedFrames.set(display_ ? display_->getDroppedFrameCount() : 0);
+        }
+
+        if (!headless_)
+        {
+            auto emulatedTime = std::chrono::duration<double>(
+                    static_cast<double>(scheduler.getCycles()) / cpuRate_);
+
+            std::this_thread::sleep_until(
+                    startTime + std::chrono::duration_cast<Clock::duration>(emulatedTime));
+        }
+    });
+
+    // Set once the replay read the end of its log
+    bool replayEnding = false;
+
+    scheduler.addEvent(INPUT_RATE, [this, &scheduler, &replayEnding] {
+        if (inputReplay_.isOpen())
+        {
+            inputReplay_.pump(*inputQueue_);
+
+            if (inputReplay_.isAtEnd() && !replayEnding)
+            {
+                // Stop to finish the run on the cycle the session ended
+                replayEnding = true;
+                scheduler.stop();
+            }
+        }
+
+        {
+            ScopedTimer timer{ metrics_ ? &metrics_->keyboardUpdate : nullptr };
+            keyboard_->update(scheduler.getCycles());
+        }
+
+        if (keyboard_->isQuitRequested())
+        {
+            scheduler.stop();
+        }
+    });
+
+    uint64_t cycles = (cycleLimit_ != 0) ? cycleLimit_ : std::numeric_limits<uint64_t>::max();
+
+    if (display_)
+    {
+        runPresented(scheduler, cycles);
+    }
+    else
+    {
+        scheduler.run(cycles);
+    }
+
+    if (replayEnding && !keyboard_->isQuitRequested() &&
+        scheduler.getCycles() < std::min(inputReplay_.getEndCycle(), cycles))
+    {
+        scheduler.run(std::min(inputReplay_.getEndCycle(), cycles) - scheduler.getCycles());
+    }
+
+    if (headless_)
+    {
+        double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+        std::printf("Ran %llu cycles in %.3f s (%.0f instructions/s)\n",
+                    static_cast<unsigned long long>(scheduler.getCycles()),
+                    seconds,
+                    scheduler.getCycles() / seconds);
+    }
+
+    if (metricsExporter_)
+    {
+        metricsExporter_->stop();
+
+        std::printf("Exported %llu metrics snapshots to `%s'\n",
+                    static_cast<unsigned long long>(metricsExporter_->getSnapshotCount()),
+                    metricsTarget_.c_str());
+    }
+
+    if (inputRecorder_.isOpen() && inputRecorder_.close(scheduler.getCycles()))
+    {
+        std::printf("Recorded %llu input events to `%s'\n",
+                    static_cast<unsigned long long>(inputRecorder_.getEventCount()),
+                    recordFile_.c_str());
+    }
+
+    if (streamGpu_ && streamGpu_->stream().flush())
+    {
+        std::printf("Streamed %llu frames in %llu bytes to `%s'\n",
+                    static_cast<unsigned long long>(streamGpu_->stream().getFrameCount()),
+                    static_cast<unsigned long long>(streamGpu_->stream().getByteCount()),
+                    streamTarget_.c_str());
+    }
+
+    if (tracedCpu_ && tracedCpu_->getTrace().save(traceFile_))
+    {
+        std::printf("Saved %llu of %llu trace records to `%s'\n",
+                    static_cast<unsigned long long>(std::min<uint64_t>(tracedCpu_->getTrace().getCount(),
+                                                                       RingBufferTrace::CAPACITY)),
+                    static_cast<unsigned long long>(tracedCpu_->getTrace().getCount()),
+                    traceFile_.c_str());
+    }
+
+    if (profiledCpu_ && profiledCpu_->getTrace().save(profileFile_))
+    {
+        std::printf("Saved profile of %llu instructions to `%s'\n",
+                    static_cast<unsigned long long>(profiledCpu_->getTrace().getCount()),
+                    profileFile_.c_str());
+    }
+
+    if (!saveStateFile_.empty() && saveState(saveStateFile_, snapshot()))
+    {
+        std::printf("Saved state at cycle %llu to `%s'\n",
+                    static_cast<unsigned long long>(scheduler.getCycles()),
+                    saveStateFile_.c_str());
     }
 }
 
-/// @brief Load fontset.
-void VirtualMachine::loadFontset()
+/// @brief Run the emulation on its own thread, presenting frames and
+///        pumping SDL events on this one.
+///
+/// SDL wants its window and events handled by the thread that created
+/// them, so this thread presents.  It only exchanges frames through the
+/// display triple buffer and input through the input queue, so the
+/// emulation never waits on vsync nor on the event pump.
+///
+/// @param scheduler Scheduler of the machine.
+/// @param cycles    Count of cycles to run.
+void VirtualMachine::runPresented(Scheduler & scheduler, uint64_t cycles)
 {
-    // Add font table to memory (80 bytes)
-    for (std::size_t fontAddress = 0; fontAddress < FONT_SET_SIZE; ++fontAddress)
+    // Wake up at least at the frame rate when no event comes
+    const int PRESENT_TIMEOUT = 4; // MS
+
+    std::atomic<bool> running{ true };
+
+    std::thread emulation{ [&scheduler, &running, cycles] {
+        scheduler.run(cycles);
+        running = false;
+    } };
+
+    while (running)
     {
-        memory_->store(fontAddress, FONT_SET[fontAddress]);
+        // Live events apply at the next input update
+        sdlInput_->poll(0);
+
+        if (display_->present() && metrics_)
+        {
+            metrics_->presentedFrames.add(1);
+        }
+
+        SDL_WaitEventTimeout(nullptr, PRESENT_TIMEOUT);
     }
+
+    emulation.join();
 }
 
-/// @brief Load file to memory at start address.
-void VirtualMachine::loadFile(std::string const& filename)
+/// @brief Capture the machine state.
+///
+/// @return Snapshot sharing unwritten memory pages with previous ones.
+Snapshot VirtualMachine::snapshot()
 {
-    std::FILE * programFile = std::fopen(filename.c_str(), "rb");
-    std::size_t byteCount = 0;
-    uint16_t address = Cpu::PROGRAM_START;
+    return takeSnapshot(*cpu_, *memory_, gpu_->getFramebuffer());
+}
 
-    do
+/// @brief Restore a machine state captured by snapshot().
+///
+/// @param snapshot Snapshot to restore.
+void VirtualMachine::restore(Snapshot const& snapshot)
+{
+    restoreSnapshot(snapshot, *cpu_, *memory_, gpu_->getFramebuffer());
+}
+
+/// @brief Run instances of the program over a thread pool, headless.
+void VirtualMachine::runBatch()
+{
+    auto runner = BatchRunner{ threadCount_, batchEngine_, cpuRate_ };
+
+    for (uint32_t instance = 0; instance < instanceCount_; ++instance)
     {
-        uint8_t byte = 0;
-        byteCount = std::fread(&byte, 1, 1, programFile);
-        memory_->store(address++, byte);
+        runner.addSession(batchRom_, cycleLimit_);
     }
-    while (byteCount != 0);
 
-    std::fclose(programFile);
+    runner.run();
+
+    std::printf("Ran %u instances, %llu cycles in %.3f s (%.0f instructions/s)\n",
+                instanceCount_,
+                static_cast<unsigned long long>(runner.getTotalCycles()),
+                runner.getElapsedSeconds(),
+                runner.getInstructionRate());
+
+    if (runner.getParkedCount() != 0)
+    {
+        std::printf("%zu instances stopped waiting for a key\n", runner.getParkedCount());
+    }
 }
 
 } // namespace chip8
@@ -28,9 +28,21 @@
 
 #include <memory.hpp>
 #include <gpu.hpp>
+#include <headless.hpp>
+#include <input_queue.hpp>
 #include <keyboard.hpp>
+#include <sdl_input.hpp>
 #include <cpu.hpp>
+#include <threaded_cpu.hpp>
+#include <scheduler.hpp>
+#include <rom.hpp>
+#include <savestate.hpp>
+#include <snapshot.hpp>
+#include <batch_runner.hpp>
 #include <debugger.hpp>
+#include <frame_stream.hpp>
+#include <input_log.hpp>
+#include <metrics.hpp>
 
 
 namespace chip8 {
@@ -45,16 +57,84 @@ class VirtualMachine
         bool initialize(int argc, char * argv[]);
         void start();
 
+        Snapshot snapshot();
+        void restore(Snapshot const& snapshot);
+
     private:
-        void loadFontset();
-        void loadFile(std::string const& filename);
+        /// @brief Default emulated CPU rate.
+        static constexpr uint32_t DEFAULT_CPU_RATE = 500; // HZ
+
+        bool initializeDisplay();
+
+        void runBatch();
+        void runPresented(Scheduler & scheduler, uint64_t cycles);
 
         SDL_Window * window_;
 
+        /// @brief Run without display nor wall clock pacing.
+        bool headless_;
+        /// @brief Cycle count to run, zero to run forever.
+        uint64_t cycleLimit_;
+        /// @brief Emulated CPU rate.
+        uint32_t cpuRate_;
+        /// @brief Trace file, empty when not tracing.
+        std::string traceFile_;
+        /// @brief Profile report file, empty when not profiling.
+        std::string profileFile_;
+        /// @brief Savestate file written when the run ends, empty for none.
+        std::string saveStateFile_;
+        /// @brief Frame stream target, empty when not streaming.
+        std::string streamTarget_;
+        /// @brief Metrics export target, empty when not exporting.
+        std::string metricsTarget_;
+        /// @brief Interval between metrics snapshots pushed.
+        uint32_t metricsInterval_;
+        /// @brief Runtime metrics, when exporting.
+        std::unique_ptr<chip8::Metrics> metrics_;
+        /// @brief Metrics exporter, when exporting.
+        std::unique_ptr<chip8::MetricsExporter> metricsExporter_;
+        /// @brief Input log written, empty when not recording.
+        std::string recordFile_;
+        /// @brief Input log recorder, when recording.
+        InputRecorder inputRecorder_;
+        /// @brief Input log replayed, when open.
+        InputReplay inputReplay_;
+        /// @brief Random seed of the CPU.
+        uint32_t seed_;
+        /// @brief Random generator algorithm of the CPU.
+        Random::Algorithm randomAlgorithm_;
+        /// @brief Savestate the run starts from, when open.
+        MappedSavestate loadState_;
+        /// @brief Display scale factor.
+        uint32_t scale_;
+        /// @brief Display pixel colors.
+        pixel::Palette palette_;
+
+        /// @brief Count of program instances to run.
+        uint32_t instanceCount_;
+        /// @brief Worker threads for instances, zero for one per hardware thread.
+        uint32_t threadCount_;
+        /// @brief Program run by all instances.
+        Rom batchRom_;
+        /// @brief CPU engine of the instances.
+        BatchRunner::Engine batchEngine_;
+
         std::shared_ptr<chip8::Gpu> gpu_;
-        std::shared_ptr<chip8::Keyboard> keyboard_;
+        /// @brief SDL display, none when headless.
+        std::shared_ptr<chip8::GpuImpl> display_;
+        /// @brief Streaming display, when streaming.
+        std::shared_ptr<chip8::StreamGpu> streamGpu_;
+        std::shared_ptr<chip8::KeyboardImpl> keyboard_;
+        /// @brief Input events applied by the keyboard.
+        std::shared_ptr<chip8::InputQueue> inputQueue_;
+        /// @brief SDL event pump, none when headless.
+        std::unique_ptr<chip8::SdlInput> sdlInput_;
         std::shared_ptr<chip8::Memory> memory_;
         std::shared_ptr<chip8::Cpu> cpu_;
+        /// @brief Traced CPU, when tracing.
+        std::shared_ptr<chip8::TracedCpu> tracedCpu_;
+        /// @brief Profiled CPU, when profiling.
+        std::shared_ptr<chip8::ProfiledCpu> profiledCpu_;
 };
 
 } // namespace chip8
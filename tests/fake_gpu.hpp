@@ -36,7 +36,7 @@ class FakeGpu : public Gpu
         {
             uint8_t x;
             uint8_t y;
-            Sprite sprite;
+            Memory::Bytes sprite;
         };
 
         FakeGpu() = default;
@@ -51,7 +51,13 @@ class FakeGpu : public Gpu
         {
             drawContext.x = x;
             drawContext.y = y;
-            drawContext.sprite = sprite;
+            drawContext.sprite.clear();
+
+            for (size_t row = 0; row < sprite.size(); ++row)
+            {
+                drawContext.sprite.push_back(sprite[row]);
+            }
+
             return spriteErased;
         }
 
@@ -59,9 +65,15 @@ class FakeGpu : public Gpu
         {
         }
 
+        Framebuffer & getFramebuffer() override
+        {
+            return framebuffer;
+        }
+
         uint16_t clearCount = 0;
         DrawContext drawContext;
         bool spriteErased = false;
+        Framebuffer framebuffer;
 };
 
 }  // chip8
@@ -63,6 +63,18 @@ class FakeKeyboard : public Keyboard
             return keys[key];
         }
 
+        uint16_t getKeys() const override
+        {
+            uint16_t mask = 0;
+
+            for (uint16_t key = 0; key < KEY_COUNT; ++key)
+            {
+                mask |= keys[key] << key;
+            }
+
+            return mask;
+        }
+
         void update() override { }
 
         bool keys[KEY_COUNT];
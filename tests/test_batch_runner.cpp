@@ -0,0 +1,179 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <batch_runner.hpp>
+
+#include "test_vm.hpp"
+
+namespace {
+
+/// @brief Program counting loops in V0, V1 and drawing a digit.
+///
+/// 0x200 ADD V0, 1; 0x202 SE V0, 0; 0x204 JP 0x200; 0x206 ADD V1, 1;
+/// 0x208 LD F, V1; 0x20A DRW V2, V2, 5; 0x20C JP 0x200
+Data makeCounterRom(uint8_t step)
+{
+    auto opcodes = OpcodeList {
+        chip8::opcode::encode7XKK(0x0, step),
+        chip8::opcode::encode3XKK(0x0, 0x00),
+        chip8::opcode::encode1NNN(0x200),
+        chip8::opcode::encode7XKK(0x1, 0x01),
+        chip8::opcode::encodeFX29(0x1),
+        chip8::opcode::encodeDXYN(0x2, 0x2, 5),
+        chip8::opcode::encode1NNN(0x200)
+    };
+
+    Data rom;
+
+    for (auto opcode : opcodes)
+    {
+        rom.push_back(opcode >> 8);
+        rom.push_back(opcode & 0xFF);
+    }
+
+    return rom;
+}
+
+} // namespace
+
+TEST_CASE("Batch runner results do not depend on threads", "[batch]")
+{
+    auto engine = GENERATE(chip8::BatchRunner::Engine::INTERP, chip8::BatchRunner::Engine::THREADED);
+
+    const size_t SESSION_COUNT = 24;
+
+    auto reference = chip8::BatchRunner{ 1, engine, 500 };
+    auto batch = chip8::BatchRunner{ 4, engine, 500 };
+
+    uint64_t expectedCycles = 0;
+
+    for (size_t index = 0; index < SESSION_COUNT; ++index)
+    {
+        auto rom = makeCounterRom(static_cast<uint8_t>(index + 1));
+        uint64_t cycles = 1000 + 997 * index;
+
+        reference.addSession(rom, cycles);
+        batch.addSession(rom, cycles);
+
+        expectedCycles += cycles;
+    }
+
+    reference.run();
+    batch.run();
+
+    REQUIRE(batch.getSessionCount() == SESSION_COUNT);
+    REQUIRE(batch.getTotalCycles() == expectedCycles);
+    REQUIRE(reference.getTotalCycles() == expectedCycles);
+
+    for (size_t index = 0; index < SESSION_COUNT; ++index)
+    {
+        auto const& expected = reference.getRegContext(index);
+        auto const& actual = batch.getRegContext(index);
+
+        REQUIRE(actual.pc == expected.pc);
+        REQUIRE(actual.i == expected.i);
+        REQUIRE(actual.vx[0x0] == expected.vx[0x0]);
+        REQUIRE(actual.vx[0x1] == expected.vx[0x1]);
+
+        for (uint32_t y = 0; y < chip8::Framebuffer::DISPLAY_HEIGHT; ++y)
+        {
+            REQUIRE(batch.getFramebuffer(index).rows()[y] == reference.getFramebuffer(index).rows()[y]);
+        }
+    }
+}
+
+TEST_CASE("Batch runner reports no instruction rate before a run", "[batch]")
+{
+    auto batch = chip8::BatchRunner{ 2, chip8::BatchRunner::Engine::INTERP, 500 };
+
+    REQUIRE(batch.getInstructionRate() == 0.0);
+
+    batch.run();
+
+    REQUIRE(batch.getInstructionRate() == 0.0);
+}
+
+TEST_CASE("Batch runner session matches a single VM", "[batch]")
+{
+    auto batch = chip8::BatchRunner{ 2, chip8::BatchRunner::Engine::INTERP, 500 };
+    auto rom = makeCounterRom(3);
+
+    batch.addSession(rom, 5000);
+    batch.run();
+
+    // No timer is used, a plain run gives the same state
+    auto vm = Chip8TestVm{};
+    vm.storeData(chip8::Cpu::PROGRAM_START, rom);
+    vm.run(5000);
+
+    REQUIRE(batch.getRegContext(0).pc == vm.cpu().getProgramCounter());
+    REQUIRE(batch.getRegContext(0).vx[0x0] == vm.cpu().getRegisterVx(0x0));
+    REQUIRE(batch.getRegContext(0).vx[0x1] == vm.cpu().getRegisterVx(0x1));
+}
+
+TEST_CASE("Batch runner takes parked sessions off the run queue", "[batch]")
+{
+    auto engine = GENERATE(chip8::BatchRunner::Engine::INTERP, chip8::BatchRunner::Engine::THREADED);
+
+    auto batch = chip8::BatchRunner{ 2, engine, 600 };
+
+    // ADD V0, 1; LD V1, K
+    Data waiting = { 0x70, 0x01, 0xF1, 0x0A };
+
+    batch.addSession(waiting, 1000000);
+    batch.addSession(makeCounterRom(1), 1000);
+    batch.run();
+
+    REQUIRE(batch.isParked(0));
+    REQUIRE_FALSE(batch.isParked(1));
+    REQUIRE(batch.getParkedCount() == 1);
+
+    // Stopped at the first timer tick, 600 Hz / 60 Hz
+    REQUIRE(batch.getTotalCycles() == 10 + 1000);
+    REQUIRE(batch.getRegContext(0).pc == chip8::Cpu::PROGRAM_START + 2);
+    REQUIRE(batch.getRegContext(0).vx[0x0] == 0x01);
+}
+
+TEST_CASE("Batch runner runs extended programs", "[batch]")
+{
+    // 0x200 LD I, 0x1300; 0x204 LD V0, [I]; 0x206 HIGH; 0x208 JP 0x208,
+    // and data past the classic 4 KB
+    Data rom(0x1101, 0x00);
+    Data code = { 0xF0, 0x00, 0x13, 0x00, 0xF0, 0x65, 0x00, 0xFF, 0x12, 0x08 };
+    std::copy(code.begin(), code.end(), rom.begin());
+    rom[0x1300 - chip8::Cpu::PROGRAM_START] = 0x5A;
+
+    auto batch = chip8::BatchRunner{ 2, chip8::BatchRunner::Engine::EXTENDED, 500 };
+
+    batch.addSession(rom, 1000);
+    batch.addSession(makeCounterRom(1), 1000);
+    batch.run();
+
+    REQUIRE(batch.getTotalCycles() == 2000);
+    REQUIRE(batch.getRegContext(0).vx[0x0] == 0x5A);
+    REQUIRE(batch.getRegContext(0).pc == 0x208);
+    REQUIRE(batch.getExtendedFramebuffer(0).isHighResolution());
+    REQUIRE_FALSE(batch.getExtendedFramebuffer(1).isHighResolution());
+}
@@ -27,100 +27,7 @@
 #include <memory.hpp>
 #include <cpu.hpp>
 
-#include "fake_gpu.hpp"
-#include "fake_keyboard.hpp"
-
-using OpcodeList = chip8::Memory::Words;
-using Data = chip8::Memory::Bytes;
-
-class CpuContext
-{
-    public:
-        CpuContext(std::shared_ptr<chip8::Cpu> cpu)
-            : cpu_{ std::move(cpu) }
-        {
-        }
-
-        uint16_t getProgramCounter() const
-        {
-            return cpu_->getRegContext().pc;
-        }
-
-        uint8_t getRegisterVx(uint16_t vxIndex) const
-        {
-            return cpu_->getRegContext().vx[vxIndex];
-        }
-
-        uint8_t getStackPointer() const
-        {
-            return cpu_->getRegContext().sp;
-        }
-
-        uint16_t getRegisterI() const
-        {
-            return cpu_->getRegContext().i;
-        }
-
-        uint8_t getDelayTimer() const
-        {
-            return cpu_->getRegContext().dt;
-        }
-
-        uint8_t getSoundTimer() const
-        {
-            return cpu_->getRegContext().st;
-        }
-
-    private:
-        std::shared_ptr<chip8::Cpu> cpu_;
-};
-
-class Chip8TestVm
-{
-    public:
-
-        Chip8TestVm()
-            : memory_{ std::make_shared<chip8::Memory>(chip8::SYSTEM_MEMORY_SIZE) }
-            , gpu_{ std::make_shared<chip8::FakeGpu>() }
-            , keyboard_{ std::make_shared<chip8::FakeKeyboard>() }
-            , cpu_{ std::make_shared<chip8::CpuImpl>(memory_, keyboard_, gpu_) }
-            , cpuContext_{ std::make_shared<CpuContext>(cpu_) }
-        {
-        }
-
-        void storeCode(OpcodeList const& program)
-        {
-            memory_->storeBuffer(chip8::Cpu::PROGRAM_START, program, chip8::Memory::Endian::LITTLE);
-        }
-
-        void storeData(uint16_t startAddress, Data const& data)
-        {
-            memory_->storeBuffer(startAddress, data);
-        }
-
-        uint16_t loadData(uint16_t address)
-        {
-            return memory_->load<uint8_t>(address);
-        }
-
-        void run()
-        {
-            cpu_->update();
-        }
-
-        CpuContext const& cpu() { return *cpuContext_; }
-
-        chip8::FakeGpu & gpu() { return *gpu_; }
-        chip8::FakeKeyboard & keyboard() { return *keyboard_; }
-
-    private:
-        std::shared_ptr<chip8::Memory> memory_;
-        std::shared_ptr<chip8::FakeGpu> gpu_;
-        std::shared_ptr<chip8::FakeKeyboard> keyboard_;
-        std::shared_ptr<chip8::Cpu> cpu_;
-
-        std::shared_ptr<CpuContext> cpuContext_;
-};
+#include "test_vm.hpp"
 
 
 TEST_CASE("Test clear display", "[opcode]")
@@ -171,6 +78,23 @@ TEST_CASE("Test call subroutine", "[opcode]")
     REQUIRE(vm.cpu().getProgramCounter() == address);
 }
 
+TEST_CASE("Test call subroutine on a full stack", "[opcode]")
+{
+    auto vm = Chip8TestVm{};
+
+    // Calls itself forever
+    auto opcodes = OpcodeList {
+        chip8::opcode::encode2NNN(chip8::Cpu::PROGRAM_START)
+    };
+
+    vm.storeCode(opcodes);
+
+    vm.run(chip8::Cpu::STACK_SIZE + 4);
+    REQUIRE(vm.cpu().getStackPointer() == chip8::Cpu::STACK_SIZE);
+    REQUIRE(vm.cpu().getProgramCounter() == chip8::Cpu::PROGRAM_START);
+    REQUIRE(vm.cpu().getRegContext().stack[chip8::Cpu::STACK_SIZE - 1] == chip8::Cpu::PROGRAM_START + 2);
+}
+
 TEST_CASE("Test return from subroutine", "[opcode]")
 {
     auto vm = Chip8TestVm{};
@@ -831,11 +755,34 @@ TEST_CASE("Generate random 8-bit number", "[opcode]")
 
         vm.storeCode(opcodes);
 
+        // The expected value is the first byte of the mt19937 sequence
+        auto state = vm.core().getState();
+        state.random = chip8::Random{ chip8::Random::Algorithm::MT19937 };
+        vm.core().setState(state);
+
         vm.run();
         REQUIRE(vm.cpu().getRegisterVx(vxIndex) < (mask2 - 4));
     }
 }
 
+TEST_CASE("Draw sprite wraps around end of memory", "[opcode]")
+{
+    auto vm = Chip8TestVm{};
+
+    vm.storeData(0xFFE, Data{ 0x11, 0x22 });
+    vm.storeData(0x000, Data{ 0x33, 0x44 });
+
+    auto opcodes = OpcodeList {
+        chip8::opcode::encodeANNN(0xFFE),
+        chip8::opcode::encodeDXYN(0, 1, 4)
+    };
+
+    vm.storeCode(opcodes);
+    vm.run(static_cast<uint32_t>(opcodes.size()));
+
+    REQUIRE(vm.gpu().drawContext.sprite == Data{ 0x11, 0x22, 0x33, 0x44 });
+}
+
 TEST_CASE("Draw sprite", "[opcode]")
 {
     auto vm = Chip8TestVm{};
@@ -847,7 +794,7 @@ TEST_CASE("Draw sprite", "[opcode]")
 
     SECTION("Draw sprite erases pixel")
     {
-        auto sprite = chip8::Sprite{0x01};
+        auto sprite = Data{0x01};
 
         vm.storeData(START_DATA_ADDRESS, sprite);
 
@@ -881,7 +828,7 @@ TEST_CASE("Draw sprite", "[opcode]")
 
     SECTION("Draw sprite does not erase pixel.")
     {
-        auto sprite = chip8::Sprite{0x00};
+        auto sprite = Data{0x00};
 
         vm.storeData(START_DATA_ADDRESS, sprite);
 
@@ -918,7 +865,7 @@ TEST_CASE("Draw sprite", "[opcode]")
         size_t  spriteLength = GENERATE(Catch::Generators::range(0x0, 0x10));
         uint8_t spriteByte = 0xA5;
 
-        auto sprite = chip8::Sprite(spriteLength, spriteByte);
+        auto sprite = Data(spriteLength, spriteByte);
 
         vm.storeData(START_DATA_ADDRESS, sprite);
 
@@ -1059,17 +1006,38 @@ TEST_CASE("Load DT register to Vx register", "[opcode]")
     REQUIRE(vm.cpu().getRegisterVx(vxIndex) == 0x00);
 }
 
-TEST_CASE("Wait and load pressed key in Vx register")
+TEST_CASE("Wait and load pressed key in Vx register", "[opcode]")
 {
     auto vm = Chip8TestVm{};
 
     auto vxIndex = GENERATE(Catch::Generators::range(0x0, 0x10));
     uint16_t expectedByte = 0x10;
+    uint16_t key = 0xF - vxIndex;
 
     auto opcodes = OpcodeList {
         chip8::opcode::encode6XKK(vxIndex, expectedByte),
         chip8::opcode::encodeFX0A(vxIndex)
     };
+
+    vm.storeCode(opcodes);
+
+    vm.run();
+    vm.run();
+    REQUIRE(vm.core().isWaitingForKey());
+    REQUIRE(vm.cpu().getProgramCounter() == 0x202);
+    REQUIRE(vm.cpu().getRegisterVx(vxIndex) == expectedByte);
+
+    // Parked runs skip their cycles
+    REQUIRE(vm.run(1000) == 1000);
+    REQUIRE(vm.core().isWaitingForKey());
+    REQUIRE(vm.cpu().getProgramCounter() == 0x202);
+
+    vm.keyboard().pressKey(key);
+
+    vm.run();
+    REQUIRE_FALSE(vm.core().isWaitingForKey());
+    REQUIRE(vm.cpu().getProgramCounter() == 0x204);
+    REQUIRE(vm.cpu().getRegisterVx(vxIndex) == key);
 }
 
 TEST_CASE("Load Vx register to DT register", "[opcode]")
@@ -1114,6 +1082,29 @@ TEST_CASE("Load Vx to ST register", "[opcode]")
     REQUIRE(vm.cpu().getSoundTimer() == expectedByte);
 }
 
+TEST_CASE("Tick timers decrements delay and sound timers", "[timer]")
+{
+    auto vm = Chip8TestVm{};
+
+    auto opcodes = OpcodeList {
+        chip8::opcode::encode6XKK(0x0, 0x02),
+        chip8::opcode::encodeFX15(0x0),
+        chip8::opcode::encode6XKK(0x1, 0x01),
+        chip8::opcode::encodeFX18(0x1)
+    };
+
+    vm.storeCode(opcodes);
+    vm.run(static_cast<uint32_t>(opcodes.size()));
+
+    vm.tickTimers();
+    REQUIRE(vm.cpu().getDelayTimer() == 0x01);
+    REQUIRE(vm.cpu().getSoundTimer() == 0x00);
+
+    vm.tickTimers();
+    REQUIRE(vm.cpu().getDelayTimer() == 0x00);
+    REQUIRE(vm.cpu().getSoundTimer() == 0x00);
+}
+
 TEST_CASE("Add Vx to I register", "[opcode]")
 {
     auto vm = Chip8TestVm{};
@@ -1277,3 +1268,90 @@ TEST_CASE("Load Vx register from location I", "[opcode]")
     }
 }
 
+
+TEST_CASE("Execute instruction rewritten by store registers", "[cache]")
+{
+    auto vm = Chip8TestVm{};
+
+    uint16_t target = chip8::Cpu::PROGRAM_START + 0xA;
+
+    auto opcodes = OpcodeList {
+        chip8::opcode::encode1NNN(target),
+        chip8::opcode::encode6XKK(0, 0x7A),
+        chip8::opcode::encode6XKK(1, 0x01),
+        chip8::opcode::encodeANNN(target),
+        chip8::opcode::encodeFX55(1),
+        chip8::opcode::encode7XKK(0xA, 0x05),
+        chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START + 2)
+    };
+
+    vm.storeCode(opcodes);
+
+    vm.run();
+    vm.run();
+    REQUIRE(vm.cpu().getRegisterVx(0xA) == 0x05);
+
+    for (size_t count = 0; count < 5; ++count)
+    {
+        vm.run();
+    }
+    REQUIRE(vm.cpu().getProgramCounter() == target);
+    REQUIRE(vm.loadData(target) == 0x7A);
+
+    vm.run();
+    REQUIRE(vm.cpu().getRegisterVx(0xA) == 0x06);
+}
+
+TEST_CASE("Execute instruction rewritten by store BCD", "[cache]")
+{
+    auto vm = Chip8TestVm{};
+
+    uint16_t target = chip8::Cpu::PROGRAM_START + 0x8;
+
+    auto opcodes = OpcodeList {
+        chip8::opcode::encode1NNN(target),
+        chip8::opcode::encode6XKK(0, 12),
+        chip8::opcode::encodeANNN(target - 1),
+        chip8::opcode::encodeFX33(0),
+        chip8::opcode::encode7XKK(0xA, 0x01),
+        chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START + 2)
+    };
+
+    vm.storeCode(opcodes);
+
+    vm.run();
+    vm.run();
+    REQUIRE(vm.cpu().getRegisterVx(0xA) == 0x01);
+
+    for (size_t count = 0; count < 4; ++count)
+    {
+        vm.run();
+    }
+    REQUIRE(vm.cpu().getProgramCounter() == target);
+
+    // 0x0102 is a SYS instruction, ignored by the CPU
+    vm.run();
+    REQUIRE(vm.cpu().getRegisterVx(0xA) == 0x01);
+    REQUIRE(vm.cpu().getProgramCounter() == target + 2);
+}
+
+TEST_CASE("Execute instruction rewritten by store buffer", "[cache]")
+{
+    auto vm = Chip8TestVm{};
+
+    auto opcodes = OpcodeList {
+        chip8::opcode::encode7XKK(0xA, 0x01),
+        chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START)
+    };
+
+    vm.storeCode(opcodes);
+
+    vm.run();
+    vm.run();
+    REQUIRE(vm.cpu().getRegisterVx(0xA) == 0x01);
+
+    vm.storeCode(OpcodeList { chip8::opcode::encode7XKK(0xA, 0x10) });
+
+    vm.run();
+    REQUIRE(vm.cpu().getRegisterVx(0xA) == 0x11);
+}
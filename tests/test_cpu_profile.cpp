@@ -0,0 +1,143 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <string>
+
+#include "test_vm.hpp"
+
+using ProfiledTestVm = BasicTestVm<chip8::ProfiledCpu>;
+
+namespace {
+
+/// @brief Loop adding to V0 until it wraps, then jumping back.
+///
+/// 0x200 ADD V0, 1; 0x202 SE V0, 0; 0x204 JP 0x200; 0x206 LD V1, V0; 0x208 JP 0x200
+OpcodeList makeLoop()
+{
+    return OpcodeList {
+        chip8::opcode::encode7XKK(0x0, 0x01),
+        chip8::opcode::encode3XKK(0x0, 0x00),
+        chip8::opcode::encode1NNN(0x200),
+        chip8::opcode::encode8XY0(0x1, 0x0),
+        chip8::opcode::encode1NNN(0x200)
+    };
+}
+
+/// @brief Read a whole text file.
+std::string readText(std::string const& filename)
+{
+    std::string text;
+    std::FILE * file = std::fopen(filename.c_str(), "r");
+    REQUIRE(file != nullptr);
+
+    int character = 0;
+
+    while ((character = std::fgetc(file)) != EOF)
+    {
+        text.push_back(static_cast<char>(character));
+    }
+
+    std::fclose(file);
+
+    return text;
+}
+
+} // namespace
+
+TEST_CASE("Profile counts instructions per class and address", "[profile]")
+{
+    auto vm = ProfiledTestVm{};
+    vm.storeCode(makeLoop());
+
+    // Disabled until traces are enabled
+    vm.run(10);
+    REQUIRE(vm.core().getTrace().getCount() == 0);
+
+    vm.core().reset();
+    vm.core().enableTraces();
+
+    // 256 additions: 255 loops of 3 instructions, then ADD, SE, LD, JP
+    vm.run(255 * 3 + 4);
+
+    auto const& profile = vm.core().getTrace();
+
+    REQUIRE(profile.getCount() == 255 * 3 + 4);
+    REQUIRE(profile.getClassCount(chip8::opcode::OPCODE_7XKK) == 256);
+    REQUIRE(profile.getClassCount(chip8::opcode::OPCODE_3XKK) == 256);
+    REQUIRE(profile.getClassCount(chip8::opcode::OPCODE_1NNN) == 256);
+    REQUIRE(profile.getClassCount(chip8::opcode::OPCODE_8XY0) == 1);
+    REQUIRE(profile.getClassCount(chip8::opcode::OPCODE_DXYN) == 0);
+
+    REQUIRE(profile.getAddressCount(0x200) == 256);
+    REQUIRE(profile.getAddressCount(0x204) == 255);
+    REQUIRE(profile.getAddressCount(0x206) == 1);
+    REQUIRE(profile.getAddressCount(0x208) == 1);
+    REQUIRE(profile.getAddressCount(0x20A) == 0);
+}
+
+TEST_CASE("Profile report lists hotspots and heat map", "[profile]")
+{
+    auto vm = ProfiledTestVm{};
+    vm.storeCode(makeLoop());
+    vm.core().enableTraces();
+    vm.run(1000);
+
+    REQUIRE(vm.core().getTrace().save("test_profile.txt"));
+
+    auto report = readText("test_profile.txt");
+    std::remove("test_profile.txt");
+
+    REQUIRE(report.find("Instructions: 1000,") == 0);
+    REQUIRE(report.find("7XKK ADD") != std::string::npos);
+    REQUIRE(report.find("0x200 ") != std::string::npos);
+    REQUIRE(report.find("Heat map") != std::string::npos);
+    // The program row is hot, the rows past it never ran
+    REQUIRE(report.find("0x200 |@") != std::string::npos);
+    REQUIRE(report.find("0x280 |" + std::string(128, ' ') + "|") != std::string::npos);
+}
+
+TEST_CASE("Profile times every instruction of a short loop", "[profile]")
+{
+    // 0x200 ADD V0, 1; 0x202 LD V1, V0; 0x204 ADD V2, V1; 0x206 JP 0x200
+    auto vm = ProfiledTestVm{};
+    vm.storeCode(OpcodeList {
+        chip8::opcode::encode7XKK(0x0, 0x01),
+        chip8::opcode::encode8XY0(0x1, 0x0),
+        chip8::opcode::encode8XY4(0x2, 0x1),
+        chip8::opcode::encode1NNN(0x200)
+    });
+    vm.core().enableTraces();
+    vm.run(4000);
+
+    auto const& profile = vm.core().getTrace();
+
+    // A period dividing the loop length would only ever time one of them
+    REQUIRE(profile.getClassSamples(chip8::opcode::OPCODE_7XKK) > 0);
+    REQUIRE(profile.getClassSamples(chip8::opcode::OPCODE_8XY0) > 0);
+    REQUIRE(profile.getClassSamples(chip8::opcode::OPCODE_8XY4) > 0);
+    REQUIRE(profile.getClassSamples(chip8::opcode::OPCODE_1NNN) > 0);
+    REQUIRE(profile.getClassSamples(chip8::opcode::OPCODE_7XKK) < 1000);
+}
@@ -0,0 +1,157 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <vector>
+
+#include <cpu.hpp>
+#include <cpu_trace.hpp>
+
+#include "test_vm.hpp"
+
+namespace {
+
+using TracedTestVm = BasicTestVm<chip8::TracedCpu>;
+
+/// @brief Trace file content.
+struct TraceFile
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t recordSize;
+    uint64_t dropped;
+    uint64_t count;
+    std::vector<chip8::TraceRecord> records;
+};
+
+TraceFile readTraceFile(std::string const& filename)
+{
+    TraceFile trace{};
+
+    std::FILE * file = std::fopen(filename.c_str(), "rb");
+    REQUIRE(file != nullptr);
+
+    REQUIRE(std::fread(trace.magic, sizeof(trace.magic), 1, file) == 1);
+    REQUIRE(std::fread(&trace.version, sizeof(trace.version), 1, file) == 1);
+    REQUIRE(std::fread(&trace.recordSize, sizeof(trace.recordSize), 1, file) == 1);
+    REQUIRE(std::fread(&trace.dropped, sizeof(trace.dropped), 1, file) == 1);
+    REQUIRE(std::fread(&trace.count, sizeof(trace.count), 1, file) == 1);
+
+    trace.records.resize(trace.count);
+
+    if (trace.count != 0)
+    {
+        REQUIRE(std::fread(trace.records.data(), sizeof(chip8::TraceRecord), trace.count, file) == trace.count);
+    }
+
+    std::fclose(file);
+    std::remove(filename.c_str());
+
+    return trace;
+}
+
+} // namespace
+
+TEST_CASE("Untraced CPU compiles tracing out", "[trace]")
+{
+    STATIC_REQUIRE_FALSE(chip8::NoTrace::ENABLED);
+    STATIC_REQUIRE(chip8::RingBufferTrace::ENABLED);
+}
+
+TEST_CASE("Traced CPU records state before each instruction", "[trace]")
+{
+    auto vm = TracedTestVm{};
+
+    auto opcodes = OpcodeList {
+        chip8::opcode::encode6XKK(0x3, 0x42),
+        chip8::opcode::encodeANNN(0x300),
+        chip8::opcode::encode7XKK(0x3, 0x01)
+    };
+
+    vm.storeCode(opcodes);
+
+    SECTION("Nothing is recorded until enabled")
+    {
+        vm.run(3);
+        REQUIRE(vm.core().getTrace().getCount() == 0);
+    }
+
+    SECTION("Records are saved oldest first")
+    {
+        vm.core().enableTraces();
+        vm.run(3);
+
+        REQUIRE(vm.core().getTrace().getCount() == 3);
+        REQUIRE(vm.core().getTrace().save("test_trace.bin"));
+
+        auto trace = readTraceFile("test_trace.bin");
+
+        REQUIRE(std::string(trace.magic, 4) == "C8TR");
+        REQUIRE(trace.version == 1);
+        REQUIRE(trace.recordSize == sizeof(chip8::TraceRecord));
+        REQUIRE(trace.dropped == 0);
+        REQUIRE(trace.count == 3);
+
+        REQUIRE(trace.records[0].pc == chip8::Cpu::PROGRAM_START);
+        REQUIRE(trace.records[0].opcode == opcodes[0]);
+        REQUIRE(trace.records[0].vx[0x3] == 0x00);
+
+        REQUIRE(trace.records[1].pc == chip8::Cpu::PROGRAM_START + 2);
+        REQUIRE(trace.records[1].vx[0x3] == 0x42);
+        REQUIRE(trace.records[1].i == 0x000);
+
+        REQUIRE(trace.records[2].pc == chip8::Cpu::PROGRAM_START + 4);
+        REQUIRE(trace.records[2].opcode == opcodes[2]);
+        REQUIRE(trace.records[2].i == 0x300);
+    }
+}
+
+TEST_CASE("Traced CPU keeps the last records", "[trace]")
+{
+    auto vm = TracedTestVm{};
+
+    // Loop forever: 0x200 ADD V0, 1; 0x202 JP 0x200
+    auto opcodes = OpcodeList {
+        chip8::opcode::encode7XKK(0x0, 0x01),
+        chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START)
+    };
+
+    vm.storeCode(opcodes);
+    vm.core().enableTraces();
+
+    const uint32_t EXTRA = 11;
+    vm.run(chip8::RingBufferTrace::CAPACITY + EXTRA);
+
+    REQUIRE(vm.core().getTrace().save("test_trace_ring.bin"));
+
+    auto trace = readTraceFile("test_trace_ring.bin");
+
+    REQUIRE(trace.dropped == EXTRA);
+    REQUIRE(trace.count == chip8::RingBufferTrace::CAPACITY);
+
+    // Record 11 is the second instruction of the loop
+    REQUIRE(trace.records.front().pc == chip8::Cpu::PROGRAM_START + 2);
+    REQUIRE(trace.records.back().pc == chip8::Cpu::PROGRAM_START);
+}
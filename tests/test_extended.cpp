@@ -0,0 +1,322 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <memory>
+
+#include <cpu.hpp>
+#include <fontset.hpp>
+#include <framebuffer.hpp>
+#include <headless.hpp>
+#include <memory.hpp>
+#include <rom.hpp>
+
+#include "test_vm.hpp"
+
+using chip8::ExtendedFramebuffer;
+using Data = chip8::Memory::Bytes;
+
+namespace {
+
+/// @brief SUPER-CHIP and XO-CHIP machine over headless devices.
+struct ExtendedMachine
+{
+    ExtendedMachine(OpcodeList const& program)
+        : memory{ }
+        , cpu{ chip8::borrow(memory), chip8::borrow(keyboard), chip8::borrow(gpu) }
+    {
+        chip8::loadProgram(memory, { });
+        memory.storeBuffer(chip8::Cpu::PROGRAM_START, program, chip8::ExtendedMemory::Endian::LITTLE);
+    }
+
+    chip8::ExtendedMemory memory;
+    chip8::HeadlessExtendedGpu gpu;
+    chip8::HeadlessKeyboard keyboard;
+    chip8::ExtendedCpu cpu;
+};
+
+} // namespace
+
+TEST_CASE("Extended memory spans 64 KB", "[extended]")
+{
+    auto memory = std::make_unique<chip8::ExtendedMemory>();
+
+    REQUIRE(memory->getSize() == 0x10000);
+
+    memory->store(0xFFFF, 0x12);
+    memory->store(0x0000, 0x34);
+
+    REQUIRE(memory->load<uint8_t>(0xFFFF) == 0x12);
+    REQUIRE(memory->load<uint16_t>(0xFFFF) == 0x1234);
+    REQUIRE(memory->load<uint8_t>(0x1000) == 0x00);
+}
+
+TEST_CASE("Extended framebuffer draws in both resolutions", "[extended]")
+{
+    auto framebuffer = ExtendedFramebuffer{};
+
+    REQUIRE_FALSE(framebuffer.isHighResolution());
+
+    SECTION("Low resolution doubles pixels")
+    {
+        REQUIRE_FALSE(framebuffer.drawSprite(1, 2, Data{ 0x80 }));
+
+        REQUIRE(framebuffer.getPixel(2, 4) == 1);
+        REQUIRE(framebuffer.getPixel(3, 4) == 1);
+        REQUIRE(framebuffer.getPixel(2, 5) == 1);
+        REQUIRE(framebuffer.getPixel(3, 5) == 1);
+        REQUIRE(framebuffer.getPixel(4, 4) == 0);
+        REQUIRE(framebuffer.getPixel(2, 6) == 0);
+    }
+
+    SECTION("High resolution spans 128x64 pixels and wraps")
+    {
+        framebuffer.setHighResolution(true);
+
+        REQUIRE_FALSE(framebuffer.drawSprite(124, 63, Data{ 0xFF, 0x81 }));
+
+        REQUIRE(framebuffer.getPixel(124, 63) == 1);
+        REQUIRE(framebuffer.getPixel(127, 63) == 1);
+        REQUIRE(framebuffer.getPixel(0, 63) == 1);
+        REQUIRE(framebuffer.getPixel(3, 63) == 1);
+        REQUIRE(framebuffer.getPixel(124, 0) == 1);
+        REQUIRE(framebuffer.getPixel(125, 0) == 0);
+        REQUIRE(framebuffer.getPixel(3, 0) == 1);
+        REQUIRE(framebuffer.rows()[63] == ((static_cast<ExtendedFramebuffer::Row>(0xF) << 124) | 0xF));
+    }
+
+    SECTION("Large sprites are 16x16")
+    {
+        framebuffer.setHighResolution(true);
+
+        Data sprite(32, 0x00);
+        sprite[0] = 0x80;
+        sprite[1] = 0x01;
+        sprite[31] = 0x01;
+
+        REQUIRE_FALSE(framebuffer.drawLargeSprite(8, 8, sprite));
+        REQUIRE(framebuffer.getPixel(8, 8) == 1);
+        REQUIRE(framebuffer.getPixel(23, 8) == 1);
+        REQUIRE(framebuffer.getPixel(23, 23) == 1);
+        REQUIRE(framebuffer.getPixel(22, 23) == 0);
+        REQUIRE(framebuffer.drawLargeSprite(8, 8, sprite));
+    }
+
+    SECTION("Switching resolution clears the display")
+    {
+        framebuffer.drawSprite(0, 0, Data{ 0xFF });
+        framebuffer.setHighResolution(true);
+
+        REQUIRE(framebuffer.getPixel(0, 0) == 0);
+    }
+}
+
+TEST_CASE("Extended framebuffer scrolls by word shifts", "[extended]")
+{
+    auto framebuffer = ExtendedFramebuffer{};
+
+    framebuffer.setHighResolution(true);
+    framebuffer.drawSprite(8, 4, Data{ 0x80 });
+    framebuffer.markClean();
+
+    SECTION("Scroll down")
+    {
+        framebuffer.scrollDown(3);
+
+        REQUIRE(framebuffer.getPixel(8, 4) == 0);
+        REQUIRE(framebuffer.getPixel(8, 7) == 1);
+        REQUIRE(framebuffer.getDirtyRows() == ((1ULL << 4) | (1ULL << 7)));
+    }
+
+    SECTION("Scroll up drops rows off the top")
+    {
+        framebuffer.scrollUp(5);
+
+        for (uint32_t y = 0; y < ExtendedFramebuffer::DISPLAY_HEIGHT; ++y)
+        {
+            REQUIRE(framebuffer.rows()[y] == 0);
+        }
+    }
+
+    SECTION("Scroll right and left")
+    {
+        framebuffer.scrollRight();
+        REQUIRE(framebuffer.getPixel(12, 4) == 1);
+
+        framebuffer.scrollLeft();
+        framebuffer.scrollLeft();
+        REQUIRE(framebuffer.getPixel(4, 4) == 1);
+        REQUIRE(framebuffer.getPixel(8, 4) == 0);
+    }
+
+    SECTION("Low resolution scrolls twice as far")
+    {
+        framebuffer.setHighResolution(false);
+        framebuffer.drawSprite(0, 0, Data{ 0x80 });
+        framebuffer.scrollRight();
+
+        REQUIRE(framebuffer.getPixel(8, 0) == 1);
+        REQUIRE(framebuffer.getPixel(9, 1) == 1);
+        REQUIRE(framebuffer.getPixel(7, 0) == 0);
+    }
+}
+
+TEST_CASE("Extended framebuffer draws the selected planes", "[extended]")
+{
+    auto framebuffer = ExtendedFramebuffer{};
+
+    framebuffer.setHighResolution(true);
+    framebuffer.selectPlanes(0x3);
+
+    REQUIRE(framebuffer.getSelectedPlaneCount() == 2);
+    REQUIRE_FALSE(framebuffer.drawSprite(0, 0, Data{ 0x80, 0x40 }));
+
+    REQUIRE(framebuffer.rows(0)[0] == static_cast<ExtendedFramebuffer::Row>(0x80) << 120);
+    REQUIRE(framebuffer.rows(1)[0] == static_cast<ExtendedFramebuffer::Row>(0x40) << 120);
+
+    framebuffer.selectPlanes(0x2);
+    framebuffer.clear();
+
+    REQUIRE(framebuffer.rows(0)[0] != 0);
+    REQUIRE(framebuffer.rows(1)[0] == 0);
+}
+
+TEST_CASE("Extended CPU runs SUPER-CHIP and XO-CHIP instructions", "[extended]")
+{
+    SECTION("High resolution drawing and scrolling")
+    {
+        auto machine = std::make_unique<ExtendedMachine>(OpcodeList{
+            chip8::opcode::encode00FF(),
+            chip8::opcode::encode6XKK(0, 100),
+            chip8::opcode::encode6XKK(1, 40),
+            chip8::opcode::encode6XKK(2, 0x8),
+            chip8::opcode::encodeFX30(2),
+            chip8::opcode::encodeDXYN(0, 1, 10),
+            chip8::opcode::encode00CN(2),
+            chip8::opcode::encode00FB()
+        });
+
+        machine->cpu.run(8);
+
+        auto const& framebuffer = machine->gpu.framebuffer();
+        auto digit = chip8::BIG_FONT_SET + 8 * chip8::BIG_FONT_SIZE;
+
+        REQUIRE(framebuffer.isHighResolution());
+        REQUIRE(machine->cpu.getRegContext().i == chip8::FONT_SET_SIZE + 8 * chip8::BIG_FONT_SIZE);
+
+        for (uint8_t row = 0; row < chip8::BIG_FONT_SIZE; ++row)
+        {
+            auto expected = static_cast<ExtendedFramebuffer::Row>(digit[row]) << (128 - 8 - 104);
+            REQUIRE(framebuffer.rows()[42 + row] == expected);
+        }
+    }
+
+    SECTION("Skips step over F000 NNNN")
+    {
+        auto machine = std::make_unique<ExtendedMachine>(OpcodeList{
+            chip8::opcode::encode3XKK(0, 0x00),
+            chip8::opcode::encodeF000(),
+            0x1234,
+            chip8::opcode::encodeF000(),
+            0xFEDC
+        });
+
+        machine->cpu.run(2);
+
+        REQUIRE(machine->cpu.getRegContext().i == 0xFEDC);
+        REQUIRE(machine->cpu.getRegContext().pc == chip8::Cpu::PROGRAM_START + 10);
+    }
+
+    SECTION("Register ranges in either order")
+    {
+        auto machine = std::make_unique<ExtendedMachine>(OpcodeList{
+            chip8::opcode::encode6XKK(1, 0x11),
+            chip8::opcode::encode6XKK(2, 0x22),
+            chip8::opcode::encode6XKK(3, 0x33),
+            chip8::opcode::encodeF000(),
+            0xF000,
+            chip8::opcode::encode5XY2(3, 1),
+            chip8::opcode::encode5XY3(4, 6)
+        });
+
+        machine->cpu.run(7);
+
+        auto const& regs = machine->cpu.getRegContext();
+
+        REQUIRE(regs.i == 0xF000);
+        REQUIRE(machine->memory.load<uint8_t>(0xF000) == 0x33);
+        REQUIRE(machine->memory.load<uint8_t>(0xF001) == 0x22);
+        REQUIRE(machine->memory.load<uint8_t>(0xF002) == 0x11);
+        REQUIRE(regs.vx[4] == 0x33);
+        REQUIRE(regs.vx[5] == 0x22);
+        REQUIRE(regs.vx[6] == 0x11);
+    }
+
+    SECTION("Flag registers")
+    {
+        auto machine = std::make_unique<ExtendedMachine>(OpcodeList{
+            chip8::opcode::encode6XKK(0, 0xAA),
+            chip8::opcode::encode6XKK(1, 0xBB),
+            chip8::opcode::encodeFX75(1),
+            chip8::opcode::encode6XKK(0, 0x00),
+            chip8::opcode::encode6XKK(1, 0x00),
+            chip8::opcode::encodeFX85(1)
+        });
+
+        machine->cpu.run(6);
+
+        REQUIRE(machine->cpu.getRegContext().vx[0] == 0xAA);
+        REQUIRE(machine->cpu.getRegContext().vx[1] == 0xBB);
+    }
+
+    SECTION("Exit stays on the instruction")
+    {
+        auto machine = std::make_unique<ExtendedMachine>(OpcodeList{ chip8::opcode::encode00FD() });
+
+        machine->cpu.run(10);
+
+        REQUIRE(machine->cpu.getRegContext().pc == chip8::Cpu::PROGRAM_START);
+    }
+}
+
+TEST_CASE("Classic CPU leaves extended instructions unknown", "[extended]")
+{
+    auto memory = chip8::Memory{};
+    auto gpu = chip8::HeadlessGpu{};
+    auto keyboard = chip8::HeadlessKeyboard{};
+    auto cpu = chip8::HeadlessCpu{ chip8::borrow(memory), chip8::borrow(keyboard), chip8::borrow(gpu) };
+
+    memory.storeBuffer(chip8::Cpu::PROGRAM_START, OpcodeList{
+        chip8::opcode::encode6XKK(0, 0x12),
+        chip8::opcode::encodeFX75(0),
+        chip8::opcode::encode6XKK(0, 0x00),
+        chip8::opcode::encodeFX85(0),
+        chip8::opcode::encode00FD()
+    }, chip8::Memory::Endian::LITTLE);
+
+    cpu.run(5);
+
+    REQUIRE(cpu.getRegContext().vx[0] == 0x00);
+    REQUIRE(cpu.getRegContext().pc == chip8::Cpu::PROGRAM_START + 10);
+}
@@ -0,0 +1,162 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+#include <unistd.h>
+
+#include <frame_stream.hpp>
+
+#include "test_vm.hpp"
+
+namespace {
+
+/// @brief Read all bytes available from a pipe.
+std::vector<uint8_t> readPipe(int descriptor)
+{
+    std::vector<uint8_t> bytes(65536);
+    ssize_t size = ::read(descriptor, bytes.data(), bytes.size());
+
+    bytes.resize(size > 0 ? size : 0);
+
+    return bytes;
+}
+
+} // namespace
+
+TEST_CASE("Frame stream decodes to the drawn frames", "[stream]")
+{
+    int pipe[2];
+    REQUIRE(::pipe(pipe) == 0);
+
+    auto gpu = chip8::StreamGpu{};
+    gpu.stream().attach(pipe[1]);
+
+    auto digit = Data{ 0xF0, 0x90, 0x90, 0x90, 0xF0 };
+    auto sprite = chip8::Sprite{ digit };
+
+    std::vector<chip8::FrameDecoder::Plane> expected;
+
+    for (uint8_t frame = 0; frame < 40; ++frame)
+    {
+        // Frames 10 to 19 do not change
+        if (frame < 10 || frame >= 20)
+        {
+            gpu.drawSprite(frame * 3, frame % 20, sprite);
+        }
+
+        gpu.draw();
+
+        chip8::FrameDecoder::Plane plane;
+        std::copy(gpu.getFramebuffer().rows(), gpu.getFramebuffer().rows() + 32, plane.begin());
+        expected.push_back(plane);
+    }
+
+    REQUIRE(gpu.stream().flush());
+    REQUIRE(gpu.stream().getFrameCount() == 40);
+
+    auto bytes = readPipe(pipe[0]);
+    REQUIRE(bytes.size() == gpu.stream().getByteCount());
+
+    uint8_t const * data = bytes.data();
+    size_t size = bytes.size();
+
+    auto decoder = chip8::FrameDecoder{};
+    REQUIRE(decoder.decodeHeader(data, size));
+
+    size_t records = 0;
+
+    while (decoder.decode(data, size))
+    {
+        ++records;
+        REQUIRE(decoder.getPlane() == expected[decoder.getFrame() - 1]);
+    }
+
+    REQUIRE(size == 0);
+    REQUIRE(records == 30);
+    REQUIRE(decoder.getFrame() == 40);
+
+    gpu.stream().close();
+    ::close(pipe[0]);
+    ::close(pipe[1]);
+}
+
+TEST_CASE("Frame stream bytes grow with display changes", "[stream]")
+{
+    int pipe[2];
+    REQUIRE(::pipe(pipe) == 0);
+
+    auto gpu = chip8::StreamGpu{};
+    gpu.stream().attach(pipe[1]);
+
+    auto row = Data{ 0xFF };
+    gpu.drawSprite(0, 0, chip8::Sprite{ row });
+
+    for (size_t frame = 0; frame < 1000; ++frame)
+    {
+        gpu.draw();
+    }
+
+    REQUIRE(gpu.stream().flush());
+
+    // Header, then one record: frame delta, payload size, zero run,
+    // literal count and the literal
+    REQUIRE(gpu.stream().getByteCount() == chip8::FrameStream::HEADER_SIZE + 5);
+
+    gpu.stream().close();
+    ::close(pipe[0]);
+    ::close(pipe[1]);
+}
+
+TEST_CASE("Frame stream rejects invalid descriptors", "[stream]")
+{
+    auto stream = chip8::FrameStream{};
+
+    REQUIRE_FALSE(stream.open("fd:"));
+    REQUIRE_FALSE(stream.open("fd:abc"));
+    REQUIRE_FALSE(stream.open("fd:3x"));
+    REQUIRE_FALSE(stream.open("fd:-1"));
+    REQUIRE_FALSE(stream.open("fd:99999999999"));
+    REQUIRE_FALSE(stream.isOpen());
+}
+
+TEST_CASE("Frame stream counts only the bytes written", "[stream]")
+{
+    int pipe[2];
+    REQUIRE(::pipe(pipe) == 0);
+
+    // The read end refuses writes
+    auto gpu = chip8::StreamGpu{};
+    gpu.stream().attach(pipe[0]);
+
+    auto row = Data{ 0xFF };
+    gpu.drawSprite(0, 0, chip8::Sprite{ row });
+    gpu.draw();
+
+    REQUIRE_FALSE(gpu.stream().flush());
+    REQUIRE_FALSE(gpu.stream().isOpen());
+    REQUIRE(gpu.stream().getByteCount() == 0);
+
+    gpu.stream().close();
+    ::close(pipe[0]);
+    ::close(pipe[1]);
+}
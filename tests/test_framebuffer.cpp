@@ -0,0 +1,195 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+#include <framebuffer.hpp>
+
+using chip8::Framebuffer;
+using Data = chip8::Memory::Bytes;
+
+TEST_CASE("Framebuffer starts cleared", "[framebuffer]")
+{
+    auto framebuffer = Framebuffer{};
+
+    for (uint8_t y = 0; y < Framebuffer::DISPLAY_HEIGHT; ++y)
+    {
+        for (uint8_t x = 0; x < Framebuffer::DISPLAY_WIDTH; ++x)
+        {
+            REQUIRE(framebuffer.getPixel(x, y) == 0);
+        }
+    }
+}
+
+TEST_CASE("Draw sprite to framebuffer", "[framebuffer]")
+{
+    auto framebuffer = Framebuffer{};
+
+    auto x = 10u;
+    auto y = 4u;
+
+    auto sprite = Data{ 0x81, 0x3C };
+
+    SECTION("Draw sprite sets pixels")
+    {
+        REQUIRE_FALSE(framebuffer.drawSprite(x, y, sprite));
+
+        REQUIRE(framebuffer.getPixel(x, y) == 1);
+        REQUIRE(framebuffer.getPixel(x + 1, y) == 0);
+        REQUIRE(framebuffer.getPixel(x + 7, y) == 1);
+        REQUIRE(framebuffer.getPixel(x + 1, y + 1) == 0);
+        REQUIRE(framebuffer.getPixel(x + 2, y + 1) == 1);
+        REQUIRE(framebuffer.getPixel(x + 5, y + 1) == 1);
+        REQUIRE(framebuffer.getPixel(x + 6, y + 1) == 0);
+    }
+
+    SECTION("Draw sprite twice erases pixels")
+    {
+        REQUIRE_FALSE(framebuffer.drawSprite(x, y, sprite));
+        REQUIRE(framebuffer.drawSprite(x, y, sprite));
+
+        REQUIRE(framebuffer.getPixel(x, y) == 0);
+        REQUIRE(framebuffer.getPixel(x + 2, y + 1) == 0);
+    }
+
+    SECTION("Draw sprite without overlap does not erase")
+    {
+        REQUIRE_FALSE(framebuffer.drawSprite(x, y, sprite));
+        REQUIRE_FALSE(framebuffer.drawSprite(x, y + 2, sprite));
+    }
+
+    SECTION("Clear erases all pixels")
+    {
+        framebuffer.drawSprite(x, y, sprite);
+        framebuffer.clear();
+
+        REQUIRE(framebuffer.getPixel(x, y) == 0);
+        REQUIRE(framebuffer.getPixel(x + 2, y + 1) == 0);
+    }
+}
+
+TEST_CASE("Draw sprite wraps around display", "[framebuffer]")
+{
+    auto framebuffer = Framebuffer{};
+
+    auto sprite = Data{ 0xFF, 0xFF };
+
+    uint8_t x = Framebuffer::DISPLAY_WIDTH - 4;
+    uint8_t y = Framebuffer::DISPLAY_HEIGHT - 1;
+
+    REQUIRE_FALSE(framebuffer.drawSprite(x, y, sprite));
+
+    REQUIRE(framebuffer.getPixel(Framebuffer::DISPLAY_WIDTH - 1, y) == 1);
+    REQUIRE(framebuffer.getPixel(0, y) == 1);
+    REQUIRE(framebuffer.getPixel(3, y) == 1);
+    REQUIRE(framebuffer.getPixel(4, y) == 0);
+    REQUIRE(framebuffer.getPixel(0, 0) == 1);
+    REQUIRE(framebuffer.getPixel(Framebuffer::DISPLAY_WIDTH - 4, 0) == 1);
+}
+
+TEST_CASE("Framebuffer stores one bit per pixel", "[framebuffer]")
+{
+    auto framebuffer = Framebuffer{};
+
+    framebuffer.drawSprite(60, 2, Data{ 0xA5 });
+
+    REQUIRE(framebuffer.rows()[2] == 0x500000000000000AULL);
+    REQUIRE(framebuffer.drawSprite(0, 2, Data{ 0x0F }) == false);
+    REQUIRE(framebuffer.drawSprite(0, 2, Data{ 0x80 }) == false);
+    REQUIRE(framebuffer.drawSprite(0, 2, Data{ 0x80 }) == true);
+    REQUIRE(framebuffer.rows()[2] == 0x5F0000000000000AULL);
+}
+
+TEST_CASE("Framebuffer expands pixels to RGBA", "[framebuffer]")
+{
+    auto framebuffer = Framebuffer{};
+    auto pixels = std::vector<Framebuffer::Pixel>(Framebuffer::PIXEL_COUNT);
+
+    framebuffer.setPixel(0, 0, 1);
+    framebuffer.setPixel(63, 31, 1);
+    framebuffer.expand(pixels.data(), Framebuffer::PITCH);
+
+    REQUIRE(pixels[0] == 0xFFFFFFFF);
+    REQUIRE(pixels[1] == 0x000000FF);
+    REQUIRE(pixels[Framebuffer::PIXEL_COUNT - 2] == 0x000000FF);
+    REQUIRE(pixels[Framebuffer::PIXEL_COUNT - 1] == 0xFFFFFFFF);
+
+    framebuffer.setPixel(0, 0, 0);
+    framebuffer.expand(pixels.data(), Framebuffer::PITCH);
+    REQUIRE(pixels[0] == 0x000000FF);
+}
+
+TEST_CASE("Framebuffer tracks dirty rows", "[framebuffer]")
+{
+    auto framebuffer = Framebuffer{};
+
+    REQUIRE(framebuffer.getDirtyRows() == 0xFFFFFFFF);
+
+    framebuffer.markClean();
+    REQUIRE(framebuffer.getDirtyRows() == 0);
+
+    SECTION("Clearing a blank display changes nothing")
+    {
+        framebuffer.clear();
+        REQUIRE(framebuffer.getDirtyRows() == 0);
+    }
+
+    SECTION("Drawing marks sprite rows, wrapping around")
+    {
+        framebuffer.drawSprite(0, 30, Data{ 0x80, 0x00, 0x80 });
+        REQUIRE(framebuffer.getDirtyRows() == 0x40000001);
+    }
+
+    SECTION("Clearing marks lit rows only")
+    {
+        framebuffer.drawSprite(10, 4, Data{ 0xFF });
+        framebuffer.setPixel(0, 9, 1);
+        framebuffer.markClean();
+
+        framebuffer.clear();
+        REQUIRE(framebuffer.getDirtyRows() == ((1u << 4) | (1u << 9)));
+    }
+
+    SECTION("Setting a pixel to its value changes nothing")
+    {
+        framebuffer.setPixel(3, 3, 0);
+        REQUIRE(framebuffer.getDirtyRows() == 0);
+
+        framebuffer.setPixel(3, 3, 1);
+        REQUIRE(framebuffer.getDirtyRows() == (1u << 3));
+    }
+}
+
+TEST_CASE("Framebuffer expands a row span", "[framebuffer]")
+{
+    auto framebuffer = Framebuffer{};
+    auto pixels = std::vector<Framebuffer::Pixel>(Framebuffer::DISPLAY_WIDTH * 2);
+
+    framebuffer.setPixel(5, 7, 1);
+    framebuffer.expand(pixels.data(), Framebuffer::PITCH, chip8::pixel::DEFAULT_PALETTE, 1, 6, 2);
+
+    REQUIRE(pixels[5] == 0x000000FF);
+    REQUIRE(pixels[Framebuffer::DISPLAY_WIDTH + 5] == 0xFFFFFFFF);
+}
@@ -0,0 +1,148 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <scheduler.hpp>
+#include <threaded_cpu.hpp>
+
+#include "test_vm.hpp"
+
+namespace {
+
+/// @brief Waits on the delay timer, then on key 0, then again.
+///
+/// 0x200 LD V0, 30; 0x202 LD DT, V0; 0x204 LD V1, DT; 0x206 SE V1, 0;
+/// 0x208 JP 0x204; 0x20A ADD V2, 1; 0x20C SKP V3; 0x20E JP 0x20C;
+/// 0x210 LD V0, 10; 0x212 JP 0x202
+OpcodeList const WAIT_PROGRAM = {
+    chip8::opcode::encode6XKK(0x0, 30),
+    chip8::opcode::encodeFX15(0x0),
+    chip8::opcode::encodeFX07(0x1),
+    chip8::opcode::encode3XKK(0x1, 0x00),
+    chip8::opcode::encode1NNN(0x204),
+    chip8::opcode::encode7XKK(0x2, 0x01),
+    chip8::opcode::encodeEX9E(0x3),
+    chip8::opcode::encode1NNN(0x20C),
+    chip8::opcode::encode6XKK(0x0, 10),
+    chip8::opcode::encode1NNN(0x202)
+};
+
+/// @brief Run the wait program under a scheduler, key 0 toggling at 7 Hz.
+template<typename CPU>
+void runWaitProgram(BasicTestVm<CPU> & vm, uint64_t cycles)
+{
+    const uint32_t CPU_RATE = 100000;
+
+    vm.storeCode(WAIT_PROGRAM);
+
+    auto scheduler = chip8::Scheduler{ chip8::borrow<chip8::Cpu>(vm.core()), CPU_RATE };
+
+    scheduler.addEvent(60, [&vm] { vm.tickTimers(); });
+    scheduler.addEvent(7, [&vm] { vm.keyboard().keys[0] = !vm.keyboard().keys[0]; });
+
+    scheduler.run(cycles);
+}
+
+} // namespace
+
+TEST_CASE("Idle loops are skipped with identical results", "[idle]")
+{
+    uint64_t cycles = GENERATE(1, 5, 1000, 4321, 99999, 250000);
+
+    // Traced cores run every cycle
+    auto reference = BasicTestVm<chip8::TracedCpu>{};
+    auto interpreter = Chip8TestVm{};
+    auto threaded = BasicTestVm<chip8::ThreadedCpu>{};
+
+    runWaitProgram(reference, cycles);
+    runWaitProgram(interpreter, cycles);
+    runWaitProgram(threaded, cycles);
+
+    auto const& expected = reference.core().getRegContext();
+
+    for (auto const * actual : { &interpreter.core().getRegContext(), &threaded.core().getRegContext() })
+    {
+        REQUIRE(actual->pc == expected.pc);
+        REQUIRE(actual->dt == expected.dt);
+
+        for (uint8_t index = 0; index < chip8::Cpu::REG_COUNT; ++index)
+        {
+            REQUIRE(actual->vx[index] == expected.vx[index]);
+        }
+    }
+
+    REQUIRE(interpreter.core().getOpcode() == reference.core().getOpcode());
+    REQUIRE(threaded.core().getOpcode() == reference.core().getOpcode());
+    REQUIRE(reference.core().getIdleCycles() == 0);
+
+    if (cycles >= 1000)
+    {
+        REQUIRE(interpreter.core().getIdleCycles() > cycles / 2);
+        REQUIRE(threaded.core().getIdleCycles() > cycles / 2);
+    }
+}
+
+TEST_CASE("Loops that change state are not skipped", "[idle]")
+{
+    auto vm = Chip8TestVm{};
+
+    // LD V1, DT; SE V1, 0; JP 0x200 never waits with DT at 0, and
+    // ADD V0, 1; JP 0x206 counts
+    vm.storeCode(OpcodeList {
+        chip8::opcode::encodeFX07(0x1),
+        chip8::opcode::encode3XKK(0x1, 0x00),
+        chip8::opcode::encode1NNN(0x200),
+        chip8::opcode::encode7XKK(0x0, 0x01),
+        chip8::opcode::encode1NNN(0x206)
+    });
+
+    vm.run(3000);
+
+    REQUIRE(vm.core().getIdleCycles() == 0);
+    REQUIRE(vm.cpu().getRegisterVx(0x0) == static_cast<uint8_t>((3000 - 2) / 2));
+}
+
+TEST_CASE("Jumps to themselves are skipped", "[idle]")
+{
+    // LD V0, 5; JP 0x202 halts on the jump
+    OpcodeList const HALT_PROGRAM = {
+        chip8::opcode::encode6XKK(0x0, 5),
+        chip8::opcode::encode1NNN(0x202)
+    };
+
+    auto interpreter = Chip8TestVm{};
+    auto threaded = BasicTestVm<chip8::ThreadedCpu>{};
+
+    interpreter.storeCode(HALT_PROGRAM);
+    threaded.storeCode(HALT_PROGRAM);
+
+    REQUIRE(interpreter.run(1000) == 1000);
+    REQUIRE(threaded.run(1000) == 1000);
+
+    REQUIRE(interpreter.core().getRegContext().pc == 0x202);
+    REQUIRE(threaded.core().getRegContext().pc == 0x202);
+    REQUIRE(interpreter.core().getIdleCycles() == 998);
+    REQUIRE(threaded.core().getIdleCycles() == 998);
+    REQUIRE(threaded.core().getOpcode() == chip8::opcode::encode1NNN(0x202));
+}
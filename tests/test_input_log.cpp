@@ -0,0 +1,186 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <cstring>
+
+#include <headless.hpp>
+#include <input_log.hpp>
+#include <keyboard.hpp>
+#include <rom.hpp>
+#include <scheduler.hpp>
+
+#include "test_vm.hpp"
+
+namespace {
+
+using chip8::InputEvent;
+
+/// @brief Program mixing random numbers and key 0.
+///
+/// 0x200 RND V2, 0xFF; 0x202 SKNP V0; 0x204 ADD V1, 1; 0x206 ADD V3, V2;
+/// 0x208 JP 0x200
+Data const KEY_PROGRAM = {
+    0xC2, 0xFF,
+    0xE0, 0xA1,
+    0x71, 0x01,
+    0x83, 0x24,
+    0x12, 0x00
+};
+
+/// @brief Headless machine with a queue driven keyboard.
+struct Machine
+{
+    Machine(uint32_t seed)
+        : memory{ std::make_shared<chip8::Memory>() }
+        , gpu{ std::make_shared<chip8::HeadlessGpu>() }
+        , queue{ std::make_shared<chip8::InputQueue>() }
+        , keyboard{ std::make_shared<chip8::KeyboardImpl>(queue) }
+        , cpu{ std::make_shared<chip8::CpuImpl>(memory, keyboard, gpu) }
+        , scheduler{ cpu, 1000 }
+    {
+        chip8::loadProgram(*memory, chip8::Rom{ KEY_PROGRAM });
+        cpu->seedRandom(seed);
+
+        scheduler.addEvent(60, [this] {
+            if (replay.isOpen())
+            {
+                replay.pump(*queue);
+            }
+
+            keyboard->update(scheduler.getCycles());
+        });
+    }
+
+    std::shared_ptr<chip8::Memory> memory;
+    std::shared_ptr<chip8::HeadlessGpu> gpu;
+    std::shared_ptr<chip8::InputQueue> queue;
+    std::shared_ptr<chip8::KeyboardImpl> keyboard;
+    std::shared_ptr<chip8::CpuImpl> cpu;
+    chip8::Scheduler scheduler;
+    chip8::InputReplay replay;
+};
+
+} // namespace
+
+TEST_CASE("Replayed input gives the recorded session", "[input_log]")
+{
+    const uint32_t SEED = 1234;
+
+    auto live = Machine{ SEED };
+    auto recorder = chip8::InputRecorder{};
+
+    REQUIRE(recorder.open("test_input.bin", chip8::Random::Algorithm::PCG32, SEED, live.scheduler.getCpuRate()));
+    live.keyboard->setRecorder(&recorder);
+
+    // Live input arrives between runs, unstamped
+    for (uint8_t step = 0; step < 20; ++step)
+    {
+        auto type = (step % 2 == 0) ? InputEvent::Type::KEY_DOWN : InputEvent::Type::KEY_UP;
+
+        live.queue->push(InputEvent{ 0, type, 0x0 });
+        live.queue->push(InputEvent{ 0, type, static_cast<uint8_t>(step % 16) });
+        live.scheduler.run(317 + 45 * step);
+    }
+
+    REQUIRE(recorder.getEventCount() > 20);
+    REQUIRE(recorder.close(live.scheduler.getCycles()));
+
+    auto replayed = Machine{ 0 };
+
+    REQUIRE(replayed.replay.open("test_input.bin"));
+    REQUIRE(replayed.replay.getRandomAlgorithm() == chip8::Random::Algorithm::PCG32);
+    REQUIRE(replayed.replay.getSeed() == SEED);
+    REQUIRE(replayed.replay.getCpuRate() == 1000);
+
+    replayed.cpu->seedRandom(replayed.replay.getSeed());
+
+    while (!replayed.replay.isAtEnd())
+    {
+        replayed.scheduler.run(1);
+    }
+
+    replayed.scheduler.run(replayed.replay.getEndCycle() - replayed.scheduler.getCycles());
+
+    auto const& expected = live.cpu->getRegContext();
+    auto const& actual = replayed.cpu->getRegContext();
+
+    REQUIRE(replayed.scheduler.getCycles() == live.scheduler.getCycles());
+    REQUIRE(replayed.keyboard->getKeys() == live.keyboard->getKeys());
+    REQUIRE(actual.pc == expected.pc);
+    REQUIRE(std::memcmp(actual.vx, expected.vx, sizeof(actual.vx)) == 0);
+
+    std::remove("test_input.bin");
+}
+
+TEST_CASE("Input log only records state changes", "[input_log]")
+{
+    auto queue = std::make_shared<chip8::InputQueue>();
+    auto keyboard = chip8::KeyboardImpl{ queue };
+    auto recorder = chip8::InputRecorder{};
+
+    REQUIRE(recorder.open("test_input_changes.bin", chip8::Random::Algorithm::MT19937, 0, 500));
+    keyboard.setRecorder(&recorder);
+
+    queue->push(InputEvent{ 0, InputEvent::Type::KEY_DOWN, 0x7 });
+    queue->push(InputEvent{ 0, InputEvent::Type::KEY_DOWN, 0x7 });
+    queue->push(InputEvent{ 0, InputEvent::Type::KEY_UP, 0x2 });
+    keyboard.update(200);
+
+    queue->push(InputEvent{ 0, InputEvent::Type::KEY_UP, 0x7 });
+    keyboard.update(300);
+
+    REQUIRE(recorder.getEventCount() == 2);
+    REQUIRE(recorder.close(400));
+
+    // Header, then 2 bytes per record, the first delta needing 2 bytes
+    std::FILE * file = std::fopen("test_input_changes.bin", "rb");
+    REQUIRE(file != nullptr);
+    std::fseek(file, 0, SEEK_END);
+    REQUIRE(std::ftell(file) == 16 + 3 + 2 + 2);
+    std::fclose(file);
+
+    auto replay = chip8::InputReplay{};
+    auto replayQueue = chip8::InputQueue{};
+    InputEvent event{};
+
+    REQUIRE(replay.open("test_input_changes.bin"));
+    replay.pump(replayQueue);
+
+    REQUIRE(replay.isAtEnd());
+    REQUIRE(replay.getEndCycle() == 400);
+
+    REQUIRE(replayQueue.pop(event));
+    REQUIRE(event.cycle == 200);
+    REQUIRE(event.type == InputEvent::Type::KEY_DOWN);
+    REQUIRE(event.key == 0x7);
+
+    REQUIRE(replayQueue.pop(event));
+    REQUIRE(event.cycle == 300);
+    REQUIRE(event.type == InputEvent::Type::KEY_UP);
+
+    REQUIRE_FALSE(replayQueue.pop(event));
+
+    std::remove("test_input_changes.bin");
+}
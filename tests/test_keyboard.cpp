@@ -0,0 +1,135 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+#include <thread>
+
+#include <input_queue.hpp>
+#include <keyboard.hpp>
+
+using chip8::InputEvent;
+
+TEST_CASE("Input queue keeps events in order until full", "[keyboard]")
+{
+    auto queue = chip8::InputQueue{};
+    InputEvent event{};
+
+    REQUIRE_FALSE(queue.pop(event));
+
+    for (size_t index = 0; index < chip8::InputQueue::CAPACITY; ++index)
+    {
+        REQUIRE(queue.push(InputEvent{ index, InputEvent::Type::KEY_DOWN, 0 }));
+    }
+
+    REQUIRE_FALSE(queue.push(InputEvent{ 0, InputEvent::Type::QUIT, 0 }));
+
+    for (size_t index = 0; index < chip8::InputQueue::CAPACITY; ++index)
+    {
+        REQUIRE(queue.peek(event));
+        REQUIRE(queue.pop(event));
+        REQUIRE(event.cycle == index);
+    }
+
+    REQUIRE_FALSE(queue.peek(event));
+}
+
+TEST_CASE("Input queue passes events between threads", "[keyboard]")
+{
+    const uint64_t EVENT_COUNT = 100000;
+
+    auto queue = chip8::InputQueue{};
+
+    std::thread producer{ [&queue] {
+        for (uint64_t cycle = 0; cycle < EVENT_COUNT; ++cycle)
+        {
+            while (!queue.push(InputEvent{ cycle, InputEvent::Type::KEY_DOWN, static_cast<uint8_t>(cycle & 0xF) }))
+            {
+                std::this_thread::yield();
+            }
+        }
+    } };
+
+    uint64_t expected = 0;
+    bool ordered = true;
+    InputEvent event{};
+
+    while (expected < EVENT_COUNT)
+    {
+        if (queue.pop(event))
+        {
+            ordered = ordered && (event.cycle == expected) && (event.key == (expected & 0xF));
+            ++expected;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+
+    REQUIRE(ordered);
+}
+
+TEST_CASE("Keyboard applies events due at the cycle", "[keyboard]")
+{
+    auto queue = std::make_shared<chip8::InputQueue>();
+    auto keyboard = chip8::KeyboardImpl{ queue };
+
+    queue->push(InputEvent{ 10, InputEvent::Type::KEY_DOWN, 0x3 });
+    queue->push(InputEvent{ 10, InputEvent::Type::KEY_DOWN, 0xC });
+    queue->push(InputEvent{ 20, InputEvent::Type::KEY_UP, 0x3 });
+    queue->push(InputEvent{ 30, InputEvent::Type::QUIT, 0 });
+
+    keyboard.update(9);
+    REQUIRE(keyboard.getKeys() == 0x0000);
+
+    keyboard.update(15);
+    REQUIRE(keyboard.getKeys() == 0x1008);
+    REQUIRE(keyboard.isKeyPressed(0x3));
+    REQUIRE(keyboard.isKeyPressed(0xC));
+    REQUIRE_FALSE(keyboard.isKeyPressed(0x4));
+
+    keyboard.update(20);
+    REQUIRE(keyboard.getKeys() == 0x1000);
+    REQUIRE_FALSE(keyboard.isQuitRequested());
+
+    keyboard.update();
+    REQUIRE(keyboard.isQuitRequested());
+}
+
+TEST_CASE("Keyboard ignores keys past the keypad", "[keyboard]")
+{
+    auto queue = std::make_shared<chip8::InputQueue>();
+    auto keyboard = chip8::KeyboardImpl{ queue };
+
+    queue->push(InputEvent{ 0, InputEvent::Type::KEY_DOWN, 0x10 });
+    queue->push(InputEvent{ 0, InputEvent::Type::KEY_DOWN, 0xFF });
+    queue->push(InputEvent{ 0, InputEvent::Type::KEY_DOWN, 0x5 });
+
+    keyboard.update();
+    REQUIRE(keyboard.getKeys() == 0x0020);
+    REQUIRE(keyboard.isKeyPressed(0x5));
+    REQUIRE_FALSE(keyboard.isKeyPressed(0x15));
+    REQUIRE_FALSE(keyboard.isKeyPressed(0xFFFF));
+}
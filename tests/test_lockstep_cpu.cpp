@@ -0,0 +1,244 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <lockstep_cpu.hpp>
+
+#include "test_vm.hpp"
+
+namespace {
+
+/// @brief ALU heavy loop, with flag operands and a lane dependent skip.
+OpcodeList makeAluProgram()
+{
+    return OpcodeList {
+        chip8::opcode::encode8XY4(0x0, 0x1),    // 0x200
+        chip8::opcode::encode8XY5(0x2, 0x0),    // 0x202
+        chip8::opcode::encode8XY6(0x3, 0x0),    // 0x204
+        chip8::opcode::encode8XYE(0x4, 0x2),    // 0x206
+        chip8::opcode::encode8XY7(0x5, 0x3),    // 0x208
+        chip8::opcode::encode8XY4(0xF, 0x0),    // 0x20A
+        chip8::opcode::encode8XY6(0x6, 0xF),    // 0x20C
+        chip8::opcode::encode8XYE(0xF, 0xF),    // 0x20E
+        chip8::opcode::encode8XY1(0x7, 0x4),    // 0x210
+        chip8::opcode::encode8XY2(0x8, 0x5),    // 0x212
+        chip8::opcode::encode8XY3(0x9, 0x0),    // 0x214
+        chip8::opcode::encode8XY0(0xA, 0x9),    // 0x216
+        chip8::opcode::encode7XKK(0x1, 0x03),   // 0x218
+        chip8::opcode::encode3XKK(0xF, 0x00),   // 0x21A
+        chip8::opcode::encode6XKK(0xB, 0x55),   // 0x21C
+        chip8::opcode::encode1NNN(0x200)        // 0x21E
+    };
+}
+
+/// @brief Convert opcodes to a big endian program image.
+Data toRom(OpcodeList const& opcodes)
+{
+    Data rom;
+
+    for (auto opcode : opcodes)
+    {
+        rom.push_back(opcode >> 8);
+        rom.push_back(opcode & 0xFF);
+    }
+
+    return rom;
+}
+
+} // namespace
+
+TEST_CASE("Lockstep lanes match the scalar CPU", "[lockstep]")
+{
+    const size_t LANE_COUNT = chip8::LockstepCpu::LANES;
+    const uint32_t CYCLES = 4000;
+
+    auto program = makeAluProgram();
+    auto lockstep = chip8::LockstepCpu{ toRom(program), LANE_COUNT };
+
+    REQUIRE(lockstep.getLaneCount() == LANE_COUNT);
+
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        auto regs = lockstep.getLaneContext(lane);
+        regs.vx[0x0] = static_cast<uint8_t>(lane * 37);
+        regs.vx[0x1] = static_cast<uint8_t>(0xFF - lane * 11);
+        lockstep.setLaneContext(lane, regs);
+    }
+
+    lockstep.run(CYCLES);
+
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        auto vm = Chip8TestVm{};
+        vm.storeCode(program);
+
+        auto regs = vm.core().getRegContext();
+        regs.vx[0x0] = static_cast<uint8_t>(lane * 37);
+        regs.vx[0x1] = static_cast<uint8_t>(0xFF - lane * 11);
+        vm.core().setRegContext(regs);
+
+        vm.run(CYCLES);
+
+        auto const& expected = vm.core().getRegContext();
+        auto actual = lockstep.getLaneContext(lane);
+
+        REQUIRE(actual.pc == expected.pc);
+        REQUIRE(actual.i == expected.i);
+        REQUIRE(actual.sp == expected.sp);
+
+        for (uint8_t index = 0; index < chip8::Cpu::REG_COUNT; ++index)
+        {
+            REQUIRE(actual.vx[index] == expected.vx[index]);
+        }
+    }
+
+    REQUIRE(lockstep.getVectorSteps() > 0);
+    REQUIRE(lockstep.getScalarSteps() > 0);
+}
+
+TEST_CASE("Lockstep lanes tick timers independently", "[lockstep]")
+{
+    auto lockstep = chip8::LockstepCpu{ toRom(makeAluProgram()), 3 };
+
+    for (size_t lane = 0; lane < 3; ++lane)
+    {
+        auto regs = lockstep.getLaneContext(lane);
+        regs.dt = static_cast<uint8_t>(lane);
+        regs.st = static_cast<uint8_t>(2 * lane);
+        lockstep.setLaneContext(lane, regs);
+    }
+
+    lockstep.tickTimers();
+    lockstep.tickTimers();
+
+    REQUIRE(lockstep.getLaneContext(0).dt == 0);
+    REQUIRE(lockstep.getLaneContext(1).dt == 0);
+    REQUIRE(lockstep.getLaneContext(2).dt == 0);
+    REQUIRE(lockstep.getLaneContext(0).st == 0);
+    REQUIRE(lockstep.getLaneContext(1).st == 0);
+    REQUIRE(lockstep.getLaneContext(2).st == 2);
+}
+
+TEST_CASE("Lockstep lanes count is capped", "[lockstep]")
+{
+    auto lockstep = chip8::LockstepCpu{ toRom(makeAluProgram()), 40 };
+
+    REQUIRE(lockstep.getLaneCount() == chip8::LockstepCpu::LANES);
+    REQUIRE(lockstep.getRegContext().pc == chip8::Cpu::PROGRAM_START);
+}
+
+TEST_CASE("Lockstep lanes fetch across the end of memory", "[lockstep]")
+{
+    const uint16_t LAST_ADDRESS = 0xFFF;
+
+    auto lockstep = chip8::LockstepCpu{ toRom(makeAluProgram()), 2 };
+
+    for (size_t lane = 0; lane < 2; ++lane)
+    {
+        auto regs = lockstep.getLaneContext(lane);
+        regs.pc = LAST_ADDRESS;
+        lockstep.setLaneContext(lane, regs);
+    }
+
+    auto vm = Chip8TestVm{};
+    vm.storeCode(makeAluProgram());
+
+    auto regs = vm.core().getRegContext();
+    regs.pc = LAST_ADDRESS;
+    vm.core().setRegContext(regs);
+
+    lockstep.run(1);
+    vm.run(1);
+
+    REQUIRE(lockstep.getLaneContext(0).pc == vm.core().getRegContext().pc);
+    REQUIRE(lockstep.getLaneContext(1).pc == vm.core().getRegContext().pc);
+}
+
+TEST_CASE("Lockstep lanes split by branches match the scalar CPU", "[lockstep]")
+{
+    const size_t LANE_COUNT = chip8::LockstepCpu::LANES;
+    const uint32_t RUNS = 64;
+    const uint32_t CYCLES = 37;
+
+    // Lanes skip apart on CXKK, call and set timers at different times
+    auto program = OpcodeList {
+        chip8::opcode::encodeCXKK(0x0, 0x03),   // 0x200
+        chip8::opcode::encode3XKK(0x0, 0x00),   // 0x202
+        chip8::opcode::encode7XKK(0x1, 0x01),   // 0x204
+        chip8::opcode::encodeANNN(0x300),       // 0x206
+        chip8::opcode::encodeFX33(0x3),         // 0x208
+        chip8::opcode::encodeFX65(0x2),         // 0x20A
+        chip8::opcode::encode2NNN(0x214),       // 0x20C
+        chip8::opcode::encode4XKK(0x2, 0x00),   // 0x20E
+        chip8::opcode::encodeFX15(0x2),         // 0x210
+        chip8::opcode::encode1NNN(0x200),       // 0x212
+        chip8::opcode::encode8XY4(0x3, 0x1),    // 0x214
+        chip8::opcode::encodeFX07(0x2),         // 0x216
+        chip8::opcode::encode00EE()             // 0x218
+    };
+
+    auto lockstep = chip8::LockstepCpu{ toRom(program), LANE_COUNT };
+
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        lockstep.seedLane(lane, static_cast<uint32_t>(lane + 1));
+    }
+
+    for (uint32_t run = 0; run < RUNS; ++run)
+    {
+        lockstep.run(CYCLES);
+        lockstep.tickTimers();
+    }
+
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        auto vm = Chip8TestVm{};
+        vm.storeCode(program);
+        vm.core().seedRandom(static_cast<uint32_t>(lane + 1));
+
+        for (uint32_t run = 0; run < RUNS; ++run)
+        {
+            vm.run(CYCLES);
+            vm.tickTimers();
+        }
+
+        auto const& expected = vm.core().getRegContext();
+        auto actual = lockstep.getLaneContext(lane);
+
+        REQUIRE(actual.pc == expected.pc);
+        REQUIRE(actual.i == expected.i);
+        REQUIRE(actual.sp == expected.sp);
+        REQUIRE(actual.dt == expected.dt);
+
+        for (uint8_t index = 0; index < chip8::Cpu::REG_COUNT; ++index)
+        {
+            REQUIRE(actual.vx[index] == expected.vx[index]);
+        }
+
+        for (uint16_t address = 0x300; address < 0x303; ++address)
+        {
+            REQUIRE(lockstep.getLaneMemory(lane).load<uint8_t>(address) == vm.loadData(address));
+        }
+    }
+}
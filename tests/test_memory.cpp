@@ -0,0 +1,104 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <memory.hpp>
+
+namespace {
+
+/// @brief Observer recording the written ranges.
+struct WriteRecorder : public chip8::Memory::WriteObserver
+{
+    void onMemoryWrite(uint16_t address, size_t size) override
+    {
+        writes.push_back({ address, size });
+    }
+
+    std::vector<std::pair<uint16_t, size_t>> writes;
+};
+
+} // namespace
+
+TEST_CASE("Memory addresses wrap around the end", "[memory]")
+{
+    auto memory = chip8::Memory{ };
+
+    memory.store(0x1005, 0xAB);
+    REQUIRE(memory.load<uint8_t>(0x005) == 0xAB);
+    REQUIRE(memory.load<uint8_t>(0xF005) == 0xAB);
+
+    memory.store(0xFFF, 0x12);
+    memory.store(0x000, 0x34);
+    REQUIRE(memory.load<uint16_t>(0xFFF) == 0x1234);
+}
+
+TEST_CASE("Memory ranges wrap around the end", "[memory]")
+{
+    auto memory = chip8::Memory{ };
+    auto recorder = WriteRecorder{};
+    memory.attach(&recorder);
+
+    const uint8_t bytes[] = { 0x01, 0x02, 0x03, 0x04 };
+    memory.storeRange(0xFFE, bytes, sizeof(bytes));
+
+    REQUIRE(memory.load<uint8_t>(0xFFE) == 0x01);
+    REQUIRE(memory.load<uint8_t>(0xFFF) == 0x02);
+    REQUIRE(memory.load<uint8_t>(0x000) == 0x03);
+    REQUIRE(memory.load<uint8_t>(0x001) == 0x04);
+
+    // Observers see the two ranges written
+    REQUIRE(recorder.writes.size() == 2);
+    REQUIRE(recorder.writes[0] == std::make_pair<uint16_t, size_t>(0xFFE, 2));
+    REQUIRE(recorder.writes[1] == std::make_pair<uint16_t, size_t>(0x000, 2));
+
+    uint8_t loaded[4] = { };
+    memory.loadRange(0x1FFE, loaded, sizeof(loaded));
+    REQUIRE(std::equal(std::begin(loaded), std::end(loaded), std::begin(bytes)));
+
+    memory.detach(&recorder);
+}
+
+TEST_CASE("Memory range writes dirty their snapshot pages", "[memory]")
+{
+    auto memory = chip8::Memory{ };
+    auto first = memory.snapshot();
+
+    const uint8_t bytes[] = { 0xAA, 0xBB };
+    memory.storeRange(0xFFF, bytes, sizeof(bytes));
+
+    auto second = memory.snapshot();
+
+    REQUIRE(second.front() != first.front());
+    REQUIRE(second.back() != first.back());
+    REQUIRE((*second.front())[0x00] == 0xBB);
+    REQUIRE((*second.back())[0xFF] == 0xAA);
+
+    for (size_t page = 1; page + 1 < first.size(); ++page)
+    {
+        REQUIRE(second[page] == first[page]);
+    }
+}
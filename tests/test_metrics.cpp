@@ -0,0 +1,190 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <metrics.hpp>
+
+namespace {
+
+/// @brief Read from a descriptor until it is closed.
+std::string readAll(int descriptor)
+{
+    std::string text;
+    char buffer[4096];
+    ssize_t size;
+
+    while ((size = ::read(descriptor, buffer, sizeof(buffer))) > 0)
+    {
+        text.append(buffer, size);
+    }
+
+    return text;
+}
+
+/// @brief Send a request to a local port and read the response.
+std::string request(uint16_t port, std::string const& text)
+{
+    int client = ::socket(AF_INET, SOCK_STREAM, 0);
+
+    struct sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (client < 0 || ::connect(client, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        return "";
+    }
+
+    ::send(client, text.data(), text.size(), 0);
+
+    auto response = readAll(client);
+    ::close(client);
+
+    return response;
+}
+
+} // namespace
+
+TEST_CASE("Histogram buckets grow by four from a microsecond", "[metrics]")
+{
+    REQUIRE(chip8::Histogram::findBucket(0) == 0);
+    REQUIRE(chip8::Histogram::findBucket(1000) == 0);
+    REQUIRE(chip8::Histogram::findBucket(1001) == 1);
+    REQUIRE(chip8::Histogram::findBucket(4000) == 1);
+    REQUIRE(chip8::Histogram::findBucket(4001) == 2);
+    REQUIRE(chip8::Histogram::findBucket(chip8::Histogram::getBound(8)) == 8);
+    REQUIRE(chip8::Histogram::findBucket(chip8::Histogram::getBound(8) + 1) == 9);
+    REQUIRE(chip8::Histogram::findBucket(~0ull) == chip8::Histogram::BUCKET_COUNT - 1);
+
+    auto histogram = chip8::Histogram{};
+
+    histogram.record(500);
+    histogram.record(3000);
+    histogram.record(3500);
+
+    REQUIRE(histogram.getBucket(0) == 1);
+    REQUIRE(histogram.getBucket(1) == 2);
+    REQUIRE(histogram.getCount() == 3);
+    REQUIRE(histogram.getSum() == 7000);
+}
+
+TEST_CASE("Metrics format in Prometheus text format", "[metrics]")
+{
+    auto metrics = chip8::Metrics{ 500 };
+
+    metrics.instructions.add(1200);
+    metrics.frames.add(3);
+    metrics.droppedFrames.set(1);
+    metrics.gpuDraw.record(2000);
+    metrics.gpuDraw.record(20000);
+
+    auto text = metrics.format("rom=\"" + chip8::escapeLabel("a\"b") + "\"");
+
+    REQUIRE(text.find("# TYPE chip8_instructions_total counter\n") != std::string::npos);
+    REQUIRE(text.find("chip8_instructions_total{rom=\"a\\\"b\"} 1200\n") != std::string::npos);
+    REQUIRE(text.find("chip8_frames_total{rom=\"a\\\"b\"} 3\n") != std::string::npos);
+    REQUIRE(text.find("chip8_frames_dropped_total{rom=\"a\\\"b\"} 1\n") != std::string::npos);
+    REQUIRE(text.find("chip8_cpu_rate_hertz{rom=\"a\\\"b\"} 500\n") != std::string::npos);
+
+    // Buckets are cumulative
+    REQUIRE(text.find("chip8_gpu_draw_seconds_bucket{rom=\"a\\\"b\",le=\"1e-06\"} 0\n") != std::string::npos);
+    REQUIRE(text.find("chip8_gpu_draw_seconds_bucket{rom=\"a\\\"b\",le=\"4e-06\"} 1\n") != std::string::npos);
+    REQUIRE(text.find("chip8_gpu_draw_seconds_bucket{rom=\"a\\\"b\",le=\"6.4e-05\"} 2\n") != std::string::npos);
+    REQUIRE(text.find("chip8_gpu_draw_seconds_bucket{rom=\"a\\\"b\",le=\"+Inf\"} 2\n") != std::string::npos);
+    REQUIRE(text.find("chip8_gpu_draw_seconds_sum{rom=\"a\\\"b\"} 0.000022000\n") != std::string::npos);
+    REQUIRE(text.find("chip8_gpu_draw_seconds_count{rom=\"a\\\"b\"} 2\n") != std::string::npos);
+
+    // Without labels, samples have no braces
+    REQUIRE(metrics.format("").find("\nchip8_frames_total 3\n") != std::string::npos);
+}
+
+TEST_CASE("Metrics exporter pushes snapshots until stopped", "[metrics]")
+{
+    int pipe[2];
+    REQUIRE(::pipe(pipe) == 0);
+
+    auto metrics = chip8::Metrics{ 500 };
+    metrics.instructions.add(42);
+
+    {
+        auto exporter = chip8::MetricsExporter{ metrics, "", 10 };
+
+        REQUIRE(exporter.open("fd:" + std::to_string(pipe[1])));
+        exporter.start();
+        exporter.stop();
+
+        // Stopping writes a last snapshot
+        REQUIRE(exporter.getSnapshotCount() >= 1);
+    }
+
+    ::close(pipe[1]);
+
+    auto text = readAll(pipe[0]);
+    ::close(pipe[0]);
+
+    REQUIRE(text.find("chip8_instructions_total 42\n") != std::string::npos);
+    REQUIRE(text.substr(text.size() - 2) == "\n\n");
+}
+
+TEST_CASE("Metrics exporter rejects invalid descriptors", "[metrics]")
+{
+    auto metrics = chip8::Metrics{ 500 };
+    auto exporter = chip8::MetricsExporter{ metrics, "", 10 };
+
+    REQUIRE_FALSE(exporter.open("fd:"));
+    REQUIRE_FALSE(exporter.open("fd:abc"));
+    REQUIRE_FALSE(exporter.open("fd:3x"));
+    REQUIRE_FALSE(exporter.open("fd:-1"));
+    REQUIRE_FALSE(exporter.open("fd:99999999999"));
+}
+
+TEST_CASE("Metrics exporter serves scrapes over HTTP", "[metrics]")
+{
+    auto metrics = chip8::Metrics{ 500 };
+    metrics.frames.add(7);
+
+    auto exporter = chip8::MetricsExporter{ metrics, "rom=\"pong\"" };
+
+    REQUIRE(exporter.open("http:127.0.0.1:0"));
+    REQUIRE(exporter.getPort() != 0);
+    exporter.start();
+
+    auto response = request(exporter.getPort(), "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+    REQUIRE(response.compare(0, 15, "HTTP/1.0 200 OK") == 0);
+    REQUIRE(response.find("Content-Type: text/plain; version=0.0.4\r\n") != std::string::npos);
+    REQUIRE(response.find("chip8_frames_total{rom=\"pong\"} 7\n") != std::string::npos);
+
+    response = request(exporter.getPort(), "GET / HTTP/1.1\r\n\r\n");
+    REQUIRE(response.compare(0, 22, "HTTP/1.0 404 Not Found") == 0);
+
+    exporter.stop();
+    REQUIRE(exporter.getSnapshotCount() == 1);
+}
@@ -0,0 +1,98 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include <framebuffer.hpp>
+#include <pixel_expand.hpp>
+
+using chip8::Framebuffer;
+
+namespace {
+
+const chip8::pixel::Palette TEST_PALETTE{ 0x10203040, 0xA0B0C0D0 };
+
+} // namespace
+
+TEST_CASE("Vector expansion matches scalar expansion", "[pixel]")
+{
+    auto scale = GENERATE(Catch::Generators::range(1u, 17u));
+
+    std::mt19937_64 generator{ scale };
+    auto rowPixels = chip8::pixel::ROW_WIDTH * scale;
+
+    std::vector<chip8::pixel::Pixel> expected(rowPixels);
+    std::vector<chip8::pixel::Pixel> pixels(rowPixels);
+
+    for (int iteration = 0; iteration < 64; ++iteration)
+    {
+        uint64_t row = generator();
+
+        chip8::pixel::expandRowScalar(row, TEST_PALETTE, scale, expected.data());
+        chip8::pixel::expandRow(row, TEST_PALETTE, scale, pixels.data());
+
+        REQUIRE(pixels == expected);
+    }
+}
+
+TEST_CASE("Scalar expansion selects palette colors", "[pixel]")
+{
+    std::vector<chip8::pixel::Pixel> pixels(chip8::pixel::ROW_WIDTH * 2);
+
+    chip8::pixel::expandRowScalar(0x8000000000000001ULL, TEST_PALETTE, 2, pixels.data());
+
+    REQUIRE(pixels[0] == TEST_PALETTE.on);
+    REQUIRE(pixels[1] == TEST_PALETTE.on);
+    REQUIRE(pixels[2] == TEST_PALETTE.off);
+    REQUIRE(pixels[125] == TEST_PALETTE.off);
+    REQUIRE(pixels[126] == TEST_PALETTE.on);
+    REQUIRE(pixels[127] == TEST_PALETTE.on);
+}
+
+TEST_CASE("Framebuffer expands scaled frame with pitch", "[pixel]")
+{
+    const uint32_t SCALE = 3;
+    const size_t PADDING = 5;
+    const size_t LINE_PIXELS = Framebuffer::DISPLAY_WIDTH * SCALE + PADDING;
+
+    auto framebuffer = Framebuffer{};
+    framebuffer.setPixel(1, 1, 1);
+
+    std::vector<chip8::pixel::Pixel> pixels(LINE_PIXELS * Framebuffer::DISPLAY_HEIGHT * SCALE, 0);
+    framebuffer.expand(pixels.data(), LINE_PIXELS * Framebuffer::PIXEL_SIZE, TEST_PALETTE, SCALE);
+
+    for (size_t y = 0; y < 2 * SCALE; ++y)
+    {
+        for (size_t x = 0; x < 2 * SCALE; ++x)
+        {
+            bool lit = (x >= SCALE) && (y >= SCALE);
+            REQUIRE(pixels[y * LINE_PIXELS + x] == (lit ? TEST_PALETTE.on : TEST_PALETTE.off));
+        }
+
+        // Padding is left untouched
+        REQUIRE(pixels[y * LINE_PIXELS + LINE_PIXELS - 1] == 0);
+    }
+}
@@ -0,0 +1,156 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include <random.hpp>
+
+using chip8::Random;
+
+namespace {
+
+/// @brief Draw bytes from a generator.
+std::vector<uint8_t> draw(Random & random, size_t count)
+{
+    std::vector<uint8_t> bytes(count);
+
+    for (auto & byte : bytes)
+    {
+        byte = random.next();
+    }
+
+    return bytes;
+}
+
+} // namespace
+
+TEST_CASE("Random sequences follow their seed", "[random]")
+{
+    auto algorithm = GENERATE(Random::Algorithm::PCG32, Random::Algorithm::MT19937);
+
+    auto first = Random{ algorithm, 7 };
+    auto second = Random{ algorithm, 7 };
+    auto other = Random{ algorithm, 8 };
+
+    auto bytes = draw(first, 256);
+
+    REQUIRE(draw(second, 256) == bytes);
+    REQUIRE(draw(other, 256) != bytes);
+
+    first.seed(7);
+    REQUIRE(draw(first, 256) == bytes);
+}
+
+TEST_CASE("Random default is PCG32 with the mt19937 default seed", "[random]")
+{
+    auto random = Random{};
+    auto seeded = Random{ Random::Algorithm::PCG32, std::mt19937::default_seed };
+
+    REQUIRE(random.getAlgorithm() == Random::Algorithm::PCG32);
+    REQUIRE(draw(random, 64) == draw(seeded, 64));
+}
+
+TEST_CASE("Random mt19937 keeps the previous CXKK sequence", "[random]")
+{
+    auto random = Random{ Random::Algorithm::MT19937, 99 };
+    std::mt19937 generator{ 99 };
+    std::uniform_int_distribution<uint8_t> distribution{ };
+
+    for (int index = 0; index < 1000; ++index)
+    {
+        REQUIRE(random.next() == distribution(generator));
+    }
+}
+
+TEST_CASE("Random PCG32 bytes are evenly spread", "[random]")
+{
+    auto random = Random{ Random::Algorithm::PCG32, 1 };
+    std::array<uint32_t, 256> counts{ };
+
+    for (int index = 0; index < 256 * 256; ++index)
+    {
+        ++counts[random.next()];
+    }
+
+    for (auto count : counts)
+    {
+        REQUIRE(count > 128);
+        REQUIRE(count < 384);
+    }
+}
+
+TEST_CASE("Random copies continue independently", "[random]")
+{
+    auto algorithm = GENERATE(Random::Algorithm::PCG32, Random::Algorithm::MT19937);
+
+    auto random = Random{ algorithm, 3 };
+    draw(random, 10);
+
+    auto copy = random;
+    auto expected = draw(random, 100);
+
+    REQUIRE(draw(copy, 100) == expected);
+
+    auto assigned = Random{ Random::Algorithm::MT19937 };
+    assigned = copy;
+
+    REQUIRE(assigned.getAlgorithm() == algorithm);
+    REQUIRE(draw(assigned, 100) == draw(copy, 100));
+}
+
+TEST_CASE("Random state saves and loads", "[random]")
+{
+    auto algorithm = GENERATE(Random::Algorithm::PCG32, Random::Algorithm::MT19937);
+
+    auto random = Random{ algorithm, 11 };
+    draw(random, 33);
+
+    std::array<uint32_t, Random::STATE_CAPACITY> words{ };
+    size_t count = random.save(words.data(), words.size());
+
+    REQUIRE(count == (algorithm == Random::Algorithm::PCG32 ? 2 : Random::STATE_CAPACITY));
+    REQUIRE(random.save(words.data(), count - 1) == 0);
+
+    auto loaded = Random{};
+    REQUIRE(loaded.load(algorithm, words.data(), count));
+    REQUIRE(loaded.getAlgorithm() == algorithm);
+    REQUIRE(draw(loaded, 100) == draw(random, 100));
+
+    REQUIRE_FALSE(loaded.load(algorithm, words.data(), 1));
+    REQUIRE_FALSE(loaded.load(static_cast<Random::Algorithm>(7), words.data(), count));
+}
+
+TEST_CASE("Random algorithms parse by name", "[random]")
+{
+    auto algorithm = Random::Algorithm::PCG32;
+
+    REQUIRE(Random::parseAlgorithm("mt19937", algorithm));
+    REQUIRE(algorithm == Random::Algorithm::MT19937);
+    REQUIRE(Random::parseAlgorithm("pcg32", algorithm));
+    REQUIRE(algorithm == Random::Algorithm::PCG32);
+    REQUIRE_FALSE(Random::parseAlgorithm("xorshift", algorithm));
+}
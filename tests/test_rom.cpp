@@ -0,0 +1,134 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+
+#include <fontset.hpp>
+#include <rom.hpp>
+
+#include "test_vm.hpp"
+
+namespace {
+
+/// @brief Write a file.
+void writeFile(std::string const& filename, Data const& bytes)
+{
+    std::FILE * file = std::fopen(filename.c_str(), "wb");
+    REQUIRE(file != nullptr);
+    REQUIRE(std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size());
+    std::fclose(file);
+}
+
+} // namespace
+
+TEST_CASE("ROM file is loaded as is", "[rom]")
+{
+    writeFile("test_rom.ch8", Data{ 0x60, 0x11, 0x12, 0x00, 0xAB });
+
+    auto rom = chip8::Rom{};
+    REQUIRE(rom.load("test_rom.ch8"));
+    std::remove("test_rom.ch8");
+
+    REQUIRE(rom.size() == 5);
+
+    auto memory = chip8::Memory{ };
+    memory.store(chip8::Cpu::PROGRAM_START + 5, 0x5A);
+
+    chip8::loadProgram(memory, rom);
+
+    REQUIRE(memory.load<uint16_t>(chip8::Cpu::PROGRAM_START) == 0x6011);
+    REQUIRE(memory.load<uint8_t>(chip8::Cpu::PROGRAM_START + 4) == 0xAB);
+    // Nothing is written past the program
+    REQUIRE(memory.load<uint8_t>(chip8::Cpu::PROGRAM_START + 5) == 0x5A);
+
+    for (size_t address = 0; address < chip8::FONT_SET_SIZE; ++address)
+    {
+        REQUIRE(memory.load<uint8_t>(address) == chip8::FONT_SET[address]);
+    }
+}
+
+TEST_CASE("ROM size is validated", "[rom]")
+{
+    auto rom = chip8::Rom{};
+
+    SECTION("Missing file")
+    {
+        REQUIRE_FALSE(rom.load("test_rom_missing.ch8"));
+    }
+
+    SECTION("Empty file")
+    {
+        writeFile("test_rom_empty.ch8", Data{});
+        REQUIRE_FALSE(rom.load("test_rom_empty.ch8"));
+        std::remove("test_rom_empty.ch8");
+    }
+
+    SECTION("Largest file")
+    {
+        writeFile("test_rom_full.ch8", Data(chip8::Rom::MAX_SIZE, 0x12));
+        REQUIRE(rom.load("test_rom_full.ch8"));
+        REQUIRE(rom.size() == chip8::Rom::MAX_SIZE);
+        std::remove("test_rom_full.ch8");
+    }
+
+    SECTION("File too large")
+    {
+        writeFile("test_rom_large.ch8", Data(chip8::Rom::MAX_SIZE + 1, 0x12));
+        REQUIRE_FALSE(rom.load("test_rom_large.ch8"));
+        std::remove("test_rom_large.ch8");
+    }
+
+    SECTION("Buffer too large")
+    {
+        auto bytes = Data(chip8::Rom::MAX_SIZE + 1, 0x12);
+        REQUIRE_FALSE(rom.load(bytes.data(), bytes.size()));
+        REQUIRE(rom.load(bytes.data(), chip8::Rom::MAX_SIZE));
+    }
+
+    REQUIRE(rom.size() <= chip8::Rom::MAX_SIZE);
+}
+
+TEST_CASE("ROM catalogue shares images", "[rom]")
+{
+    writeFile("test_rom_catalogue.ch8", Data{ 0x12, 0x00 });
+
+    auto catalogue = chip8::RomCatalogue{};
+    REQUIRE(catalogue.add("test_rom_catalogue.ch8"));
+    REQUIRE(catalogue.add("test_rom_catalogue.ch8"));
+    REQUIRE_FALSE(catalogue.add("test_rom_missing.ch8"));
+    std::remove("test_rom_catalogue.ch8");
+
+    catalogue.add("counter", chip8::Rom{ Data{ 0x70, 0x01, 0x12, 0x00 } });
+
+    REQUIRE(catalogue.size() == 2);
+    REQUIRE(catalogue.find("missing") == nullptr);
+
+    auto found = catalogue.find("test_rom_catalogue.ch8");
+    REQUIRE(found != nullptr);
+
+    auto copy = *found;
+    REQUIRE(copy.data() == found->data());
+    REQUIRE(catalogue.find("counter")->size() == 4);
+}
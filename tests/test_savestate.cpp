@@ -0,0 +1,236 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <cstdio>
+
+#include <rom.hpp>
+#include <headless.hpp>
+#include <savestate.hpp>
+
+#include "test_vm.hpp"
+
+namespace {
+
+/// @brief Machine drawing to a real framebuffer.
+struct Machine
+{
+    Machine()
+        : memory{ }
+        , cpu{ chip8::borrow(memory), chip8::borrow(keyboard), chip8::borrow(gpu) }
+    {
+    }
+
+    chip8::Snapshot snapshot()
+    {
+        return chip8::takeSnapshot(cpu, memory, gpu.getFramebuffer());
+    }
+
+    chip8::Memory memory;
+    chip8::HeadlessGpu gpu;
+    chip8::HeadlessKeyboard keyboard;
+    chip8::CpuImpl cpu;
+};
+
+/// @brief Program drawing random digits and calling a subroutine.
+///
+/// 0x200 RND V0, 0F; 0x202 LD F, V0; 0x204 DRW V1, V0, 5; 0x206 CALL 0x20A;
+/// 0x208 JP 0x200; 0x20A ADD V1, 3; 0x20C RET
+OpcodeList makeProgram()
+{
+    return OpcodeList {
+        chip8::opcode::encodeCXKK(0x0, 0x0F),
+        chip8::opcode::encodeFX29(0x0),
+        chip8::opcode::encodeDXYN(0x1, 0x0, 5),
+        chip8::opcode::encode2NNN(0x20A),
+        chip8::opcode::encode1NNN(0x200),
+        chip8::opcode::encode7XKK(0x1, 0x03),
+        chip8::opcode::encode00EE()
+    };
+}
+
+/// @brief Read a whole file.
+Data readFile(std::string const& filename)
+{
+    Data bytes;
+    std::FILE * file = std::fopen(filename.c_str(), "rb");
+    REQUIRE(file != nullptr);
+
+    int byte = 0;
+
+    while ((byte = std::fgetc(file)) != EOF)
+    {
+        bytes.push_back(static_cast<uint8_t>(byte));
+    }
+
+    std::fclose(file);
+
+    return bytes;
+}
+
+/// @brief Write a whole file.
+void writeFile(std::string const& filename, Data const& bytes)
+{
+    std::FILE * file = std::fopen(filename.c_str(), "wb");
+    REQUIRE(file != nullptr);
+    REQUIRE(std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size());
+    std::fclose(file);
+}
+
+} // namespace
+
+TEST_CASE("Savestate resumes the saved machine", "[savestate]")
+{
+    auto program = makeProgram();
+    auto algorithm = GENERATE(chip8::Random::Algorithm::PCG32, chip8::Random::Algorithm::MT19937);
+
+    auto saved = Machine{};
+    chip8::loadProgram(saved.memory, { });
+    saved.memory.storeBuffer(chip8::Cpu::PROGRAM_START, program, chip8::Memory::Endian::LITTLE);
+
+    auto state = saved.cpu.getState();
+    state.random = chip8::Random{ algorithm, 99 };
+    saved.cpu.setState(state);
+    saved.cpu.run(1003);
+
+    REQUIRE(chip8::saveState("test_state.bin", saved.snapshot()));
+
+    auto mapped = chip8::MappedSavestate{};
+    REQUIRE(mapped.open("test_state.bin"));
+    REQUIRE(mapped.image()->pc == saved.cpu.getRegContext().pc);
+    REQUIRE(mapped.image()->randomAlgorithm == static_cast<uint8_t>(algorithm));
+
+    auto resumed = Machine{};
+    mapped.restore(resumed.cpu, resumed.memory, resumed.gpu.getFramebuffer());
+    mapped.close();
+
+    std::remove("test_state.bin");
+
+    saved.cpu.run(2000);
+    resumed.cpu.run(2000);
+
+    auto const& expected = saved.cpu.getRegContext();
+    auto const& actual = resumed.cpu.getRegContext();
+
+    REQUIRE(actual.pc == expected.pc);
+    REQUIRE(actual.sp == expected.sp);
+    REQUIRE(actual.i == expected.i);
+    REQUIRE(actual.stack[0] == expected.stack[0]);
+
+    for (uint8_t index = 0; index < chip8::Cpu::REG_COUNT; ++index)
+    {
+        REQUIRE(actual.vx[index] == expected.vx[index]);
+    }
+
+    for (uint32_t y = 0; y < chip8::Framebuffer::DISPLAY_HEIGHT; ++y)
+    {
+        REQUIRE(resumed.gpu.framebuffer().rows()[y] == saved.gpu.framebuffer().rows()[y]);
+    }
+}
+
+TEST_CASE("Savestate files are byte stable", "[savestate]")
+{
+    auto first = Machine{};
+    auto second = Machine{};
+
+    for (auto machine : { &first, &second })
+    {
+        machine->memory.storeBuffer(chip8::Cpu::PROGRAM_START, makeProgram(), chip8::Memory::Endian::LITTLE);
+        machine->cpu.run(321);
+    }
+
+    REQUIRE(chip8::saveState("test_state_a.bin", first.snapshot()));
+    REQUIRE(chip8::saveState("test_state_b.bin", second.snapshot()));
+
+    auto bytesA = readFile("test_state_a.bin");
+    auto bytesB = readFile("test_state_b.bin");
+
+    std::remove("test_state_a.bin");
+    std::remove("test_state_b.bin");
+
+    REQUIRE(bytesA.size() == sizeof(chip8::SavestateImage));
+    REQUIRE(bytesA == bytesB);
+}
+
+TEST_CASE("Savestate rejects invalid files", "[savestate]")
+{
+    auto mapped = chip8::MappedSavestate{};
+
+    REQUIRE_FALSE(mapped.open("test_state_missing.bin"));
+
+    std::FILE * file = std::fopen("test_state_short.bin", "wb");
+    REQUIRE(file != nullptr);
+    std::fputs("C8SS", file);
+    std::fclose(file);
+
+    REQUIRE_FALSE(mapped.open("test_state_short.bin"));
+    REQUIRE(mapped.image() == nullptr);
+
+    std::remove("test_state_short.bin");
+}
+
+TEST_CASE("Savestate rejects out of range registers", "[savestate]")
+{
+    Machine machine;
+    REQUIRE(chip8::saveState("test_state_valid.bin", machine.snapshot()));
+
+    auto valid = readFile("test_state_valid.bin");
+    auto mapped = chip8::MappedSavestate{};
+
+    REQUIRE(mapped.open("test_state_valid.bin"));
+    mapped.close();
+
+    auto corrupt = [&valid](size_t offset, uint8_t value) {
+        Data bytes = valid;
+        bytes[offset] = value;
+        return bytes;
+    };
+
+    SECTION("Stack pointer past the stack")
+    {
+        writeFile("test_state_bad.bin", corrupt(offsetof(chip8::SavestateImage, sp), chip8::Cpu::STACK_SIZE + 1));
+    }
+
+    SECTION("Program counter past memory")
+    {
+        writeFile("test_state_bad.bin", corrupt(offsetof(chip8::SavestateImage, pc) + 1, 0x10));
+    }
+
+    SECTION("I register past memory")
+    {
+        writeFile("test_state_bad.bin", corrupt(offsetof(chip8::SavestateImage, i) + 1, 0x10));
+    }
+
+    SECTION("Unknown random algorithm")
+    {
+        writeFile("test_state_bad.bin", corrupt(offsetof(chip8::SavestateImage, randomAlgorithm), 0xFF));
+    }
+
+    REQUIRE_FALSE(mapped.open("test_state_bad.bin"));
+    REQUIRE(mapped.image() == nullptr);
+
+    std::remove("test_state_valid.bin");
+    std::remove("test_state_bad.bin");
+}
@@ -0,0 +1,206 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <limits>
+#include <vector>
+
+#include <metrics.hpp>
+#include <scheduler.hpp>
+
+namespace {
+
+/// @brief CPU recording the spans it is asked to run.
+class CountingCpu : public chip8::Cpu
+{
+    public:
+        void reset() override {}
+        void update() override { run(1); }
+
+        uint32_t run(uint32_t cycles) override
+        {
+            spans.push_back(cycles);
+            return cycles;
+        }
+
+        void tickTimers() override { ++timerTicks; }
+
+        void enableTraces() override {}
+        void disableTraces() override {}
+        RegContext const& getRegContext() const override { return regs_; }
+        chip8::opcode::Opcode getOpcode() const override { return 0x0000; }
+        bool isWaitingForKey() const override { return false; }
+        State getState() const override { return State{ regs_, {} }; }
+        void setState(State const& state) override { regs_ = state.regs; }
+
+        std::vector<uint32_t> spans;
+        uint32_t timerTicks = 0;
+
+    private:
+        RegContext regs_ = {};
+};
+
+} // namespace
+
+TEST_CASE("Scheduler runs requested cycles", "[scheduler]")
+{
+    auto cpu = std::make_shared<CountingCpu>();
+    auto scheduler = chip8::Scheduler{ cpu, 500 };
+
+    REQUIRE(scheduler.run(1000) == 1000);
+    REQUIRE(scheduler.getCycles() == 1000);
+    REQUIRE(cpu->spans == std::vector<uint32_t>{ 1000 });
+}
+
+TEST_CASE("Scheduler fires events on emulated cycles", "[scheduler]")
+{
+    auto cpu = std::make_shared<CountingCpu>();
+    auto scheduler = chip8::Scheduler{ cpu, 500 };
+
+    std::vector<uint64_t> firedCycles;
+
+    scheduler.addEvent(60, [&] {
+        cpu->tickTimers();
+        firedCycles.push_back(scheduler.getCycles());
+    });
+
+    SECTION("Events fire at n * rate / hz rounded up")
+    {
+        scheduler.run(50);
+
+        REQUIRE(firedCycles == std::vector<uint64_t>{ 9, 17, 25, 34, 42, 50 });
+        REQUIRE(cpu->timerTicks == 6);
+        REQUIRE(cpu->spans == std::vector<uint32_t>{ 9, 8, 8, 9, 8, 8 });
+    }
+
+    SECTION("Event timing does not depend on run slicing")
+    {
+        for (int slice = 0; slice < 50; ++slice)
+        {
+            scheduler.run(1);
+        }
+
+        REQUIRE(firedCycles == std::vector<uint64_t>{ 9, 17, 25, 34, 42, 50 });
+    }
+
+    SECTION("Event added later keeps its phase")
+    {
+        std::vector<uint64_t> lateCycles;
+
+        scheduler.run(20);
+        scheduler.addEvent(100, [&] { lateCycles.push_back(scheduler.getCycles()); });
+        scheduler.run(10);
+
+        REQUIRE(lateCycles == std::vector<uint64_t>{ 25, 30 });
+    }
+}
+
+TEST_CASE("Scheduler fires simultaneous events in order", "[scheduler]")
+{
+    auto cpu = std::make_shared<CountingCpu>();
+    auto scheduler = chip8::Scheduler{ cpu, 120 };
+
+    std::vector<int> order;
+
+    scheduler.addEvent(60, [&] { order.push_back(1); });
+    scheduler.addEvent(60, [&] { order.push_back(2); });
+
+    scheduler.run(4);
+
+    REQUIRE(order == std::vector<int>{ 1, 2, 1, 2 });
+}
+
+TEST_CASE("Scheduler fires events faster than the CPU", "[scheduler]")
+{
+    auto cpu = std::make_shared<CountingCpu>();
+    auto scheduler = chip8::Scheduler{ cpu, 60 };
+
+    uint32_t fired = 0;
+
+    scheduler.addEvent(120, [&] { ++fired; });
+    scheduler.run(3);
+
+    REQUIRE(fired == 6);
+}
+
+TEST_CASE("Scheduler stops when an event requests it", "[scheduler]")
+{
+    auto cpu = std::make_shared<CountingCpu>();
+    auto scheduler = chip8::Scheduler{ cpu, 1000 };
+
+    scheduler.addEvent(100, [&] {
+        if (scheduler.getCycles() == 30)
+        {
+            scheduler.stop();
+        }
+    });
+
+    REQUIRE(scheduler.run(1000) == 30);
+    REQUIRE(scheduler.isStopped());
+
+    REQUIRE(scheduler.run(5) == 5);
+    REQUIRE_FALSE(scheduler.isStopped());
+}
+
+TEST_CASE("Scheduler measures CPU runs", "[scheduler]")
+{
+    auto cpu = std::make_shared<CountingCpu>();
+    auto scheduler = chip8::Scheduler{ cpu, 500 };
+    auto metrics = chip8::Metrics{ 500 };
+
+    scheduler.setMetrics(&metrics);
+    scheduler.addEvent(60, [] {});
+
+    REQUIRE(scheduler.run(50000) == 50000);
+    REQUIRE(metrics.instructions.get() == 50000);
+    // The first run is timed, then one per sample period
+    auto samples = (cpu->spans.size() + chip8::Histogram::SAMPLE_PERIOD - 1) / chip8::Histogram::SAMPLE_PERIOD;
+    REQUIRE(metrics.cpuRun.getCount() == samples);
+
+    scheduler.setMetrics(nullptr);
+    scheduler.run(500);
+    REQUIRE(metrics.instructions.get() == 50000);
+}
+
+TEST_CASE("Scheduler runs until stopped from any cycle", "[scheduler]")
+{
+    auto cpu = std::make_shared<CountingCpu>();
+    auto scheduler = chip8::Scheduler{ cpu, 500 };
+    bool armed = false;
+    uint32_t ticks = 0;
+
+    scheduler.addEvent(60, [&scheduler, &armed, &ticks] {
+        if (armed && ++ticks == 2)
+        {
+            scheduler.stop();
+        }
+    });
+
+    REQUIRE(scheduler.run(100) == 100);
+    armed = true;
+
+    // The stop cycle saturates instead of wrapping around
+    REQUIRE(scheduler.run(std::numeric_limits<uint64_t>::max()) > 0);
+    REQUIRE(ticks == 2);
+}
@@ -0,0 +1,176 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+
+#include <rom.hpp>
+#include <headless.hpp>
+#include <snapshot.hpp>
+
+#include "test_vm.hpp"
+
+namespace {
+
+/// @brief Machine drawing to a real framebuffer.
+struct Machine
+{
+    Machine(OpcodeList const& program)
+        : memory{ }
+        , cpu{ chip8::borrow(memory), chip8::borrow(keyboard), chip8::borrow(gpu) }
+    {
+        chip8::loadProgram(memory, { });
+        memory.storeBuffer(chip8::Cpu::PROGRAM_START, program, chip8::Memory::Endian::LITTLE);
+        cpu.seedRandom(1234);
+    }
+
+    chip8::Snapshot snapshot()
+    {
+        return chip8::takeSnapshot(cpu, memory, gpu.getFramebuffer());
+    }
+
+    void restore(chip8::Snapshot const& snapshot)
+    {
+        chip8::restoreSnapshot(snapshot, cpu, memory, gpu.getFramebuffer());
+    }
+
+    chip8::Memory memory;
+    chip8::HeadlessGpu gpu;
+    chip8::HeadlessKeyboard keyboard;
+    chip8::CpuImpl cpu;
+};
+
+/// @brief Program drawing random digits and storing registers.
+///
+/// 0x200 RND V0, 0F; 0x202 LD F, V0; 0x204 DRW V1, V2, 5; 0x206 ADD V1, 5;
+/// 0x208 LD I, 0x400; 0x20A LD [I], V2; 0x20C ADD V2, 1; 0x20E JP 0x200
+OpcodeList makeProgram()
+{
+    return OpcodeList {
+        chip8::opcode::encodeCXKK(0x0, 0x0F),
+        chip8::opcode::encodeFX29(0x0),
+        chip8::opcode::encodeDXYN(0x1, 0x2, 5),
+        chip8::opcode::encode7XKK(0x1, 0x05),
+        chip8::opcode::encodeANNN(0x400),
+        chip8::opcode::encodeFX55(0x2),
+        chip8::opcode::encode7XKK(0x2, 0x01),
+        chip8::opcode::encode1NNN(0x200)
+    };
+}
+
+/// @brief Compare two machines.
+void requireSameState(Machine & actual, Machine & expected)
+{
+    auto const& actualRegs = actual.cpu.getRegContext();
+    auto const& expectedRegs = expected.cpu.getRegContext();
+
+    REQUIRE(actualRegs.pc == expectedRegs.pc);
+    REQUIRE(actualRegs.i == expectedRegs.i);
+    REQUIRE(actualRegs.sp == expectedRegs.sp);
+
+    for (uint8_t index = 0; index < chip8::Cpu::REG_COUNT; ++index)
+    {
+        REQUIRE(actualRegs.vx[index] == expectedRegs.vx[index]);
+    }
+
+    for (size_t address = 0; address < chip8::SYSTEM_MEMORY_SIZE; ++address)
+    {
+        REQUIRE(actual.memory.data()[address] == expected.memory.data()[address]);
+    }
+
+    for (uint32_t y = 0; y < chip8::Framebuffer::DISPLAY_HEIGHT; ++y)
+    {
+        REQUIRE(actual.gpu.framebuffer().rows()[y] == expected.gpu.framebuffer().rows()[y]);
+    }
+}
+
+} // namespace
+
+TEST_CASE("Memory snapshots share unwritten pages", "[snapshot]")
+{
+    auto memory = chip8::Memory{ };
+
+    auto first = memory.snapshot();
+    memory.store(0x305, 0xAB);
+    auto second = memory.snapshot();
+
+    REQUIRE(first.size() == chip8::SYSTEM_MEMORY_SIZE / chip8::Memory::PAGE_SIZE);
+    REQUIRE(second.size() == first.size());
+
+    for (size_t page = 0; page < first.size(); ++page)
+    {
+        if (page == 0x305 / chip8::Memory::PAGE_SIZE)
+        {
+            REQUIRE(second[page] != first[page]);
+            REQUIRE((*second[page])[0x05] == 0xAB);
+            REQUIRE((*first[page])[0x05] == 0x00);
+        }
+        else
+        {
+            REQUIRE(second[page] == first[page]);
+        }
+    }
+
+    memory.restore(first);
+
+    REQUIRE(memory.load<uint8_t>(0x305) == 0x00);
+}
+
+TEST_CASE("Restored machine replays the same execution", "[snapshot]")
+{
+    auto program = makeProgram();
+    auto machine = Machine{ program };
+
+    machine.cpu.run(500);
+    auto snapshot = machine.snapshot();
+    machine.cpu.run(700);
+
+    auto expected = Machine{ program };
+    expected.cpu.run(1200);
+
+    requireSameState(machine, expected);
+
+    // Diverge, then rewind and replay
+    machine.cpu.seedRandom(42);
+    machine.cpu.run(300);
+    machine.restore(snapshot);
+    machine.cpu.run(700);
+
+    requireSameState(machine, expected);
+}
+
+TEST_CASE("Restored code is decoded again", "[snapshot]")
+{
+    auto machine = Machine{ OpcodeList{ chip8::opcode::encode6XKK(0x0, 0x11) } };
+    auto snapshot = machine.snapshot();
+
+    machine.memory.storeBuffer(chip8::Cpu::PROGRAM_START, OpcodeList{ chip8::opcode::encode6XKK(0x0, 0x22) },
+                               chip8::Memory::Endian::LITTLE);
+    machine.cpu.update();
+
+    REQUIRE(machine.cpu.getRegContext().vx[0x0] == 0x22);
+
+    machine.restore(snapshot);
+    machine.cpu.update();
+
+    REQUIRE(machine.cpu.getRegContext().vx[0x0] == 0x11);
+}
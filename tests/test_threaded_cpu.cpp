@@ -0,0 +1,238 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+#include <cstring>
+
+#include <headless.hpp>
+#include <memory.hpp>
+#include <rom.hpp>
+#include <threaded_cpu.hpp>
+
+#include "test_vm.hpp"
+
+using ThreadedTestVm = BasicTestVm<chip8::ThreadedCpu>;
+
+namespace {
+
+/// @brief Subroutine call in a counted loop.
+OpcodeList const LOOP_PROGRAM = {
+    chip8::opcode::encode6XKK(0, 0x00),
+    chip8::opcode::encode6XKK(1, 0x05),
+    chip8::opcode::encode2NNN(chip8::Cpu::PROGRAM_START + 0x10),
+    chip8::opcode::encode7XKK(0, 0x01),
+    chip8::opcode::encode3XKK(0, 0x14),
+    chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START + 0x04),
+    chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START + 0x0C),
+    0x0000,
+    chip8::opcode::encode8XY4(0, 1),
+    chip8::opcode::encodeANNN(0x300),
+    chip8::opcode::encodeFX1E(0),
+    chip8::opcode::encode00EE()
+};
+
+/// @brief Random digits drawn across the display.
+OpcodeList const DRAW_PROGRAM = {
+    chip8::opcode::encodeCXKK(2, 0x0F),
+    chip8::opcode::encodeFX29(2),
+    chip8::opcode::encodeDXYN(0, 1, 5),
+    chip8::opcode::encode7XKK(0, 0x05),
+    chip8::opcode::encode7XKK(1, 0x03),
+    chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START)
+};
+
+/// @brief Opcode sequences fused by the threaded engine, and ALU flags
+///        overwritten before they are read.
+OpcodeList const FUSED_PROGRAM = {
+    chip8::opcode::encode6XKK(0, 0x05),
+    chip8::opcode::encode6XKK(1, 0xFF),
+    chip8::opcode::encodeANNN(0x050),
+    chip8::opcode::encodeDXYN(0, 1, 5),
+    chip8::opcode::encode8XY4(0, 1),
+    chip8::opcode::encode8XY6(1, 0),
+    chip8::opcode::encode8XYE(0, 1),
+    chip8::opcode::encode3XKK(0xF, 0x00),
+    chip8::opcode::encode7XKK(2, 0x03),
+    chip8::opcode::encode3XKK(2, 0x30),
+    chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START + 0x10),
+    chip8::opcode::encodeANNN(0x300),
+    chip8::opcode::encodeFX33(2),
+    chip8::opcode::encodeFX65(2),
+    chip8::opcode::encode8XY5(3, 0),
+    chip8::opcode::encodeFX55(0xF),
+    chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START)
+};
+
+/// @brief BCD digits overwriting the FX65 that follows the FX33.
+OpcodeList const BCD_REWRITE_PROGRAM = {
+    chip8::opcode::encode6XKK(0, 0x80),
+    chip8::opcode::encodeANNN(chip8::Cpu::PROGRAM_START + 0x6),
+    chip8::opcode::encodeFX33(0),
+    chip8::opcode::encodeFX65(2),
+    chip8::opcode::encode6XKK(1, 0x01),
+    chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START)
+};
+
+/// @brief Machine over headless devices.
+///
+/// @tparam CPU CPU implementation.
+template<typename CPU>
+struct HeadlessMachine
+{
+    HeadlessMachine(OpcodeList const& program = DRAW_PROGRAM)
+        : memory{ }
+        , cpu{ chip8::borrow(memory), chip8::borrow(keyboard), chip8::borrow(gpu) }
+    {
+        chip8::loadProgram(memory, { });
+        memory.storeBuffer(chip8::Cpu::PROGRAM_START, program, chip8::Memory::Endian::LITTLE);
+    }
+
+    chip8::Memory memory;
+    chip8::HeadlessGpu gpu;
+    chip8::HeadlessKeyboard keyboard;
+    CPU cpu;
+};
+
+/// @brief Check that two machines are in the same state.
+template<typename EXPECTED, typename ACTUAL>
+void requireSameMachine(EXPECTED const& expected, ACTUAL const& actual)
+{
+    auto const& expectedRegs = expected.cpu.getRegContext();
+    auto const& actualRegs = actual.cpu.getRegContext();
+
+    REQUIRE(actualRegs.pc == expectedRegs.pc);
+    REQUIRE(actualRegs.i == expectedRegs.i);
+    REQUIRE(std::memcmp(actualRegs.vx, expectedRegs.vx, sizeof(actualRegs.vx)) == 0);
+    REQUIRE(std::memcmp(actual.gpu.framebuffer().rows(), expected.gpu.framebuffer().rows(),
+                        sizeof(chip8::Framebuffer::Row) * chip8::Framebuffer::DISPLAY_HEIGHT) == 0);
+}
+
+} // namespace
+
+TEST_CASE("Threaded engine matches interpreter", "[threaded]")
+{
+    auto interpreter = Chip8TestVm{};
+    auto threaded = ThreadedTestVm{};
+
+    uint32_t cycles = GENERATE(1, 2, 7, 13, 100, 1000);
+
+    interpreter.storeCode(LOOP_PROGRAM);
+    threaded.storeCode(LOOP_PROGRAM);
+
+    REQUIRE(interpreter.run(cycles) == cycles);
+    REQUIRE(threaded.run(cycles) == cycles);
+
+    auto const& expected = interpreter.cpu().getRegContext();
+    auto const& actual = threaded.cpu().getRegContext();
+
+    REQUIRE(actual.pc == expected.pc);
+    REQUIRE(actual.i == expected.i);
+    REQUIRE(actual.sp == expected.sp);
+    REQUIRE(std::memcmp(actual.vx, expected.vx, sizeof(actual.vx)) == 0);
+    REQUIRE(std::memcmp(actual.stack, expected.stack, sizeof(actual.stack)) == 0);
+}
+
+TEST_CASE("Threaded engine runs block rewritten by store registers", "[threaded]")
+{
+    auto vm = ThreadedTestVm{};
+
+    uint16_t target = chip8::Cpu::PROGRAM_START + 0xA;
+
+    auto opcodes = OpcodeList {
+        chip8::opcode::encode1NNN(target),
+        chip8::opcode::encode6XKK(0, 0x7A),
+        chip8::opcode::encode6XKK(1, 0x01),
+        chip8::opcode::encodeANNN(target),
+        chip8::opcode::encodeFX55(1),
+        chip8::opcode::encode7XKK(0xA, 0x05),
+        chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START + 2)
+    };
+
+    vm.storeCode(opcodes);
+
+    REQUIRE(vm.run(3) == 3);
+    REQUIRE(vm.cpu().getRegisterVx(0xA) == 0x05);
+
+    REQUIRE(vm.run(5) == 5);
+    REQUIRE(vm.cpu().getRegisterVx(0xA) == 0x06);
+    REQUIRE(vm.cpu().getProgramCounter() == target + 2);
+
+    REQUIRE(vm.run(2) == 2);
+    REQUIRE(vm.cpu().getProgramCounter() == chip8::Cpu::PROGRAM_START + 4);
+}
+
+TEST_CASE("Threaded engine parks on key wait", "[threaded]")
+{
+    auto vm = ThreadedTestVm{};
+
+    auto opcodes = OpcodeList {
+        chip8::opcode::encode6XKK(0, 0x01),
+        chip8::opcode::encodeFX0A(3),
+        chip8::opcode::encode7XKK(3, 0x10),
+        chip8::opcode::encode1NNN(chip8::Cpu::PROGRAM_START + 2)
+    };
+
+    vm.storeCode(opcodes);
+
+    REQUIRE(vm.run(100) == 100);
+    REQUIRE(vm.core().isWaitingForKey());
+    REQUIRE(vm.cpu().getProgramCounter() == chip8::Cpu::PROGRAM_START + 2);
+
+    vm.keyboard().pressKey(0x9);
+
+    REQUIRE(vm.run(3) == 3);
+    REQUIRE(vm.core().isWaitingForKey() == false);
+    REQUIRE(vm.cpu().getRegisterVx(3) == 0x19);
+    REQUIRE(vm.cpu().getProgramCounter() == chip8::Cpu::PROGRAM_START + 2);
+}
+
+TEST_CASE("Headless cores match the cores over device interfaces", "[threaded]")
+{
+    uint32_t cycles = GENERATE(1, 6, 100, 5000);
+
+    auto interpreter = HeadlessMachine<chip8::CpuImpl>{};
+    auto headless = HeadlessMachine<chip8::HeadlessCpu>{};
+    auto threaded = HeadlessMachine<chip8::HeadlessThreadedCpu>{};
+
+    REQUIRE(interpreter.cpu.run(cycles) == cycles);
+    REQUIRE(headless.cpu.run(cycles) == cycles);
+    REQUIRE(threaded.cpu.run(cycles) == cycles);
+
+    requireSameMachine(interpreter, headless);
+    requireSameMachine(interpreter, threaded);
+}
+
+TEST_CASE("Threaded superinstructions and dead flags match the interpreter", "[threaded]")
+{
+    auto const& program = GENERATE(FUSED_PROGRAM, BCD_REWRITE_PROGRAM);
+    uint32_t cycles = GENERATE(1, 3, 4, 9, 11, 14, 100, 5000);
+
+    auto interpreter = HeadlessMachine<chip8::CpuImpl>{ program };
+    auto threaded = HeadlessMachine<chip8::HeadlessThreadedCpu>{ program };
+
+    REQUIRE(interpreter.cpu.run(cycles) == cycles);
+    REQUIRE(threaded.cpu.run(cycles) == cycles);
+
+    requireSameMachine(interpreter, threaded);
+    REQUIRE(std::memcmp(interpreter.memory.data(), threaded.memory.data(), interpreter.memory.getSize()) == 0);
+}
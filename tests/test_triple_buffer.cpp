@@ -0,0 +1,105 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <thread>
+
+#include <triple_buffer.hpp>
+
+namespace {
+
+/// @brief Value large enough to be torn if buffers were shared.
+using Frame = std::array<uint64_t, 32>;
+
+} // namespace
+
+TEST_CASE("Triple buffer reader gets the newest published value", "[triple_buffer]")
+{
+    auto buffer = chip8::TripleBuffer<Frame>{};
+
+    REQUIRE_FALSE(buffer.update());
+
+    for (uint64_t value = 1; value <= 3; ++value)
+    {
+        buffer.back().fill(value);
+
+        // Only the values the reader never took are dropped
+        REQUIRE(buffer.publish() == (value != 1));
+    }
+
+    REQUIRE(buffer.update());
+    REQUIRE(buffer.front()[0] == 3);
+
+    // Nothing new, the front buffer is kept
+    REQUIRE_FALSE(buffer.update());
+    REQUIRE(buffer.front()[31] == 3);
+
+    buffer.back().fill(4);
+    REQUIRE_FALSE(buffer.update());
+
+    REQUIRE_FALSE(buffer.publish());
+    REQUIRE(buffer.update());
+    REQUIRE(buffer.front()[0] == 4);
+}
+
+TEST_CASE("Triple buffer hands complete values between threads", "[triple_buffer]")
+{
+    const uint64_t FRAME_COUNT = 100000;
+
+    auto buffer = chip8::TripleBuffer<Frame>{};
+
+    std::thread writer{ [&buffer] {
+        for (uint64_t value = 1; value <= FRAME_COUNT; ++value)
+        {
+            buffer.back().fill(value);
+            buffer.publish();
+        }
+    } };
+
+    uint64_t last = 0;
+    bool complete = true;
+    bool ordered = true;
+
+    while (last != FRAME_COUNT)
+    {
+        if (buffer.update())
+        {
+            auto const& frame = buffer.front();
+
+            complete = complete && std::all_of(frame.begin(), frame.end(),
+                                               [&frame](uint64_t value) { return value == frame[0]; });
+            ordered = ordered && (frame[0] > last);
+            last = frame[0];
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    writer.join();
+
+    REQUIRE(complete);
+    REQUIRE(ordered);
+}
@@ -0,0 +1,146 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Martin Lafreniere
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHIP8_TESTVM_HPP
+#define CHIP8_TESTVM_HPP
+
+#include <vector>
+
+#include <memory.hpp>
+#include <cpu.hpp>
+
+#include "fake_gpu.hpp"
+#include "fake_keyboard.hpp"
+
+using OpcodeList = chip8::Memory::Words;
+using Data = chip8::Memory::Bytes;
+
+class CpuContext
+{
+    public:
+        CpuContext(std::shared_ptr<chip8::Cpu> cpu)
+            : cpu_{ std::move(cpu) }
+        {
+        }
+
+        chip8::Cpu::RegContext const& getRegContext() const
+        {
+            return cpu_->getRegContext();
+        }
+
+        uint16_t getProgramCounter() const
+        {
+            return cpu_->getRegContext().pc;
+        }
+
+        uint8_t getRegisterVx(uint16_t vxIndex) const
+        {
+            return cpu_->getRegContext().vx[vxIndex];
+        }
+
+        uint8_t getStackPointer() const
+        {
+            return cpu_->getRegContext().sp;
+        }
+
+        uint16_t getRegisterI() const
+        {
+            return cpu_->getRegContext().i;
+        }
+
+        uint8_t getDelayTimer() const
+        {
+            return cpu_->getRegContext().dt;
+        }
+
+        uint8_t getSoundTimer() const
+        {
+            return cpu_->getRegContext().st;
+        }
+
+    private:
+        std::shared_ptr<chip8::Cpu> cpu_;
+};
+
+template<typename CPU>
+class BasicTestVm
+{
+    public:
+
+        BasicTestVm()
+            : memory_{ std::make_shared<chip8::Memory>() }
+            , gpu_{ std::make_shared<chip8::FakeGpu>() }
+            , keyboard_{ std::make_shared<chip8::FakeKeyboard>() }
+            , cpu_{ std::make_shared<CPU>(memory_, keyboard_, gpu_) }
+            , cpuContext_{ std::make_shared<CpuContext>(cpu_) }
+        {
+        }
+
+        void storeCode(OpcodeList const& program)
+        {
+            memory_->storeBuffer(chip8::Cpu::PROGRAM_START, program, chip8::Memory::Endian::LITTLE);
+        }
+
+        void storeData(uint16_t startAddress, Data const& data)
+        {
+            memory_->storeBuffer(startAddress, data);
+        }
+
+        uint16_t loadData(uint16_t address)
+        {
+            return memory_->load<uint8_t>(address);
+        }
+
+        void run()
+        {
+            cpu_->update();
+        }
+
+        uint32_t run(uint32_t cycles)
+        {
+            return cpu_->run(cycles);
+        }
+
+        void tickTimers()
+        {
+            cpu_->tickTimers();
+        }
+
+        CpuContext const& cpu() { return *cpuContext_; }
+        CPU & core() { return *cpu_; }
+
+        chip8::FakeGpu & gpu() { return *gpu_; }
+        chip8::FakeKeyboard & keyboard() { return *keyboard_; }
+
+    private:
+        std::shared_ptr<chip8::Memory> memory_;
+        std::shared_ptr<chip8::FakeGpu> gpu_;
+        std::shared_ptr<chip8::FakeKeyboard> keyboard_;
+        std::shared_ptr<CPU> cpu_;
+
+        std::shared_ptr<CpuContext> cpuContext_;
+};
+
+using Chip8TestVm = BasicTestVm<chip8::CpuImpl>;
+
+#endif  // CHIP8_TESTVM_HPP